@@ -0,0 +1,2276 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+// Headless benchmarks.
+// Usage: bench [mode] [maxParticles] [workerThreads] [frames]
+// Modes, and what maxParticles means for each (default in brackets):
+//   forces, validate, cutoff, fmm, pic, pme, gpu: max particle count [1000000],
+//     pic and pme exit 1 if a NaN or infinite particle breaks them
+//   blocksteps: particle count [2000]
+//   pool: population [100000]
+//   determinism: particle count [4000], frames is the step count [50],
+//     workerThreads is ignored (runs 1, 4 and 16), exits 1 on a mismatch
+//   instancing, impostors: instance count [10000]
+//   vertexformat: the sphere's vertex count [1000000]
+//   meshes: takes no count
+//   arena: mesh count [2000]
+//   load: submesh count [64]
+//   volume: particle count [100000]
+//   trails: particle count [10000]
+//   pointcloud: point count [2000000]
+//   frame: particle count [2000], frames is the timed frame count [200]
+// With no mode (or "all"), runs validate, forces and cutoff.
+// The GL modes need no window or display, see offscreen.h.
+
+#include <glad/glad.h>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "particleSystem.h"
+#include "particlePool.h"
+#include "forceSolver.h"
+#include "barnesHut.h"
+#include "fastMultipole.h"
+#include "particleInCell.h"
+#include "particleMeshEwald.h"
+#include "jobSystem.h"
+#include "integrator.h"
+#include "cellList.h"
+#include "gpuParticles.h"
+#include "shader.h"
+#include "camera.h"
+#include "proceduralMesh.h"
+#include "meshOptimizer.h"
+#include "geometryArena.h"
+#include "offscreen.h"
+#include "sphereImpostors.h"
+#include "chargeDensityVolume.h"
+#include "volumeRenderer.h"
+#include "pointCloud.h"
+#include "pointCloudBuilder.h"
+#include "particleTrails.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// Neutral plasma: alternating electrons and protons uniformly filling a cube
+static void makePlasma(ParticleSystem& particles, std::size_t count, float side, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> coordinate(-0.5f * side, 0.5f * side);
+    particles.clear();
+    particles.reserve(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        ParticleSpecies species = i % 2 == 0 ? ParticleSpecies::Electron : ParticleSpecies::Proton;
+        particles.addParticle(species, glm::vec3(coordinate(rng), coordinate(rng), coordinate(rng)));
+    }
+}
+
+// Steps per second, running for at least minSeconds (and at least one step).
+// One untimed step first, so first-use allocations and list builds don't count.
+static double stepsPerSecond(ParticleSystem& particles, ForceSolver& solver, JobSystem* jobs, double minSeconds)
+{
+    Integrator integrator(1.0e-4f, 1, IntegrationScheme::VelocityVerlet, jobs);
+    integrator.step(particles, solver);
+    int steps = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    while (steps == 0 || elapsed < minSeconds)
+    {
+        integrator.step(particles, solver);
+        steps++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return steps / elapsed;
+}
+
+// A diverged particle must not take a grid solver down with it: the same
+// plasma with a NaN and an infinite particle appended has to give the others
+// the accelerations they get without them (to float rounding, the deposit
+// order may change), and the two zero. Prints the result, returns whether it passed.
+static bool checkNonFinitePositions(ForceSolver& solver, bool periodic)
+{
+    const std::size_t count = 2000;
+    const float side = 10.0f;
+    ParticleSystem clean;
+    makePlasma(clean, count, side, 12);
+    if (periodic)
+        clean.box = PeriodicBox(side);
+    ParticleSystem diverged = clean;
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float infinity = std::numeric_limits<float>::infinity();
+    diverged.addParticle(ParticleSpecies::Electron, glm::vec3(nan, 0.0f, 0.0f));
+    diverged.addParticle(ParticleSpecies::Proton, glm::vec3(infinity, -infinity, 1.0f));
+    solver.computeAccelerations(clean);
+    solver.computeAccelerations(diverged);
+
+    double maxError = 0.0;
+    bool finite = true;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        glm::vec3 exact = clean.acceleration(i);
+        glm::vec3 candidate = diverged.acceleration(i);
+        finite = finite && std::isfinite(candidate.x) && std::isfinite(candidate.y) && std::isfinite(candidate.z);
+        maxError = std::max(maxError, double(glm::length(candidate - exact) / std::max(glm::length(exact), 1.0e-30f)));
+    }
+    for (std::size_t i = count; i < diverged.size(); i++)
+    {
+        finite = finite && diverged.acceleration(i) == glm::vec3(0.0f);
+    }
+    bool passed = finite && maxError < 1.0e-4;
+    std::printf("nonfinite_check,%s,max_relative_error,%.4e,%s\n", solver.name(), maxError, passed ? "ok" : "FAILED");
+    std::fflush(stdout);
+    return passed;
+}
+
+static void benchForces(std::size_t maxParticles, JobSystem& jobs)
+{
+    // The all-pairs path is skipped past this size, a single step would take minutes
+    const std::size_t bruteForceLimit = 65536;
+    BruteForceSolver bruteForce(&jobs);
+    BarnesHutSolver barnesHut(0.5f, &jobs);
+    ParticleSystem particles;
+
+    std::printf("solver,threads,particles,steps_per_second\n");
+    for (std::size_t n = 1000; n <= maxParticles; n *= 10)
+    {
+        if (n <= bruteForceLimit)
+        {
+            makePlasma(particles, n, 10.0f, 1);
+            std::printf("%s,%u,%zu,%.3f\n", bruteForce.name(), jobs.threadCount(), n, stepsPerSecond(particles, bruteForce, &jobs, 1.0));
+        }
+        makePlasma(particles, n, 10.0f, 1);
+        std::printf("%s,%u,%zu,%.3f\n", barnesHut.name(), jobs.threadCount(), n, stepsPerSecond(particles, barnesHut, &jobs, 1.0));
+        std::fflush(stdout);
+    }
+}
+
+static void validateBarnesHut(std::size_t particleCount)
+{
+    BruteForceSolver bruteForce;
+    ParticleSystem particles;
+    makePlasma(particles, particleCount, 10.0f, 2);
+
+    std::printf("theta,particles,rms_relative_error,max_relative_error\n");
+    const float thetas[] = { 0.2f, 0.3f, 0.5f, 0.7f, 1.0f };
+    for (float theta : thetas)
+    {
+        BarnesHutSolver barnesHut(theta);
+        ForceError error = measureForceError(particles, bruteForce, barnesHut);
+        std::printf("%.2f,%zu,%.6e,%.6e\n", theta, particleCount, error.rmsRelative, error.maxRelative);
+    }
+}
+
+// Force error against the exact sum for every expansion order, then
+// steps per second of FMM against Barnes-Hut as the particle count grows
+static void benchFastMultipole(std::size_t maxParticles, JobSystem& jobs)
+{
+    BruteForceSolver bruteForce(&jobs);
+    ParticleSystem particles;
+    std::size_t errorParticles = std::min<std::size_t>(maxParticles, 20000);
+    makePlasma(particles, errorParticles, 10.0f, 2);
+
+    std::printf("order,theta,particles,rms_relative_error,max_relative_error,seconds_per_evaluation\n");
+    for (int order = 1; order <= 8; order++)
+    {
+        FastMultipoleSolver fastMultipole(order, 0.6f, &jobs);
+        ForceError error = measureForceError(particles, bruteForce, fastMultipole);
+        ParticleSystem timed = particles;
+        Clock::time_point start = Clock::now();
+        fastMultipole.computeAccelerations(timed);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::printf("%d,%.2f,%zu,%.6e,%.6e,%.6f\n", order, fastMultipole.theta, errorParticles, error.rmsRelative, error.maxRelative, seconds);
+        std::fflush(stdout);
+    }
+
+    FastMultipoleSolver fastMultipole(4, 0.6f, &jobs);
+    BarnesHutSolver barnesHut(0.5f, &jobs);
+    std::printf("solver,threads,particles,steps_per_second\n");
+    for (std::size_t n = 1000; n <= maxParticles; n *= 10)
+    {
+        ForceSolver* solvers[] = { &barnesHut, &fastMultipole };
+        for (ForceSolver* solver : solvers)
+        {
+            makePlasma(particles, n, 10.0f, 1);
+            std::printf("%s,%u,%zu,%.3f\n", solver->name(), jobs.threadCount(), n, stepsPerSecond(particles, *solver, &jobs, 1.0));
+            std::fflush(stdout);
+        }
+    }
+}
+
+// Total energy, kinetic plus softened Coulomb, in double so the drift isn't rounding
+static double totalEnergy(const ParticleSystem& particles)
+{
+    const std::size_t n = particles.size();
+    const double eps2 = double(particles.softening) * particles.softening;
+    double kinetic = 0.0;
+    double potential = 0.0;
+    for (std::size_t i = 0; i < n; i++)
+    {
+        double v2 = double(particles.velX[i]) * particles.velX[i]
+            + double(particles.velY[i]) * particles.velY[i]
+            + double(particles.velZ[i]) * particles.velZ[i];
+        // Accelerations are coulomb_coupling * q_i E / m_i, so energies are
+        // in units of m_i * (length / time)^2
+        kinetic += 0.5 * particles.mass[i] * v2;
+        for (std::size_t j = i + 1; j < n; j++)
+        {
+            double dx = double(particles.posX[i]) - particles.posX[j];
+            double dy = double(particles.posY[i]) - particles.posY[j];
+            double dz = double(particles.posZ[i]) - particles.posZ[j];
+            potential += double(coulomb_coupling) * particles.charge[i] * particles.charge[j] / std::sqrt(dx * dx + dy * dy + dz * dz + eps2);
+        }
+    }
+    return kinetic + potential;
+}
+
+// Sparse plasma with a few bound electron-proton pairs, the pairs need a step
+// hundreds of times finer than the rest
+static void makeClusteredPlasma(ParticleSystem& particles, std::size_t count, std::size_t pairs, unsigned int seed)
+{
+    makePlasma(particles, count, 10.0f, seed);
+    std::mt19937 rng(seed + 1);
+    std::uniform_real_distribution<float> coordinate(-5.0f, 5.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    const float separation = 0.02f;
+    for (std::size_t p = 0; p < pairs; p++)
+    {
+        glm::vec3 center(coordinate(rng), coordinate(rng), coordinate(rng));
+        glm::vec3 axis = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 1.0e-3f));
+        glm::vec3 tangent = glm::normalize(glm::cross(axis, std::abs(axis.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0)));
+        // Circular orbit of the electron about the (much heavier) proton
+        float speed = std::sqrt(coulomb_coupling * std::abs(ELECTRON_CHARGE_E * PROTON_CHARGE_E) / (ELECTRON_MASS_KG * separation));
+        particles.addParticle(ParticleSpecies::Proton, center);
+        particles.addParticle(ParticleSpecies::Electron, center + axis * separation, tangent * speed);
+    }
+}
+
+// Block timesteps against velocity Verlet at the finest step the block run
+// needed, same clustered system and simulated time. Reports the relative
+// energy error and simulated time per wall second.
+static void benchBlockTimesteps(std::size_t particleCount, JobSystem& jobs)
+{
+    const float timeStep = 1.0e-2f;
+    const int steps = 20;
+    const std::size_t pairs = std::max<std::size_t>(particleCount / 100, 1);
+    BruteForceSolver bruteForce(&jobs);
+    ParticleSystem initial;
+    makeClusteredPlasma(initial, particleCount, pairs, 3);
+    double initialEnergy = totalEnergy(initial);
+
+    ParticleSystem particles = initial;
+    Integrator block(timeStep, 1, IntegrationScheme::BlockTimesteps, &jobs);
+    int finestLevel = 0;
+    std::vector<std::size_t> levelCounts(block.maxTimestepLevel + 1, 0);
+    Clock::time_point start = Clock::now();
+    for (int s = 0; s < steps; s++)
+    {
+        block.step(particles, bruteForce);
+        for (uint8_t level : block.getTimestepLevels())
+        {
+            finestLevel = std::max<int>(finestLevel, level);
+            levelCounts[level]++;
+        }
+    }
+    double blockSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    double blockError = std::abs(totalEnergy(particles) - initialEnergy) / std::abs(initialEnergy);
+
+    std::printf("level,mean_particles\n");
+    for (std::size_t level = 0; level < levelCounts.size(); level++)
+    {
+        std::printf("%zu,%.1f\n", level, double(levelCounts[level]) / steps);
+    }
+
+    particles = initial;
+    int substeps = 1 << finestLevel;
+    Integrator global(timeStep, substeps, IntegrationScheme::VelocityVerlet, &jobs);
+    start = Clock::now();
+    for (int s = 0; s < steps; s++)
+    {
+        global.step(particles, bruteForce);
+    }
+    double globalSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    double globalError = std::abs(totalEnergy(particles) - initialEnergy) / std::abs(initialEnergy);
+
+    double simulated = steps * timeStep;
+    std::printf("scheme,particles,pairs,finest_step,simulated_per_wall_second,relative_energy_error\n");
+    std::printf("%s,%zu,%zu,%.3e,%.6f,%.3e\n", integrationSchemeName(IntegrationScheme::BlockTimesteps),
+        particles.size(), pairs, timeStep / substeps, simulated / blockSeconds, blockError);
+    std::printf("%s,%zu,%zu,%.3e,%.6f,%.3e\n", integrationSchemeName(IntegrationScheme::VelocityVerlet),
+        particles.size(), pairs, timeStep / substeps, simulated / globalSeconds, globalError);
+}
+
+// Spawn and despawn throughput of the pool. Every round
+// an emitter at the centre spawns a batch, everything drifts, particles that
+// leave the box are removed and random recent spawns annihilate (some handles
+// are stale by then). No forces, this measures the bookkeeping only.
+static void benchPool(std::size_t population)
+{
+    const float side = 10.0f;
+    const std::size_t batch = std::max<std::size_t>(population / 100, 1);
+    ParticlePool pool;
+    pool.reserve(population * 2);
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> coordinate(-0.5f * side, 0.5f * side);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (std::size_t i = 0; i < population; i++)
+    {
+        ParticleSpecies species = i % 2 == 0 ? ParticleSpecies::Electron : ParticleSpecies::Proton;
+        pool.spawn(species, glm::vec3(coordinate(rng), coordinate(rng), coordinate(rng)), glm::vec3(unit(rng), unit(rng), unit(rng)));
+    }
+    std::vector<ParticleHandle> recent(batch * 4);
+    std::size_t recentNext = 0;
+    std::uniform_int_distribution<std::size_t> pickRecent(0, recent.size() - 1);
+
+    std::size_t spawned = 0;
+    std::size_t despawned = 0;
+    std::size_t staleHandles = 0;
+    std::size_t compactions = 0;
+    std::size_t rounds = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    while (elapsed < 2.0)
+    {
+        for (std::size_t k = 0; k < batch; k++)
+        {
+            ParticleSpecies species = k % 2 == 0 ? ParticleSpecies::Electron : ParticleSpecies::Proton;
+            recent[recentNext] = pool.spawn(species, glm::vec3(0.0f), 20.0f * glm::vec3(unit(rng), unit(rng), unit(rng)));
+            recentNext = (recentNext + 1) % recent.size();
+        }
+        spawned += batch;
+        pool.particles.drift(0.01f);
+
+        const ParticleSystem& particles = pool.particles;
+        despawned += pool.despawnIf([&particles, side](std::size_t i)
+        {
+            return std::abs(particles.posX[i]) > 0.5f * side || std::abs(particles.posY[i]) > 0.5f * side
+                || std::abs(particles.posZ[i]) > 0.5f * side;
+        });
+        for (std::size_t k = 0; k < batch / 4; k++)
+        {
+            if (pool.despawn(recent[pickRecent(rng)]))
+                despawned++;
+            else
+                staleHandles++;
+        }
+        if (pool.compactIfFragmented())
+            compactions++;
+        rounds++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    std::printf("initial,final,batch,rounds,events_per_second,stale_handles,compactions,holes\n");
+    std::printf("%zu,%zu,%zu,%zu,%.0f,%zu,%zu,%zu\n", population, pool.liveCount(), batch, rounds,
+        (spawned + despawned) / elapsed, staleHandles, compactions, pool.holeCount());
+}
+
+// Short-range solvers at a fixed density of 8 particles per unit volume,
+// so the cell and neighbour lists should scale linearly
+static void benchCutoff(std::size_t maxParticles, JobSystem& jobs)
+{
+    const std::size_t bruteForceLimit = 65536;
+    const float density = 8.0f;
+    const float cutoff = 1.5f;
+    BruteForceSolver bruteForce(&jobs);
+    CutoffSolver cellList(cutoff, 0.5f, false, &jobs);
+    CutoffSolver verletList(cutoff, 0.5f, true, &jobs);
+    verletList.getNeighbourList().skin = 0.3f;
+    ParticleSystem particles;
+
+    std::printf("solver,threads,particles,steps_per_second\n");
+    for (std::size_t n = 1000; n <= maxParticles; n *= 10)
+    {
+        float side = std::cbrt(float(n) / density);
+        ForceSolver* solvers[] = { &bruteForce, &cellList, &verletList };
+        for (ForceSolver* solver : solvers)
+        {
+            if (solver == &bruteForce && n > bruteForceLimit)
+                continue;
+            makePlasma(particles, n, side, 3);
+            std::printf("%s,%u,%zu,%.3f\n", solver->name(), jobs.threadCount(), n, stepsPerSecond(particles, *solver, &jobs, 1.0));
+            std::fflush(stdout);
+        }
+    }
+}
+
+// Deterministic mode: the same plasma stepped by every CPU solver on 1, 4 and
+// 16 job threads (1 is the inline path, no JobSystem), with and without
+// ForceSolver::deterministic. differing_floats counts the positions and
+// velocities of the whole trajectory that differ in any bit from the 1-thread
+// run, deterministic runs must have none. brute-force-kahan is the brute
+// force solver with compensatedSummation. Returns the number of deterministic
+// runs that differ, which main turns into the exit code so ctest can fail on it.
+static std::size_t benchDeterminism(std::size_t particleCount, int steps)
+{
+    const float side = 10.0f;
+    struct SolverCase
+    {
+        const char* name;
+        bool periodic;
+        std::function<std::unique_ptr<ForceSolver>(JobSystem*)> make;
+    };
+    const SolverCase cases[] = {
+        { "brute-force", false, [](JobSystem* jobs) { return std::make_unique<BruteForceSolver>(jobs); } },
+        { "brute-force-kahan", false, [](JobSystem* jobs)
+            {
+                std::unique_ptr<BruteForceSolver> solver = std::make_unique<BruteForceSolver>(jobs);
+                solver->compensatedSummation = true;
+                return solver;
+            } },
+        { "barnes-hut", false, [](JobSystem* jobs) { return std::make_unique<BarnesHutSolver>(0.5f, jobs); } },
+        { "cutoff", false, [](JobSystem* jobs) { return std::make_unique<CutoffSolver>(2.0f, 0.0f, true, jobs); } },
+        { "fmm", false, [](JobSystem* jobs) { return std::make_unique<FastMultipoleSolver>(4, 0.6f, jobs); } },
+        { "pic", false, [](JobSystem* jobs) { return std::make_unique<ParticleInCellSolver>(64, ChargeAssignment::TriangularShapedCloud, jobs); } },
+        { "pme", true, [](JobSystem* jobs) { return std::make_unique<ParticleMeshEwaldSolver>(32, ChargeAssignment::TriangularShapedCloud, 6.0f, jobs); } },
+    };
+    const unsigned int threadCounts[] = { 1, 4, 16 };
+
+    std::printf("solver,deterministic,threads,particles,steps,differing_floats,max_position_difference,ms_per_step\n");
+    std::vector<float> reference;
+    std::vector<float> trajectory;
+    std::size_t failures = 0;
+    for (const SolverCase& solverCase : cases)
+    {
+        for (bool deterministic : { false, true })
+        {
+            for (unsigned int threads : threadCounts)
+            {
+                std::unique_ptr<JobSystem> jobs = threads > 1 ? std::make_unique<JobSystem>(threads - 1) : nullptr;
+                std::unique_ptr<ForceSolver> solver = solverCase.make(jobs.get());
+                solver->deterministic = deterministic;
+                ParticleSystem particles;
+                makePlasma(particles, particleCount, side, 11);
+                if (solverCase.periodic)
+                    particles.box = PeriodicBox(side);
+                Integrator integrator(1.0e-4f, 1, IntegrationScheme::VelocityVerlet, jobs.get());
+
+                // Positions then velocities of every particle, after every step
+                trajectory.clear();
+                double seconds = 0.0;
+                for (int step = 0; step < steps; step++)
+                {
+                    Clock::time_point start = Clock::now();
+                    integrator.step(particles, *solver);
+                    seconds += std::chrono::duration<double>(Clock::now() - start).count();
+                    const AlignedFloats* arrays[] = { &particles.posX, &particles.posY, &particles.posZ,
+                                                      &particles.velX, &particles.velY, &particles.velZ };
+                    for (const AlignedFloats* array : arrays)
+                    {
+                        trajectory.insert(trajectory.end(), array->begin(), array->begin() + particles.size());
+                    }
+                }
+                if (threads == threadCounts[0])
+                    reference = trajectory;
+
+                std::size_t differing = 0;
+                double maxPositionDifference = 0.0;
+                const std::size_t perStep = 6 * particles.size();
+                for (std::size_t k = 0; k < trajectory.size(); k++)
+                {
+                    if (std::bit_cast<uint32_t>(trajectory[k]) == std::bit_cast<uint32_t>(reference[k]))
+                        continue;
+                    differing++;
+                    if (k % perStep < 3 * particles.size())
+                        maxPositionDifference = std::max(maxPositionDifference, std::abs(double(trajectory[k]) - reference[k]));
+                }
+                if (deterministic && differing > 0)
+                    failures++;
+                std::printf("%s,%d,%u,%zu,%d,%zu,%.6e,%.3f\n", solverCase.name, deterministic ? 1 : 0, threads,
+                    particleCount, steps, differing, maxPositionDifference, 1000.0 * seconds / std::max(steps, 1));
+                std::fflush(stdout);
+            }
+        }
+    }
+    std::printf("deterministic_runs_differing,%zu\n", failures);
+    return failures;
+}
+
+// Compute-shader path against the scalar CPU reference: same steps on both,
+// then count the state floats that differ in any bit. On a GPU driver some
+// differences are expected, on Mesa llvmpipe there should be none.
+static void benchGpu(std::size_t maxParticles, JobSystem& jobs)
+{
+    const std::size_t gpuLimit = 65536;
+    const int compareSteps = 20;
+    OffscreenContext context;
+    if (!createOffscreenContext(context))
+    {
+        return;
+    }
+    std::printf("renderer,%s\n", (const char*) glGetString(GL_RENDERER));
+
+    {
+        GpuParticleSystem gpuParticles;
+        gpuParticles.loadShaders("shaders/particleForces_comp.glsl", "shaders/particleIntegrate_comp.glsl");
+        BruteForceSolver reference(&jobs);
+        reference.useSimd = false;
+        ParticleSystem particles;
+
+        std::printf("scheme,particles,steps,differing_floats,total_floats\n");
+        const IntegrationScheme schemes[] = { IntegrationScheme::VelocityVerlet, IntegrationScheme::Leapfrog };
+        for (IntegrationScheme scheme : schemes)
+        {
+            std::size_t n = std::min<std::size_t>(maxParticles, 4096);
+            makePlasma(particles, n, 10.0f, 4);
+            gpuParticles.upload(particles);
+            Integrator integrator(1.0e-2f, 1, scheme, &jobs);
+            for (int s = 0; s < compareSteps; s++)
+            {
+                integrator.step(particles, reference);
+                gpuParticles.step(scheme, integrator.timeStep);
+            }
+            ParticleSystem fromGpu = particles;
+            gpuParticles.download(fromGpu);
+
+            const AlignedFloats ParticleSystem::* fields[] = {
+                &ParticleSystem::posX, &ParticleSystem::posY, &ParticleSystem::posZ,
+                &ParticleSystem::velX, &ParticleSystem::velY, &ParticleSystem::velZ,
+                &ParticleSystem::accX, &ParticleSystem::accY, &ParticleSystem::accZ };
+            std::size_t differing = 0;
+            for (const AlignedFloats ParticleSystem::* field : fields)
+            {
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    if (std::memcmp(&(particles.*field)[i], &(fromGpu.*field)[i], sizeof(float)) != 0)
+                        differing++;
+                }
+            }
+            std::printf("%s,%zu,%d,%zu,%zu\n", integrationSchemeName(scheme), n, compareSteps, differing, n * 9);
+        }
+
+        std::printf("path,particles,steps_per_second\n");
+        BruteForceSolver bruteForce(&jobs);
+        for (std::size_t n = 1000; n <= std::min(maxParticles, gpuLimit); n *= 4)
+        {
+            makePlasma(particles, n, 10.0f, 1);
+            std::printf("cpu-%s,%zu,%.3f\n", bruteForce.name(), n, stepsPerSecond(particles, bruteForce, &jobs, 1.0));
+
+            makePlasma(particles, n, 10.0f, 1);
+            gpuParticles.upload(particles);
+            gpuParticles.step(IntegrationScheme::VelocityVerlet, 1.0e-4f);
+            glFinish();
+            int steps = 0;
+            Clock::time_point start = Clock::now();
+            double elapsed = 0.0;
+            while (steps == 0 || elapsed < 1.0)
+            {
+                gpuParticles.step(IntegrationScheme::VelocityVerlet, 1.0e-4f);
+                // Wait every step, otherwise this only measures how fast commands queue up
+                glFinish();
+                steps++;
+                elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            }
+            std::printf("gpu-compute,%zu,%.3f\n", n, steps / elapsed);
+            std::fflush(stdout);
+        }
+    }
+
+    destroyOffscreenContext(context);
+}
+
+// Nearest-rank percentile, p in [0, 1]
+static double percentile(std::vector<double> values, double p)
+{
+    if (values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+    std::size_t rank = (std::size_t) std::ceil(p * values.size());
+    return values[std::clamp<std::size_t>(rank, 1, values.size()) - 1];
+}
+
+static double median(const std::vector<double>& values)
+{
+    return percentile(values, 0.5);
+}
+
+static double millisecondsBetween(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Particle-in-cell against the exact sum on a smooth cloud (a Gaussian ball
+// of electrons), where the mean field dominates. Median and 90th percentile
+// of the per-particle relative error, RMS would be all close pairs, which
+// PIC smooths away by design. Then the non-finite position check, and steps
+// per second against Barnes-Hut. Returns whether the check passed.
+static bool benchParticleInCell(std::size_t maxParticles, JobSystem& jobs)
+{
+    BruteForceSolver bruteForce(&jobs);
+    ParticleSystem particles;
+    std::size_t errorParticles = std::min<std::size_t>(maxParticles, 20000);
+    std::mt19937 rng(6);
+    std::normal_distribution<float> coordinate(0.0f, 2.0f);
+    particles.reserve(errorParticles);
+    for (std::size_t i = 0; i < errorParticles; i++)
+    {
+        particles.addParticle(ParticleSpecies::Electron, glm::vec3(coordinate(rng), coordinate(rng), coordinate(rng)));
+    }
+    ParticleSystem reference = particles;
+    bruteForce.computeAccelerations(reference);
+
+    std::printf("grid,assignment,particles,median_relative_error,p90_relative_error,seconds_per_evaluation\n");
+    const uint32_t grids[] = { 32, 64, 128 };
+    const ChargeAssignment assignments[] = { ChargeAssignment::CloudInCell, ChargeAssignment::TriangularShapedCloud };
+    for (uint32_t grid : grids)
+    {
+        for (ChargeAssignment assignment : assignments)
+        {
+            ParticleInCellSolver particleInCell(grid, assignment, &jobs);
+            ParticleSystem candidate = particles;
+            // The first call also builds the Green's function spectrum
+            particleInCell.computeAccelerations(candidate);
+            Clock::time_point start = Clock::now();
+            particleInCell.computeAccelerations(candidate);
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            std::vector<double> errors(errorParticles);
+            for (std::size_t i = 0; i < errorParticles; i++)
+            {
+                glm::vec3 exact = reference.acceleration(i);
+                errors[i] = glm::length(candidate.acceleration(i) - exact) / std::max(glm::length(exact), 1.0e-30f);
+            }
+            std::printf("%u,%s,%zu,%.4e,%.4e,%.4f\n", grid, chargeAssignmentName(assignment), errorParticles,
+                median(errors), percentile(errors, 0.9), seconds);
+            std::fflush(stdout);
+        }
+    }
+
+    ParticleInCellSolver particleInCell(64, ChargeAssignment::TriangularShapedCloud, &jobs);
+    bool passed = checkNonFinitePositions(particleInCell, false);
+    BarnesHutSolver barnesHut(0.5f, &jobs);
+    std::printf("solver,threads,particles,steps_per_second\n");
+    for (std::size_t n = 1000; n <= maxParticles; n *= 10)
+    {
+        ForceSolver* solvers[] = { &barnesHut, &particleInCell };
+        for (ForceSolver* solver : solvers)
+        {
+            makePlasma(particles, n, 10.0f, 1);
+            std::printf("%s,%u,%zu,%.3f\n", solver->name(), jobs.threadCount(), n, stepsPerSecond(particles, *solver, &jobs, 1.0));
+            std::fflush(stdout);
+        }
+    }
+    return passed;
+}
+
+// Ewald sum straight from the formula, in double: erfc pairs under the
+// nearest image and an explicit sum over every wave vector up to maxFrequency
+// per axis. alpha = 7 / side makes both halves converge to about 1e-7.
+// Softening is added to the nearest image pair, as the solvers do.
+static void directEwald(ParticleSystem& particles, int maxFrequency)
+{
+    const double pi = 3.14159265358979323846;
+    const std::size_t n = particles.size();
+    const double side = particles.box.side;
+    const double alpha = 7.0 / side;
+    const double volume = side * side * side;
+    const double eps2 = double(particles.softening) * particles.softening;
+    std::vector<glm::dvec3> field(n, glm::dvec3(0.0));
+    for (std::size_t i = 0; i < n; i++)
+    {
+        for (std::size_t j = 0; j < n; j++)
+        {
+            if (i == j)
+                continue;
+            glm::dvec3 d = glm::dvec3(particles.position(i)) - glm::dvec3(particles.position(j));
+            d -= side * glm::round(d / side);
+            double r = glm::length(d);
+            double f = (std::erfc(alpha * r) / r + 2.0 * alpha / std::sqrt(pi) * std::exp(-alpha * alpha * r * r)) / (r * r);
+            f += 1.0 / std::pow(r * r + eps2, 1.5) - 1.0 / (r * r * r);
+            field[i] += particles.charge[j] * f * d;
+        }
+    }
+    std::vector<double> cosines(n), sines(n);
+    for (int mx = -maxFrequency; mx <= maxFrequency; mx++)
+    {
+        for (int my = -maxFrequency; my <= maxFrequency; my++)
+        {
+            for (int mz = -maxFrequency; mz <= maxFrequency; mz++)
+            {
+                if (mx == 0 && my == 0 && mz == 0)
+                    continue;
+                glm::dvec3 k = 2.0 * pi / side * glm::dvec3(mx, my, mz);
+                double k2 = glm::dot(k, k);
+                double amplitude = 4.0 * pi / (volume * k2) * std::exp(-k2 / (4.0 * alpha * alpha));
+                // S(k) = sum q e^{-ik.r}, E(r) = sum_k amplitude k Im(S(k) e^{ik.r})
+                double structureRe = 0.0;
+                double structureIm = 0.0;
+                for (std::size_t j = 0; j < n; j++)
+                {
+                    double phase = glm::dot(k, glm::dvec3(particles.position(j)));
+                    cosines[j] = std::cos(phase);
+                    sines[j] = std::sin(phase);
+                    structureRe += particles.charge[j] * cosines[j];
+                    structureIm -= particles.charge[j] * sines[j];
+                }
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    double im = structureRe * sines[i] + structureIm * cosines[i];
+                    field[i] += amplitude * im * k;
+                }
+            }
+        }
+    }
+    for (std::size_t i = 0; i < n; i++)
+    {
+        double coef = coulomb_coupling * particles.charge[i] / particles.mass[i];
+        particles.accX[i] = float(coef * field[i].x);
+        particles.accY[i] = float(coef * field[i].y);
+        particles.accZ[i] = float(coef * field[i].z);
+    }
+}
+
+// Particle-mesh Ewald against the direct Ewald sum on a random neutral plasma
+// in a periodic box, RMS and max relative error per grid and assignment, then
+// the non-finite position check, and steps per second at a fixed density
+// (one particle per unit volume, cells about 0.6 wide) as the box grows.
+// Returns whether the check passed.
+static bool benchParticleMeshEwald(std::size_t maxParticles, JobSystem& jobs)
+{
+    ParticleSystem particles;
+    makePlasma(particles, 1000, 10.0f, 8);
+    particles.box = PeriodicBox(10.0f);
+    ParticleSystem reference = particles;
+    directEwald(reference, 10);
+
+    std::printf("grid,assignment,cutoff_cells,particles,rms_relative_error,max_relative_error,seconds_per_evaluation\n");
+    const uint32_t grids[] = { 16, 32, 64 };
+    const ChargeAssignment assignments[] = { ChargeAssignment::CloudInCell, ChargeAssignment::TriangularShapedCloud };
+    for (uint32_t grid : grids)
+    {
+        for (ChargeAssignment assignment : assignments)
+        {
+            ParticleMeshEwaldSolver particleMeshEwald(grid, assignment, 6.0f, &jobs);
+            ParticleSystem candidate = particles;
+            // The first call also builds the influence function
+            particleMeshEwald.computeAccelerations(candidate);
+            Clock::time_point start = Clock::now();
+            particleMeshEwald.computeAccelerations(candidate);
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            double errorSum = 0.0;
+            double referenceSum = 0.0;
+            double maxError = 0.0;
+            for (std::size_t i = 0; i < particles.size(); i++)
+            {
+                glm::vec3 exact = reference.acceleration(i);
+                double error = glm::length(candidate.acceleration(i) - exact);
+                errorSum += error * error;
+                referenceSum += double(glm::dot(exact, exact));
+                maxError = std::max(maxError, error / std::max(double(glm::length(exact)), 1.0e-30));
+            }
+            std::printf("%u,%s,%.1f,%zu,%.4e,%.4e,%.4f\n", grid, chargeAssignmentName(assignment), particleMeshEwald.cutoffCells,
+                particles.size(), std::sqrt(errorSum / referenceSum), maxError, seconds);
+            std::fflush(stdout);
+        }
+    }
+
+    ParticleMeshEwaldSolver checked(32, ChargeAssignment::TriangularShapedCloud, 6.0f, &jobs);
+    bool passed = checkNonFinitePositions(checked, true);
+    std::printf("solver,threads,particles,grid,steps_per_second\n");
+    for (std::size_t n = 1000; n <= maxParticles; n *= 10)
+    {
+        float side = std::cbrt(float(n));
+        uint32_t grid = std::bit_ceil(uint32_t(side / 0.6f));
+        ParticleMeshEwaldSolver particleMeshEwald(grid, ChargeAssignment::TriangularShapedCloud, 6.0f, &jobs);
+        makePlasma(particles, n, side, 1);
+        particles.box = PeriodicBox(side);
+        std::printf("%s,%u,%zu,%u,%.3f\n", particleMeshEwald.name(), jobs.threadCount(), n, grid,
+            stepsPerSecond(particles, particleMeshEwald, &jobs, 1.0));
+        std::fflush(stdout);
+    }
+    return passed;
+}
+
+// The old particle loop (uniforms + draw per object) against one drawInstanced
+// call. cpu_ms is the time until the last GL call returns, frame_ms also waits
+// for the GPU to finish.
+static void benchInstancing(std::size_t instanceCount)
+{
+    const int frames = 30;
+    OffscreenContext context;
+    if (!createOffscreenContext(context))
+    {
+        return;
+    }
+    std::printf("renderer,%s\n", (const char*) glGetString(GL_RENDERER));
+
+    {
+        OffscreenTarget target = createOffscreenTarget(800, 600);
+        glEnable(GL_DEPTH_TEST);
+
+        Shader meshShader = Shader();
+        meshShader.compileVertexShader("shaders/mesh_vert.glsl");
+        meshShader.compileFragmentShader("shaders/mesh_frag.glsl");
+        meshShader.compileFragmentShader("shaders/lighting_frag.glsl");
+        meshShader.linkShaders();
+        meshShader.use();
+        MeshUniform meshUniform = meshShader.getMeshUniform("mesh");
+        MaterialUniform materialUniform = meshShader.getMaterialUniform("material");
+        CameraUniform cameraUniform = meshShader.getCameraUniform("camera");
+        GLint renderInstancedUniform = meshShader.getUniform("renderInstanced");
+        setInt(meshShader.getUniform("numSpotLights"), 0);
+        setInt(meshShader.getUniform("numPointLights"), 0);
+        setInt(meshShader.getUniform("numDirLights"), 1);
+        DirLight dirLight;
+        dirLight.direction = glm::vec3(-0.5f, -1.0f, -0.5f);
+        setDirLight(meshShader.getDirLightUniform("dirLights[0]"), dirLight);
+        setMaterial(materialUniform, Material(glm::vec3(0.1f, 0.1f, 0.8f)));
+
+        Camera camera;
+        camera.position = glm::vec3(0.0f, 0.0f, 30.0f);
+        camera.updateView();
+        setCamera(cameraUniform, camera);
+
+        Mesh sphere = uvSphere(0.05f, 10, 10);
+        sphere.bufferToGPU();
+
+        ParticleSystem particles;
+        makePlasma(particles, instanceCount, 20.0f, 5);
+        std::vector<glm::mat4> models(instanceCount);
+
+        std::printf("path,instances,draw_calls,cpu_ms,frame_ms\n");
+        for (int instanced = 0; instanced < 2; instanced++)
+        {
+            setBool(renderInstancedUniform, instanced == 1);
+            std::vector<double> cpuTimes;
+            std::vector<double> frameTimes;
+            std::size_t drawCalls = 0;
+            for (int frame = 0; frame < frames + 1; frame++)
+            {
+                glFinish();
+                Clock::time_point start = Clock::now();
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                drawCalls = 0;
+                if (instanced == 1)
+                {
+                    for (std::size_t i = 0; i < instanceCount; i++)
+                    {
+                        models[i] = calculateModelMatrix(particles.position(i), sphere.rotation, sphere.scale);
+                    }
+                    sphere.drawInstanced(models);
+                    drawCalls++;
+                }
+                else
+                {
+                    for (std::size_t i = 0; i < instanceCount; i++)
+                    {
+                        glm::mat4 model = calculateModelMatrix(particles.position(i), sphere.rotation, sphere.scale);
+                        setMesh(meshUniform, model, calculateNormalMatrix(model));
+                        sphere.draw();
+                        drawCalls++;
+                    }
+                }
+                Clock::time_point submitted = Clock::now();
+                glFinish();
+                Clock::time_point finished = Clock::now();
+                // First frame pays for buffer creation and shader compilation
+                if (frame == 0)
+                    continue;
+                cpuTimes.push_back(millisecondsBetween(start, submitted));
+                frameTimes.push_back(millisecondsBetween(start, finished));
+            }
+            std::printf("%s,%zu,%zu,%.3f,%.3f\n", instanced == 1 ? "instanced" : "per-object", instanceCount, drawCalls, median(cpuTimes), median(frameTimes));
+            std::fflush(stdout);
+        }
+        deleteOffscreenTarget(target);
+    }
+
+    destroyOffscreenContext(context);
+}
+
+// The same spheres as instanced uvSphere meshes and as ray-cast impostors.
+// covered_pixels should nearly agree, the mesh silhouette is a polygon.
+static void benchImpostors(std::size_t instanceCount)
+{
+    const int frames = 30;
+    const int width = 800;
+    const int height = 600;
+    OffscreenContext context;
+    if (!createOffscreenContext(context))
+    {
+        return;
+    }
+    std::printf("renderer,%s\n", (const char*) glGetString(GL_RENDERER));
+
+    {
+        OffscreenTarget target = createOffscreenTarget(width, height);
+        glEnable(GL_DEPTH_TEST);
+        DirLight dirLight;
+        dirLight.direction = glm::vec3(-0.5f, -1.0f, -0.5f);
+        Material material(glm::vec3(0.1f, 0.1f, 0.8f));
+        Camera camera;
+        camera.position = glm::vec3(0.0f, 0.0f, 30.0f);
+        camera.updateView();
+
+        Shader meshShader = Shader();
+        meshShader.compileVertexShader("shaders/mesh_vert.glsl");
+        meshShader.compileFragmentShader("shaders/mesh_frag.glsl");
+        meshShader.compileFragmentShader("shaders/lighting_frag.glsl");
+        meshShader.linkShaders();
+        Shader impostorShader = Shader();
+        impostorShader.compileVertexShader("shaders/particleImpostor_vert.glsl");
+        impostorShader.compileFragmentShader("shaders/particleImpostor_frag.glsl");
+        impostorShader.compileFragmentShader("shaders/lighting_frag.glsl");
+        impostorShader.linkShaders();
+        Shader* shaders[] = { &meshShader, &impostorShader };
+        for (Shader* shader : shaders)
+        {
+            shader->use();
+            setInt(shader->getUniform("numSpotLights"), 0);
+            setInt(shader->getUniform("numPointLights"), 0);
+            setInt(shader->getUniform("numDirLights"), 1);
+            setDirLight(shader->getDirLightUniform("dirLights[0]"), dirLight);
+            setMaterial(shader->getMaterialUniform("material"), material);
+            setCamera(shader->getCameraUniform("camera"), camera);
+        }
+        meshShader.use();
+        setBool(meshShader.getUniform("renderInstanced"), true);
+        impostorShader.use();
+        setBool(impostorShader.getUniform("useParticleBuffer"), false);
+        setFloat(impostorShader.getUniform("radius"), 0.05f);
+
+        Mesh sphere = uvSphere(0.05f, 10, 10);
+        sphere.bufferToGPU();
+        SphereImpostors impostors;
+
+        ParticleSystem particles;
+        makePlasma(particles, instanceCount, 20.0f, 5);
+        std::vector<glm::mat4> models(instanceCount);
+        std::vector<glm::vec3> centers(instanceCount);
+        for (std::size_t i = 0; i < instanceCount; i++)
+        {
+            models[i] = calculateModelMatrix(particles.position(i), sphere.rotation, sphere.scale);
+            centers[i] = particles.position(i);
+        }
+        std::vector<float> depths(std::size_t(width) * height);
+
+        std::printf("path,instances,vertices_per_instance,frame_ms,covered_pixels\n");
+        for (int impostor = 0; impostor < 2; impostor++)
+        {
+            std::vector<double> frameTimes;
+            for (int frame = 0; frame < frames + 1; frame++)
+            {
+                glFinish();
+                Clock::time_point start = Clock::now();
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                if (impostor == 1)
+                {
+                    impostorShader.use();
+                    impostors.draw(centers);
+                }
+                else
+                {
+                    meshShader.use();
+                    sphere.drawInstanced(models);
+                }
+                glFinish();
+                Clock::time_point finished = Clock::now();
+                if (frame == 0)
+                    continue;
+                frameTimes.push_back(millisecondsBetween(start, finished));
+            }
+            glReadPixels(0, 0, width, height, GL_DEPTH_COMPONENT, GL_FLOAT, depths.data());
+            std::size_t covered = 0;
+            for (float depth : depths)
+            {
+                if (depth < 1.0f)
+                    covered++;
+            }
+            std::printf("%s,%zu,%zu,%.3f,%zu\n", impostor == 1 ? "impostor" : "mesh", instanceCount,
+                impostor == 1 ? std::size_t(4) : sphere.indices.size(), median(frameTimes), covered);
+            std::fflush(stdout);
+        }
+        deleteOffscreenTarget(target);
+    }
+
+    destroyOffscreenContext(context);
+}
+
+// Mesh vertex layouts on a uvSphere of about vertexCount vertices: bytes per
+// vertex, CPU packing cost, and the worst decoding error against the float
+// attributes (position as a fraction of the bounding box, normal in degrees,
+// texture coordinate in uv units). Then a 64 x 64 segment sphere drawn
+// instanced from every layout through mesh_vert.glsl, frame time and the
+// mean and max difference per channel from the float image in 8-bit steps.
+static void benchVertexFormat(std::size_t vertexCount)
+{
+    struct LayoutCase
+    {
+        const char* name;
+        VertexLayout layout;
+    };
+    VertexLayout octahedral;
+    octahedral.octahedralNormals = true;
+    VertexLayout halfTexCoords;
+    halfTexCoords.texCoords = TexCoordFormat::Half;
+    VertexLayout compactUnorm = VertexLayout::compact();
+    compactUnorm.texCoords = TexCoordFormat::Unorm16;
+    const LayoutCase cases[] = {
+        { "float", VertexLayout() },
+        { "octahedral-normals", octahedral },
+        { "half-texcoords", halfTexCoords },
+        { "compact", VertexLayout::compact() },
+        { "compact-unorm16", compactUnorm },
+    };
+
+    int segments = std::max(int(std::sqrt(double(vertexCount))), 3);
+    Mesh sphere = uvSphere(1.0f, segments, segments);
+    const std::size_t n = sphere.vertices.size();
+
+    std::printf("layout,vertices,bytes_per_vertex,pack_ns_per_vertex,max_position_error,max_normal_error_degrees,max_texcoord_error\n");
+    for (const LayoutCase& layoutCase : cases)
+    {
+        const VertexLayout layout = layoutCase.layout;
+        PackedVertices packed;
+        int repetitions = 0;
+        Clock::time_point start = Clock::now();
+        double elapsed = 0.0;
+        while (repetitions == 0 || elapsed < 0.25)
+        {
+            packed = packVertices(sphere.vertices, sphere.normals, sphere.texCoords, layout);
+            repetitions++;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        // Decode every vertex the way the vertex fetch and mesh_vert.glsl do
+        const std::size_t normalOffset = layout.quantizePositions ? 8 : 12;
+        const std::size_t texCoordOffset = normalOffset + (layout.octahedralNormals ? 4 : 12);
+        glm::vec3 extent = packed.positionScale;
+        float largestExtent = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1.0e-30f));
+        double positionError = 0.0;
+        double normalError = 0.0;
+        double texCoordError = 0.0;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            const uint8_t* vertex = packed.bytes.data() + i * std::size_t(packed.stride);
+            glm::vec3 position;
+            glm::vec3 normal;
+            glm::vec2 texCoord;
+            if (layout.quantizePositions)
+            {
+                uint64_t bits;
+                std::memcpy(&bits, vertex, sizeof(bits));
+                position = packed.positionOffset + packed.positionScale * glm::vec3(glm::unpackUnorm4x16(bits));
+            }
+            else
+            {
+                std::memcpy(&position, vertex, sizeof(position));
+            }
+            if (layout.octahedralNormals)
+            {
+                uint32_t bits;
+                std::memcpy(&bits, vertex + normalOffset, sizeof(bits));
+                normal = octahedralDecode(glm::unpackSnorm2x16(bits));
+            }
+            else
+            {
+                std::memcpy(&normal, vertex + normalOffset, sizeof(normal));
+            }
+            if (layout.texCoords == TexCoordFormat::Float)
+            {
+                std::memcpy(&texCoord, vertex + texCoordOffset, sizeof(texCoord));
+            }
+            else
+            {
+                uint32_t bits;
+                std::memcpy(&bits, vertex + texCoordOffset, sizeof(bits));
+                texCoord = layout.texCoords == TexCoordFormat::Half ? glm::unpackHalf2x16(bits) : glm::unpackUnorm2x16(bits);
+            }
+            glm::vec3 positionDifference = glm::abs(position - sphere.vertices[i]);
+            positionError = std::max(positionError, double(std::max(std::max(positionDifference.x, positionDifference.y), positionDifference.z)) / largestExtent);
+            glm::dvec3 decoded(normal);
+            glm::dvec3 original(sphere.normals[i]);
+            double angle = std::atan2(glm::length(glm::cross(decoded, original)), glm::dot(decoded, original));
+            normalError = std::max(normalError, angle * 180.0 / std::numbers::pi);
+            glm::vec2 texCoordDifference = glm::abs(texCoord - sphere.texCoords[i]);
+            texCoordError = std::max(texCoordError, double(std::max(texCoordDifference.x, texCoordDifference.y)));
+        }
+        std::printf("%s,%zu,%d,%.3f,%.3e,%.4f,%.3e\n", layoutCase.name, n, packed.stride,
+            1.0e9 * elapsed / (double(repetitions) * double(n)), positionError, normalError, texCoordError);
+        std::fflush(stdout);
+    }
+
+    const int frames = 20;
+    const int width = 800;
+    const int height = 600;
+    OffscreenContext context;
+    if (!createOffscreenContext(context))
+    {
+        return;
+    }
+    std::printf("renderer,%s\n", (const char*) glGetString(GL_RENDERER));
+    {
+        OffscreenTarget target = createOffscreenTarget(width, height);
+        glEnable(GL_DEPTH_TEST);
+        DirLight dirLight;
+        dirLight.direction = glm::vec3(-0.5f, -1.0f, -0.5f);
+        Material material(glm::vec3(0.1f, 0.1f, 0.8f));
+        Camera camera;
+        camera.position = glm::vec3(0.0f, 0.0f, 12.0f);
+        camera.updateView();
+
+        Shader meshShader = Shader();
+        meshShader.compileVertexShader("shaders/mesh_vert.glsl");
+        meshShader.compileFragmentShader("shaders/mesh_frag.glsl");
+        meshShader.compileFragmentShader("shaders/lighting_frag.glsl");
+        meshShader.linkShaders();
+        meshShader.use();
+        setInt(meshShader.getUniform("numSpotLights"), 0);
+        setInt(meshShader.getUniform("numPointLights"), 0);
+        setInt(meshShader.getUniform("numDirLights"), 1);
+        setDirLight(meshShader.getDirLightUniform("dirLights[0]"), dirLight);
+        setMaterial(meshShader.getMaterialUniform("material"), material);
+        setCamera(meshShader.getCameraUniform("camera"), camera);
+        setBool(meshShader.getUniform("renderInstanced"), true);
+        VertexFormatUniform vertexFormatUniform = meshShader.getVertexFormatUniform("vertexFormat");
+
+        // A 5 x 5 grid of spheres, each about half a unit across
+        std::vector<glm::mat4> models;
+        for (int x = -2; x <= 2; x++)
+        {
+            for (int y = -2; y <= 2; y++)
+            {
+                models.push_back(calculateModelMatrix(glm::vec3(1.6f * x, 1.6f * y, 0.0f), glm::vec3(0.3f * x, 0.2f * y, 0.0f), glm::vec3(0.7f)));
+            }
+        }
+        std::vector<uint8_t> reference(std::size_t(width) * height * 4);
+        std::vector<uint8_t> pixels(reference.size());
+
+        Mesh drawnSphere = uvSphere(1.0f, 64, 64);
+        std::printf("layout,instances,vertex_buffer_bytes,frame_ms,mean_difference,max_difference\n");
+        for (const LayoutCase& layoutCase : cases)
+        {
+            drawnSphere.vertexLayout = layoutCase.layout;
+            drawnSphere.bufferToGPU();
+            setVertexFormat(vertexFormatUniform, drawnSphere);
+            std::vector<double> frameTimes;
+            for (int frame = 0; frame < frames + 1; frame++)
+            {
+                glFinish();
+                Clock::time_point start = Clock::now();
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                drawnSphere.drawInstanced(models);
+                glFinish();
+                Clock::time_point finished = Clock::now();
+                if (frame > 0)
+                    frameTimes.push_back(millisecondsBetween(start, finished));
+            }
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            if (&layoutCase == &cases[0])
+                reference = pixels;
+            double totalDifference = 0.0;
+            int maxDifference = 0;
+            for (std::size_t k = 0; k < pixels.size(); k++)
+            {
+                int difference = std::abs(int(pixels[k]) - int(reference[k]));
+                totalDifference += difference;
+                maxDifference = std::max(maxDifference, difference);
+            }
+            std::printf("%s,%zu,%zu,%.3f,%.4f,%d\n", layoutCase.name, models.size(), drawnSphere.getVertexBufferBytes(), median(frameTimes),
+                        totalDifference / pixels.size(), maxDifference);
+            std::fflush(stdout);
+        }
+        deleteOffscreenTarget(target);
+    }
+    destroyOffscreenContext(context);
+}
+
+// Every corner its own vertex, the way files come without their duplicates joined
+static Mesh unweldedCopy(const Mesh& mesh)
+{
+    Mesh soup;
+    for (unsigned int index : mesh.indices)
+    {
+        soup.indices.push_back((unsigned int) soup.vertices.size());
+        soup.vertices.push_back(mesh.vertices[index]);
+        soup.normals.push_back(mesh.normals[index]);
+        soup.texCoords.push_back(mesh.texCoords[index]);
+    }
+    return soup;
+}
+
+// Welding and the load time pass (weldVertices, optimizeMesh) on typical
+// meshes: vertex counts, time, ACMR, and the GPU vertex and index buffer
+// sizes, the indices 16-bit wherever they fit. Then each mesh drawn 25 times
+// instanced before and after, frame time and the mean and max difference
+// per channel in 8-bit steps.
+static void benchMeshes()
+{
+    const int frames = 10;
+    const int width = 800;
+    const int height = 600;
+    struct MeshCase
+    {
+        const char* name;
+        Mesh mesh;
+        WeldSettings weld;
+    };
+    WeldSettings untextured;
+    untextured.texCoordEpsilon = -1.0f;
+    std::vector<MeshCase> cases;
+    cases.push_back({ "particle-sphere-10", uvSphere(1.0f, 10, 10), untextured });
+    cases.push_back({ "sphere-64", uvSphere(1.0f, 64, 64), WeldSettings() });
+    cases.push_back({ "sphere-64-unwelded", unweldedCopy(uvSphere(1.0f, 64, 64)), WeldSettings() });
+    cases.push_back({ "plane-256", uvPlane(2.0f, 256, 256), WeldSettings() });
+    cases.push_back({ "plane-300", uvPlane(2.0f, 300, 300), WeldSettings() });
+
+    OffscreenContext context;
+    if (!createOffscreenContext(context))
+    {
+        return;
+    }
+    std::printf("renderer,%s\n", (const char*) glGetString(GL_RENDERER));
+    {
+        OffscreenTarget target = createOffscreenTarget(width, height);
+        glEnable(GL_DEPTH_TEST);
+        DirLight dirLight;
+        dirLight.direction = glm::vec3(-0.5f, -1.0f, -0.5f);
+        Material material(glm::vec3(0.1f, 0.1f, 0.8f));
+        Camera camera;
+        camera.position = glm::vec3(0.0f, 0.0f, 12.0f);
+        camera.updateView();
+
+        Shader meshShader = Shader();
+        meshShader.compileVertexShader("shaders/mesh_vert.glsl");
+        meshShader.compileFragmentShader("shaders/mesh_frag.glsl");
+        meshShader.compileFragmentShader("shaders/lighting_frag.glsl");
+        meshShader.linkShaders();
+        meshShader.use();
+        setInt(meshShader.getUniform("numSpotLights"), 0);
+        setInt(meshShader.getUniform("numPointLights"), 0);
+        setInt(meshShader.getUniform("numDirLights"), 1);
+        setDirLight(meshShader.getDirLightUniform("dirLights[0]"), dirLight);
+        setMaterial(meshShader.getMaterialUniform("material"), material);
+        setCamera(meshShader.getCameraUniform("camera"), camera);
+        setBool(meshShader.getUniform("renderInstanced"), true);
+        VertexFormatUniform vertexFormatUniform = meshShader.getVertexFormatUniform("vertexFormat");
+
+        // A 5 x 5 grid, tilted so the planes face the camera
+        std::vector<glm::mat4> models;
+        for (int x = -2; x <= 2; x++)
+        {
+            for (int y = -2; y <= 2; y++)
+            {
+                models.push_back(calculateModelMatrix(glm::vec3(1.6f * x, 1.6f * y, 0.0f), glm::vec3(1.2f + 0.3f * x, 0.2f * y, 0.0f), glm::vec3(0.7f)));
+            }
+        }
+        std::vector<uint8_t> reference(std::size_t(width) * height * 4);
+        std::vector<uint8_t> pixels(reference.size());
+
+        // Draws mesh as buffered, frame time in ms, the image in pixels
+        auto drawFrames = [&](Mesh& mesh)
+        {
+            setVertexFormat(vertexFormatUniform, mesh);
+            std::vector<double> frameTimes;
+            for (int frame = 0; frame < frames + 1; frame++)
+            {
+                glFinish();
+                Clock::time_point start = Clock::now();
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                mesh.drawInstanced(models);
+                glFinish();
+                Clock::time_point finished = Clock::now();
+                if (frame > 0)
+                    frameTimes.push_back(millisecondsBetween(start, finished));
+            }
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            return median(frameTimes);
+        };
+
+        std::printf("mesh,vertices_before,vertices_after,triangles,weld_ms,optimize_ms,acmr_before,acmr_after,"
+                    "vertex_bytes_before,vertex_bytes_after,index_bytes_before,index_bytes_after,frame_ms_before,frame_ms_after,"
+                    "mean_difference,max_difference\n");
+        for (MeshCase& meshCase : cases)
+        {
+            Mesh& original = meshCase.mesh;
+            original.bufferToGPU();
+            // Every mesh used to be 32-bit indices, whatever its size
+            std::size_t indexBytesBefore = sizeof(unsigned int) * original.indices.size();
+            double frameBefore = drawFrames(original);
+            reference = pixels;
+
+            Mesh processed(original);
+            Clock::time_point start = Clock::now();
+            weldVertices(processed, meshCase.weld);
+            Clock::time_point welded = Clock::now();
+            MeshOptimizeStats stats;
+            optimizeMesh(processed, MeshOptimizeSettings(), &stats);
+            processed.bufferToGPU();
+            double frameAfter = drawFrames(processed);
+
+            double totalDifference = 0.0;
+            int maxDifference = 0;
+            for (std::size_t k = 0; k < pixels.size(); k++)
+            {
+                int difference = std::abs(int(pixels[k]) - int(reference[k]));
+                totalDifference += difference;
+                maxDifference = std::max(maxDifference, difference);
+            }
+            std::printf("%s,%zu,%zu,%zu,%.3f,%.3f,%.3f,%.3f,%zu,%zu,%zu,%zu,%.3f,%.3f,%.4f,%d\n", meshCase.name,
+                        original.vertices.size(), processed.vertices.size(), processed.indices.size() / 3,
+                        millisecondsBetween(start, welded), 1000.0 * stats.seconds,
+                        analyzeVertexCache(original.indices, original.vertices.size(), 16).acmr, stats.cacheAfter.acmr,
+                        original.getVertexBufferBytes(), processed.getVertexBufferBytes(),
+                        indexBytesBefore, processed.getIndexBufferBytes(), frameBefore, frameAfter,
+                        totalDifference / pixels.size(), maxDifference);
+            std::fflush(stdout);
+        }
+        deleteOffscreenTarget(target);
+    }
+    destroyOffscreenContext(context);
+}
+
+// meshCount distinct spheres (4 to 19 segments) drawn three ways: every Mesh
+// with its own VAO and buffers, from one GeometryArena bound once with a
+// draw per mesh, and from the arena in one multiDraw. CPU time to submit,
+// frame time, and the largest difference from the per-Mesh image in 8-bit
+// steps. Then every other mesh is removed and the arena defragmented: free
+// blocks and the largest of them before and after, the defragment time, and
+// the image once the meshes are added back, against the first.
+static void benchArena(std::size_t meshCount)
+{
+    const int frames = 10;
+    const int width = 800;
+    const int height = 600;
+    meshCount = std::max<std::size_t>(meshCount, 1);
+    OffscreenContext context;
+    if (!createOffscreenContext(context))
+    {
+        return;
+    }
+    std::printf("renderer,%s\n", (const char*) glGetString(GL_RENDERER));
+    {
+        OffscreenTarget target = createOffscreenTarget(width, height);
+        glEnable(GL_DEPTH_TEST);
+        DirLight dirLight;
+        dirLight.direction = glm::vec3(-0.5f, -1.0f, -0.5f);
+        Material material(glm::vec3(0.1f, 0.1f, 0.8f));
+        Camera camera;
+        camera.position = glm::vec3(0.0f, 0.0f, 12.0f);
+        camera.updateView();
+
+        Shader meshShader = Shader();
+        meshShader.compileVertexShader("shaders/mesh_vert.glsl");
+        meshShader.compileFragmentShader("shaders/mesh_frag.glsl");
+        meshShader.compileFragmentShader("shaders/lighting_frag.glsl");
+        meshShader.linkShaders();
+        meshShader.use();
+        setInt(meshShader.getUniform("numSpotLights"), 0);
+        setInt(meshShader.getUniform("numPointLights"), 0);
+        setInt(meshShader.getUniform("numDirLights"), 1);
+        setDirLight(meshShader.getDirLightUniform("dirLights[0]"), dirLight);
+        setMaterial(meshShader.getMaterialUniform("material"), material);
+        setCamera(meshShader.getCameraUniform("camera"), camera);
+        GLint renderInstancedUniform = meshShader.getUniform("renderInstanced");
+        MeshUniform meshUniform = meshShader.getMeshUniform("mesh");
+        VertexFormatUniform vertexFormatUniform = meshShader.getVertexFormatUniform("vertexFormat");
+
+        // A square grid filling the view, every sphere its own mesh
+        int side = std::max(int(std::ceil(std::sqrt(double(meshCount)))), 1);
+        float spacing = 9.0f / side;
+        std::vector<Mesh> meshes;
+        std::vector<glm::mat4> models;
+        meshes.reserve(meshCount);
+        for (std::size_t i = 0; i < meshCount; i++)
+        {
+            int segments = 4 + int(i % 16);
+            meshes.push_back(uvSphere(0.4f * spacing, segments, segments));
+            glm::vec3 position(spacing * (float(i % side) - 0.5f * (side - 1)), spacing * (float(i / side) - 0.5f * (side - 1)), 0.0f);
+            models.push_back(calculateModelMatrix(position, glm::vec3(0.3f, 0.2f * float(i % 7), 0.0f), glm::vec3(1.0f)));
+        }
+        std::vector<glm::mat3> normalMatrices;
+        for (const glm::mat4& model : models)
+        {
+            normalMatrices.push_back(calculateNormalMatrix(model));
+        }
+
+        std::vector<uint8_t> reference(std::size_t(width) * height * 4);
+        std::vector<uint8_t> pixels(reference.size());
+        auto compare = [&]()
+        {
+            int maxDifference = 0;
+            for (std::size_t k = 0; k < pixels.size(); k++)
+            {
+                maxDifference = std::max(maxDifference, std::abs(int(pixels[k]) - int(reference[k])));
+            }
+            return maxDifference;
+        };
+        // Median CPU submit and whole frame times in ms, the image in pixels
+        auto timeFrames = [&](const std::function<void()>& drawAll, double& submitMs, double& frameMs)
+        {
+            std::vector<double> submitTimes;
+            std::vector<double> frameTimes;
+            for (int frame = 0; frame < frames + 1; frame++)
+            {
+                glFinish();
+                Clock::time_point start = Clock::now();
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                drawAll();
+                Clock::time_point submitted = Clock::now();
+                glFinish();
+                Clock::time_point finished = Clock::now();
+                if (frame > 0)
+                {
+                    submitTimes.push_back(millisecondsBetween(start, submitted));
+                    frameTimes.push_back(millisecondsBetween(start, finished));
+                }
+            }
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            submitMs = median(submitTimes);
+            frameMs = median(frameTimes);
+        };
+
+        std::printf("path,meshes,draw_calls,submit_ms,frame_ms,max_difference\n");
+        double submitMs;
+        double frameMs;
+        for (Mesh& mesh : meshes)
+        {
+            mesh.bufferToGPU();
+        }
+        setBool(renderInstancedUniform, false);
+        setVertexFormat(vertexFormatUniform, meshes[0]);
+        timeFrames([&]()
+        {
+            for (std::size_t i = 0; i < meshes.size(); i++)
+            {
+                setMesh(meshUniform, models[i], normalMatrices[i]);
+                meshes[i].draw();
+            }
+        }, submitMs, frameMs);
+        reference = pixels;
+        std::printf("mesh-vaos,%zu,%zu,%.3f,%.3f,%d\n", meshCount, meshCount, submitMs, frameMs, 0);
+
+        GeometryArenaSettings settings;
+        settings.vertexCapacity = 1024;
+        settings.indexCapacity = 4096;
+        GeometryArena arena(settings);
+        std::vector<GeometryHandle> handles;
+        Clock::time_point addStart = Clock::now();
+        for (const Mesh& mesh : meshes)
+        {
+            handles.push_back(arena.add(mesh));
+        }
+        double addMs = millisecondsBetween(addStart, Clock::now());
+        setVertexFormat(vertexFormatUniform, arena);
+        timeFrames([&]()
+        {
+            arena.bind();
+            for (std::size_t i = 0; i < handles.size(); i++)
+            {
+                setMesh(meshUniform, models[i], normalMatrices[i]);
+                arena.draw(handles[i]);
+            }
+            glBindVertexArray(0);
+        }, submitMs, frameMs);
+        std::printf("arena-draws,%zu,%zu,%.3f,%.3f,%d\n", meshCount, meshCount, submitMs, frameMs, compare());
+
+        setBool(renderInstancedUniform, true);
+        timeFrames([&]()
+        {
+            arena.bind();
+            arena.multiDraw(handles, models);
+            glBindVertexArray(0);
+        }, submitMs, frameMs);
+        std::printf("arena-multidraw,%zu,%d,%.3f,%.3f,%d\n", meshCount, 1, submitMs, frameMs, compare());
+        std::fflush(stdout);
+
+        for (std::size_t i = 0; i < handles.size(); i += 2)
+        {
+            arena.remove(handles[i]);
+        }
+        const FreeListAllocator& vertices = arena.getVertexAllocator();
+        std::size_t fragmentedBlocks = vertices.getFreeBlockCount();
+        std::size_t fragmentedLargest = vertices.getLargestFreeBlock();
+        glFinish();
+        Clock::time_point defragmentStart = Clock::now();
+        arena.defragment();
+        glFinish();
+        double defragmentMs = millisecondsBetween(defragmentStart, Clock::now());
+        std::size_t defragmentedBlocks = vertices.getFreeBlockCount();
+        std::size_t defragmentedLargest = vertices.getLargestFreeBlock();
+        for (std::size_t i = 0; i < handles.size(); i += 2)
+        {
+            handles[i] = arena.add(meshes[i]);
+        }
+        timeFrames([&]()
+        {
+            arena.bind();
+            arena.multiDraw(handles, models);
+            glBindVertexArray(0);
+        }, submitMs, frameMs);
+        std::printf("add_ms,%.3f\n", addMs);
+        std::printf("capacity_vertices,%zu,used,%zu\n", vertices.getCapacity(), vertices.getUsed());
+        std::printf("free_blocks_after_removing_half,%zu,largest,%zu\n", fragmentedBlocks, fragmentedLargest);
+        std::printf("defragment_ms,%.3f\n", defragmentMs);
+        std::printf("free_blocks_after_defragment,%zu,largest,%zu\n", defragmentedBlocks, defragmentedLargest);
+        std::printf("max_difference_after_adding_back,%d\n", compare());
+        std::fflush(stdout);
+        deleteOffscreenTarget(target);
+    }
+    destroyOffscreenContext(context);
+}
+
+static std::size_t meshCopies = 0;
+static std::size_t meshBytesCopied = 0;
+
+static std::size_t meshBytes(const Mesh& mesh)
+{
+    return sizeof(glm::vec3) * (mesh.vertices.size() + mesh.normals.size()) +
+           sizeof(glm::vec2) * mesh.texCoords.size() + sizeof(unsigned int) * mesh.indices.size();
+}
+
+// Mesh as it was before it could move: with only a copy constructor, every
+// return, push_back and vector growth deep copies the vertex vectors
+struct CopyOnlyMesh : Mesh
+{
+    CopyOnlyMesh() = default;
+    CopyOnlyMesh(const CopyOnlyMesh& other) : Mesh(other)
+    {
+        meshCopies++;
+        meshBytesCopied += meshBytes(other);
+    }
+};
+
+// Mesh as it is, counting the copies it still makes (there should be none)
+struct CountedMesh : Mesh
+{
+    CountedMesh() = default;
+    CountedMesh(const CountedMesh& other) : Mesh(other)
+    {
+        meshCopies++;
+        meshBytesCopied += meshBytes(other);
+    }
+    CountedMesh(CountedMesh&&) noexcept = default;
+};
+
+// Stands in for Model::processMesh: a new Mesh filled from the importer's arrays, returned by value
+template <typename MeshType>
+static MeshType importMesh(const Mesh& source)
+{
+    MeshType mesh;
+    for (std::size_t i = 0; i < source.vertices.size(); i++)
+    {
+        mesh.vertices.push_back(source.vertices[i]);
+        mesh.normals.push_back(source.normals[i]);
+        mesh.texCoords.push_back(source.texCoords[i]);
+    }
+    mesh.indices = source.indices;
+    return mesh;
+}
+
+// A model of meshCount submeshes loaded the way Model::processNode does,
+// into a vector that grows as it goes, with the old copy-only Mesh and with
+// the move-aware one: load time, mesh copies and the bytes they copied.
+// Then Textures created one at a time into a growing vector, like
+// TextureManager, and how many of their GL names are still textures after.
+static void benchLoad(std::size_t meshCount)
+{
+    const int runs = 5;
+    meshCount = std::max<std::size_t>(meshCount, 1);
+    Mesh source = uvSphere(1.0f, 128, 128);
+    std::printf("path,submeshes,vertices_per_mesh,load_ms,mesh_copies,megabytes_copied\n");
+    auto run = [&](const char* path, auto importOne)
+    {
+        std::vector<double> times;
+        std::size_t copies = 0;
+        std::size_t bytes = 0;
+        for (int r = 0; r < runs; r++)
+        {
+            meshCopies = 0;
+            meshBytesCopied = 0;
+            Clock::time_point start = Clock::now();
+            std::size_t loaded = importOne();
+            times.push_back(millisecondsBetween(start, Clock::now()));
+            copies = meshCopies;
+            bytes = meshBytesCopied;
+            if (loaded != meshCount)
+            {
+                std::printf("ERROR: %s loaded %zu meshes\n", path, loaded);
+            }
+        }
+        std::printf("%s,%zu,%zu,%.3f,%zu,%.1f\n", path, meshCount, source.vertices.size(), median(times),
+                    copies, double(bytes) / (1024.0 * 1024.0));
+    };
+    run("copy-only", [&]()
+    {
+        std::vector<CopyOnlyMesh> meshes;
+        for (std::size_t i = 0; i < meshCount; i++)
+        {
+            meshes.push_back(importMesh<CopyOnlyMesh>(source));
+        }
+        return meshes.size();
+    });
+    run("move", [&]()
+    {
+        std::vector<CountedMesh> meshes;
+        for (std::size_t i = 0; i < meshCount; i++)
+        {
+            meshes.push_back(importMesh<CountedMesh>(source));
+        }
+        return meshes.size();
+    });
+    std::fflush(stdout);
+
+    OffscreenContext context;
+    if (!createOffscreenContext(context))
+    {
+        return;
+    }
+    {
+        const std::size_t textureCount = 256;
+        std::vector<Texture> textures;
+        for (std::size_t i = 0; i < textureCount; i++)
+        {
+            textures.emplace_back();
+            glBindTexture(GL_TEXTURE_2D, textures.back().id.get());
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        std::size_t live = 0;
+        for (const Texture& texture : textures)
+        {
+            live += glIsTexture(texture.id.get()) ? 1 : 0;
+        }
+        std::printf("textures,%zu,live_names,%zu\n", textureCount, live);
+        std::fflush(stdout);
+    }
+    destroyOffscreenContext(context);
+}
+
+// The charge density volume: splat and upload times, then the frame time of
+// the march at full and half resolution, with and without empty space
+// skipping, on two offset Gaussian clouds (electrons and protons) behind a
+// row of opaque impostor spheres. Each image is compared against the full
+// resolution march without skipping, mean and max difference per channel in
+// 8-bit steps.
+static void benchVolume(std::size_t particleCount, JobSystem& jobs)
+{
+    const int frames = 20;
+    const int width = 800;
+    const int height = 600;
+    OffscreenContext context;
+    if (!createOffscreenContext(context))
+    {
+        return;
+    }
+    std::printf("renderer,%s\n", (const char*) glGetString(GL_RENDERER));
+
+    {
+        OffscreenTarget target = createOffscreenTarget(width, height);
+        glEnable(GL_DEPTH_TEST);
+        Camera camera;
+        camera.position = glm::vec3(0.0f, 0.0f, 15.0f);
+        camera.updateView();
+
+        DirLight dirLight;
+        dirLight.direction = glm::vec3(-0.5f, -1.0f, -0.5f);
+        Shader impostorShader = Shader();
+        impostorShader.compileVertexShader("shaders/particleImpostor_vert.glsl");
+        impostorShader.compileFragmentShader("shaders/particleImpostor_frag.glsl");
+        impostorShader.compileFragmentShader("shaders/lighting_frag.glsl");
+        impostorShader.linkShaders();
+        impostorShader.use();
+        setInt(impostorShader.getUniform("numSpotLights"), 0);
+        setInt(impostorShader.getUniform("numPointLights"), 0);
+        setInt(impostorShader.getUniform("numDirLights"), 1);
+        setDirLight(impostorShader.getDirLightUniform("dirLights[0]"), dirLight);
+        setMaterial(impostorShader.getMaterialUniform("material"), Material(glm::vec3(0.8f)));
+        setCamera(impostorShader.getCameraUniform("camera"), camera);
+        setBool(impostorShader.getUniform("useParticleBuffer"), false);
+        setFloat(impostorShader.getUniform("radius"), 0.4f);
+        SphereImpostors impostors;
+        std::vector<glm::vec3> occluders;
+        for (int i = 0; i < 9; i++)
+        {
+            occluders.push_back(glm::vec3(float(i) - 4.0f, -0.5f, 4.0f));
+        }
+
+        std::mt19937 rng(9);
+        std::normal_distribution<float> spread(0.0f, 1.0f);
+        std::vector<glm::vec3> positions(particleCount);
+        std::vector<float> charges(particleCount);
+        for (std::size_t i = 0; i < particleCount; i++)
+        {
+            bool electron = i % 2 == 0;
+            positions[i] = glm::vec3(electron ? -2.5f : 2.5f, 0.0f, 0.0f) + glm::vec3(spread(rng), spread(rng), spread(rng));
+            charges[i] = electron ? -1.0f : 1.0f;
+        }
+
+        ChargeDensityVolume volume(64, 8);
+        std::vector<double> splatTimes;
+        std::vector<double> uploadTimes;
+        for (int frame = 0; frame < frames + 1; frame++)
+        {
+            Clock::time_point start = Clock::now();
+            volume.splat(positions, charges, &jobs);
+            Clock::time_point splatted = Clock::now();
+            volume.upload();
+            glFinish();
+            Clock::time_point uploaded = Clock::now();
+            if (frame == 0)
+                continue;
+            splatTimes.push_back(millisecondsBetween(start, splatted));
+            uploadTimes.push_back(millisecondsBetween(splatted, uploaded));
+        }
+        std::printf("particles,grid,splat_ms,upload_ms\n");
+        std::printf("%zu,%u,%.3f,%.3f\n", particleCount, volume.gridSize, median(splatTimes), median(uploadTimes));
+
+        VolumeRenderer renderer;
+        renderer.loadShaders("shaders/fullscreen_vert.glsl", "shaders/volumeRaymarch_frag.glsl", "shaders/volumeUpsample_frag.glsl");
+        std::vector<unsigned char> reference;
+        std::vector<unsigned char> pixels(std::size_t(width) * height * 4);
+        std::printf("downsample,skip_empty,frame_ms,mean_difference,max_difference\n");
+        for (int downsample = 1; downsample <= 2; downsample++)
+        {
+            for (int skip = 0; skip < 2; skip++)
+            {
+                renderer.downsample = downsample;
+                renderer.skipEmptySpace = skip == 1;
+                std::vector<double> frameTimes;
+                for (int frame = 0; frame < frames + 1; frame++)
+                {
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    impostorShader.use();
+                    impostors.draw(occluders);
+                    glFinish();
+                    Clock::time_point start = Clock::now();
+                    renderer.render(volume, camera, width, height);
+                    glFinish();
+                    Clock::time_point finished = Clock::now();
+                    if (frame == 0)
+                        continue;
+                    frameTimes.push_back(millisecondsBetween(start, finished));
+                }
+                glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+                if (reference.empty())
+                    reference = pixels;
+                double differenceSum = 0.0;
+                int maxDifference = 0;
+                for (std::size_t i = 0; i < pixels.size(); i++)
+                {
+                    if (i % 4 == 3)
+                        continue;
+                    int difference = std::abs(int(pixels[i]) - int(reference[i]));
+                    differenceSum += difference;
+                    maxDifference = std::max(maxDifference, difference);
+                }
+                std::printf("%d,%d,%.3f,%.4f,%d\n", downsample, skip, median(frameTimes),
+                    differenceSum / (double(width) * height * 3.0), maxDifference);
+                std::fflush(stdout);
+            }
+        }
+        deleteOffscreenTarget(target);
+    }
+
+    destroyOffscreenContext(context);
+}
+
+// Particle trails: the persistently mapped ring, which writes one row of
+// positions a frame, against re-uploading the whole history every frame the
+// way a rebuilt line mesh would, both drawn by the same shader. cpu_ms is
+// the time to record and submit, frame_ms includes waiting for the GPU. The
+// final images must match, max_difference in 8-bit steps.
+static void benchTrails(std::size_t particleCount)
+{
+    const int frames = 60;
+    const int width = 800;
+    const int height = 600;
+    const uint32_t trailLength = 64;
+    OffscreenContext context;
+    if (!createOffscreenContext(context))
+    {
+        return;
+    }
+    std::printf("renderer,%s\n", (const char*) glGetString(GL_RENDERER));
+
+    {
+        OffscreenTarget target = createOffscreenTarget(width, height);
+        Camera camera;
+        camera.position = glm::vec3(0.0f, 8.0f, 30.0f);
+        camera.front = glm::normalize(-camera.position);
+        camera.updateView();
+
+        ParticleSystem particles;
+        makePlasma(particles, particleCount, 20.0f, 13);
+        std::vector<glm::vec3> start(particleCount);
+        std::vector<float> charges(particleCount);
+        for (std::size_t i = 0; i < particleCount; i++)
+        {
+            start[i] = particles.position(i);
+            charges[i] = particles.charge[i];
+        }
+        // Every particle circles the y axis, the inner ones faster
+        auto positionsAt = [&start](int frame, std::vector<glm::vec3>& positions)
+        {
+            positions.resize(start.size());
+            for (std::size_t i = 0; i < start.size(); i++)
+            {
+                glm::vec3 p = start[i];
+                float angle = 0.02f * float(frame) * 10.0f / (glm::length(glm::vec2(p.x, p.z)) + 1.0f);
+                float c = std::cos(angle);
+                float s = std::sin(angle);
+                positions[i] = glm::vec3(c * p.x - s * p.z, p.y, s * p.x + c * p.z);
+            }
+        };
+
+        ParticleTrails trails;
+        trails.trailLength = trailLength;
+        trails.loadShaders("shaders/particleTrail_vert.glsl", "shaders/particleTrail_frag.glsl");
+        // The same shader fed a history uploaded whole, oldest row first
+        Shader rebuildShader = Shader();
+        rebuildShader.compileVertexShader("shaders/particleTrail_vert.glsl");
+        rebuildShader.compileFragmentShader("shaders/particleTrail_frag.glsl");
+        rebuildShader.linkShaders();
+        GLint rebuildProjectionUniform = rebuildShader.getUniform("projection");
+        GLint rebuildViewUniform = rebuildShader.getUniform("view");
+        GLint rebuildRowStrideUniform = rebuildShader.getUniform("rowStride");
+        GLint rebuildRowCountUniform = rebuildShader.getUniform("rowCount");
+        GLint rebuildNewestRowUniform = rebuildShader.getUniform("newestRow");
+        GLint rebuildPointsPerTrailUniform = rebuildShader.getUniform("pointsPerTrail");
+        GLint rebuildMaxSegmentLengthUniform = rebuildShader.getUniform("maxSegmentLength");
+        GLint rebuildNegativeColorUniform = rebuildShader.getUniform("negativeColor");
+        GLint rebuildPositiveColorUniform = rebuildShader.getUniform("positiveColor");
+        GLuint rebuildBuffer;
+        glGenBuffers(1, &rebuildBuffer);
+        GLuint emptyVAO;
+        glGenVertexArrays(1, &emptyVAO);
+
+        std::vector<glm::vec3> positions;
+        std::vector<std::vector<glm::vec4>> rows(trailLength, std::vector<glm::vec4>(particleCount));
+        std::vector<glm::vec4> rebuilt;
+        std::vector<unsigned char> reference;
+        std::vector<unsigned char> pixels(std::size_t(width) * height * 4);
+        std::printf("path,particles,trail_length,record_ms,frame_ms,max_difference\n");
+        for (int ring = 1; ring >= 0; ring--)
+        {
+            std::vector<double> recordTimes;
+            std::vector<double> frameTimes;
+            int warmup = int(trailLength);
+            for (int frame = 0; frame < warmup + frames; frame++)
+            {
+                positionsAt(frame, positions);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                glFinish();
+                Clock::time_point begin = Clock::now();
+                Clock::time_point recorded;
+                if (ring == 1)
+                {
+                    trails.record(positions, charges);
+                    recorded = Clock::now();
+                    trails.draw(camera, 1.0e30f);
+                }
+                else
+                {
+                    std::vector<glm::vec4>& row = rows[std::size_t(frame) % trailLength];
+                    for (std::size_t i = 0; i < particleCount; i++)
+                    {
+                        row[i] = glm::vec4(positions[i], charges[i]);
+                    }
+                    uint32_t recordedRows = std::min<uint32_t>(uint32_t(frame) + 1, trailLength);
+                    rebuilt.clear();
+                    for (uint32_t age = recordedRows; age-- > 0;)
+                    {
+                        const std::vector<glm::vec4>& source = rows[std::size_t(frame - int(age)) % trailLength];
+                        rebuilt.insert(rebuilt.end(), source.begin(), source.end());
+                    }
+                    glBindBuffer(GL_SHADER_STORAGE_BUFFER, rebuildBuffer);
+                    glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(rebuilt.size() * sizeof(glm::vec4)), rebuilt.data(), GL_STREAM_DRAW);
+                    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+                    recorded = Clock::now();
+                    if (recordedRows >= 2)
+                    {
+                        glEnable(GL_BLEND);
+                        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                        glDepthMask(GL_FALSE);
+                        rebuildShader.use();
+                        setMat4(rebuildProjectionUniform, camera.projection);
+                        setMat4(rebuildViewUniform, camera.view);
+                        setUInt(rebuildRowStrideUniform, (unsigned int) particleCount);
+                        setUInt(rebuildRowCountUniform, recordedRows);
+                        setUInt(rebuildNewestRowUniform, recordedRows - 1);
+                        setUInt(rebuildPointsPerTrailUniform, recordedRows);
+                        setFloat(rebuildMaxSegmentLengthUniform, 1.0e30f);
+                        setVec3(rebuildNegativeColorUniform, trails.negativeColor);
+                        setVec3(rebuildPositiveColorUniform, trails.positiveColor);
+                        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, rebuildBuffer);
+                        glBindVertexArray(emptyVAO);
+                        glDrawArrays(GL_LINES, 0, GLsizei(particleCount * (recordedRows - 1) * 2));
+                        glBindVertexArray(0);
+                        glDepthMask(GL_TRUE);
+                        glDisable(GL_BLEND);
+                    }
+                }
+                glFinish();
+                Clock::time_point finished = Clock::now();
+                if (frame < warmup)
+                    continue;
+                recordTimes.push_back(millisecondsBetween(begin, recorded));
+                frameTimes.push_back(millisecondsBetween(begin, finished));
+            }
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            if (reference.empty())
+                reference = pixels;
+            int maxDifference = 0;
+            for (std::size_t i = 0; i < pixels.size(); i++)
+            {
+                maxDifference = std::max(maxDifference, std::abs(int(pixels[i]) - int(reference[i])));
+            }
+            std::printf("%s,%zu,%u,%.3f,%.3f,%d\n", ring == 1 ? "ring" : "rebuild", particleCount, trailLength,
+                median(recordTimes), median(frameTimes), maxDifference);
+            std::fflush(stdout);
+        }
+        glDeleteVertexArrays(1, &emptyVAO);
+        glDeleteBuffers(1, &rebuildBuffer);
+        deleteOffscreenTarget(target);
+    }
+
+    destroyOffscreenContext(context);
+}
+
+// The point cloud streamer. Builds an octree file from a synthetic terrain
+// of pointCount points (build time and throughput), then flies the camera
+// from high above the whole terrain down to skim across it, under a VRAM
+// budget far smaller than the file. Every 30th frame is printed: frame time,
+// what was drawn, resident nodes against the slots the budget holds, loads
+// waiting, and the uploads and evictions so far. resident never exceeding
+// slots is the budget holding.
+static void benchPointCloud(std::size_t pointCount)
+{
+    const int frames = 300;
+    const int width = 800;
+    const int height = 600;
+    const std::size_t budgetBytes = std::size_t(32) << 20;
+    const std::string path = "bench_pointcloud.pcot";
+
+    SyntheticPointSource source(pointCount, 80.0f);
+    PointCloudBuildStats buildStats;
+    if (!buildPointCloud(source, path, PointCloudBuildSettings(), &buildStats))
+    {
+        return;
+    }
+    double buildSeconds = buildStats.boundsSeconds + buildStats.countSeconds + buildStats.distributeSeconds + buildStats.buildSeconds;
+    std::printf("points,chunks,nodes,depth,file_mb,build_seconds,million_points_per_second\n");
+    std::printf("%llu,%zu,%zu,%u,%.1f,%.3f,%.2f\n", (unsigned long long) buildStats.writtenPoints, buildStats.chunkCount,
+        buildStats.nodeCount, buildStats.depth, double(buildStats.writtenPoints) * sizeof(CloudPoint) / (1 << 20),
+        buildSeconds, double(buildStats.inputPoints) / buildSeconds * 1.0e-6);
+    std::fflush(stdout);
+
+    OffscreenContext context;
+    if (!createOffscreenContext(context))
+    {
+        std::remove(path.c_str());
+        return;
+    }
+    std::printf("renderer,%s\n", (const char*) glGetString(GL_RENDERER));
+
+    {
+        OffscreenTarget target = createOffscreenTarget(width, height);
+        glEnable(GL_DEPTH_TEST);
+        Camera camera;
+        camera.farPlane = 500.0f;
+        camera.updateProjection();
+
+        PointCloud cloud;
+        if (cloud.open(path, budgetBytes))
+        {
+            cloud.loadShaders("shaders/pointCloud_vert.glsl", "shaders/pointCloud_frag.glsl");
+            std::printf("budget_mb,slots,points_per_slot\n");
+            std::printf("%.1f,%zu,%u\n", double(cloud.getBudgetBytes()) / (1 << 20), cloud.getSlotCount(),
+                cloud.getHeader().maxNodePoints);
+
+            std::vector<double> frameTimes;
+            std::size_t maxResident = 0;
+            std::printf("frame,frame_ms,nodes_drawn,points_drawn,resident,pending,total_uploads,total_evictions\n");
+            for (int frame = 0; frame < frames; frame++)
+            {
+                float t = float(frame) / float(frames - 1);
+                // Down from overhead, then along the ground looking ahead
+                camera.position = glm::mix(glm::vec3(0.0f, 120.0f, 60.0f), glm::vec3(-30.0f, 8.0f, -30.0f), std::sqrt(t));
+                glm::vec3 lookAt = glm::mix(glm::vec3(0.0f), glm::vec3(-40.0f, 0.0f, -45.0f), t);
+                camera.front = glm::normalize(lookAt - camera.position);
+                camera.updateView();
+
+                glFinish();
+                Clock::time_point start = Clock::now();
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                cloud.update(camera, height);
+                cloud.draw(camera, height);
+                glFinish();
+                Clock::time_point finished = Clock::now();
+                frameTimes.push_back(millisecondsBetween(start, finished));
+
+                const PointCloudStats& stats = cloud.getStats();
+                maxResident = std::max(maxResident, stats.residentNodes);
+                if (frame % 30 == 0 || frame == frames - 1)
+                {
+                    std::printf("%d,%.3f,%zu,%zu,%zu,%zu,%zu,%zu\n", frame, frameTimes.back(), stats.nodesDrawn,
+                        stats.pointsDrawn, stats.residentNodes, stats.pendingLoads, stats.totalUploads, stats.totalEvictions);
+                    std::fflush(stdout);
+                }
+            }
+            std::printf("median_frame_ms,max_frame_ms,max_resident,slots\n");
+            std::printf("%.3f,%.3f,%zu,%zu\n", median(frameTimes), *std::max_element(frameTimes.begin(), frameTimes.end()),
+                maxResident, cloud.getSlotCount());
+            cloud.close();
+        }
+        deleteOffscreenTarget(target);
+    }
+
+    destroyOffscreenContext(context);
+    std::remove(path.c_str());
+}
+
+// One frame of the windowed app split into stages, each timed on its own:
+// a Barnes-Hut step, regenerating the procedural meshes, uploading them,
+// setting the per-frame uniforms, submitting the draws and waiting for the
+// GPU. Times are in milliseconds, one line per stage.
+static void benchFrame(std::size_t particleCount, int frames, JobSystem& jobs)
+{
+    const int warmupFrames = 5;
+    OffscreenContext context;
+    if (!createOffscreenContext(context))
+    {
+        return;
+    }
+    std::printf("renderer,%s\n", (const char*) glGetString(GL_RENDERER));
+
+    {
+        OffscreenTarget target = createOffscreenTarget(800, 600);
+        glEnable(GL_DEPTH_TEST);
+
+        Shader meshShader = Shader();
+        meshShader.compileVertexShader("shaders/mesh_vert.glsl");
+        meshShader.compileFragmentShader("shaders/mesh_frag.glsl");
+        meshShader.compileFragmentShader("shaders/lighting_frag.glsl");
+        meshShader.linkShaders();
+        meshShader.use();
+        MeshUniform meshUniform = meshShader.getMeshUniform("mesh");
+        MaterialUniform materialUniform = meshShader.getMaterialUniform("material");
+        CameraUniform cameraUniform = meshShader.getCameraUniform("camera");
+        SpotLightUniform spotLightUniform = meshShader.getSpotLightUniform("spotLights[0]");
+        PointLightUniform pointLightUniform = meshShader.getPointLightUniform("pointLights[0]");
+        DirLightUniform dirLightUniform = meshShader.getDirLightUniform("dirLights[0]");
+        GLint numSpotLightsUniform = meshShader.getUniform("numSpotLights");
+        GLint numPointLightsUniform = meshShader.getUniform("numPointLights");
+        GLint numDirLightsUniform = meshShader.getUniform("numDirLights");
+        GLint renderInstancedUniform = meshShader.getUniform("renderInstanced");
+
+        SpotLight spotLight;
+        spotLight.position = glm::vec3(0.0f, 5.0f, 20.0f);
+        spotLight.direction = glm::vec3(0.0f, 0.0f, -1.0f);
+        PointLight pointLight;
+        pointLight.position = glm::vec3(5.0f, 5.0f, 5.0f);
+        DirLight dirLight;
+        dirLight.direction = glm::vec3(-0.5f, -1.0f, -0.5f);
+        Material electronMaterial(glm::vec3(0.1f, 0.1f, 0.8f));
+        Material protonMaterial(glm::vec3(0.8f, 0.1f, 0.1f));
+        Material planeMaterial(glm::vec3(0.5f, 0.5f, 0.5f));
+
+        Camera camera;
+        camera.position = glm::vec3(0.0f, 0.0f, 30.0f);
+
+        ParticleSystem particles;
+        makePlasma(particles, particleCount, 20.0f, 6);
+        BarnesHutSolver solver(0.5f, &jobs);
+        Integrator integrator(1.0e-4f, 1, IntegrationScheme::VelocityVerlet, &jobs);
+        std::vector<glm::mat4> electronModels;
+        std::vector<glm::mat4> protonModels;
+
+        const char* stageNames[] = { "particle_step", "mesh_generation", "mesh_upload", "uniform_setup", "draw_submission", "gpu_wait", "frame_total" };
+        const int stageCount = sizeof(stageNames) / sizeof(stageNames[0]);
+        std::vector<double> stageTimes[stageCount];
+
+        for (int frame = 0; frame < warmupFrames + frames; frame++)
+        {
+            Clock::time_point t0 = Clock::now();
+            integrator.step(particles, solver);
+
+            Clock::time_point t1 = Clock::now();
+            // Constructed every frame, as a scene rebuild would. Never assigned:
+            // copying a Mesh that has been uploaded would share its GL names.
+            Mesh electron = uvSphere(0.05f, 10, 10);
+            Mesh proton = uvSphere(0.1f, 16, 16);
+            Mesh plane = uvPlane(40.0f, 64, 64);
+
+            Clock::time_point t2 = Clock::now();
+            electron.bufferToGPU();
+            proton.bufferToGPU();
+            plane.bufferToGPU();
+
+            Clock::time_point t3 = Clock::now();
+            camera.updateProjection();
+            camera.updateView();
+            meshShader.use();
+            setSpotLight(spotLightUniform, spotLight);
+            setPointLight(pointLightUniform, pointLight);
+            setDirLight(dirLightUniform, dirLight);
+            setCamera(cameraUniform, camera);
+            setInt(numSpotLightsUniform, 1);
+            setInt(numPointLightsUniform, 1);
+            setInt(numDirLightsUniform, 1);
+            electronModels.clear();
+            protonModels.clear();
+            for (std::size_t i = 0; i < particles.size(); i++)
+            {
+                if (particles.charge[i] < 0.0f)
+                    electronModels.push_back(calculateModelMatrix(particles.position(i), electron.rotation, electron.scale));
+                else
+                    protonModels.push_back(calculateModelMatrix(particles.position(i), proton.rotation, proton.scale));
+            }
+
+            Clock::time_point t4 = Clock::now();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glm::mat4 planeModel = calculateModelMatrix(glm::vec3(0.0f, -10.0f, 0.0f), plane.rotation, plane.scale);
+            setBool(renderInstancedUniform, false);
+            setMaterial(materialUniform, planeMaterial);
+            setMesh(meshUniform, planeModel, calculateNormalMatrix(planeModel));
+            plane.draw();
+            setBool(renderInstancedUniform, true);
+            setMaterial(materialUniform, electronMaterial);
+            electron.drawInstanced(electronModels);
+            setMaterial(materialUniform, protonMaterial);
+            proton.drawInstanced(protonModels);
+
+            Clock::time_point t5 = Clock::now();
+            glFinish();
+            Clock::time_point t6 = Clock::now();
+
+            // The first frames pay for shader compilation and buffer creation
+            if (frame < warmupFrames)
+                continue;
+            Clock::time_point stamps[] = { t0, t1, t2, t3, t4, t5, t6 };
+            for (int stage = 0; stage < stageCount - 1; stage++)
+            {
+                stageTimes[stage].push_back(millisecondsBetween(stamps[stage], stamps[stage + 1]));
+            }
+            stageTimes[stageCount - 1].push_back(millisecondsBetween(t0, t6));
+        }
+
+        std::printf("stage,particles,samples,median_ms,p95_ms,p99_ms\n");
+        for (int stage = 0; stage < stageCount; stage++)
+        {
+            const std::vector<double>& times = stageTimes[stage];
+            std::printf("%s,%zu,%zu,%.4f,%.4f,%.4f\n", stageNames[stage], particleCount, times.size(),
+                percentile(times, 0.5), percentile(times, 0.95), percentile(times, 0.99));
+        }
+        std::fflush(stdout);
+        deleteOffscreenTarget(target);
+    }
+
+    destroyOffscreenContext(context);
+}
+
+int main(int argc, char** argv)
+{
+    std::string mode = argc > 1 ? argv[1] : "all";
+    std::size_t maxParticles = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    unsigned int workerThreads = argc > 3 ? (unsigned int) std::strtoul(argv[3], nullptr, 10) : 0;
+    JobSystem jobs(workerThreads);
+    // Nonzero when a mode that checks something finds it broken
+    int exitCode = 0;
+
+    if (mode == "validate" || mode == "all")
+    {
+        validateBarnesHut(std::min<std::size_t>(maxParticles, 10000));
+    }
+    if (mode == "forces" || mode == "all")
+    {
+        benchForces(maxParticles, jobs);
+    }
+    if (mode == "cutoff" || mode == "all")
+    {
+        benchCutoff(maxParticles, jobs);
+    }
+    if (mode == "fmm")
+    {
+        benchFastMultipole(maxParticles, jobs);
+    }
+    if (mode == "pic")
+    {
+        if (!benchParticleInCell(maxParticles, jobs))
+        {
+            exitCode = 1;
+        }
+    }
+    if (mode == "pme")
+    {
+        if (!benchParticleMeshEwald(maxParticles, jobs))
+        {
+            exitCode = 1;
+        }
+    }
+    if (mode == "blocksteps")
+    {
+        benchBlockTimesteps(argc > 2 ? maxParticles : 2000, jobs);
+    }
+    if (mode == "pool")
+    {
+        benchPool(argc > 2 ? maxParticles : 100000);
+    }
+    if (mode == "determinism")
+    {
+        int steps = argc > 4 ? std::atoi(argv[4]) : 50;
+        if (benchDeterminism(argc > 2 ? maxParticles : 4000, std::max(steps, 1)) > 0)
+        {
+            exitCode = 1;
+        }
+    }
+    if (mode == "gpu")
+    {
+        benchGpu(maxParticles, jobs);
+    }
+    if (mode == "instancing")
+    {
+        benchInstancing(argc > 2 ? maxParticles : 10000);
+    }
+    if (mode == "impostors")
+    {
+        benchImpostors(argc > 2 ? maxParticles : 10000);
+    }
+    if (mode == "vertexformat")
+    {
+        benchVertexFormat(argc > 2 ? maxParticles : 1000000);
+    }
+    if (mode == "meshes")
+    {
+        benchMeshes();
+    }
+    if (mode == "arena")
+    {
+        benchArena(argc > 2 ? maxParticles : 2000);
+    }
+    if (mode == "load")
+    {
+        benchLoad(argc > 2 ? maxParticles : 64);
+    }
+    if (mode == "volume")
+    {
+        benchVolume(argc > 2 ? maxParticles : 100000, jobs);
+    }
+    if (mode == "trails")
+    {
+        benchTrails(argc > 2 ? maxParticles : 10000);
+    }
+    if (mode == "pointcloud")
+    {
+        benchPointCloud(argc > 2 ? maxParticles : 2000000);
+    }
+    if (mode == "frame")
+    {
+        int frames = argc > 4 ? std::atoi(argv[4]) : 200;
+        benchFrame(argc > 2 ? maxParticles : 2000, std::max(frames, 1), jobs);
+    }
+    return exitCode;
+}
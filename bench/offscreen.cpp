@@ -0,0 +1,196 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "offscreen.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <GLFW/glfw3.h>
+#else
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#if defined(_WIN32)
+
+bool createOffscreenContext(OffscreenContext& context)
+{
+    context.display = nullptr;
+    context.context = nullptr;
+    context.surface = nullptr;
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(1, 1, "bench", NULL, NULL);
+    if (window == NULL)
+    {
+        std::printf("ERROR: Failed to create GLFW window\n");
+        glfwTerminate();
+        return false;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::printf("ERROR: Failed to initialize GLAD\n");
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return false;
+    }
+    context.context = window;
+    return true;
+}
+
+void destroyOffscreenContext(OffscreenContext& context)
+{
+    if (context.context != nullptr)
+    {
+        glfwDestroyWindow((GLFWwindow*) context.context);
+        glfwTerminate();
+    }
+    context.context = nullptr;
+}
+
+#else
+
+static EGLDisplay getEglDisplay()
+{
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (extensions != nullptr && getPlatformDisplay != nullptr && std::strstr(extensions, "EGL_MESA_platform_surfaceless") != nullptr)
+    {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY)
+            return display;
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool createOffscreenContext(OffscreenContext& context)
+{
+    context.display = nullptr;
+    context.context = nullptr;
+    context.surface = nullptr;
+
+    EGLDisplay display = getEglDisplay();
+    EGLint major;
+    EGLint minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+    {
+        std::printf("ERROR: Failed to initialize EGL\n");
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        std::printf("ERROR: EGL has no desktop OpenGL\n");
+        eglTerminate(display);
+        return false;
+    }
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE };
+
+    // Without a surface no config is needed, otherwise fall back to a 1x1 pbuffer
+    EGLContext eglContext = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    bool surfaceless = extensions != nullptr
+        && std::strstr(extensions, "EGL_KHR_surfaceless_context") != nullptr
+        && std::strstr(extensions, "EGL_KHR_no_config_context") != nullptr;
+    if (surfaceless)
+    {
+        eglContext = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+    }
+    if (eglContext == EGL_NO_CONTEXT)
+    {
+        const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE };
+        const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (eglChooseConfig(display, configAttributes, &config, 1, &configCount) && configCount > 0)
+        {
+            eglContext = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+            surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+        }
+    }
+    if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, eglContext))
+    {
+        std::printf("ERROR: Failed to create an EGL OpenGL 4.5 context (0x%x)\n", eglGetError());
+        if (surface != EGL_NO_SURFACE)
+            eglDestroySurface(display, surface);
+        if (eglContext != EGL_NO_CONTEXT)
+            eglDestroyContext(display, eglContext);
+        eglTerminate(display);
+        return false;
+    }
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+    {
+        std::printf("ERROR: Failed to initialize GLAD\n");
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (surface != EGL_NO_SURFACE)
+            eglDestroySurface(display, surface);
+        eglDestroyContext(display, eglContext);
+        eglTerminate(display);
+        return false;
+    }
+
+    context.display = display;
+    context.context = eglContext;
+    context.surface = surface;
+    return true;
+}
+
+void destroyOffscreenContext(OffscreenContext& context)
+{
+    if (context.display == nullptr)
+    {
+        return;
+    }
+    EGLDisplay display = (EGLDisplay) context.display;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context.surface != nullptr)
+        eglDestroySurface(display, (EGLSurface) context.surface);
+    eglDestroyContext(display, (EGLContext) context.context);
+    eglTerminate(display);
+    context.display = nullptr;
+    context.context = nullptr;
+    context.surface = nullptr;
+}
+
+#endif
+
+OffscreenTarget createOffscreenTarget(int width, int height)
+{
+    OffscreenTarget target;
+    glGenFramebuffers(1, &target.framebuffer);
+    glGenRenderbuffers(1, &target.color);
+    glGenRenderbuffers(1, &target.depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, target.color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, target.depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target.depth);
+    glViewport(0, 0, width, height);
+    return target;
+}
+
+void deleteOffscreenTarget(OffscreenTarget& target)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &target.framebuffer);
+    glDeleteRenderbuffers(1, &target.color);
+    glDeleteRenderbuffers(1, &target.depth);
+}
@@ -0,0 +1,35 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_OFFSCREEN_H
+#define OPENGL_RENDERER_OFFSCREEN_H
+
+#include <glad/glad.h>
+
+// A GL 4.5 core context with no window. On Linux it comes from EGL, Mesa's
+// surfaceless platform when available, so it also runs on GPU-less machines
+// through llvmpipe. Windows has no EGL, there it is a hidden GLFW window.
+struct OffscreenContext
+{
+    void* display;
+    void* context;
+    void* surface;
+};
+
+bool createOffscreenContext(OffscreenContext& context);
+void destroyOffscreenContext(OffscreenContext& context);
+
+// Colour and depth renderbuffers to draw into, a surfaceless context has no
+// default framebuffer
+struct OffscreenTarget
+{
+    GLuint framebuffer;
+    GLuint color;
+    GLuint depth;
+};
+
+OffscreenTarget createOffscreenTarget(int width, int height);
+void deleteOffscreenTarget(OffscreenTarget& target);
+
+#endif //OPENGL_RENDERER_OFFSCREEN_H
@@ -0,0 +1,76 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_BARNESHUT_H
+#define OPENGL_RENDERER_BARNESHUT_H
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "forceSolver.h"
+#include "jobSystem.h"
+
+struct BarnesHutNode
+{
+    // Expansion centre, weighted by |q| so a neutral cluster still has a sensible centre
+    glm::vec3 center;
+    float charge;
+    // Dipole moment about center. Plasmas are close to neutral, so the
+    // monopole alone would throw away most of the far field.
+    glm::vec3 dipole;
+    float absCharge;
+
+    glm::vec3 boxCenter;
+    float halfSize;
+    // Squared distance inside which the node must be opened, set at build time from theta
+    float openRadius2;
+
+    // Children are stored contiguously, childCount == 0 means leaf
+    uint32_t firstChild;
+    uint32_t childCount;
+    // Range into BarnesHutSolver::order
+    uint32_t begin;
+    uint32_t end;
+};
+
+// Octree solver, O(N log N). A node is expanded unless
+// distance > size / theta + |center - boxCenter| (Barnes' offset criterion).
+class BarnesHutSolver : public ForceSolver
+{
+public:
+    // Opening angle, 0 degenerates to the exact sum
+    float theta;
+    uint32_t leafSize;
+    // Tree walks run in parallel, the build is serial
+    JobSystem* jobs;
+
+    BarnesHutSolver();
+    explicit BarnesHutSolver(float theta, JobSystem* jobs = nullptr);
+
+    const char* name() const override;
+    void computeAccelerations(ParticleSystem& particles) override;
+    // Rebuilds the whole tree, then walks it for the targets only
+    void computeSubsetAccelerations(ParticleSystem& particles, const std::vector<uint32_t>& targets) override;
+
+    void build(const ParticleSystem& particles);
+    const std::vector<BarnesHutNode>& getNodes() const { return nodes; }
+
+private:
+    std::vector<BarnesHutNode> nodes;
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> scratch;
+    std::vector<uint8_t> octants;
+    // One traversal stack per job thread
+    std::vector<std::vector<uint32_t>> stacks;
+
+    void buildNode(const ParticleSystem& particles, uint32_t nodeIndex, int depth);
+    void computeLeafMoments(const ParticleSystem& particles, BarnesHutNode& node);
+    void computeParentMoments(BarnesHutNode& node);
+    glm::vec3 fieldAt(const ParticleSystem& particles, glm::vec3 point, std::vector<uint32_t>& stack) const;
+    void accelerateParticles(ParticleSystem& particles, const std::vector<uint32_t>& targets);
+};
+
+#endif //OPENGL_RENDERER_BARNESHUT_H
@@ -0,0 +1,99 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_CELLLIST_H
+#define OPENGL_RENDERER_CELLLIST_H
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "forceSolver.h"
+#include "jobSystem.h"
+#include "particleSystem.h"
+
+// Uniform grid over the particles' bounding box, rebuilt with a counting sort.
+// Cell c holds the slots cellStart[c] .. cellStart[c + 1], slot k is particle
+// sortedIndices[k]. gather() copies positions and charges into slot order so
+// neighbour walks read contiguous memory instead of hopping around the arrays.
+class CellGrid
+{
+public:
+    float cellSize;
+    glm::vec3 origin;
+    glm::ivec3 dims;
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> sortedIndices;
+    std::vector<uint32_t> particleCell;
+    AlignedFloats sortedX, sortedY, sortedZ, sortedCharge;
+
+    CellGrid();
+
+    // minCellSize is a lower bound, cells grow if the grid would have far more cells than particles
+    void build(const ParticleSystem& particles, float minCellSize, JobSystem* jobs = nullptr);
+    // Refreshes the sorted copies from the current positions, build() calls it too
+    void gather(const ParticleSystem& particles, JobSystem* jobs = nullptr);
+
+    glm::ivec3 cellCoord(glm::vec3 position) const;
+    uint32_t cellIndex(glm::ivec3 coord) const { return uint32_t((coord.z * dims.y + coord.y) * dims.x + coord.x); }
+    uint32_t cellCount() const { return uint32_t(dims.x) * uint32_t(dims.y) * uint32_t(dims.z); }
+
+private:
+    std::vector<uint32_t> cursor;
+};
+
+// Verlet neighbour list: everything within cutoff + skin, kept until some
+// particle has moved more than skin / 2 since the list was built, or the
+// cutoff or skin changed.
+class NeighbourList
+{
+public:
+    float skin;
+    // neighbours[offsets[k] .. offsets[k + 1]) are the candidate slots of grid slot k
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> neighbours;
+
+    NeighbourList();
+
+    bool needsRebuild(const ParticleSystem& particles, float cutoff) const;
+    void build(const ParticleSystem& particles, const CellGrid& grid, float cutoff, JobSystem* jobs = nullptr);
+
+private:
+    float builtCutoff;
+    float builtSkin;
+    AlignedFloats referenceX, referenceY, referenceZ;
+};
+
+// Short-range Coulomb, optionally screened (Yukawa), cut off at `cutoff`.
+// The force is shifted to reach zero at the cutoff so energy stays smooth.
+// O(N) for a fixed density.
+class CutoffSolver : public ForceSolver
+{
+public:
+    float cutoff;
+    // Debye length of exp(-r / length) / r screening, 0 means unscreened
+    float screeningLength;
+    bool useNeighbourList;
+    JobSystem* jobs;
+
+    CutoffSolver();
+    CutoffSolver(float cutoff, float screeningLength, bool useNeighbourList, JobSystem* jobs = nullptr);
+
+    const char* name() const override;
+    void computeAccelerations(ParticleSystem& particles) override;
+
+    const CellGrid& getGrid() const { return grid; }
+    NeighbourList& getNeighbourList() { return neighbourList; }
+
+private:
+    CellGrid grid;
+    NeighbourList neighbourList;
+
+    float pairFactor(float r2, float eps2, float shift) const;
+    void accumulateFromGrid(ParticleSystem& particles);
+    void accumulateFromList(ParticleSystem& particles);
+};
+
+#endif //OPENGL_RENDERER_CELLLIST_H
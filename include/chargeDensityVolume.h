@@ -0,0 +1,71 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_CHARGEDENSITYVOLUME_H
+#define OPENGL_RENDERER_CHARGEDENSITYVOLUME_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "jobSystem.h"
+#include "particleInCell.h"
+#include "texture.h"
+
+// Particle charge splatted onto a cubic grid around the particles, for
+// drawing as a volume. The deposit uses the PIC assignment weights, density
+// is charge per unit volume. Voxel (x, y, z) is centred at
+// origin + cellSize * (x, y, z) and stored x fastest, the order of the 3D texture.
+//
+// Alongside the density it keeps a coarse grid of macro cells, each holding
+// the minimum and maximum density over its voxels plus a one voxel border
+// (what trilinear filtering can reach), so a ray marcher can step over empty
+// macro cells whole.
+class ChargeDensityVolume
+{
+public:
+    // Voxels per side, a multiple of macroCellSize
+    uint32_t gridSize;
+    // Voxels per macro cell side
+    uint32_t macroCellSize;
+    ChargeAssignment assignment;
+
+    ChargeDensityVolume();
+    ChargeDensityVolume(uint32_t gridSize, uint32_t macroCellSize);
+
+    // Refits the grid to the particles' bounding cube and deposits their charge
+    void splat(const std::vector<glm::vec3>& positions, const std::vector<float>& charges, JobSystem* jobs = nullptr);
+    // Density to an R32F texture (linear filtering), macro cells to RG32F (nearest)
+    void upload();
+
+    glm::vec3 getOrigin() const { return origin; }
+    float getCellSize() const { return cellSize; }
+    // Corner and side of the cube the texture spans, voxel faces rather than centres
+    glm::vec3 boundsMin() const { return origin - glm::vec3(0.5f * cellSize); }
+    float boundsSide() const { return float(gridSize) * cellSize; }
+    uint32_t macroGridSize() const { return gridSize / macroCellSize; }
+    // Largest |density| of the last splat, 0 with no charge
+    float getMaxAbsDensity() const { return maxAbsDensity; }
+
+    const std::vector<float>& getDensity() const { return density; }
+    const std::vector<glm::vec2>& getMacroRanges() const { return macroRanges; }
+    const Texture3D& getDensityTexture() const { return densityTexture; }
+    const Texture3D& getMacroTexture() const { return macroTexture; }
+
+private:
+    std::vector<std::vector<float>> threadDensity;
+    std::vector<float> density;
+    std::vector<glm::vec2> macroRanges;
+    glm::vec3 origin;
+    float cellSize;
+    float maxAbsDensity;
+    Texture3D densityTexture;
+    Texture3D macroTexture;
+
+    void fitGrid(const std::vector<glm::vec3>& positions);
+    void buildMacroRanges(JobSystem* jobs);
+};
+
+#endif //OPENGL_RENDERER_CHARGEDENSITYVOLUME_H
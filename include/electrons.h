@@ -13,6 +13,8 @@
 #define ELECTRON_RADIUS 1.0e-22 // this is not a true radius, but a functional size indication
 #define PROTON_RADIUS_mm 0.84075e-15 * 1.0e3
 #define HYDROGEN_ORBIT_RADIUS_mm 5.29e-11 * 1.0e3
+#define ELECTRON_CHARGE_E -1.0
+#define PROTON_CHARGE_E 1.0
 
 // acceleration per distance squared between the two particles.
 // these are all surprisingly tame values between 0.01 and 300.0
@@ -21,5 +23,9 @@ constexpr float accel_on_p_from_e_per_m2 = CUOLOMBS_CONSTANT_NC2_PER_M2 * -E_CUO
 constexpr float accel_on_e_from_e_per_m2 = CUOLOMBS_CONSTANT_NC2_PER_M2 * E_CUOLOMBS * E_CUOLOMBS / (ELECTRON_MASS_KG * 1.0e3);
 constexpr float accel_on_p_from_p_per_m2 = CUOLOMBS_CONSTANT_NC2_PER_M2 * E_CUOLOMBS * E_CUOLOMBS / (PROTON_MASS_KG * 1.0e3);
 
+// k * e^2 with the same mm scaling as above; multiply by q_a * q_b / m_a (charges in e, mass in kg)
+// to get the acceleration per distance squared on particle a.
+constexpr float coulomb_coupling = CUOLOMBS_CONSTANT_NC2_PER_M2 * E_CUOLOMBS * E_CUOLOMBS / 1.0e3;
+
 
 #endif //OPENGL_RENDERER_ELECTRONS_H
\ No newline at end of file
@@ -0,0 +1,148 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_FASTMULTIPOLE_H
+#define OPENGL_RENDERER_FASTMULTIPOLE_H
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "forceSolver.h"
+#include "jobSystem.h"
+
+const int FAST_MULTIPOLE_MAX_ORDER = 10;
+
+struct FastMultipoleNode
+{
+    // Expansion centre, weighted by |q| like BarnesHutNode
+    glm::vec3 center;
+    // Every particle of the node lies within radius of center
+    float radius;
+    float absCharge;
+
+    glm::vec3 boxCenter;
+    float halfSize;
+
+    uint32_t parent;
+    uint32_t depth;
+    // Children are stored contiguously, childCount == 0 means leaf
+    uint32_t firstChild;
+    uint32_t childCount;
+    // Range into FastMultipoleSolver::sortedIndices
+    uint32_t begin;
+    uint32_t end;
+};
+
+// Cartesian Taylor-series multipole tables up to a given order. Multi-indices
+// n = (nx, ny, nz) with |n| <= order are numbered by degree, and every
+// operator is precomputed as a list of index triples so the passes are flat loops.
+//
+//   multipole  M_n = sum_j q_j (z - x_j)^n / n!
+//   local      L_k = d^k phi(z), phi(x) = sum_k L_k (x - z)^k / k!
+//   M2L        L_k += sum_n M_n D_(n+k)(z_B - z_A),  D_n = d^n (1 / r)
+//
+// Expanding about z - x_j rather than x_j - z folds the (-1)^|n| of the
+// Taylor series into the moments, so M2L is a plain sum of products.
+struct MultipoleTables
+{
+    int order;
+    int terms;
+    // index[(nx * (order + 1) + ny) * (order + 1) + nz]
+    std::vector<int> index;
+    std::vector<glm::ivec3> exponents;
+    // n - e_axis, the term each monomial and derivative is built from, -1 for n = 0
+    std::vector<int> parentTerm;
+    std::vector<int> parentAxis;
+    // n + e_axis for axis 0..2, -1 past the order
+    std::vector<glm::ivec3> raisedTerm;
+
+    struct M2LTerm
+    {
+        int local;
+        int multipole;
+        int derivative;
+    };
+    struct ShiftTerm
+    {
+        int target;
+        int source;
+        int offset;
+    };
+    std::vector<M2LTerm> m2lTerms;
+    // M_n += M_m d^(n-m) / (n-m)!, d = z_parent - z_child, and
+    // L_k += L_m d^(m-k) / (m-k)!, d = z_child - z_parent
+    std::vector<ShiftTerm> m2mTerms;
+    std::vector<ShiftTerm> l2lTerms;
+
+    MultipoleTables();
+
+    void build(int order);
+    // out[n] = d^n / n!
+    void monomials(glm::dvec3 d, double* out) const;
+    // out[n] = d^n (1 / |r|) for |n| <= order, scratch holds (order + 1) * terms doubles
+    void derivatives(glm::dvec3 r, double* out, double* scratch) const;
+};
+
+// Fast multipole method on an adaptive octree, O(N) for a fixed order.
+// Multipoles go up the tree (P2M, M2M), a dual-tree walk pairs well separated
+// nodes (M2L) and sums the rest directly (P2P), locals go back down (L2L,
+// L2P). The error falls roughly like theta^(order + 1).
+//
+// The upward and downward passes run one tree level at a time, every level
+// in parallel. The walk is split into target subtrees, each task only writes
+// locals and fields inside its own subtree. More threads cut more subtrees,
+// unless the solver is deterministic.
+class FastMultipoleSolver : public ForceSolver
+{
+public:
+    // Expansion order, clamped to [1, FAST_MULTIPOLE_MAX_ORDER]. The far
+    // field uses multipoles up to order - 1.
+    int order;
+    // Two nodes interact through their expansions when
+    // |z_A - z_B| * theta > r_A + r_B, in (0, 1)
+    float theta;
+    uint32_t leafSize;
+    JobSystem* jobs;
+
+    FastMultipoleSolver();
+    FastMultipoleSolver(int order, float theta, JobSystem* jobs = nullptr);
+
+    const char* name() const override;
+    void computeAccelerations(ParticleSystem& particles) override;
+
+    void build(const ParticleSystem& particles);
+    const std::vector<FastMultipoleNode>& getNodes() const { return nodes; }
+
+private:
+    MultipoleTables tables;
+    std::vector<FastMultipoleNode> nodes;
+    // Tree slot k holds particle sortedIndices[k], sortedParticles[k] is its position and charge
+    std::vector<uint32_t> sortedIndices;
+    std::vector<glm::vec4> sortedParticles;
+    std::vector<uint32_t> scratch;
+    std::vector<uint8_t> octants;
+    // levels[d] lists the nodes at depth d
+    std::vector<std::vector<uint32_t>> levels;
+    // terms coefficients per node
+    std::vector<double> multipoles;
+    std::vector<double> locals;
+    // Per tree slot, P2P adds to it during the walk and L2P at the end
+    std::vector<glm::vec3> fields;
+    // Per job thread: derivative table and its recursion scratch
+    std::vector<std::vector<double>> threadWork;
+
+    void buildNode(const ParticleSystem& particles, uint32_t nodeIndex, uint32_t depth);
+    void upwardPass();
+    void computeLeafMoments(uint32_t nodeIndex);
+    void computeParentMoments(uint32_t nodeIndex);
+    void interact(uint32_t source, uint32_t target, float eps2, std::vector<double>& work);
+    void multipoleToLocal(uint32_t source, uint32_t target, std::vector<double>& work);
+    void particleToParticle(uint32_t source, uint32_t target, float eps2);
+    void downwardPass();
+};
+
+#endif //OPENGL_RENDERER_FASTMULTIPOLE_H
@@ -0,0 +1,249 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_FFT_H
+#define OPENGL_RENDERER_FFT_H
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <numbers>
+#include <vector>
+
+#include "jobSystem.h"
+
+typedef std::complex<double> Complex;
+
+// Iterative radix-2 complex FFT of one power-of-two length. The bit-reversal
+// permutation and the twiddles are tabulated once, transforms only read them
+// so one plan serves any number of threads.
+//
+// Unnormalized in both directions: inverse(forward(x)) = n * x.
+class FftPlan
+{
+public:
+    FftPlan() : n(0) {}
+    explicit FftPlan(std::size_t n) { init(n); }
+
+    std::size_t size() const { return n; }
+
+    void init(std::size_t length)
+    {
+        n = length;
+        reversed.assign(n, 0);
+        std::size_t bits = 0;
+        while ((std::size_t(1) << bits) < n)
+        {
+            bits++;
+        }
+        for (std::size_t i = 0; i < n; i++)
+        {
+            std::size_t r = 0;
+            for (std::size_t b = 0; b < bits; b++)
+            {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            reversed[i] = r;
+        }
+        // twiddles[k] = exp(-2 pi i k / n) for k < n / 2
+        twiddles.resize(n / 2);
+        for (std::size_t k = 0; k < n / 2; k++)
+        {
+            double angle = -2.0 * std::numbers::pi * double(k) / double(n);
+            twiddles[k] = Complex(std::cos(angle), std::sin(angle));
+        }
+    }
+
+    // In place, data holds n contiguous values
+    void transform(Complex* data, bool inverse) const
+    {
+        for (std::size_t i = 0; i < n; i++)
+        {
+            if (i < reversed[i])
+                std::swap(data[i], data[reversed[i]]);
+        }
+        for (std::size_t length = 2; length <= n; length *= 2)
+        {
+            std::size_t half = length / 2;
+            std::size_t step = n / length;
+            for (std::size_t start = 0; start < n; start += length)
+            {
+                for (std::size_t k = 0; k < half; k++)
+                {
+                    Complex w = inverse ? std::conj(twiddles[k * step]) : twiddles[k * step];
+                    Complex odd = w * data[start + k + half];
+                    data[start + k + half] = data[start + k] - odd;
+                    data[start + k] += odd;
+                }
+            }
+        }
+    }
+
+private:
+    std::size_t n;
+    std::vector<std::size_t> reversed;
+    std::vector<Complex> twiddles;
+};
+
+// Real-to-complex 3D FFT of an nx * ny * nz grid, every size a power of two
+// and nz >= 2. The real grid is indexed (x * ny + y) * nz + z, the spectrum
+// keeps the nz / 2 + 1 non-redundant z frequencies, (x * ny + y) * (nz / 2 + 1) + kz.
+//
+// Each z line is one complex FFT of half the length (even samples as the
+// real part, odd ones as the imaginary part) plus a split pass, then the
+// y and x lines of the half spectrum get ordinary complex FFTs. Lines are
+// transformed in parallel, each through a per-thread contiguous copy.
+//
+// inverse(forward(x)) = nx * ny * nz * x, like FftPlan.
+class RealFft3D
+{
+public:
+    RealFft3D() : nx(0), ny(0), nz(0) {}
+
+    std::size_t sizeX() const { return nx; }
+    std::size_t sizeY() const { return ny; }
+    std::size_t sizeZ() const { return nz; }
+    std::size_t spectrumZ() const { return nz / 2 + 1; }
+    std::size_t realSize() const { return nx * ny * nz; }
+    std::size_t spectrumSize() const { return nx * ny * spectrumZ(); }
+
+    void init(std::size_t sizeX, std::size_t sizeY, std::size_t sizeZ)
+    {
+        if (sizeX == nx && sizeY == ny && sizeZ == nz)
+            return;
+        nx = sizeX;
+        ny = sizeY;
+        nz = sizeZ;
+        planX.init(nx);
+        planY.init(ny);
+        planHalfZ.init(nz / 2);
+        // splitTwiddles[k] = exp(-2 pi i k / nz) for k <= nz / 2
+        splitTwiddles.resize(nz / 2 + 1);
+        for (std::size_t k = 0; k <= nz / 2; k++)
+        {
+            double angle = -2.0 * std::numbers::pi * double(k) / double(nz);
+            splitTwiddles[k] = Complex(std::cos(angle), std::sin(angle));
+        }
+    }
+
+    void forward(const double* real, Complex* spectrum, JobSystem* jobs)
+    {
+        const std::size_t half = nz / 2;
+        const std::size_t sz = spectrumZ();
+        prepareScratch(jobs);
+        parallelFor(jobs, 0, nx * ny, FFT_LINES_PER_TASK,
+            [this, real, spectrum, half, sz](std::size_t begin, std::size_t end, unsigned int thread)
+            {
+                Complex* z = lineScratch[thread].data();
+                for (std::size_t line = begin; line < end; line++)
+                {
+                    const double* in = real + line * nz;
+                    for (std::size_t k = 0; k < half; k++)
+                    {
+                        z[k] = Complex(in[2 * k], in[2 * k + 1]);
+                    }
+                    planHalfZ.transform(z, false);
+                    Complex* out = spectrum + line * sz;
+                    for (std::size_t k = 0; k <= half; k++)
+                    {
+                        Complex a = z[k % half];
+                        Complex b = std::conj(z[(half - k) % half]);
+                        Complex even = 0.5 * (a + b);
+                        Complex odd = Complex(0.0, -0.5) * (a - b);
+                        out[k] = even + splitTwiddles[k] * odd;
+                    }
+                }
+            });
+        transformYX(spectrum, false, jobs);
+    }
+
+    // Overwrites spectrum
+    void inverse(Complex* spectrum, double* real, JobSystem* jobs)
+    {
+        const std::size_t half = nz / 2;
+        const std::size_t sz = spectrumZ();
+        prepareScratch(jobs);
+        transformYX(spectrum, true, jobs);
+        parallelFor(jobs, 0, nx * ny, FFT_LINES_PER_TASK,
+            [this, real, spectrum, half, sz](std::size_t begin, std::size_t end, unsigned int thread)
+            {
+                Complex* z = lineScratch[thread].data();
+                for (std::size_t line = begin; line < end; line++)
+                {
+                    const Complex* in = spectrum + line * sz;
+                    for (std::size_t k = 0; k < half; k++)
+                    {
+                        Complex a = in[k];
+                        Complex b = std::conj(in[half - k]);
+                        Complex even = a + b;
+                        Complex odd = (a - b) * std::conj(splitTwiddles[k]);
+                        z[k] = even + Complex(0.0, 1.0) * odd;
+                    }
+                    planHalfZ.transform(z, true);
+                    double* out = real + line * nz;
+                    for (std::size_t k = 0; k < half; k++)
+                    {
+                        out[2 * k] = z[k].real();
+                        out[2 * k + 1] = z[k].imag();
+                    }
+                }
+            });
+    }
+
+private:
+    static const std::size_t FFT_LINES_PER_TASK = 16;
+
+    std::size_t nx, ny, nz;
+    FftPlan planX, planY, planHalfZ;
+    std::vector<Complex> splitTwiddles;
+    std::vector<std::vector<Complex>> lineScratch;
+
+    void prepareScratch(JobSystem* jobs)
+    {
+        std::size_t threads = jobs != nullptr ? jobs->threadCount() : 1;
+        std::size_t longest = std::max(std::max(nx, ny), nz / 2);
+        lineScratch.resize(threads);
+        for (std::vector<Complex>& scratch : lineScratch)
+        {
+            scratch.resize(longest);
+        }
+    }
+
+    // y lines, then x lines, of the half spectrum
+    void transformYX(Complex* spectrum, bool inverse, JobSystem* jobs)
+    {
+        const std::size_t sz = spectrumZ();
+        parallelFor(jobs, 0, nx * sz, FFT_LINES_PER_TASK,
+            [this, spectrum, inverse, sz](std::size_t begin, std::size_t end, unsigned int thread)
+            {
+                Complex* line = lineScratch[thread].data();
+                for (std::size_t l = begin; l < end; l++)
+                {
+                    Complex* base = spectrum + (l / sz) * ny * sz + l % sz;
+                    for (std::size_t y = 0; y < ny; y++)
+                        line[y] = base[y * sz];
+                    planY.transform(line, inverse);
+                    for (std::size_t y = 0; y < ny; y++)
+                        base[y * sz] = line[y];
+                }
+            });
+        const std::size_t planeStride = ny * sz;
+        parallelFor(jobs, 0, planeStride, FFT_LINES_PER_TASK,
+            [this, spectrum, inverse, planeStride](std::size_t begin, std::size_t end, unsigned int thread)
+            {
+                Complex* line = lineScratch[thread].data();
+                for (std::size_t l = begin; l < end; l++)
+                {
+                    Complex* base = spectrum + l;
+                    for (std::size_t x = 0; x < nx; x++)
+                        line[x] = base[x * planeStride];
+                    planX.transform(line, inverse);
+                    for (std::size_t x = 0; x < nx; x++)
+                        base[x * planeStride] = line[x];
+                }
+            });
+    }
+};
+
+#endif //OPENGL_RENDERER_FFT_H
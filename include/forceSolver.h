@@ -0,0 +1,80 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_FORCESOLVER_H
+#define OPENGL_RENDERER_FORCESOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "particleSystem.h"
+#include "jobSystem.h"
+
+// Pieces a deterministic solver splits its parallel work into, fixed instead
+// of following the thread count
+const std::size_t DETERMINISTIC_SPLIT_COUNT = 16;
+
+// Fills particles.acc{X,Y,Z} for every particle in [0, particles.size())
+class ForceSolver
+{
+public:
+    // Bit-identical accelerations for any JobSystem thread count and schedule.
+    // Solvers that sum every particle's terms in its own task, in a fixed
+    // order (brute force, Barnes-Hut, cutoff), always are and ignore it.
+    bool deterministic;
+
+    ForceSolver() : deterministic(false) {}
+    virtual ~ForceSolver() = default;
+    virtual const char* name() const = 0;
+    virtual void computeAccelerations(ParticleSystem& particles) = 0;
+    // Only the particles in targets get new accelerations, the others keep
+    // theirs, every particle is still a source. Block timesteps call this with
+    // the few particles that finish a step. The default evaluates everything
+    // and puts the other accelerations back, solvers that can evaluate single
+    // particles override it.
+    virtual void computeSubsetAccelerations(ParticleSystem& particles, const std::vector<uint32_t>& targets);
+};
+
+// Exact O(N^2) all-pairs sum, the reference every other solver is measured against
+class BruteForceSolver : public ForceSolver
+{
+public:
+    // Rows of the interaction matrix are split across jobs, each task owns the
+    // accelerations of its rows so no reduction is needed
+    JobSystem* jobs;
+    // The scalar kernel sums in plain index order, the order the GPU path
+    // reproduces, so it is the one to compare against bit for bit
+    bool useSimd;
+    // Kahan summation of each row, the error stops growing with the particle count
+    bool compensatedSummation;
+
+    BruteForceSolver();
+    explicit BruteForceSolver(JobSystem* jobs);
+
+    const char* name() const override;
+    void computeAccelerations(ParticleSystem& particles) override;
+    void computeSubsetAccelerations(ParticleSystem& particles, const std::vector<uint32_t>& targets) override;
+
+private:
+    void computeRows(ParticleSystem& particles, std::size_t begin, std::size_t end) const;
+};
+
+struct ForceError
+{
+    // sqrt(sum |a - a_ref|^2 / sum |a_ref|^2)
+    float rmsRelative;
+    // max over particles of |a - a_ref| / |a_ref|
+    float maxRelative;
+};
+
+// Adds partials[1 ..] into partials[0] over the elements [begin, end), as a
+// balanced pairwise tree that only depends on partials.size(). With a fixed
+// number of partials, each filled in a fixed order, the sum is reproducible.
+void pairwiseReduce(std::vector<std::vector<double>>& partials, std::size_t begin, std::size_t end);
+
+// Runs both solvers on copies of particles and compares the accelerations
+ForceError measureForceError(const ParticleSystem& particles, ForceSolver& reference, ForceSolver& candidate);
+
+#endif //OPENGL_RENDERER_FORCESOLVER_H
@@ -0,0 +1,161 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_GEOMETRYARENA_H
+#define OPENGL_RENDERER_GEOMETRYARENA_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "mesh.h"
+
+// Ranges of one buffer, handed out best fit from a list of free blocks that
+// merge with their neighbours when freed. Offsets and sizes are in whatever
+// unit the caller counts in.
+class FreeListAllocator
+{
+public:
+    static const std::size_t NO_SPACE = ~std::size_t(0);
+
+    FreeListAllocator();
+    explicit FreeListAllocator(std::size_t capacity);
+
+    // Forgets every allocation, leaving one free block of capacity
+    void reset(std::size_t capacity);
+    // The offset of size units from the smallest free block that holds them, or NO_SPACE
+    std::size_t allocate(std::size_t size);
+    void free(std::size_t offset, std::size_t size);
+
+    std::size_t getCapacity() const { return capacity; }
+    std::size_t getUsed() const { return used; }
+    std::size_t getFreeBlockCount() const { return freeByOffset.size(); }
+    std::size_t getLargestFreeBlock() const;
+
+private:
+    std::size_t capacity;
+    std::size_t used;
+    // The same free blocks twice: by offset to find neighbours, by size to find the best fit
+    std::map<std::size_t, std::size_t> freeByOffset;
+    std::multimap<std::size_t, std::size_t> freeBySize;
+
+    void insertFree(std::size_t offset, std::size_t size);
+    void eraseFree(std::map<std::size_t, std::size_t>::iterator block);
+};
+
+// A mesh in a GeometryArena, valid until removed, defragment() included
+typedef uint32_t GeometryHandle;
+const GeometryHandle INVALID_GEOMETRY = ~GeometryHandle(0);
+
+struct GeometryArenaSettings
+{
+    VertexLayout layout;
+    // Quantized positions are relative to this box for every mesh, so one
+    // vertexFormat serves every draw. Positions outside it are clamped.
+    glm::vec3 boundsMin = glm::vec3(-1.0f);
+    glm::vec3 boundsMax = glm::vec3(1.0f);
+    // Initial sizes, in vertices and in 32-bit index slots (a 16-bit index takes half of one)
+    std::size_t vertexCapacity = std::size_t(1) << 16;
+    std::size_t indexCapacity = std::size_t(1) << 18;
+};
+
+// Where a mesh sits in the arena, what a glDrawElementsBaseVertex of it takes
+struct GeometryRange
+{
+    GLint baseVertex = 0;
+    GLsizei vertexCount = 0;
+    // Counted in indices of indexType from the start of the index buffer
+    GLuint firstIndex = 0;
+    GLsizei indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+};
+
+// Many meshes in one vertex buffer and one index buffer, both immutable
+// storage, behind a single VAO. Each mesh's indices stay relative to its
+// first vertex and are drawn with a base vertex, so a mesh of up to 65536
+// vertices keeps 16-bit indices however full the arena is. Every mesh has
+// the arena's vertex layout.
+//
+// Space is handed out by two FreeListAllocators. When add() doesn't fit, the
+// arena defragments, and if that isn't enough either it moves into buffers
+// twice the size. Both copy the live meshes buffer to buffer on the GPU.
+//
+// The draws expect bind(), and any number of them can follow with no other
+// VAO bound in between. add() and defragment() may unbind it.
+class GeometryArena
+{
+public:
+    explicit GeometryArena(const GeometryArenaSettings& settings = GeometryArenaSettings());
+    ~GeometryArena();
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    // Packs and uploads the mesh's CPU data, INVALID_GEOMETRY if it has no triangles
+    GeometryHandle add(const Mesh& mesh);
+    void remove(GeometryHandle handle);
+    // Moves every mesh to the front of new buffers of the same size, leaving one free block in each
+    void defragment();
+
+    void bind() const;
+    void draw(GeometryHandle handle) const;
+    // instanceCount copies in one call, the shader places them by gl_InstanceID
+    void drawInstanced(GeometryHandle handle, GLsizei instanceCount) const;
+    // One copy per model matrix (aModel in mesh_vert.glsl), like Mesh::drawInstanced
+    void drawInstanced(GeometryHandle handle, const std::vector<glm::mat4>& models);
+    // Mesh handles[i] with model matrix models[i], every mesh in one
+    // glMultiDrawElementsIndirect per index type. The shader reads the models
+    // from aModel, as for drawInstanced.
+    void multiDraw(const std::vector<GeometryHandle>& handles, const std::vector<glm::mat4>& models);
+
+    GeometryRange getRange(GeometryHandle handle) const;
+    VertexLayout getLayout() const { return layout; }
+    // For setVertexFormat(), the same for every mesh
+    glm::vec3 getPositionOffset() const { return positionOffset; }
+    glm::vec3 getPositionScale() const { return positionScale; }
+    std::size_t getMeshCount() const { return entries.size() - freeHandles.size(); }
+    const FreeListAllocator& getVertexAllocator() const { return vertexAllocator; }
+    const FreeListAllocator& getIndexAllocator() const { return indexAllocator; }
+
+private:
+    struct Entry
+    {
+        bool live = false;
+        std::size_t vertexOffset = 0;
+        std::size_t vertexCount = 0;
+        // In 32-bit slots
+        std::size_t indexOffset = 0;
+        std::size_t indexSlots = 0;
+        std::size_t indexCount = 0;
+        GLenum indexType = GL_UNSIGNED_INT;
+    };
+
+    VertexLayout layout;
+    GLsizei stride;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    glm::vec3 positionOffset;
+    glm::vec3 positionScale;
+    GLuint VAO;
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    GLuint instanceBuffer;
+    GLuint indirectBuffer;
+    std::size_t instanceCapacity;
+    std::size_t indirectCapacity;
+    FreeListAllocator vertexAllocator;
+    FreeListAllocator indexAllocator;
+    std::vector<Entry> entries;
+    std::vector<GeometryHandle> freeHandles;
+
+    // Copies every live mesh into new buffers of these capacities, packed from the front
+    void relocate(std::size_t vertexCapacity, std::size_t indexCapacity);
+    void uploadInstances(const std::vector<glm::mat4>& models);
+};
+
+#endif //OPENGL_RENDERER_GEOMETRYARENA_H
@@ -0,0 +1,84 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_GLHANDLE_H
+#define OPENGL_RENDERER_GLHANDLE_H
+
+#include <glad/glad.h>
+
+#include <utility>
+
+// Sole owner of one GL object name, deleted with Deleter::destroy() when the
+// handle dies or is given another name. Moving hands the name over and leaves
+// 0 behind, copying isn't allowed, so a name is never deleted twice. 0 means
+// no object, and nothing is deleted for it.
+template <typename Deleter>
+class GLHandle
+{
+public:
+    GLHandle() : name(0) {}
+    explicit GLHandle(GLuint name) : name(name) {}
+    ~GLHandle() { reset(); }
+
+    GLHandle(const GLHandle&) = delete;
+    GLHandle& operator=(const GLHandle&) = delete;
+
+    GLHandle(GLHandle&& other) noexcept : name(std::exchange(other.name, 0)) {}
+    GLHandle& operator=(GLHandle&& other) noexcept
+    {
+        if (this != &other)
+            reset(std::exchange(other.name, 0));
+        return *this;
+    }
+
+    GLuint get() const { return name; }
+    explicit operator bool() const { return name != 0; }
+
+    // Deletes the current object, if any, and takes ownership of newName
+    void reset(GLuint newName = 0)
+    {
+        if (name != 0)
+            Deleter::destroy(name);
+        name = newName;
+    }
+    // Gives up ownership without deleting
+    GLuint release() { return std::exchange(name, 0); }
+
+private:
+    GLuint name;
+};
+
+struct GLBufferDeleter { static void destroy(GLuint name) { glDeleteBuffers(1, &name); } };
+struct GLVertexArrayDeleter { static void destroy(GLuint name) { glDeleteVertexArrays(1, &name); } };
+struct GLTextureDeleter { static void destroy(GLuint name) { glDeleteTextures(1, &name); } };
+struct GLProgramDeleter { static void destroy(GLuint name) { glDeleteProgram(name); } };
+
+typedef GLHandle<GLBufferDeleter> GLBuffer;
+typedef GLHandle<GLVertexArrayDeleter> GLVertexArray;
+typedef GLHandle<GLTextureDeleter> GLTexture;
+typedef GLHandle<GLProgramDeleter> GLProgram;
+
+// A fresh name of each kind, owned by the returned handle
+inline GLBuffer createGLBuffer()
+{
+    GLuint name = 0;
+    glGenBuffers(1, &name);
+    return GLBuffer(name);
+}
+
+inline GLVertexArray createGLVertexArray()
+{
+    GLuint name = 0;
+    glGenVertexArrays(1, &name);
+    return GLVertexArray(name);
+}
+
+inline GLTexture createGLTexture()
+{
+    GLuint name = 0;
+    glGenTextures(1, &name);
+    return GLTexture(name);
+}
+
+#endif //OPENGL_RENDERER_GLHANDLE_H
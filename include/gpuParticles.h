@@ -0,0 +1,83 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_GPUPARTICLES_H
+#define OPENGL_RENDERER_GPUPARTICLES_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "particleSystem.h"
+#include "integrator.h"
+#include "shader.h"
+
+// SSBO binding points shared with the particle shaders
+const GLuint PARTICLE_POSITION_BINDING = 0;
+const GLuint PARTICLE_VELOCITY_BINDING = 1;
+const GLuint PARTICLE_ACCELERATION_BINDING = 2;
+const GLuint PARTICLE_DRAW_ORDER_BINDING = 3;
+
+// Particle state living in shader storage buffers, stepped by compute shaders
+// with the same all-pairs sum and kick/drift order as the CPU path. The
+// position buffer is read directly by particle_vert.glsl, so nothing is
+// copied back to the CPU while the simulation runs on the GPU.
+//
+// Particles keep their CPU order, so the force sums run in the same order as
+// coulombAccelerationsScalar. A separate draw order buffer lists negative
+// charges first, which makes each species one contiguous instance range.
+class GpuParticleSystem
+{
+public:
+    GpuParticleSystem();
+    ~GpuParticleSystem();
+
+    GpuParticleSystem(const GpuParticleSystem&) = delete;
+    GpuParticleSystem& operator=(const GpuParticleSystem&) = delete;
+
+    // Needs a current 4.3+ context
+    void loadShaders(const char* forceShaderPath, const char* integrateShaderPath);
+
+    // Replaces the GPU state with particles, softening included
+    void upload(const ParticleSystem& particles);
+    // Writes positions, velocities and accelerations back, particles must not have changed size
+    void download(ParticleSystem& particles) const;
+
+    // One step of dt, same scheme semantics as Integrator
+    void step(IntegrationScheme scheme, float dt);
+    void computeAccelerations();
+    void invalidateAccelerations() { accelerationsValid = false; }
+
+    std::size_t size() const { return count; }
+    GLsizei getNegativeCount() const { return negativeCount; }
+    GLsizei getPositiveCount() const { return GLsizei(count) - negativeCount; }
+
+    // For particle_vert.glsl, instance i draws particle drawOrder[firstParticle + i]
+    void bindForDrawing() const;
+
+private:
+    // Positions, velocities, accelerations, draw order
+    GLuint buffers[4];
+    Shader forceShader;
+    Shader integrateShader;
+    GLint forceCountUniform;
+    GLint forceSofteningUniform;
+    GLint integrateCountUniform;
+    GLint kickUniform;
+    GLint driftUniform;
+
+    std::size_t count;
+    GLsizei negativeCount;
+    float softening2;
+    bool accelerationsValid;
+
+    void integrate(float kick, float drift);
+    void bindSimulationBuffers() const;
+    void allocateBuffers();
+    void deleteBuffersIfAllocated();
+};
+
+#endif //OPENGL_RENDERER_GPUPARTICLES_H
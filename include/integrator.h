@@ -0,0 +1,82 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_INTEGRATOR_H
+#define OPENGL_RENDERER_INTEGRATOR_H
+
+#include <cstdint>
+#include <vector>
+
+#include "particleSystem.h"
+#include "forceSolver.h"
+#include "jobSystem.h"
+
+enum class IntegrationScheme
+{
+    // Kick-drift-kick, reuses the end-of-step accelerations for the next step
+    VelocityVerlet,
+    // Drift-kick-drift, forces are evaluated at the half step
+    Leapfrog,
+    // Kick-drift-kick where every particle steps with timeStep / 2^level,
+    // only particles in close encounters take the small steps
+    BlockTimesteps,
+};
+
+const char* integrationSchemeName(IntegrationScheme scheme);
+
+// Fixed-timestep symplectic integrator. Frame time is banked in an
+// accumulator and spent in whole steps of timeStep, each split into
+// substeps, so the cost of physics does not depend on the frame rate.
+class Integrator
+{
+public:
+    IntegrationScheme scheme;
+    float timeStep;
+    int substeps;
+    // Caps the catch-up after a long frame, the remainder is dropped
+    int maxStepsPerFrame;
+    JobSystem* jobs;
+    // BlockTimesteps: the finest level, and eta of the step criterion
+    //   dt_i = eta * min(sqrt(softening / |a_i|), |a_i| / |da_i/dt|)
+    int maxTimestepLevel;
+    float timestepAccuracy;
+
+    Integrator();
+    Integrator(float timeStep, int substeps, IntegrationScheme scheme, JobSystem* jobs = nullptr);
+
+    // Returns the number of fixed steps taken
+    int advance(ParticleSystem& particles, ForceSolver& solver, float frameTime);
+    // One fixed step (all substeps), ignoring the accumulator
+    void step(ParticleSystem& particles, ForceSolver& solver);
+    // Banks frameTime and returns how many fixed steps are due, for callers
+    // that step something other than a ParticleSystem (the GPU path)
+    int consumeSteps(float frameTime);
+    float substepTime() const { return timeStep / float(substeps > 1 ? substeps : 1); }
+
+    // Fraction of a step still in the accumulator, for render interpolation
+    float alpha() const { return accumulator / timeStep; }
+    // Call when particles are added, removed or teleported
+    void invalidateAccelerations() { accelerationsValid = false; }
+
+    // BlockTimesteps: each particle's level after the last step
+    const std::vector<uint8_t>& getTimestepLevels() const { return levels; }
+
+private:
+    float accumulator;
+    bool accelerationsValid;
+
+    void velocityVerlet(ParticleSystem& particles, ForceSolver& solver, float dt);
+    void leapfrog(ParticleSystem& particles, ForceSolver& solver, float dt);
+
+    std::vector<uint8_t> levels;
+    std::vector<uint32_t> activeParticles;
+    std::vector<glm::vec3> startAccelerations;
+    // Particles per level, so the next step boundary is known without a scan
+    std::vector<uint32_t> levelCounts;
+
+    void blockTimesteps(ParticleSystem& particles, ForceSolver& solver, float dt);
+    int chooseLevel(float dt, glm::vec3 acceleration, glm::vec3 jerk, float softening) const;
+};
+
+#endif //OPENGL_RENDERER_INTEGRATOR_H
@@ -0,0 +1,86 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_JOBSYSTEM_H
+#define OPENGL_RENDERER_JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// body(begin, end, threadIndex), threadIndex is in [0, JobSystem::threadCount())
+// and can be used to pick a per-thread scratch buffer.
+typedef std::function<void(std::size_t, std::size_t, unsigned int)> ParallelForBody;
+
+// Work-stealing thread pool. Every thread owns a deque, pops its own work
+// from the back and steals from the front of the others. The thread that
+// calls parallelFor() works on the loop too, as thread index 0 unless it
+// is itself a worker. Calls from outside threads are serialized.
+class JobSystem
+{
+public:
+    // 0 workers means one per hardware thread, minus the calling thread
+    explicit JobSystem(unsigned int workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned int threadCount() const { return (unsigned int) queues.size(); }
+
+    // Splits [begin, end) into chunks of chunkSize and blocks until all ran.
+    // Chunk boundaries only depend on the arguments, never on scheduling.
+    // If a body throws, the chunks not started yet are skipped and the first
+    // exception is rethrown here, on the calling thread, once the rest finished.
+    void parallelFor(std::size_t begin, std::size_t end, std::size_t chunkSize, const ParallelForBody& body);
+
+private:
+    // One parallelFor() call, shared by its tasks, alive until pending reaches 0
+    struct Loop
+    {
+        std::atomic<std::size_t> pending;
+        std::atomic<bool> failed;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+
+    struct Task
+    {
+        const ParallelForBody* body;
+        std::size_t begin;
+        std::size_t end;
+        Loop* loop;
+    };
+
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> queuedTasks;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    // Outside threads share slot 0, so they take turns
+    std::recursive_mutex externalMutex;
+    bool stopping;
+
+    void workerLoop(unsigned int index);
+    bool runOneTask(unsigned int index);
+    unsigned int currentThreadIndex() const;
+};
+
+// Runs inline when jobs is null, so systems can take an optional JobSystem*
+void parallelFor(JobSystem* jobs, std::size_t begin, std::size_t end, std::size_t chunkSize, const ParallelForBody& body);
+
+#endif //OPENGL_RENDERER_JOBSYSTEM_H
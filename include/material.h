@@ -35,6 +35,12 @@ struct Material
     Material(glm::vec3 diffuse, glm::vec3 specular, float shininess);
     Material(std::string diffuseTex);
     Material(std::string diffuseTex, std::string specularTex);
+
+    // Owns its textures, so it moves but doesn't copy; pass it by reference
+    Material(const Material&) = delete;
+    Material& operator=(const Material&) = delete;
+    Material(Material&&) noexcept = default;
+    Material& operator=(Material&&) noexcept = default;
 };
 
 #endif //OPENGL_RENDERER_MATERIAL_H
\ No newline at end of file
@@ -6,15 +6,73 @@
 #define MESH_H
 
 #include <cmath>
+#include <cstdint>
 #include <numbers>
 #include <vector>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <string>
+#include "glHandle.h"
 #include "texture.h"
 #include "material.h"
 
+enum class TexCoordFormat
+{
+    Float,
+    // Any range, 11 significant bits
+    Half,
+    // Only [0, 1], steps of 1 / 65535
+    Unorm16,
+};
+
+// How bufferToGPU() packs a vertex. Every attribute goes into one interleaved
+// buffer; the default is plain floats, 32 bytes a vertex, which any shader
+// reading locations 0 to 2 can draw. The packed encodings need the shader to
+// decode them from the vertexFormat uniform (see mesh_vert.glsl, setVertexFormat()).
+struct VertexLayout
+{
+    // unorm16 within the mesh's bounding box, dequantized by the shader
+    // with the mesh's positionOffset and positionScale
+    bool quantizePositions = false;
+    // Two snorm16 on the octahedron map instead of three floats
+    bool octahedralNormals = false;
+    TexCoordFormat texCoords = TexCoordFormat::Float;
+
+    // 16 bytes a vertex: quantized positions, octahedral normals, half texcoords
+    static VertexLayout compact();
+};
+
+// Bytes per vertex of layout
+GLsizei vertexStride(VertexLayout layout);
+
+// Interleaved vertices in a layout's format, ready for a vertex buffer
+struct PackedVertices
+{
+    std::vector<uint8_t> bytes;
+    GLsizei stride = 0;
+    // Quantized positions: position = positionOffset + positionScale * unorm
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+};
+
+// Missing normals or texture coordinates are packed as zero
+PackedVertices packVertices(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals,
+                            const std::vector<glm::vec2>& texCoords, VertexLayout layout);
+// Quantizes positions in the given box instead of their own, so meshes packed
+// in the same box share positionOffset and positionScale. Positions outside it are clamped.
+PackedVertices packVertices(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals,
+                            const std::vector<glm::vec2>& texCoords, VertexLayout layout, glm::vec3 boundsMin, glm::vec3 boundsMax);
+
+// Points attributes 0 to 2 of the bound VAO at the bound GL_ARRAY_BUFFER, in layout's format
+void setVertexAttributes(VertexLayout layout);
+// Points attributes 3 to 6 (aModel) of the bound VAO at the bound GL_ARRAY_BUFFER, one mat4 per instance
+void setInstanceModelAttributes();
+
+// Unit vector to the octahedron map, both components in [-1, 1], and back
+glm::vec2 octahedralEncode(glm::vec3 normal);
+glm::vec3 octahedralDecode(glm::vec2 encoded);
+
 class Mesh
 {
 public:
@@ -28,28 +86,62 @@ public:
         std::vector<glm::vec3> vertices;
         std::vector<glm::vec3> normals;
         std::vector<glm::vec2> texCoords;
-        // EBO Data
+        // EBO Data, buffered as 16-bit when every index fits
         std::vector<unsigned int> indices;
+        // Read by the next bufferToGPU()
+        VertexLayout vertexLayout;
 
         Mesh();
+        // Copies take the CPU data only, the copy needs its own bufferToGPU().
+        // Moves take the GPU buffers along and leave the source empty.
         Mesh(const Mesh& other);
-        ~Mesh();
+        Mesh(Mesh&& other) noexcept;
+        Mesh& operator=(const Mesh& other);
+        Mesh& operator=(Mesh&& other) noexcept;
         void calculateModel();
         void calculateNormal();
 
         void bufferToGPU();
         void draw();
+        // instanceCount copies in one call, the shader places them by gl_InstanceID
+        void drawInstanced(GLsizei instanceCount);
+        // One copy per model matrix in one call. The matrices go to a per-instance
+        // buffer (aModel in mesh_vert.glsl), uploaded once per call.
+        void drawInstanced(const std::vector<glm::mat4>& models);
+
+        // Of the buffered vertices, for setVertexFormat()
+        VertexLayout getBufferedLayout() const { return bufferedLayout; }
+        glm::vec3 getPositionOffset() const { return positionOffset; }
+        glm::vec3 getPositionScale() const { return positionScale; }
+        std::size_t getVertexBufferBytes() const { return vertexBufferBytes; }
+        // GL_UNSIGNED_SHORT for meshes of at most 65536 vertices, else GL_UNSIGNED_INT
+        GLenum getIndexType() const { return indexType; }
+        std::size_t getIndexBufferBytes() const { return indexBufferBytes; }
 
 private:
-        GLuint VAO;
-        GLuint VBOs[3];
-        GLuint EBO;
+        GLVertexArray VAO;
+        GLBuffer VBO;
+        GLBuffer EBO;
+        VertexLayout bufferedLayout;
+        glm::vec3 positionOffset;
+        glm::vec3 positionScale;
+        std::size_t vertexBufferBytes;
+        GLenum indexType;
+        std::size_t indexBufferBytes;
+        // Per-instance model matrices, created on the first drawInstanced(models)
+        GLBuffer instanceVBO;
+        std::size_t instanceCapacity;
         void allocateBuffers();
-        void deleteBuffersIfAllocated();
+        void allocateInstanceBuffer(std::size_t capacity);
+        void deleteBuffers();
 };
 
 Mesh makeTriangle();
 
+// Same transforms as Mesh::calculateModel/calculateNormal, without needing a Mesh per object
+glm::mat4 calculateModelMatrix(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale);
+glm::mat3 calculateNormalMatrix(const glm::mat4& model);
+
 
 Mesh makefibonnacciSphere(int samples);
 #endif
@@ -0,0 +1,130 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_MESHOPTIMIZER_H
+#define OPENGL_RENDERER_MESHOPTIMIZER_H
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.h"
+
+// How triangles are reordered for the post-transform vertex cache
+enum class VertexCacheOrder
+{
+    // Keep the generator's or the file's order
+    None,
+    // Tom Forsyth's greedy scoring over a 32 entry LRU cache, not tuned to any
+    // one cache size, several times slower than Tipsify
+    Forsyth,
+    // Sander et al.'s Tipsy, a fan walk planned for a FIFO of cacheSize, linear
+    // time and the lower ACMR when the cache really is that FIFO
+    Tipsify,
+};
+
+const char* vertexCacheOrderName(VertexCacheOrder order);
+
+struct MeshOptimizeSettings
+{
+    VertexCacheOrder cacheOrder = VertexCacheOrder::Tipsify;
+    // FIFO entries Tipsify plans for and the overdraw pass and statistics simulate
+    uint32_t cacheSize = 16;
+    // Cuts the cache ordered triangles into clusters and draws the outward
+    // facing ones first, so they hide the rest behind them
+    bool optimizeOverdraw = true;
+    // A cluster may end once its own ACMR is at most this times the mesh's.
+    // Higher gives more, smaller clusters to sort, at more cache misses.
+    float overdrawThreshold = 1.05f;
+    // Renumbers vertices in the order the indices first use them, dropping unused ones
+    bool optimizeVertexFetch = true;
+};
+
+struct VertexCacheStats
+{
+    // Average cache miss ratio, vertices transformed per triangle: 3 at worst,
+    // about 0.5 at best for a large closed mesh
+    double acmr = 0.0;
+    // Average transform to vertex ratio, vertices transformed per vertex used: 1 at best
+    double atvr = 0.0;
+};
+
+struct MeshOptimizeStats
+{
+    std::size_t triangles = 0;
+    std::size_t verticesBefore = 0;
+    std::size_t verticesAfter = 0;
+    VertexCacheStats cacheBefore;
+    VertexCacheStats cacheAfter;
+    double overdrawBefore = 0.0;
+    double overdrawAfter = 0.0;
+    std::size_t clusters = 0;
+    // The optimisation alone, without the analyses
+    double seconds = 0.0;
+};
+
+// Replays indices through a FIFO vertex cache of cacheSize entries
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, std::size_t vertexCount, uint32_t cacheSize);
+// Rasterizes the triangles in order with a depth test, orthographically
+// from the 6 axis directions, without culling like the renderer. Returns the
+// fragments that passed the depth test per covered pixel, 1 at best.
+double analyzeOverdraw(const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions);
+
+// Triangle orders, the indices are permuted a triangle at a time
+void optimizeVertexCacheForsyth(std::vector<unsigned int>& indices, std::size_t vertexCount);
+void optimizeVertexCacheTipsify(std::vector<unsigned int>& indices, std::size_t vertexCount, uint32_t cacheSize);
+// Reorders cache ordered triangles for overdraw, keeping most of their
+// locality. Clusters start wherever the cache simulation restarts from
+// scratch, and are split further where their ACMR drops to threshold times
+// the mesh's, then sorted by how far out their area weighted normal faces.
+// Returns the number of clusters.
+std::size_t optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions,
+                             uint32_t cacheSize, float threshold);
+const unsigned int UNUSED_VERTEX = ~0u;
+// Renumbers vertices in order of first use and returns old -> new, with
+// UNUSED_VERTEX for vertices no triangle uses (empty if the indices are out of range)
+std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int>& indices, std::size_t vertexCount);
+
+// Applies a remap from optimizeVertexFetch to one attribute array. Arrays
+// that aren't one entry per vertex (an absent attribute) are left alone.
+template <typename T>
+void remapVertexAttribute(std::vector<T>& attribute, const std::vector<unsigned int>& remap, std::size_t newCount)
+{
+    if (attribute.size() != remap.size())
+        return;
+    std::vector<T> remapped(newCount);
+    for (std::size_t i = 0; i < remap.size(); i++)
+    {
+        if (remap[i] != UNUSED_VERTEX)
+            remapped[remap[i]] = attribute[i];
+    }
+    attribute.swap(remapped);
+}
+
+// How close two vertices must be for weldVertices() to merge them, the
+// largest difference per component. A negative epsilon leaves that attribute
+// out, the merged vertex keeps the first one's value.
+struct WeldSettings
+{
+    // At least 0, 0 merges only identical positions
+    float positionEpsilon = 1e-6f;
+    float normalEpsilon = 1e-3f;
+    float texCoordEpsilon = 1e-6f;
+};
+
+// Merges vertices whose attributes all match within settings, each onto the
+// first of them, and drops triangles that collapse to a line or point.
+// Positions are hashed on a grid of positionEpsilon cells, so a vertex is
+// only compared with those in its own and the neighbouring cells. Returns
+// the number of vertices removed.
+std::size_t weldVertices(Mesh& mesh, const WeldSettings& settings = WeldSettings());
+
+// The whole pass on a mesh's CPU data: cache order, overdraw, then vertex
+// fetch order. Call before bufferToGPU(). Stats, when given, are filled in
+// before and after, which costs more than the pass itself.
+void optimizeMesh(Mesh& mesh, const MeshOptimizeSettings& settings = MeshOptimizeSettings(), MeshOptimizeStats* stats = nullptr);
+
+#endif //OPENGL_RENDERER_MESHOPTIMIZER_H
@@ -0,0 +1,124 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_PARTICLEINCELL_H
+#define OPENGL_RENDERER_PARTICLEINCELL_H
+
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "fft.h"
+#include "forceSolver.h"
+#include "jobSystem.h"
+
+// How a particle's charge is spread over the grid, and its field read back
+enum class ChargeAssignment
+{
+    // Linear weights over the 2 nearest cells per axis
+    CloudInCell,
+    // Quadratic weights over the 3 nearest cells per axis, smoother and less grid noise
+    TriangularShapedCloud,
+};
+
+const char* chargeAssignmentName(ChargeAssignment assignment);
+
+// Weights of the cells first, first + 1, first + 2 along one axis for grid
+// coordinate u (cell centres at integers), returns first. CIC leaves the third at zero.
+inline int chargeAssignmentWeights(ChargeAssignment assignment, float u, float weights[3])
+{
+    if (assignment == ChargeAssignment::CloudInCell)
+    {
+        float cell = std::floor(u);
+        float f = u - cell;
+        weights[0] = 1.0f - f;
+        weights[1] = f;
+        weights[2] = 0.0f;
+        return int(cell);
+    }
+    float cell = std::floor(u + 0.5f);
+    float d = u - cell;
+    weights[0] = 0.5f * (0.5f - d) * (0.5f - d);
+    weights[1] = 0.75f - d * d;
+    weights[2] = 0.5f * (0.5f + d) * (0.5f + d);
+    return int(cell) - 1;
+}
+
+// A NaN or infinite coordinate (a blown-up close encounter) has no cell, the
+// grid solvers leave such particles out of the fit, deposit and gather
+inline bool isFinitePosition(glm::vec3 position)
+{
+    return std::isfinite(position.x) && std::isfinite(position.y) && std::isfinite(position.z);
+}
+
+// u into [low, high] while still a float, NaN to low, so the cast in
+// chargeAssignmentWeights stays defined and the cells it returns in range
+inline float clampGridCoordinate(float u, float low, float high)
+{
+    if (!(u >= low))
+        return low;
+    return std::min(u, high);
+}
+
+// Particle-in-cell: the charge is deposited on a cubic grid around the
+// particles, the potential comes from one FFT convolution with 1 / r, and
+// the field (central differences of the potential) is interpolated back with
+// the same weights, which keeps the self-force at zero. O(N + G^3 log G) for
+// G cells per side, the force is smoothed below about two cells, so it suits
+// large smooth plasmas rather than close encounters.
+//
+// The boundaries are open (Hockney's method): the charge grid is zero padded
+// to twice its size per side, so the circular convolution never wraps one
+// particle's charge onto another. The grid is refitted to the particles'
+// bounding cube every evaluation.
+//
+// Deposit and gather run over particles in parallel, the deposit into one
+// grid per job thread that are summed afterwards. A deterministic solver
+// deposits into DETERMINISTIC_SPLIT_COUNT grids instead, one per fixed
+// range of particles.
+class ParticleInCellSolver : public ForceSolver
+{
+public:
+    // Cells per side, a power of two (at least 8)
+    uint32_t gridSize;
+    ChargeAssignment assignment;
+    JobSystem* jobs;
+
+    ParticleInCellSolver();
+    ParticleInCellSolver(uint32_t gridSize, ChargeAssignment assignment, JobSystem* jobs = nullptr);
+
+    const char* name() const override;
+    void computeAccelerations(ParticleSystem& particles) override;
+
+    // Grid of the last evaluation, cell (i, j, k) is centred at origin + cellSize * (i, j, k)
+    glm::vec3 getOrigin() const { return origin; }
+    float getCellSize() const { return cellSize; }
+
+private:
+    RealFft3D fft;
+    // Spectrum of 1 / |n| on the doubled grid with unit cells, real since the kernel is even
+    std::vector<double> greenSpectrum;
+    uint32_t greenGridSize;
+    // gridSize^3 charges per job thread, or per particle range when deterministic
+    std::vector<std::vector<double>> partialCharges;
+    // Doubled grid: charge, then potential
+    std::vector<double> padded;
+    std::vector<Complex> spectrum;
+    // gridSize^3, E in units of charge / length^2 like the Coulomb kernels
+    std::vector<float> fieldX, fieldY, fieldZ;
+    glm::vec3 origin;
+    float cellSize;
+
+    void fitGrid(const ParticleSystem& particles);
+    void buildGreenFunction();
+    void depositCharge(const ParticleSystem& particles);
+    void solvePotential();
+    void computeField();
+    void gatherAccelerations(ParticleSystem& particles);
+};
+
+#endif //OPENGL_RENDERER_PARTICLEINCELL_H
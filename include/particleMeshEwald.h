@@ -0,0 +1,77 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_PARTICLEMESHEWALD_H
+#define OPENGL_RENDERER_PARTICLEMESHEWALD_H
+
+#include <cstdint>
+#include <vector>
+
+#include "fft.h"
+#include "forceSolver.h"
+#include "jobSystem.h"
+#include "particleInCell.h"
+
+// Coulomb forces in a periodic box (particles.box), summed over every image.
+//
+// Ewald splits 1 / r into erfc(alpha r) / r, which dies off within the cutoff
+// and is summed over pairs directly (nearest image, periodic cells), and
+// erf(alpha r) / r, which is smooth and summed in Fourier space. Particle-mesh
+// Ewald does the Fourier part on a grid: charges are deposited with the PIC
+// assignment weights, multiplied by 4 pi exp(-k^2 / 4 alpha^2) / (k^2 V) with
+// the assignment's transform divided out twice, and each field component comes
+// back through one inverse FFT (ik differentiation) and the same weights.
+// O(N log N) for a fixed density when the grid grows with N.
+//
+// The k = 0 term is dropped, so a box with net charge behaves as if a uniform
+// background cancelled it. The cutoff is capped at half the box side.
+class ParticleMeshEwaldSolver : public ForceSolver
+{
+public:
+    // Cells per side, a power of two (at least 8)
+    uint32_t gridSize;
+    ChargeAssignment assignment;
+    // Real-space cutoff in grid cells. alpha is set so erfc(alpha * cutoff) is
+    // about 1e-5, and more cells push the grid's error down with it.
+    float cutoffCells;
+    JobSystem* jobs;
+
+    ParticleMeshEwaldSolver();
+    ParticleMeshEwaldSolver(uint32_t gridSize, ChargeAssignment assignment, float cutoffCells, JobSystem* jobs = nullptr);
+
+    const char* name() const override;
+    void computeAccelerations(ParticleSystem& particles) override;
+
+    // Of the last evaluation
+    float getCutoff() const { return cutoff; }
+    float getSplitting() const { return alpha; }
+
+private:
+    RealFft3D fft;
+    // Per spectrum entry: 4 pi exp(-k^2 / 4 alpha^2) / (k^2 V W(k)^2)
+    std::vector<double> influence;
+    // Wavenumber per grid frequency, 0 at Nyquist so the derivative stays real
+    std::vector<double> wavenumbers;
+    uint32_t influenceGridSize;
+    ChargeAssignment influenceAssignment;
+    float influenceSide, influenceAlpha;
+    float cutoff, alpha;
+    // gridSize^3 charges per job thread, or per particle range when deterministic
+    std::vector<std::vector<double>> partialCharges;
+    std::vector<double> charges;
+    std::vector<Complex> spectrum, fieldSpectrum;
+    // gridSize^3 reciprocal-space field, one component at a time through scratch
+    std::vector<double> scratch;
+    std::vector<float> fieldX, fieldY, fieldZ;
+    // Real-space cells: counting sort of the particles, cells side >= cutoff
+    std::vector<uint32_t> cellStart, sortedIndices, particleCell, cursor;
+
+    void buildInfluenceFunction(float side);
+    void depositCharge(const ParticleSystem& particles, float side);
+    void solveField();
+    void gatherAccelerations(ParticleSystem& particles, float side);
+    void addRealSpace(ParticleSystem& particles, float side);
+};
+
+#endif //OPENGL_RENDERER_PARTICLEMESHEWALD_H
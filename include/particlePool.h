@@ -0,0 +1,105 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_PARTICLEPOOL_H
+#define OPENGL_RENDERER_PARTICLEPOOL_H
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "particleSystem.h"
+
+const uint32_t INVALID_PARTICLE_SLOT = 0xFFFFFFFFu;
+
+// Names one spawned particle for as long as it lives. The slot is reused after
+// a despawn, the generation then no longer matches and the handle goes stale.
+struct ParticleHandle
+{
+    uint32_t slot;
+    uint32_t generation;
+
+    ParticleHandle();
+    ParticleHandle(uint32_t slot, uint32_t generation);
+
+    bool isValid() const { return slot != INVALID_PARTICLE_SLOT; }
+};
+
+// Spawns and despawns particles in a ParticleSystem without shifting it.
+//
+// A despawned particle leaves a hole: zero charge and velocity, so it neither
+// pushes nor moves and the force kernels need no special case. The next spawn
+// fills the newest hole. compact() moves particles from the end into the holes
+// and truncates, so the arrays are contiguous again and only the moved
+// particles change index. Handles go through a slot table and survive all of it.
+//
+// Holes are still slots of the ParticleSystem, compact before handing it to
+// anything that treats every slot as a particle (drawing, recording). Spawning
+// into a hole or compacting changes which particle an index means, call
+// Integrator::invalidateAccelerations() after either. After reserve() nothing
+// allocates until the pool outgrows the reservation.
+class ParticlePool
+{
+public:
+    ParticleSystem particles;
+    // compactIfFragmented() compacts once more than this fraction of slots are holes
+    float maxHoleFraction;
+
+    ParticlePool();
+
+    void reserve(std::size_t capacity);
+    void clear();
+
+    ParticleHandle spawn(ParticleSpecies species, glm::vec3 position, glm::vec3 velocity = glm::vec3(0.0f));
+    ParticleHandle spawn(float particleCharge, float particleMass, glm::vec3 position, glm::vec3 velocity);
+    // False if the handle was already stale
+    bool despawn(ParticleHandle handle);
+    // Despawns every live particle whose index satisfies predicate(index), returns how many
+    template <typename Predicate>
+    std::size_t despawnIf(Predicate predicate);
+
+    bool isAlive(ParticleHandle handle) const;
+    // Current index into particles, INVALID_PARTICLE_SLOT for a stale handle
+    uint32_t indexOf(ParticleHandle handle) const;
+    // Invalid handle for a hole
+    ParticleHandle handleAt(std::size_t index) const;
+    bool isHole(std::size_t index) const { return owners[index] == INVALID_PARTICLE_SLOT; }
+
+    std::size_t liveCount() const { return particles.size() - holes.size(); }
+    std::size_t holeCount() const { return holes.size(); }
+
+    void compact();
+    // Returns true if it compacted
+    bool compactIfFragmented();
+
+private:
+    // Per handle slot: its particle index (INVALID_PARTICLE_SLOT while free) and generation
+    std::vector<uint32_t> slotIndices;
+    std::vector<uint32_t> slotGenerations;
+    std::vector<uint32_t> freeSlots;
+    // Per particle index: the handle slot owning it, INVALID_PARTICLE_SLOT for a hole
+    std::vector<uint32_t> owners;
+    std::vector<uint32_t> holes;
+
+    void despawnIndex(std::size_t index);
+};
+
+template <typename Predicate>
+std::size_t ParticlePool::despawnIf(Predicate predicate)
+{
+    std::size_t despawned = 0;
+    for (std::size_t i = 0; i < particles.size(); i++)
+    {
+        if (!isHole(i) && predicate(i))
+        {
+            despawnIndex(i);
+            despawned++;
+        }
+    }
+    return despawned;
+}
+
+#endif //OPENGL_RENDERER_PARTICLEPOOL_H
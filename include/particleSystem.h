@@ -0,0 +1,171 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_PARTICLESYSTEM_H
+#define OPENGL_RENDERER_PARTICLESYSTEM_H
+
+#include <glm/vec3.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#include <new>
+#include <vector>
+
+#include "electrons.h"
+#include "jobSystem.h"
+
+// Width of the widest float kernel (AVX = 8 lanes). Arrays are padded to a
+// multiple of this so the kernels never need a scalar tail.
+constexpr std::size_t PARTICLE_SIMD_WIDTH = 8;
+constexpr std::size_t PARTICLE_ALIGNMENT = 32;
+
+template <typename T, std::size_t Alignment>
+struct AlignedAllocator
+{
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t n)
+    {
+        std::size_t bytes = (n * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+#ifdef _WIN32
+        void* ptr = _aligned_malloc(bytes, Alignment);
+#else
+        void* ptr = std::aligned_alloc(Alignment, bytes);
+#endif
+        if (ptr == nullptr)
+            throw std::bad_alloc();
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, std::size_t)
+    {
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+typedef std::vector<float, AlignedAllocator<float, PARTICLE_ALIGNMENT>> AlignedFloats;
+
+enum class ParticleSpecies
+{
+    Electron,
+    Proton,
+};
+
+// Charge in elementary charges, mass in kg.
+float speciesCharge(ParticleSpecies species);
+float speciesMass(ParticleSpecies species);
+
+// The box and its 26 neighbours, what the renderer draws of a periodic box
+const int PERIODIC_IMAGE_COUNT = 27;
+
+// The cube [-side / 2, side / 2)^3 repeated in every direction, side 0 means
+// open boundaries. Only ParticleMeshEwaldSolver sums over the images, the
+// other solvers treat a periodic box as open.
+struct PeriodicBox
+{
+    float side;
+
+    PeriodicBox() : side(0.0f) {}
+    explicit PeriodicBox(float side) : side(side) {}
+
+    bool isPeriodic() const { return side > 0.0f; }
+
+    // Into [-side / 2, side / 2)
+    float wrap(float x) const { return x - side * std::floor(x / side + 0.5f); }
+    // The shortest of the separations d + n * side
+    float minimumImage(float d) const { return d - side * std::round(d / side); }
+    glm::vec3 wrap(glm::vec3 p) const { return glm::vec3(wrap(p.x), wrap(p.y), wrap(p.z)); }
+    glm::vec3 minimumImage(glm::vec3 d) const { return glm::vec3(minimumImage(d.x), minimumImage(d.y), minimumImage(d.z)); }
+    // Image 0 is the box itself, 1 .. PERIODIC_IMAGE_COUNT - 1 the neighbours sharing a face, edge or corner
+    glm::vec3 imageOffset(int image) const
+    {
+        int k = image == 0 ? 13 : (image <= 13 ? image - 1 : image);
+        return glm::vec3(float(k % 3 - 1), float(k / 3 % 3 - 1), float(k / 9 - 1)) * side;
+    }
+};
+
+// Structure-of-arrays particle store. Every array holds paddedSize() floats;
+// the padding past size() is kept at zero charge so it never contributes.
+class ParticleSystem
+{
+public:
+    AlignedFloats posX, posY, posZ;
+    AlignedFloats velX, velY, velZ;
+    AlignedFloats accX, accY, accZ;
+    AlignedFloats charge;
+    AlignedFloats mass;
+
+    // Plummer softening length, keeps close approaches (and the padding) finite.
+    // Must be greater than zero.
+    float softening;
+    // drift() wraps positions back into a periodic box
+    PeriodicBox box;
+
+    ParticleSystem();
+
+    std::size_t size() const { return count; }
+    std::size_t paddedSize() const { return posX.size(); }
+
+    void reserve(std::size_t capacity);
+    void clear();
+    std::size_t addParticle(ParticleSpecies species, glm::vec3 position, glm::vec3 velocity = glm::vec3(0.0f));
+    std::size_t addParticle(float particleCharge, float particleMass, glm::vec3 position, glm::vec3 velocity);
+    // Overwrites particle i, acceleration zeroed
+    void setParticle(std::size_t i, float particleCharge, float particleMass, glm::vec3 position, glm::vec3 velocity);
+    // Copies every array of particle `from` into `to`
+    void moveParticle(std::size_t from, std::size_t to);
+    // Drops the particles past newCount, keeping the padding zeroed. Never frees or allocates.
+    void truncate(std::size_t newCount);
+
+    glm::vec3 position(std::size_t i) const { return glm::vec3(posX[i], posY[i], posZ[i]); }
+    glm::vec3 velocity(std::size_t i) const { return glm::vec3(velX[i], velY[i], velZ[i]); }
+    glm::vec3 acceleration(std::size_t i) const { return glm::vec3(accX[i], accY[i], accZ[i]); }
+
+    // Coulomb acceleration on every particle from every other particle.
+    void computeAccelerations();
+    void computeAccelerations(std::size_t begin, std::size_t end);
+    // v += a * dt and x += v * dt, the building blocks of the integrators
+    void kick(float dt, JobSystem* jobs = nullptr);
+    void drift(float dt, JobSystem* jobs = nullptr);
+    // Every position into the box, drift() does it after each step
+    void wrapPositions(JobSystem* jobs = nullptr);
+
+private:
+    std::size_t count;
+    void resizeArrays(std::size_t padded);
+};
+
+// a_i = K q_i / m_i * sum_j q_j (p_i - p_j) / (|p_i - p_j|^2 + eps^2)^(3/2)
+// for i in [begin, end), against all paddedSize() sources.
+void coulombAccelerationsScalar(ParticleSystem& particles, std::size_t begin, std::size_t end);
+void coulombAccelerationsSimd(ParticleSystem& particles, std::size_t begin, std::size_t end);
+// The same sums with Kahan compensation, accurate to a few ulps however many
+// sources there are. Without AVX the SIMD one is the scalar one.
+void coulombAccelerationsCompensatedScalar(ParticleSystem& particles, std::size_t begin, std::size_t end);
+void coulombAccelerationsCompensatedSimd(ParticleSystem& particles, std::size_t begin, std::size_t end);
+
+#endif //OPENGL_RENDERER_PARTICLESYSTEM_H
@@ -0,0 +1,91 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_PARTICLETRAILS_H
+#define OPENGL_RENDERER_PARTICLETRAILS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "camera.h"
+#include "shader.h"
+
+// Frames the GPU may still be drawing trails from while the CPU writes new ones
+const uint32_t TRAIL_FRAMES_IN_FLIGHT = 3;
+
+// Fading lines through the last trailLength positions of every particle,
+// all drawn by one glDrawArrays.
+//
+// The history is one persistently mapped buffer of rows, each holding one
+// frame's position and charge for every particle. record() writes a single
+// row, so a frame costs O(particles) however long the trails are, and the
+// oldest row is simply overwritten. Line vertices come from gl_VertexID in
+// particleTrail_vert.glsl, which reads both ends of its segment from the
+// rows, so there is no vertex buffer to rebuild.
+//
+// The buffer has TRAIL_FRAMES_IN_FLIGHT rows more than the trails need, and
+// a fence after each draw: the row record() writes was last read that many
+// frames ago, and it waits on that frame's fence, which has almost always passed.
+class ParticleTrails
+{
+public:
+    // Positions per trail, the newest included. A new length restarts the trails.
+    uint32_t trailLength;
+    glm::vec3 negativeColor;
+    glm::vec3 positiveColor;
+
+    ParticleTrails();
+    ~ParticleTrails();
+
+    ParticleTrails(const ParticleTrails&) = delete;
+    ParticleTrails& operator=(const ParticleTrails&) = delete;
+
+    void loadShaders(const char* vertexShaderPath, const char* fragmentShaderPath);
+
+    // Appends one position per particle. A different particle count than
+    // the last call restarts every trail from these positions.
+    void record(const std::vector<glm::vec3>& positions, const std::vector<float>& charges);
+    // Segments longer than maxSegmentLength are left out, so a particle
+    // wrapping around a periodic box or a playback seek leaves no line across the scene
+    void draw(const Camera& camera, float maxSegmentLength);
+    // Forgets the history, the next record() starts new trails
+    void clear();
+
+    std::size_t getParticleCount() const { return particleCount; }
+    // Positions each trail has so far, at most trailLength
+    uint32_t getRecordedLength() const { return recordedRows; }
+
+private:
+    Shader shader;
+    GLint projectionUniform;
+    GLint viewUniform;
+    GLint rowStrideUniform;
+    GLint rowCountUniform;
+    GLint newestRowUniform;
+    GLint pointsPerTrailUniform;
+    GLint maxSegmentLengthUniform;
+    GLint negativeColorUniform;
+    GLint positiveColorUniform;
+
+    GLuint historyBuffer;
+    // Written straight into by record(), mapped for the buffer's whole life
+    glm::vec4* history;
+    GLuint emptyVAO;
+    std::size_t particleCount;
+    uint32_t allocatedLength;
+    uint32_t rowCount;
+    uint32_t newestRow;
+    uint32_t recordedRows;
+    uint64_t frame;
+    GLsync fences[TRAIL_FRAMES_IN_FLIGHT + 1];
+
+    void allocate(std::size_t count);
+    void release();
+};
+
+#endif //OPENGL_RENDERER_PARTICLETRAILS_H
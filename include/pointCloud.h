@@ -0,0 +1,140 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_POINTCLOUD_H
+#define OPENGL_RENDERER_POINTCLOUD_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "camera.h"
+#include "pointCloudFile.h"
+#include "shader.h"
+
+struct PointCloudStats
+{
+    std::size_t nodesDrawn = 0;
+    std::size_t pointsDrawn = 0;
+    std::size_t residentNodes = 0;
+    // Nodes asked of the loader and not uploaded yet
+    std::size_t pendingLoads = 0;
+    // This frame
+    std::size_t uploads = 0;
+    std::size_t evictions = 0;
+    // Since open()
+    std::size_t totalUploads = 0;
+    std::size_t totalEvictions = 0;
+};
+
+// Draws a point cloud octree file (pointCloudFile.h) of any size, streaming
+// nodes in as the camera needs them. Only the header and node table are
+// read up front.
+//
+// Each frame update() walks the octree from the root, most coarse on screen
+// first: a node whose point spacing projects to more than maxScreenSpaceError
+// pixels is refined into its children, but only once it is resident itself,
+// so detail always arrives coarse to fine. Missing nodes are queued for a
+// loader thread that reads them from the file.
+//
+// VRAM is one vertex buffer of vramBudgetBytes cut into slots of
+// maxNodePoints points, allocated by open() and never grown. A loaded node
+// takes a free slot, or the slot of the node drawn least recently; nodes
+// drawn this frame are never evicted, so when the budget is full refinement
+// simply stops. Every drawn node is one range of one glMultiDrawArrays.
+class PointCloud
+{
+public:
+    // In pixels
+    float maxScreenSpaceError;
+    // Caps the bytes uploaded in one update(), so a burst of loads spreads over frames
+    std::size_t uploadBytesPerFrame;
+    // Largest point sprite, in pixels
+    float maxPointSize;
+
+    PointCloud();
+    ~PointCloud();
+
+    PointCloud(const PointCloud&) = delete;
+    PointCloud& operator=(const PointCloud&) = delete;
+
+    bool open(const std::string& path, std::size_t vramBudgetBytes);
+    void close();
+    bool isOpen() const { return loader.joinable(); }
+
+    void loadShaders(const char* vertexShaderPath, const char* fragmentShaderPath);
+
+    // Chooses the nodes to draw, queues missing ones and uploads finished loads
+    void update(const Camera& camera, int viewportHeight);
+    // The nodes update() chose that are resident
+    void draw(const Camera& camera, int viewportHeight);
+
+    const PointCloudStats& getStats() const { return stats; }
+    const PointCloudFileHeader& getHeader() const { return header; }
+    std::size_t getSlotCount() const { return slotCount; }
+    std::size_t getBudgetBytes() const { return slotCount * slotBytes(); }
+
+private:
+    enum class NodeState : uint8_t { Absent, Requested, Resident };
+
+    struct LoadedNode
+    {
+        uint32_t node;
+        std::vector<CloudPoint> points;
+    };
+
+    PointCloudFileHeader header;
+    std::vector<PointCloudNodeRecord> nodes;
+    // Main thread only
+    std::vector<NodeState> nodeStates;
+    std::vector<int32_t> nodeSlots;
+    std::vector<uint64_t> nodeLastDrawn;
+    // Levels below a drawn node that are drawn in full, valid for this frame's drawn nodes
+    std::vector<uint8_t> nodeRefinedDepth;
+    std::vector<int32_t> slotNodes;
+    std::vector<float> slotSpacing;
+    std::size_t slotCount;
+    uint64_t frame;
+    std::vector<uint32_t> drawNodes;
+    std::vector<GLint> drawFirsts;
+    std::vector<GLsizei> drawCounts;
+    PointCloudStats stats;
+
+    // Loader thread, requests and completed loads under loaderMutex
+    std::thread loader;
+    std::ifstream file;
+    std::mutex loaderMutex;
+    std::condition_variable loaderCondition;
+    std::deque<uint32_t> requests;
+    std::deque<LoadedNode> completed;
+    bool stopping;
+
+    Shader shader;
+    GLint cameraProjectionUniform;
+    GLint cameraViewUniform;
+    GLint projectionScaleUniform;
+    GLint pointsPerSlotUniform;
+    GLint maxPointSizeUniform;
+    GLuint VAO;
+    GLuint VBO;
+    GLuint spacingSSBO;
+
+    std::size_t slotBytes() const { return std::size_t(header.maxNodePoints) * sizeof(CloudPoint); }
+    void loaderLoop();
+    void selectNodes(const Camera& camera, int viewportHeight, std::vector<uint32_t>& wanted);
+    void uploadCompletedLoads();
+    int32_t acquireSlot();
+    void updateSlotSpacing();
+};
+
+#endif //OPENGL_RENDERER_POINTCLOUD_H
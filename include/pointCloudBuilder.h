@@ -0,0 +1,94 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_POINTCLOUDBUILDER_H
+#define OPENGL_RENDERER_POINTCLOUDBUILDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "pointCloudFile.h"
+
+// Where the builder reads points from. It makes several passes, so a source
+// must be able to start over and return the same points in the same order.
+class PointSource
+{
+public:
+    virtual ~PointSource() = default;
+    virtual void rewind() = 0;
+    // Up to maxCount points into out, 0 once the source is exhausted
+    virtual std::size_t read(CloudPoint* out, std::size_t maxCount) = 0;
+};
+
+// A file of raw CloudPoint records back to back
+class RawPointFileSource : public PointSource
+{
+public:
+    bool open(const std::string& path);
+    void rewind() override;
+    std::size_t read(CloudPoint* out, std::size_t maxCount) override;
+
+private:
+    std::ifstream file;
+};
+
+// A rolling terrain of count points over a side x side square around the
+// origin, coloured by height. Point i depends on nothing but i and the seed,
+// so it can be generated again on every pass instead of being stored.
+class SyntheticPointSource : public PointSource
+{
+public:
+    SyntheticPointSource(uint64_t count, float side, uint64_t seed = 1);
+    void rewind() override { next = 0; }
+    std::size_t read(CloudPoint* out, std::size_t maxCount) override;
+
+private:
+    uint64_t count;
+    float side;
+    uint64_t seed;
+    uint64_t next;
+};
+
+struct PointCloudBuildSettings
+{
+    uint32_t maxNodePoints = 32768;
+    // Cells per side of a node's sampling grid, the node's point spacing is its side / samplingGridSize
+    uint32_t samplingGridSize = 128;
+    // The cloud is split into chunks of at most this many points (when the
+    // counting grid is fine enough), each built into a subtree in memory on its own
+    std::size_t maxChunkPoints = std::size_t(1) << 22;
+    // Cells per side of the grid the chunks are cut from, a power of two
+    uint32_t countingGridSize = 128;
+    // Points held per chunk before they are appended to its temporary file
+    std::size_t distributeBufferPoints = 8192;
+};
+
+struct PointCloudBuildStats
+{
+    uint64_t inputPoints = 0;
+    uint64_t writtenPoints = 0;
+    // Coincident points beyond what the deepest level can hold
+    uint64_t droppedPoints = 0;
+    std::size_t chunkCount = 0;
+    std::size_t largestChunkPoints = 0;
+    std::size_t nodeCount = 0;
+    uint32_t depth = 0;
+    double boundsSeconds = 0.0;
+    double countSeconds = 0.0;
+    double distributeSeconds = 0.0;
+    double buildSeconds = 0.0;
+};
+
+// Builds the octree file out of core: one pass for the bounds, one counting
+// points on a coarse grid to cut the cloud into chunks, one appending every
+// point to its chunk's temporary file (outputPath.chunkN, removed after),
+// then each chunk is loaded and built on its own. Only the top node of every
+// chunk stays in memory until the levels above the chunks have sampled from
+// them, so memory is one chunk plus one node per chunk, whatever the input size.
+bool buildPointCloud(PointSource& source, const std::string& outputPath,
+                     const PointCloudBuildSettings& settings, PointCloudBuildStats* stats = nullptr);
+
+#endif //OPENGL_RENDERER_POINTCLOUDBUILDER_H
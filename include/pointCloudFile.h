@@ -0,0 +1,60 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_POINTCLOUDFILE_H
+#define OPENGL_RENDERER_POINTCLOUDFILE_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+// Point cloud octree file layout (little-endian), written by buildPointCloud():
+//   PointCloudFileHeader
+//   node points, CloudPoint[pointCount] per node, nodes in no particular order
+//   PointCloudNodeRecord[nodeCount] at nodeTableOffset, written last
+//
+// Every point is stored once, in the shallowest node that sampled it. An
+// inner node keeps at most one point per cell of a samplingGridSize^3 grid
+// over its cube and hands the rest to its children, so drawing a node and
+// all its ancestors gives the cloud at that node's point spacing. No node
+// holds more than maxNodePoints points.
+
+const uint32_t POINT_CLOUD_VERSION = 1;
+const int32_t POINT_CLOUD_NO_NODE = -1;
+
+// 16 bytes, the vertex layout the renderer draws straight from
+struct CloudPoint
+{
+    glm::vec3 position;
+    uint8_t color[4];
+};
+static_assert(sizeof(CloudPoint) == 16, "CloudPoint is read and written as raw bytes");
+
+struct PointCloudFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t nodeCount;
+    uint32_t rootNode;
+    uint64_t pointCount;
+    uint64_t nodeTableOffset;
+    float boundsMin[3];
+    float boundsSide;
+    uint32_t maxNodePoints;
+    uint32_t samplingGridSize;
+};
+
+struct PointCloudNodeRecord
+{
+    uint64_t offset;
+    uint32_t pointCount;
+    uint32_t level;
+    // Node indices, POINT_CLOUD_NO_NODE for an empty octant. Child c covers
+    // the octant with x, y, z above the centre in bits 0, 1, 2 of c.
+    int32_t children[8];
+    float center[3];
+    float halfSide;
+};
+
+#endif //OPENGL_RENDERER_POINTCLOUDFILE_H
@@ -19,6 +19,7 @@
 #include "material.h"
 #include "camera.h"
 #include "mesh.h"
+#include "glHandle.h"
 
 struct DirLightUniform;
 struct PointLightUniform;
@@ -26,16 +27,22 @@ struct SpotLightUniform;
 struct MaterialUniform;
 struct CameraUniform;
 struct MeshUniform;
+struct VertexFormatUniform;
+class GeometryArena;
 
 class Shader
 {
 public:
-    // Program ID
-    unsigned int ID;
+    // Program ID, deleted with the Shader. Moving a Shader hands the program over.
+    GLProgram ID;
     std::vector<unsigned int> shaders;
 
     Shader();
-    ~Shader();
+
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+    Shader(Shader&&) noexcept = default;
+    Shader& operator=(Shader&&) noexcept = default;
 
     void compileVertexShader(const char* shaderPath);
     void compileFragmentShader(const char* shaderPath);
@@ -56,10 +63,12 @@ public:
     MaterialUniform getMaterialUniform(std::string uniformName);
     CameraUniform getCameraUniform(std::string uniformName);
     MeshUniform getMeshUniform(std::string uniformName);
+    VertexFormatUniform getVertexFormatUniform(std::string uniformName);
 };
 
 void setBool(GLint uniform, bool value);
 void setInt(GLint uniform, int value);
+void setUInt(GLint uniform, unsigned int value);
 void setFloat(GLint uniform, float value);
 void setVec2(GLint uniform, glm::vec2 vec);
 void setVec3(GLint uniform, glm::vec3 vec);
@@ -69,9 +78,13 @@ void setMat3(GLint uniform, glm::mat3 mat);
 void setDirLight(DirLightUniform uniform, DirLight dirLight);
 void setPointLight(PointLightUniform uniform, PointLight pointLight);
 void setSpotLight(SpotLightUniform uniform, SpotLight spotLight);
-void setMaterial(MaterialUniform uniform, Material material);
+void setMaterial(MaterialUniform uniform, const Material& material);
 void setCamera(CameraUniform uniform, Camera camera);
 void setMesh(MeshUniform uniform, Mesh& mesh);
+void setMesh(MeshUniform uniform, const glm::mat4& model, const glm::mat3& normal);
+// How the mesh's vertex buffer is packed, set before drawing it
+void setVertexFormat(VertexFormatUniform uniform, const Mesh& mesh);
+void setVertexFormat(VertexFormatUniform uniform, const GeometryArena& arena);
 
 struct DirLightUniform {
     GLint direction;
@@ -140,4 +153,12 @@ struct MeshUniform
     GLint normal;
 };
 
+struct VertexFormatUniform
+{
+    GLint quantizedPositions;
+    GLint positionOffset;
+    GLint positionScale;
+    GLint octahedralNormals;
+};
+
 #endif
@@ -0,0 +1,113 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_SIMULATIONTHREAD_H
+#define OPENGL_RENDERER_SIMULATIONTHREAD_H
+
+#include <glm/vec3.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "forceSolver.h"
+#include "integrator.h"
+#include "particleSystem.h"
+#include "trajectory.h"
+#include "tripleBuffer.h"
+
+// What the renderer needs of one simulation state
+struct ParticleSnapshot
+{
+    std::vector<glm::vec3> positions;
+    std::vector<float> charges;
+    // The particles' PeriodicBox side, 0 for open boundaries
+    float boxSide;
+    double simulationTime;
+    // steadySeconds() when it was published
+    double publishTime;
+    uint64_t step;
+    // Bumped on every resume, snapshots of different epochs aren't blended
+    uint32_t epoch;
+
+    ParticleSnapshot();
+};
+
+// Monotonic wall clock in seconds, shared by both threads
+double steadySeconds();
+
+// How far to blend from previous to current when drawing at `now`. The
+// renderer stays one snapshot behind and moves from previous to current over
+// the wall time that separated their publication. 1 (draw current as is)
+// when the two don't belong to the same run.
+float snapshotBlend(const ParticleSnapshot& previous, const ParticleSnapshot& current, double now);
+
+// Steps the CPU simulation in real time on its own thread and publishes a
+// snapshot after every batch of steps, so a slow step delays the next
+// snapshot instead of the next frame.
+//
+// While running, the thread owns the particles, the integrator and the
+// recorder. setPaused(true) returns once the thread is idle, after that the
+// caller may touch them (GPU upload, opening a recording) until it resumes.
+class SimulationThread
+{
+public:
+    SimulationThread();
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void start(ParticleSystem& particles, Integrator& integrator, ForceSolver* solver, TrajectoryRecorder* recorder = nullptr);
+    void stop();
+    bool isRunning() const { return worker.joinable(); }
+
+    void setPaused(bool paused);
+    bool isPaused() const { return pauseRequested.load(std::memory_order_relaxed); }
+
+    // Picked up before the next step
+    void setForceSolver(ForceSolver* solver) { requestedSolver.store(solver, std::memory_order_relaxed); }
+    void setSubsteps(int substeps) { requestedSubsteps.store(substeps, std::memory_order_relaxed); }
+    void setScheme(IntegrationScheme scheme) { requestedScheme.store(scheme, std::memory_order_relaxed); }
+    int getSubsteps() const { return requestedSubsteps.load(std::memory_order_relaxed); }
+    IntegrationScheme getScheme() const { return requestedScheme.load(std::memory_order_relaxed); }
+
+    // Render thread reads through update() / readBuffer()
+    TripleBuffer<ParticleSnapshot>& snapshots() { return exchange; }
+
+private:
+    std::thread worker;
+    ParticleSystem* particles;
+    Integrator* integrator;
+    TrajectoryRecorder* recorder;
+
+    std::atomic<ForceSolver*> requestedSolver;
+    std::atomic<int> requestedSubsteps;
+    std::atomic<IntegrationScheme> requestedScheme;
+
+    // Pausing is a handshake, only the snapshots are exchanged lock-free
+    std::mutex controlMutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable idleCondition;
+    std::atomic<bool> pauseRequested;
+    std::atomic<bool> stopping;
+    bool idle;
+
+    TripleBuffer<ParticleSnapshot> exchange;
+    // Simulation thread only
+    double simulationTime;
+    uint64_t stepCount;
+    uint32_t epoch;
+
+    void run();
+    // Returns false once stopping
+    bool waitWhilePaused();
+    void publishSnapshot();
+};
+
+#endif //OPENGL_RENDERER_SIMULATIONTHREAD_H
@@ -0,0 +1,52 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_SPHEREIMPOSTORS_H
+#define OPENGL_RENDERER_SPHEREIMPOSTORS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Spheres drawn as one camera-facing quad of 4 vertices each, ray-cast in
+// particleImpostor_frag.glsl for an exact silhouette, depth and per-pixel
+// lighting at any size. The quad corners come from gl_VertexID, so the only
+// vertex data is the per-instance centre. The radius is a uniform, one draw
+// per sphere size.
+class SphereImpostors
+{
+public:
+    SphereImpostors();
+    ~SphereImpostors();
+
+    SphereImpostors(const SphereImpostors&) = delete;
+    SphereImpostors& operator=(const SphereImpostors&) = delete;
+
+    // One sphere per centre in one call. The centres go to a per-instance
+    // buffer (aCenter in particleImpostor_vert.glsl), uploaded once per call.
+    // imagesPerCenter must match the shader's imageCount - firstImage, each
+    // centre then stays bound for that many instances, one per periodic image.
+    void draw(const std::vector<glm::vec3>& centers, GLuint imagesPerCenter = 1);
+    // instanceCount spheres, the shader takes the centres from the particle
+    // SSBO (useParticleBuffer)
+    void drawInstanced(GLsizei instanceCount);
+
+private:
+    GLuint VAO;
+    // No attributes at all, for drawInstanced(count)
+    GLuint emptyVAO;
+    GLuint instanceVBO;
+    std::size_t instanceCapacity;
+    GLuint divisor;
+
+    void allocateInstanceBuffer(std::size_t capacity);
+};
+
+// Radius in pixels a sphere covers on screen at the given distance from the
+// camera, for choosing between an impostor and a real mesh
+float projectedRadiusPixels(const glm::mat4& projection, float viewportHeight, float distance, float radius);
+
+#endif //OPENGL_RENDERER_SPHEREIMPOSTORS_H
@@ -0,0 +1,85 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_SPSCRING_H
+#define OPENGL_RENDERER_SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. The producer only writes head, the consumer only writes tail, and
+// each sits on its own cache line so the two sides don't false-share.
+template <typename T>
+class SpscRing
+{
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(std::size_t capacity = 64)
+        : head(0),
+          tail(0)
+    {
+        reset(capacity);
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const { return slots.size(); }
+
+    // Empties and resizes the ring, neither side may be using it
+    void reset(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+        {
+            size *= 2;
+        }
+        slots.assign(size, T());
+        mask = size - 1;
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    // Producer side, false if the ring is full
+    bool push(const T& value)
+    {
+        std::size_t writeIndex = head.load(std::memory_order_relaxed);
+        if (writeIndex - tail.load(std::memory_order_acquire) == slots.size())
+        {
+            return false;
+        }
+        slots[writeIndex & mask] = value;
+        head.store(writeIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, false if the ring is empty
+    bool pop(T& value)
+    {
+        std::size_t readIndex = tail.load(std::memory_order_relaxed);
+        if (readIndex == head.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        value = slots[readIndex & mask];
+        tail.store(readIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate unless called from one of the two owning threads while the other is idle
+    std::size_t size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> slots;
+    std::size_t mask;
+    alignas(64) std::atomic<std::size_t> head;
+    alignas(64) std::atomic<std::size_t> tail;
+};
+
+#endif //OPENGL_RENDERER_SPSCRING_H
@@ -10,6 +10,7 @@
 #include <stb_image.h>
 
 #include "glm/vec3.hpp"
+#include "glHandle.h"
 #include <vector>
 #include <string>
 #include <unordered_map>
@@ -22,6 +23,7 @@ struct TextureManager
 {
     // Allegedly we want the fast lookup of a vector, (runtime)
     // but also the convenience of a hashtable (loadtime)
+    // Textures are moved, never copied, when the vector grows
     std::vector<Texture> textures;
     std::unordered_map<std::string, TextureID> textureMap;
 
@@ -42,16 +44,50 @@ public:
     bool isResident;
     // Fun fact: 1GB = 256 4-channel 1024x1024 textures
 
+    // Owned, freed with the Texture
     unsigned char *texData;
 
     Texture();
     Texture(std::string filename);
     ~Texture();
 
+    // One owner for the GL texture and the pixels, moving leaves the source empty
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+    Texture(Texture&& other) noexcept;
+    Texture& operator=(Texture&& other) noexcept;
+
     void loadFromFile(std::string filename);
     void loadToGPU();
     void unloadFromGPU();
 
+    GLTexture id;
+};
+
+// A 3D texture filled from memory rather than loaded from a file, for volume
+// data that changes every frame. Storage is immutable, upload() replaces the
+// contents in place. No GL calls until allocate(), so it can be a member of
+// something constructed before the context exists.
+class Texture3D
+{
+public:
+    int width;
+    int height;
+    int depth;
+    GLenum internalFormat;
+
+    Texture3D();
+    ~Texture3D();
+
+    Texture3D(const Texture3D&) = delete;
+    Texture3D& operator=(const Texture3D&) = delete;
+
+    // Reallocates only if the size or format changed. filter is GL_LINEAR or GL_NEAREST.
+    void allocate(int width, int height, int depth, GLenum internalFormat, GLint filter);
+    // width * height * depth texels of format / type, x fastest
+    void upload(GLenum format, GLenum type, const void* data);
+    void bind(GLuint unit) const;
+
     GLuint id;
 };
 
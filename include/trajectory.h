@@ -0,0 +1,166 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_TRAJECTORY_H
+#define OPENGL_RENDERER_TRAJECTORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "particleSystem.h"
+#include "spscRing.h"
+
+// Trajectory file layout (little-endian):
+//   TrajectoryFileHeader
+//   float charge[particleCount], float mass[particleCount]
+//   chunks: TrajectoryChunkHeader + compressed payload
+//   TrajectoryIndexEntry[chunkCount] + TrajectoryFooter, written on close
+//
+// A chunk's raw payload is frameCount frames of
+//   double time, float posX/Y/Z[particleCount], float velX/Y/Z[particleCount]
+// as 32-bit words. Every word is XORed with the same word of the previous
+// frame (the chunk's first frame with zero, so chunks decode on their own),
+// the words are split into four byte planes and the planes are run-length
+// coded. Slowly moving particles leave the high bytes unchanged, so most of
+// the top planes collapse into zero runs.
+//
+// Without a footer (the writer died) the reader walks the chunk headers instead.
+
+const uint32_t TRAJECTORY_VERSION = 1;
+
+struct TrajectoryFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t particleCount;
+    uint32_t framesPerChunk;
+};
+
+struct TrajectoryChunkHeader
+{
+    char magic[4];
+    uint32_t frameCount;
+    uint64_t firstFrame;
+    uint64_t rawSize;
+    uint64_t compressedSize;
+};
+
+struct TrajectoryIndexEntry
+{
+    uint64_t offset;
+    uint64_t firstFrame;
+    uint64_t frameCount;
+};
+
+struct TrajectoryFooter
+{
+    uint64_t indexOffset;
+    uint64_t chunkCount;
+    char magic[4];
+    uint32_t version;
+};
+
+// Appends frames from the simulation thread without blocking it. record()
+// copies the state into a preallocated frame slot and hands the slot to a
+// writer thread through an SPSC ring, a second ring returns used slots.
+// When every slot is in flight the frame is dropped and counted.
+class TrajectoryRecorder
+{
+public:
+    TrajectoryRecorder();
+    ~TrajectoryRecorder();
+
+    TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+    TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+    // The particle count (and charges, masses) is fixed for the whole file
+    bool open(const std::string& path, const ParticleSystem& particles, std::size_t bufferedFrames = 64);
+    // Waits for the writer to drain, then writes the index
+    void close();
+    bool isOpen() const { return writer.joinable(); }
+
+    // False if the frame was dropped or the particle count changed
+    bool record(const ParticleSystem& particles, double time);
+
+    std::size_t getRecordedFrames() const { return recordedFrames; }
+    std::size_t getDroppedFrames() const { return droppedFrames; }
+
+private:
+    std::ofstream file;
+    std::thread writer;
+    std::atomic<bool> stopping;
+    std::size_t particleCount;
+    std::size_t frameWords;
+    uint32_t framesPerChunk;
+
+    // Slot s holds frameWords words starting at s * frameWords
+    std::vector<uint32_t> slotData;
+    SpscRing<uint32_t> filledSlots;
+    SpscRing<uint32_t> freeSlots;
+    std::size_t recordedFrames;
+    std::size_t droppedFrames;
+
+    // Writer thread only
+    std::vector<uint32_t> chunkWords;
+    std::vector<uint32_t> previousFrame;
+    std::vector<uint8_t> compressed;
+    std::vector<TrajectoryIndexEntry> index;
+    uint32_t chunkFrames;
+    uint64_t writtenFrames;
+
+    void writerLoop();
+    void appendFrame(uint32_t slot);
+    void flushChunk();
+};
+
+// Memory-maps a trajectory file and decodes frames on demand. The most recent
+// chunk stays decoded, so playing forward only pays for each chunk once.
+class TrajectoryReader
+{
+public:
+    TrajectoryReader();
+    ~TrajectoryReader();
+
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+
+    std::size_t getFrameCount() const { return frameCount; }
+    std::size_t getParticleCount() const { return particleCount; }
+
+    // Writes frame's positions and velocities into particles, rebuilding it
+    // with the recorded charges and masses if its size doesn't match
+    bool readFrame(std::size_t frame, ParticleSystem& particles, double* time = nullptr);
+
+private:
+    const uint8_t* data;
+    std::size_t fileSize;
+#if defined(_WIN32)
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+    std::size_t particleCount;
+    std::size_t frameCount;
+    const float* charges;
+    const float* masses;
+    std::vector<TrajectoryIndexEntry> index;
+
+    std::size_t decodedChunk;
+    std::vector<uint32_t> decodedWords;
+
+    bool loadIndex(std::size_t payloadStart);
+    bool decodeChunk(std::size_t chunk);
+};
+
+#endif //OPENGL_RENDERER_TRAJECTORY_H
@@ -0,0 +1,70 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_TRIPLEBUFFER_H
+#define OPENGL_RENDERER_TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free latest-value exchange between one writer thread and one reader
+// thread. The writer fills its back buffer and publishes it by swapping it
+// with the middle one, the reader takes the middle one by swapping it with
+// its front buffer. Neither side ever waits: the writer overwrites a middle
+// buffer the reader never picked up, the reader keeps its front buffer until
+// something newer arrives.
+//
+// The middle buffer's index and a "not yet read" bit share one atomic byte,
+// so each swap is a single exchange.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer()
+        : middle(1),
+          back(0),
+          front(2)
+    {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Writer side: the buffer to fill, keeps its old contents so it can be updated in place
+    T& writeBuffer() { return buffers[back]; }
+
+    // Writer side: hands writeBuffer() to the reader
+    void publish()
+    {
+        uint8_t previous = middle.exchange(uint8_t(back | FRESH_BIT), std::memory_order_acq_rel);
+        back = previous & INDEX_MASK;
+    }
+
+    // Reader side: swaps in the newest published buffer, false if nothing was published since the last call
+    bool update()
+    {
+        if ((middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+        {
+            return false;
+        }
+        uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & INDEX_MASK;
+        return true;
+    }
+
+    // Reader side: stays valid and unchanged until the next update()
+    const T& readBuffer() const { return buffers[front]; }
+
+private:
+    static const uint8_t FRESH_BIT = 0x4;
+    static const uint8_t INDEX_MASK = 0x3;
+
+    T buffers[3];
+    // Shared, written by both sides
+    alignas(64) std::atomic<uint8_t> middle;
+    // Owned by the writer and the reader respectively, kept apart to avoid false sharing
+    alignas(64) uint8_t back;
+    alignas(64) uint8_t front;
+};
+
+#endif //OPENGL_RENDERER_TRIPLEBUFFER_H
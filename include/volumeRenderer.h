@@ -0,0 +1,79 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#ifndef OPENGL_RENDERER_VOLUMERENDERER_H
+#define OPENGL_RENDERER_VOLUMERENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "camera.h"
+#include "chargeDensityVolume.h"
+#include "shader.h"
+
+// Draws a ChargeDensityVolume over whatever is in the bound framebuffer:
+// emission-absorption ray marching, negative density blue and positive red,
+// stopped at the scene's depth so opaque geometry hides the volume behind it.
+//
+// The march runs at 1 / downsample of the resolution per axis, each ray
+// stopping at the nearest depth of the pixels it stands for. A full
+// resolution pass then composites it, weighting the 4 nearest low resolution
+// samples by how close their depth is to the pixel's, so volume doesn't bleed
+// across silhouettes. Empty macro cells are crossed in one step.
+class VolumeRenderer
+{
+public:
+    // 1 marches every pixel, 2 a quarter of them
+    int downsample;
+    bool skipEmptySpace;
+    // Optical depth across one voxel at the volume's largest |density|. Per
+    // voxel rather than per unit length, so the look doesn't change as the
+    // grid refits to particles spreading out.
+    float voxelOpticalDepth;
+    // Samples per voxel along a ray
+    float samplesPerVoxel;
+
+    VolumeRenderer();
+    ~VolumeRenderer();
+
+    VolumeRenderer(const VolumeRenderer&) = delete;
+    VolumeRenderer& operator=(const VolumeRenderer&) = delete;
+
+    void loadShaders(const char* vertexShaderPath, const char* raymarchShaderPath, const char* upsampleShaderPath);
+
+    // width and height are the bound framebuffer's, its depth is copied
+    // before anything is drawn. Restores the framebuffer, viewport, blending
+    // and depth state it changes.
+    void render(const ChargeDensityVolume& volume, const Camera& camera, int width, int height);
+
+private:
+    Shader raymarchShader;
+    Shader upsampleShader;
+    GLint inverseViewProjectionUniform;
+    GLint cameraPositionUniform;
+    GLint volumeMinUniform;
+    GLint volumeSideUniform;
+    GLint macroGridSizeUniform;
+    GLint densityScaleUniform;
+    GLint stepLengthUniform;
+    GLint skipEmptySpaceUniform;
+    GLint marchDownsampleUniform;
+    GLint upsampleInverseViewProjectionUniform;
+    GLint upsampleCameraPositionUniform;
+    GLint upsampleDownsampleUniform;
+    GLuint emptyVAO;
+    // Full resolution copy of the scene depth
+    GLuint sceneDepth;
+    // Low resolution march: premultiplied colour and the depth each ray stopped at
+    GLuint marchFramebuffer;
+    GLuint marchColor;
+    GLuint marchDepth;
+    int fullWidth, fullHeight;
+    int marchWidth, marchHeight;
+
+    void allocateTargets(int width, int height);
+    void deleteTargets();
+};
+
+#endif //OPENGL_RENDERER_VOLUMERENDERER_H
@@ -1,9 +1,9 @@
-#version 460 core
+#version 450 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
-// Instanced
-//layout (location = 3) in mat4 aModel;
+// Instanced, one model matrix per instance (locations 3 to 6)
+layout (location = 3) in mat4 aModel;
 
 out vec3 FragPos;
 out vec3 Normal;
@@ -15,6 +15,13 @@ struct Camera {
     vec3 position;
 };
 
+struct VertexFormat {
+    bool quantizedPositions; // aPos is unorm16, the position is positionOffset + positionScale * aPos
+    vec3 positionOffset;
+    vec3 positionScale;
+    bool octahedralNormals; // aNormal.xy is the normal on the octahedron map
+};
+
 struct Mesh {
     mat4 model; // Mesh transformation matrix
     mat3 normal; // Mesh normal transformation matrix
@@ -22,23 +29,36 @@ struct Mesh {
 
 uniform Mesh mesh;
 uniform Camera camera;
-
-//uniform mat4 projection;
-//uniform mat4 view;
-//uniform mat4 model;
-//uniform mat3 normal;
+uniform VertexFormat vertexFormat;
 
 // if false, use model uniform
 // if true, use aModels layout
-//uniform bool renderInstanced;
+uniform bool renderInstanced;
+
+// Mesh::vertexLayout's packed encodings, left unset the attributes are plain floats
+vec3 decodePosition(vec3 position)
+{
+    return vertexFormat.quantizedPositions ? vertexFormat.positionOffset + vertexFormat.positionScale * position : position;
+}
+
+vec3 decodeNormal(vec3 normal)
+{
+    if (!vertexFormat.octahedralNormals)
+        return normal;
+    vec3 n = vec3(normal.xy, 1.0 - abs(normal.x) - abs(normal.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
 
 void main()
 {
-    //mat4 modelMatrix = renderInstanced ? aModel : model;
-    //mat3 normalMatrix = transpose(inverse(mat3(model)));
+    mat4 modelMatrix = renderInstanced ? aModel : mesh.model;
+    // Computed per vertex so the instance buffer only has to carry the model matrix
+    mat3 normalMatrix = renderInstanced ? transpose(inverse(mat3(aModel))) : mesh.normal;
 
-    FragPos = vec3(mesh.model * vec4(aPos, 1.0));
-    Normal = mesh.normal * aNormal;
+    FragPos = vec3(modelMatrix * vec4(decodePosition(aPos), 1.0));
+    Normal = normalMatrix * decodeNormal(aNormal);
     TexCoords = aTexCoords;
 
     // Converted to screenspace
@@ -0,0 +1,56 @@
+#version 450 core
+// 4.50 rather than 4.60 so this also runs on Mesa llvmpipe
+// All-pairs Coulomb accelerations. Each work group walks the particles one
+// tile at a time, staging the tile's positions in shared memory so every
+// invocation reads them from there instead of from the SSBO.
+#define TILE_SIZE 256
+layout (local_size_x = TILE_SIZE) in;
+
+// xyz position, w charge
+layout (std430, binding = 0) readonly buffer Positions { vec4 positions[]; };
+// xyz velocity, w coulomb_coupling * q / m
+layout (std430, binding = 1) readonly buffer Velocities { vec4 velocities[]; };
+layout (std430, binding = 2) writeonly buffer Accelerations { vec4 accelerations[]; };
+
+uniform uint particleCount;
+uniform float softening2;
+
+shared vec4 tile[TILE_SIZE];
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    vec3 self = i < particleCount ? positions[i].xyz : vec3(0.0);
+
+    // precise stops the compiler fusing multiply-adds, the sum is evaluated
+    // in the same order as coulombAccelerationsScalar so the results match
+    precise float ax = 0.0;
+    precise float ay = 0.0;
+    precise float az = 0.0;
+    for (uint base = 0; base < particleCount; base += TILE_SIZE)
+    {
+        uint j = base + gl_LocalInvocationID.x;
+        tile[gl_LocalInvocationID.x] = j < particleCount ? positions[j] : vec4(0.0);
+        barrier();
+
+        uint tileCount = min(uint(TILE_SIZE), particleCount - base);
+        for (uint k = 0; k < tileCount; k++)
+        {
+            precise float dx = self.x - tile[k].x;
+            precise float dy = self.y - tile[k].y;
+            precise float dz = self.z - tile[k].z;
+            precise float r2 = dx * dx + dy * dy + dz * dz + softening2;
+            precise float s = tile[k].w / (r2 * sqrt(r2));
+            ax += s * dx;
+            ay += s * dy;
+            az += s * dz;
+        }
+        barrier();
+    }
+
+    if (i < particleCount)
+    {
+        float coef = velocities[i].w;
+        accelerations[i] = vec4(coef * ax, coef * ay, coef * az, 0.0);
+    }
+}
@@ -0,0 +1,43 @@
+#version 450 core
+// Hits are never nearer than the quad, so early depth testing still works
+layout (depth_greater) out float gl_FragDepth;
+out vec4 FragColor;
+
+in vec3 RayTarget;
+flat in vec3 SphereCenter;
+flat in float SphereRadius;
+
+struct Camera {
+    mat4 projection; // Camera projection transformation matrix
+    mat4 view; // Camera view transformation matrix
+    vec3 position;
+};
+
+uniform Camera camera;
+
+// lighting_frag.glsl
+vec3 lightFragment(vec3 fragPos, vec3 normal);
+
+void main()
+{
+    // Eye ray against the sphere, nearest root of |o + t d - c|^2 = r^2
+    vec3 origin = camera.position;
+    vec3 direction = normalize(RayTarget - origin);
+    vec3 offset = origin - SphereCenter;
+    float b = dot(offset, direction);
+    float c = dot(offset, offset) - SphereRadius * SphereRadius;
+    float discriminant = b * b - c;
+    if (discriminant < 0.0)
+    {
+        discard;
+    }
+    float t = -b - sqrt(discriminant);
+    vec3 hit = origin + t * direction;
+    vec3 normal = (hit - SphereCenter) / SphereRadius;
+
+    vec4 clip = camera.projection * camera.view * vec4(hit, 1.0);
+    float ndcDepth = clip.z / clip.w;
+    gl_FragDepth = (gl_DepthRange.diff * ndcDepth + gl_DepthRange.near + gl_DepthRange.far) * 0.5;
+
+    FragColor = vec4(lightFragment(hit, normal), 1.0);
+}
@@ -0,0 +1,74 @@
+#version 450 core
+// Instanced sphere centre, unused when useParticleBuffer is set
+layout (location = 0) in vec3 aCenter;
+
+// World space point on the quad, the fragment shader casts the eye ray through it
+out vec3 RayTarget;
+flat out vec3 SphereCenter;
+flat out float SphereRadius;
+
+struct Camera {
+    mat4 projection; // Camera projection transformation matrix
+    mat4 view; // Camera view transformation matrix
+    vec3 position;
+};
+
+uniform Camera camera;
+uniform float radius;
+// Centres from the compute shaders' SSBO instead of aCenter, as in particle_vert.glsl
+uniform bool useParticleBuffer;
+uniform uint firstParticle;
+// Periodic images: every centre is drawn imageCount - firstImage times, once per
+// image in [firstImage, imageCount), shifted by boxSide. Image 0 is the box
+// itself, 1..26 its neighbours, the order of PeriodicBox::imageOffset().
+uniform float boxSide;
+uniform int firstImage;
+uniform int imageCount;
+
+layout (std430, binding = 0) readonly buffer Positions { vec4 positions[]; };
+layout (std430, binding = 3) readonly buffer DrawOrder { uint drawOrder[]; };
+
+vec3 imageOffset(int image)
+{
+    // Skip over the middle of the 3x3x3 block, which image 0 already is
+    int k = image == 0 ? 13 : (image <= 13 ? image - 1 : image);
+    return vec3(float(k % 3 - 1), float(k / 3 % 3 - 1), float(k / 9 - 1)) * boxSide;
+}
+
+void main()
+{
+    // The instanced attribute advances once per imagesPerCenter instances.
+    // Left unset the uniforms are 0, one image per centre with no offset.
+    int imagesPerCenter = max(imageCount - firstImage, 1);
+    int centerIndex = gl_InstanceID / imagesPerCenter;
+    vec3 center = useParticleBuffer ? positions[drawOrder[firstParticle + uint(centerIndex)]].xyz : aCenter;
+    center += imageOffset(firstImage + gl_InstanceID % imagesPerCenter);
+    SphereCenter = center;
+    SphereRadius = radius;
+
+    // Triangle strip corners from the vertex index, no vertex buffer
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+
+    vec3 toCenter = center - camera.position;
+    float dist = length(toCenter);
+    if (dist <= radius * 1.001)
+    {
+        // Camera inside the sphere, nothing sensible to draw
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+        RayTarget = center;
+        return;
+    }
+    // The quad faces the camera at the sphere's nearest point. There the
+    // silhouette cone has radius r * sqrt((d - r) / (d + r)), so the quad
+    // covers the sphere exactly under perspective, and every hit lies behind
+    // it, which is what lets the fragment shader promise depth_greater.
+    vec3 axis = toCenter / dist;
+    vec3 helper = abs(axis.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 right = normalize(cross(helper, axis));
+    vec3 up = cross(axis, right);
+    float halfSize = radius * sqrt((dist - radius) / (dist + radius));
+    vec3 planeCenter = camera.position + axis * (dist - radius);
+
+    RayTarget = planeCenter + (corner.x * right + corner.y * up) * halfSize;
+    gl_Position = camera.projection * camera.view * vec4(RayTarget, 1.0);
+}
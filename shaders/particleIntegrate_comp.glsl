@@ -0,0 +1,34 @@
+#version 450 core
+// v += a * kick, then x += v * drift. A zero step skips that half, so one
+// program covers the kick-drift and drift-only passes of both schemes.
+layout (local_size_x = 256) in;
+
+layout (std430, binding = 0) buffer Positions { vec4 positions[]; };
+layout (std430, binding = 1) buffer Velocities { vec4 velocities[]; };
+layout (std430, binding = 2) readonly buffer Accelerations { vec4 accelerations[]; };
+
+uniform uint particleCount;
+uniform float kick;
+uniform float drift;
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= particleCount)
+    {
+        return;
+    }
+
+    // precise keeps the multiply and add separate, as in ParticleSystem::kick and drift
+    precise vec3 velocity = velocities[i].xyz;
+    if (kick != 0.0)
+    {
+        velocity = velocity + accelerations[i].xyz * kick;
+        velocities[i].xyz = velocity;
+    }
+    if (drift != 0.0)
+    {
+        precise vec3 position = positions[i].xyz + velocity * drift;
+        positions[i].xyz = position;
+    }
+}
@@ -0,0 +1,41 @@
+#version 450 core
+out vec4 TrailColor;
+
+uniform mat4 projection;
+uniform mat4 view;
+// History rows, each one frame of every particle, the newest at newestRow
+uniform uint rowStride;
+uniform uint rowCount;
+uniform uint newestRow;
+uniform uint pointsPerTrail;
+uniform float maxSegmentLength;
+uniform vec3 negativeColor;
+uniform vec3 positiveColor;
+
+// Position in xyz, charge in w
+layout (std430, binding = 5) readonly buffer TrailHistory { vec4 history[]; };
+
+vec4 historyAt(uint particle, uint age)
+{
+    uint row = (newestRow + rowCount - age) % rowCount;
+    return history[row * rowStride + particle];
+}
+
+void main()
+{
+    // Two vertices per segment, pointsPerTrail - 1 segments per particle, newest first
+    uint segmentsPerTrail = pointsPerTrail - 1u;
+    uint segment = uint(gl_VertexID) >> 1;
+    uint particle = segment / segmentsPerTrail;
+    uint end = uint(gl_VertexID) & 1u;
+    uint age = segment % segmentsPerTrail + end;
+    vec4 point = historyAt(particle, age);
+    vec4 other = historyAt(particle, end == 1u ? age - 1u : age + 1u);
+
+    gl_Position = projection * view * vec4(point.xyz, 1.0);
+    // Both ends of a dropped segment go beyond the far plane, so the line is culled
+    if (point.w == 0.0 || distance(point.xyz, other.xyz) > maxSegmentLength)
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+    float fade = 1.0 - float(age) / float(segmentsPerTrail);
+    TrailColor = vec4(point.w < 0.0 ? negativeColor : positiveColor, fade);
+}
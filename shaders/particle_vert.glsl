@@ -0,0 +1,66 @@
+#version 450 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+struct Camera {
+    mat4 projection; // Camera projection transformation matrix
+    mat4 view; // Camera view transformation matrix
+    vec3 position;
+};
+
+struct VertexFormat {
+    bool quantizedPositions; // aPos is unorm16, the position is positionOffset + positionScale * aPos
+    vec3 positionOffset;
+    vec3 positionScale;
+    bool octahedralNormals; // aNormal.xy is the normal on the octahedron map
+};
+
+struct Mesh {
+    mat4 model; // Mesh transformation matrix, without the particle's translation
+    mat3 normal; // Mesh normal transformation matrix
+};
+
+uniform Mesh mesh;
+uniform Camera camera;
+uniform VertexFormat vertexFormat;
+// First particle slot of this draw, each species is a contiguous range
+uniform uint firstParticle;
+
+// Written by the particle compute shaders, xyz position, w charge
+layout (std430, binding = 0) readonly buffer Positions { vec4 positions[]; };
+// Particle indices grouped by species
+layout (std430, binding = 3) readonly buffer DrawOrder { uint drawOrder[]; };
+
+// Mesh::vertexLayout's packed encodings, left unset the attributes are plain floats
+vec3 decodePosition(vec3 position)
+{
+    return vertexFormat.quantizedPositions ? vertexFormat.positionOffset + vertexFormat.positionScale * position : position;
+}
+
+vec3 decodeNormal(vec3 normal)
+{
+    if (!vertexFormat.octahedralNormals)
+        return normal;
+    vec3 n = vec3(normal.xy, 1.0 - abs(normal.x) - abs(normal.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+void main()
+{
+    // One instance per particle
+    vec3 particlePosition = positions[drawOrder[firstParticle + gl_InstanceID]].xyz;
+
+    FragPos = vec3(mesh.model * vec4(decodePosition(aPos), 1.0)) + particlePosition;
+    Normal = mesh.normal * decodeNormal(aNormal);
+    TexCoords = aTexCoords;
+
+    // Converted to screenspace
+    gl_Position = camera.projection * camera.view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,26 @@
+#version 450 core
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec4 aColor;
+
+out vec3 PointColor;
+
+uniform mat4 projection;
+uniform mat4 view;
+// projection[1][1] * viewport height / 2, pixels per unit at distance 1
+uniform float projectionScale;
+uniform int pointsPerSlot;
+uniform float maxPointSize;
+
+// Point spacing of the node in each slot of the vertex buffer
+layout (std430, binding = 4) readonly buffer SlotSpacing { float slotSpacing[]; };
+
+void main()
+{
+    vec4 viewPosition = view * vec4(aPosition, 1.0);
+    gl_Position = projection * viewPosition;
+    // Every node starts its slot's range, and a draw's first is part of gl_VertexID
+    float spacing = slotSpacing[gl_VertexID / pointsPerSlot];
+    // One point's spacing across, so neighbouring points just close the gaps
+    gl_PointSize = clamp(spacing * projectionScale / max(-viewPosition.z, 1.0e-4), 1.0, maxPointSize);
+    PointColor = aColor.rgb;
+}
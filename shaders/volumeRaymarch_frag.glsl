@@ -0,0 +1,103 @@
+#version 450 core
+// Emission-absorption march through the charge density, one ray per low
+// resolution pixel. Writes premultiplied colour and the distance the ray
+// stopped at, for the depth-aware upsample in volumeUpsample_frag.glsl.
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out float RayDepth;
+
+layout (binding = 0) uniform sampler2D sceneDepth;
+layout (binding = 1) uniform sampler3D density;
+// Min and max density per macro cell, border voxels included
+layout (binding = 2) uniform sampler3D macroRanges;
+
+uniform mat4 inverseViewProjection;
+uniform vec3 cameraPosition;
+uniform vec3 volumeMin;
+uniform float volumeSide;
+uniform int macroGridSize;
+// Extinction per unit length per unit |density|
+uniform float densityScale;
+uniform float stepLength;
+uniform bool skipEmptySpace;
+// Full resolution pixels per low resolution pixel, per axis
+uniform int downsample;
+
+const vec3 negativeColor = vec3(0.2, 0.45, 1.0);
+const vec3 positiveColor = vec3(1.0, 0.3, 0.15);
+// Macro cells whose extinction stays below this are treated as empty
+const float emptyExtinction = 1.0e-3;
+const int maxSteps = 2048;
+
+// Distance from the camera to the surface behind full resolution pixel `pixel`
+float sceneDistance(ivec2 pixel)
+{
+    float depth = texelFetch(sceneDepth, pixel, 0).r;
+    vec2 ndc = (vec2(pixel) + 0.5) / vec2(textureSize(sceneDepth, 0)) * 2.0 - 1.0;
+    vec4 world = inverseViewProjection * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+    return length(world.xyz / world.w - cameraPosition);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec2 ndc = gl_FragCoord.xy * float(downsample) / vec2(textureSize(sceneDepth, 0)) * 2.0 - 1.0;
+    vec4 farPoint = inverseViewProjection * vec4(ndc, 1.0, 1.0);
+    vec3 direction = normalize(farPoint.xyz / farPoint.w - cameraPosition);
+
+    // The nearest surface among the pixels this ray stands for, so the
+    // volume never shows in front of geometry it should be behind
+    float stopDistance = 1.0e30;
+    ivec2 fullSize = textureSize(sceneDepth, 0);
+    for (int y = 0; y < downsample; y++)
+    {
+        for (int x = 0; x < downsample; x++)
+        {
+            ivec2 fullPixel = min(pixel * downsample + ivec2(x, y), fullSize - 1);
+            stopDistance = min(stopDistance, sceneDistance(fullPixel));
+        }
+    }
+    RayDepth = stopDistance;
+    FragColor = vec4(0.0);
+
+    // Slab test against the volume's cube
+    vec3 safeDirection = mix(direction, vec3(1.0e-8), lessThan(abs(direction), vec3(1.0e-8)));
+    vec3 inverseDirection = 1.0 / safeDirection;
+    vec3 t0 = (volumeMin - cameraPosition) * inverseDirection;
+    vec3 t1 = (volumeMin + volumeSide - cameraPosition) * inverseDirection;
+    vec3 tNear = min(t0, t1);
+    vec3 tFar = max(t0, t1);
+    float t = max(max(max(tNear.x, tNear.y), tNear.z), 0.0);
+    float tEnd = min(min(min(tFar.x, tFar.y), tFar.z), stopDistance);
+    if (t >= tEnd)
+        return;
+
+    float macroSide = volumeSide / float(macroGridSize);
+    vec4 accumulated = vec4(0.0);
+    for (int i = 0; i < maxSteps && t < tEnd; i++)
+    {
+        vec3 position = cameraPosition + direction * t;
+        vec3 uvw = (position - volumeMin) / volumeSide;
+        if (skipEmptySpace)
+        {
+            ivec3 cell = clamp(ivec3(uvw * float(macroGridSize)), ivec3(0), ivec3(macroGridSize - 1));
+            vec2 range = texelFetch(macroRanges, cell, 0).rg;
+            if (max(-range.x, range.y) * densityScale < emptyExtinction)
+            {
+                // Out through the cell's far faces, a hair past them
+                vec3 cellMin = volumeMin + vec3(cell) * macroSide;
+                vec3 exitFaces = mix(cellMin, cellMin + macroSide, greaterThan(direction, vec3(0.0)));
+                vec3 exits = (exitFaces - cameraPosition) * inverseDirection;
+                t = max(min(min(exits.x, exits.y), exits.z), t) + 1.0e-3 * macroSide;
+                continue;
+            }
+        }
+        float rho = texture(density, uvw).r;
+        float alpha = 1.0 - exp(-abs(rho) * densityScale * stepLength);
+        vec3 color = rho < 0.0 ? negativeColor : positiveColor;
+        accumulated += (1.0 - accumulated.a) * vec4(color * alpha, alpha);
+        if (accumulated.a > 0.99)
+            break;
+        t += stepLength;
+    }
+    FragColor = accumulated;
+}
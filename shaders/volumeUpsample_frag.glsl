@@ -0,0 +1,50 @@
+#version 450 core
+// Composites the low resolution march at full resolution. Each of the 4
+// nearest march samples gets its bilinear weight, scaled down the further the
+// depth its ray stopped at is from this pixel's, so samples from the other
+// side of a silhouette barely count.
+out vec4 FragColor;
+
+layout (binding = 0) uniform sampler2D sceneDepth;
+layout (binding = 1) uniform sampler2D marchColor;
+layout (binding = 2) uniform sampler2D marchDepth;
+
+uniform mat4 inverseViewProjection;
+uniform vec3 cameraPosition;
+uniform int downsample;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 fullSize = textureSize(sceneDepth, 0);
+    float depth = texelFetch(sceneDepth, pixel, 0).r;
+    vec2 ndc = gl_FragCoord.xy / vec2(fullSize) * 2.0 - 1.0;
+    vec4 world = inverseViewProjection * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+    float pixelDistance = length(world.xyz / world.w - cameraPosition);
+
+    if (downsample == 1)
+    {
+        FragColor = texelFetch(marchColor, pixel, 0);
+        return;
+    }
+
+    ivec2 marchSize = textureSize(marchColor, 0);
+    vec2 coordinate = gl_FragCoord.xy / float(downsample) - 0.5;
+    ivec2 base = ivec2(floor(coordinate));
+    vec2 f = coordinate - vec2(base);
+    vec4 sum = vec4(0.0);
+    float weightSum = 0.0;
+    for (int y = 0; y < 2; y++)
+    {
+        for (int x = 0; x < 2; x++)
+        {
+            ivec2 neighbour = clamp(base + ivec2(x, y), ivec2(0), marchSize - 1);
+            float bilinear = (x == 1 ? f.x : 1.0 - f.x) * (y == 1 ? f.y : 1.0 - f.y);
+            float relativeGap = abs(texelFetch(marchDepth, neighbour, 0).r - pixelDistance) / pixelDistance;
+            float weight = (bilinear + 1.0e-3) / (relativeGap + 1.0e-3);
+            sum += weight * texelFetch(marchColor, neighbour, 0);
+            weightSum += weight;
+        }
+    }
+    FragColor = sum / weightSum;
+}
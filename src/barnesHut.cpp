@@ -0,0 +1,277 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "barnesHut.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// Coincident particles would otherwise split forever
+static const int MAX_TREE_DEPTH = 32;
+static const std::size_t BARNES_HUT_QUERIES_PER_TASK = 256;
+
+BarnesHutSolver::BarnesHutSolver()
+    : theta(0.5f),
+      leafSize(8),
+      jobs(nullptr)
+{}
+
+BarnesHutSolver::BarnesHutSolver(float theta, JobSystem* jobs)
+    : theta(theta),
+      leafSize(8),
+      jobs(jobs)
+{}
+
+const char* BarnesHutSolver::name() const
+{
+    return "barnes-hut";
+}
+
+void BarnesHutSolver::build(const ParticleSystem& particles)
+{
+    uint32_t n = uint32_t(particles.size());
+    nodes.clear();
+    order.resize(n);
+    scratch.resize(n);
+    octants.resize(n);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        order[i] = i;
+    }
+
+    glm::vec3 lo(0.0f);
+    glm::vec3 hi(0.0f);
+    if (n > 0)
+    {
+        lo = hi = particles.position(0);
+    }
+    for (uint32_t i = 1; i < n; i++)
+    {
+        glm::vec3 p = particles.position(i);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+    glm::vec3 extent = hi - lo;
+
+    BarnesHutNode root;
+    root.boxCenter = 0.5f * (lo + hi);
+    // Pad slightly so particles on the max face still land inside
+    root.halfSize = 0.5f * std::max(std::max(extent.x, extent.y), extent.z) * 1.001f + 1.0e-6f;
+    root.begin = 0;
+    root.end = n;
+    root.firstChild = 0;
+    root.childCount = 0;
+    nodes.push_back(root);
+    buildNode(particles, 0, 0);
+}
+
+void BarnesHutSolver::buildNode(const ParticleSystem& particles, uint32_t nodeIndex, int depth)
+{
+    uint32_t begin = nodes[nodeIndex].begin;
+    uint32_t end = nodes[nodeIndex].end;
+    if (end - begin <= leafSize || depth >= MAX_TREE_DEPTH)
+    {
+        computeLeafMoments(particles, nodes[nodeIndex]);
+        return;
+    }
+
+    // Counting sort of the node's range into its eight octants
+    glm::vec3 boxCenter = nodes[nodeIndex].boxCenter;
+    float halfSize = nodes[nodeIndex].halfSize;
+    uint32_t counts[8] = {};
+    for (uint32_t k = begin; k < end; k++)
+    {
+        uint32_t i = order[k];
+        uint8_t octant = (particles.posX[i] >= boxCenter.x ? 1 : 0)
+                       | (particles.posY[i] >= boxCenter.y ? 2 : 0)
+                       | (particles.posZ[i] >= boxCenter.z ? 4 : 0);
+        octants[i] = octant;
+        counts[octant]++;
+    }
+    uint32_t offsets[8];
+    uint32_t offset = begin;
+    for (int o = 0; o < 8; o++)
+    {
+        offsets[o] = offset;
+        offset += counts[o];
+    }
+    uint32_t starts[8];
+    std::copy(offsets, offsets + 8, starts);
+    for (uint32_t k = begin; k < end; k++)
+    {
+        uint32_t i = order[k];
+        scratch[offsets[octants[i]]++] = i;
+    }
+    std::copy(scratch.begin() + begin, scratch.begin() + end, order.begin() + begin);
+
+    uint32_t firstChild = uint32_t(nodes.size());
+    uint32_t childCount = 0;
+    float childHalf = 0.5f * halfSize;
+    for (int o = 0; o < 8; o++)
+    {
+        if (counts[o] == 0)
+            continue;
+        BarnesHutNode child;
+        child.boxCenter = boxCenter + glm::vec3(o & 1 ? childHalf : -childHalf,
+                                                o & 2 ? childHalf : -childHalf,
+                                                o & 4 ? childHalf : -childHalf);
+        child.halfSize = childHalf;
+        child.begin = starts[o];
+        child.end = starts[o] + counts[o];
+        child.firstChild = 0;
+        child.childCount = 0;
+        nodes.push_back(child);
+        childCount++;
+    }
+    nodes[nodeIndex].firstChild = firstChild;
+    nodes[nodeIndex].childCount = childCount;
+
+    for (uint32_t c = 0; c < childCount; c++)
+    {
+        buildNode(particles, firstChild + c, depth + 1);
+    }
+    computeParentMoments(nodes[nodeIndex]);
+}
+
+static void computeOpenRadius(BarnesHutNode& node, float theta)
+{
+    float openDistance = theta > 0.0f ? 2.0f * node.halfSize / theta + glm::distance(node.center, node.boxCenter) : INFINITY;
+    node.openRadius2 = openDistance * openDistance;
+}
+
+void BarnesHutSolver::computeLeafMoments(const ParticleSystem& particles, BarnesHutNode& node)
+{
+    float charge = 0.0f;
+    float absCharge = 0.0f;
+    glm::vec3 weighted(0.0f);
+    for (uint32_t k = node.begin; k < node.end; k++)
+    {
+        uint32_t i = order[k];
+        float q = particles.charge[i];
+        charge += q;
+        absCharge += std::abs(q);
+        weighted += std::abs(q) * particles.position(i);
+    }
+    node.charge = charge;
+    node.absCharge = absCharge;
+    node.center = absCharge > 0.0f ? weighted / absCharge : node.boxCenter;
+
+    glm::vec3 dipole(0.0f);
+    for (uint32_t k = node.begin; k < node.end; k++)
+    {
+        uint32_t i = order[k];
+        dipole += particles.charge[i] * (particles.position(i) - node.center);
+    }
+    node.dipole = dipole;
+    computeOpenRadius(node, theta);
+}
+
+void BarnesHutSolver::computeParentMoments(BarnesHutNode& node)
+{
+    float charge = 0.0f;
+    float absCharge = 0.0f;
+    glm::vec3 weighted(0.0f);
+    for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++)
+    {
+        const BarnesHutNode& child = nodes[c];
+        charge += child.charge;
+        absCharge += child.absCharge;
+        weighted += child.absCharge * child.center;
+    }
+    node.charge = charge;
+    node.absCharge = absCharge;
+    node.center = absCharge > 0.0f ? weighted / absCharge : node.boxCenter;
+
+    // Shift each child's dipole to the parent centre
+    glm::vec3 dipole(0.0f);
+    for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++)
+    {
+        const BarnesHutNode& child = nodes[c];
+        dipole += child.dipole + child.charge * (child.center - node.center);
+    }
+    node.dipole = dipole;
+    computeOpenRadius(node, theta);
+}
+
+glm::vec3 BarnesHutSolver::fieldAt(const ParticleSystem& particles, glm::vec3 point, std::vector<uint32_t>& stack) const
+{
+    const float eps2 = particles.softening * particles.softening;
+    glm::vec3 field(0.0f);
+
+    stack.clear();
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const BarnesHutNode& node = nodes[stack.back()];
+        stack.pop_back();
+
+        glm::vec3 d = point - node.center;
+        float r2 = glm::dot(d, d);
+        if (r2 > node.openRadius2)
+        {
+            // E = Q d / r^3 + 3 (D.d) d / r^5 - D / r^3
+            r2 += eps2;
+            float invR = 1.0f / std::sqrt(r2);
+            float invR3 = invR * invR * invR;
+            float invR5 = invR3 * invR * invR;
+            field += (node.charge * invR3 + 3.0f * glm::dot(node.dipole, d) * invR5) * d - node.dipole * invR3;
+        }
+        else if (node.childCount == 0)
+        {
+            for (uint32_t k = node.begin; k < node.end; k++)
+            {
+                uint32_t j = order[k];
+                glm::vec3 dj = point - particles.position(j);
+                float rj2 = glm::dot(dj, dj) + eps2;
+                field += particles.charge[j] / (rj2 * std::sqrt(rj2)) * dj;
+            }
+        }
+        else
+        {
+            for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++)
+            {
+                stack.push_back(c);
+            }
+        }
+    }
+    return field;
+}
+
+void BarnesHutSolver::computeAccelerations(ParticleSystem& particles)
+{
+    build(particles);
+    if (particles.size() == 0)
+        return;
+    // Tree order keeps consecutive queries walking the same nodes
+    accelerateParticles(particles, order);
+}
+
+void BarnesHutSolver::computeSubsetAccelerations(ParticleSystem& particles, const std::vector<uint32_t>& targets)
+{
+    build(particles);
+    if (particles.size() == 0)
+        return;
+    accelerateParticles(particles, targets);
+}
+
+void BarnesHutSolver::accelerateParticles(ParticleSystem& particles, const std::vector<uint32_t>& targets)
+{
+    stacks.resize(jobs != nullptr ? jobs->threadCount() : 1);
+    parallelFor(jobs, 0, targets.size(), BARNES_HUT_QUERIES_PER_TASK,
+        [this, &particles, &targets](std::size_t begin, std::size_t end, unsigned int thread)
+        {
+            std::vector<uint32_t>& stack = stacks[thread];
+            for (std::size_t k = begin; k < end; k++)
+            {
+                uint32_t i = targets[k];
+                glm::vec3 field = fieldAt(particles, particles.position(i), stack);
+                float coef = coulomb_coupling * particles.charge[i] / particles.mass[i];
+                particles.accX[i] = coef * field.x;
+                particles.accY[i] = coef * field.y;
+                particles.accZ[i] = coef * field.z;
+            }
+        });
+}
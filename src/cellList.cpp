@@ -0,0 +1,346 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "cellList.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+static const std::size_t CELL_LIST_PARTICLES_PER_TASK = 512;
+
+// Calls visit(l, dx, dy, dz, r2) for every slot l in the 27 cells around
+// slot k with r2 < range2. l == k is included, with r2 == 0.
+template <typename Visit>
+static void forEachNeighbour(const CellGrid& grid, uint32_t k, float range2, Visit visit)
+{
+    float x = grid.sortedX[k];
+    float y = grid.sortedY[k];
+    float z = grid.sortedZ[k];
+    glm::ivec3 center = grid.cellCoord(glm::vec3(x, y, z));
+    glm::ivec3 lo = glm::max(center - 1, glm::ivec3(0));
+    glm::ivec3 hi = glm::min(center + 1, grid.dims - 1);
+    for (int cz = lo.z; cz <= hi.z; cz++)
+    {
+        for (int cy = lo.y; cy <= hi.y; cy++)
+        {
+            // Cells along x are contiguous, walk them as one run
+            uint32_t first = grid.cellStart[grid.cellIndex(glm::ivec3(lo.x, cy, cz))];
+            uint32_t last = grid.cellStart[grid.cellIndex(glm::ivec3(hi.x, cy, cz)) + 1];
+            for (uint32_t l = first; l < last; l++)
+            {
+                float dx = x - grid.sortedX[l];
+                float dy = y - grid.sortedY[l];
+                float dz = z - grid.sortedZ[l];
+                float r2 = dx * dx + dy * dy + dz * dz;
+                if (r2 < range2)
+                {
+                    visit(l, dx, dy, dz, r2);
+                }
+            }
+        }
+    }
+}
+
+CellGrid::CellGrid()
+    : cellSize(1.0f),
+      origin(0.0f),
+      dims(1)
+{}
+
+// Clamped while still a float, casting a NaN, infinite or out of range value is undefined
+static int clampCell(float cell, int dim)
+{
+    if (!(cell >= 0.0f))
+        return 0;
+    if (cell >= float(dim - 1))
+        return dim - 1;
+    return int(cell);
+}
+
+glm::ivec3 CellGrid::cellCoord(glm::vec3 position) const
+{
+    glm::vec3 cell = glm::floor((position - origin) / cellSize);
+    return glm::ivec3(clampCell(cell.x, dims.x), clampCell(cell.y, dims.y), clampCell(cell.z, dims.z));
+}
+
+void CellGrid::build(const ParticleSystem& particles, float minCellSize, JobSystem* jobs)
+{
+    uint32_t n = uint32_t(particles.size());
+    glm::vec3 lo(0.0f);
+    glm::vec3 hi(0.0f);
+    // A NaN or infinite position (a blown-up close encounter) stays out of
+    // the bounds, cellCoord() clamps it into an edge cell
+    bool first = true;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        glm::vec3 p = particles.position(i);
+        if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+            continue;
+        lo = first ? p : glm::min(lo, p);
+        hi = first ? p : glm::max(hi, p);
+        first = false;
+    }
+
+    // A sparse cloud in a huge box would otherwise allocate billions of empty cells.
+    // In double, so neither the extent nor the product overflow before the check.
+    const double maxCells = std::max(8.0 * n, 64.0);
+    cellSize = minCellSize;
+    while (true)
+    {
+        glm::dvec3 extent = (glm::dvec3(hi) - glm::dvec3(lo)) / double(cellSize);
+        glm::dvec3 cells = glm::min(glm::floor(extent) + 1.0, glm::dvec3(maxCells));
+        if (cells.x * cells.y * cells.z <= maxCells)
+        {
+            dims = glm::ivec3(cells);
+            break;
+        }
+        cellSize *= 1.26f;
+    }
+    origin = lo;
+
+    uint32_t cells = cellCount();
+    particleCell.resize(n);
+    sortedIndices.resize(n);
+    parallelFor(jobs, 0, n, CELL_LIST_PARTICLES_PER_TASK,
+        [this, &particles](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                particleCell[i] = cellIndex(cellCoord(particles.position(i)));
+            }
+        });
+
+    // Counting sort: histogram, exclusive prefix sum, scatter
+    cellStart.assign(cells + 1, 0);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        cellStart[particleCell[i] + 1]++;
+    }
+    for (uint32_t c = 0; c < cells; c++)
+    {
+        cellStart[c + 1] += cellStart[c];
+    }
+    cursor.assign(cellStart.begin(), cellStart.end() - 1);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        sortedIndices[cursor[particleCell[i]]++] = i;
+    }
+    gather(particles, jobs);
+}
+
+void CellGrid::gather(const ParticleSystem& particles, JobSystem* jobs)
+{
+    std::size_t n = sortedIndices.size();
+    sortedX.resize(n);
+    sortedY.resize(n);
+    sortedZ.resize(n);
+    sortedCharge.resize(n);
+    parallelFor(jobs, 0, n, CELL_LIST_PARTICLES_PER_TASK,
+        [this, &particles](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t k = begin; k < end; k++)
+            {
+                uint32_t i = sortedIndices[k];
+                sortedX[k] = particles.posX[i];
+                sortedY[k] = particles.posY[i];
+                sortedZ[k] = particles.posZ[i];
+                sortedCharge[k] = particles.charge[i];
+            }
+        });
+}
+
+NeighbourList::NeighbourList()
+    : skin(0.1f),
+      builtCutoff(-1.0f),
+      builtSkin(-1.0f)
+{}
+
+bool NeighbourList::needsRebuild(const ParticleSystem& particles, float cutoff) const
+{
+    if (cutoff != builtCutoff || skin != builtSkin || offsets.size() != particles.size() + 1)
+        return true;
+
+    float limit2 = 0.25f * skin * skin;
+    for (std::size_t i = 0; i < particles.size(); i++)
+    {
+        float dx = particles.posX[i] - referenceX[i];
+        float dy = particles.posY[i] - referenceY[i];
+        float dz = particles.posZ[i] - referenceZ[i];
+        if (dx * dx + dy * dy + dz * dz > limit2)
+            return true;
+    }
+    return false;
+}
+
+void NeighbourList::build(const ParticleSystem& particles, const CellGrid& grid, float cutoff, JobSystem* jobs)
+{
+    uint32_t n = uint32_t(particles.size());
+    float range = cutoff + skin;
+    float range2 = range * range;
+
+    // Two passes (count, then fill) so the layout is the same no matter
+    // which thread handled which slot
+    offsets.assign(n + 1, 0);
+    parallelFor(jobs, 0, n, CELL_LIST_PARTICLES_PER_TASK,
+        [&](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t k = begin; k < end; k++)
+            {
+                uint32_t count = 0;
+                forEachNeighbour(grid, uint32_t(k), range2,
+                    [&](uint32_t l, float, float, float, float)
+                    {
+                        if (l != k)
+                            count++;
+                    });
+                offsets[k + 1] = count;
+            }
+        });
+    for (uint32_t k = 0; k < n; k++)
+    {
+        offsets[k + 1] += offsets[k];
+    }
+    neighbours.resize(offsets[n]);
+    parallelFor(jobs, 0, n, CELL_LIST_PARTICLES_PER_TASK,
+        [&](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t k = begin; k < end; k++)
+            {
+                uint32_t next = offsets[k];
+                forEachNeighbour(grid, uint32_t(k), range2,
+                    [&](uint32_t l, float, float, float, float)
+                    {
+                        if (l != k)
+                            neighbours[next++] = l;
+                    });
+            }
+        });
+
+    referenceX.assign(particles.posX.begin(), particles.posX.begin() + n);
+    referenceY.assign(particles.posY.begin(), particles.posY.begin() + n);
+    referenceZ.assign(particles.posZ.begin(), particles.posZ.begin() + n);
+    builtCutoff = cutoff;
+    builtSkin = skin;
+}
+
+CutoffSolver::CutoffSolver()
+    : cutoff(1.0f),
+      screeningLength(0.0f),
+      useNeighbourList(true),
+      jobs(nullptr)
+{}
+
+CutoffSolver::CutoffSolver(float cutoff, float screeningLength, bool useNeighbourList, JobSystem* jobs)
+    : cutoff(cutoff),
+      screeningLength(screeningLength),
+      useNeighbourList(useNeighbourList),
+      jobs(jobs)
+{}
+
+const char* CutoffSolver::name() const
+{
+    return useNeighbourList ? "cutoff-verlet-list" : "cutoff-cell-list";
+}
+
+// |E| / r for a unit source charge at distance r, minus its value at the cutoff
+float CutoffSolver::pairFactor(float r2, float eps2, float shift) const
+{
+    float r = std::sqrt(r2 + eps2);
+    float magnitude = 1.0f / (r * r);
+    if (screeningLength > 0.0f)
+    {
+        float x = r / screeningLength;
+        magnitude *= std::exp(-x) * (1.0f + x);
+    }
+    return (magnitude - shift) / r;
+}
+
+void CutoffSolver::computeAccelerations(ParticleSystem& particles)
+{
+    if (useNeighbourList)
+    {
+        if (neighbourList.needsRebuild(particles, cutoff))
+        {
+            grid.build(particles, cutoff + neighbourList.skin, jobs);
+            neighbourList.build(particles, grid, cutoff, jobs);
+        }
+        else
+        {
+            // Slots stay valid until the next rebuild, only positions moved
+            grid.gather(particles, jobs);
+        }
+        accumulateFromList(particles);
+    }
+    else
+    {
+        grid.build(particles, cutoff, jobs);
+        accumulateFromGrid(particles);
+    }
+}
+
+void CutoffSolver::accumulateFromGrid(ParticleSystem& particles)
+{
+    const float eps2 = particles.softening * particles.softening;
+    const float cutoff2 = cutoff * cutoff;
+    const float shift = pairFactor(cutoff2, 0.0f, 0.0f) * cutoff;
+    parallelFor(jobs, 0, particles.size(), CELL_LIST_PARTICLES_PER_TASK,
+        [&](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t k = begin; k < end; k++)
+            {
+                glm::vec3 field(0.0f);
+                forEachNeighbour(grid, uint32_t(k), cutoff2,
+                    [&](uint32_t l, float dx, float dy, float dz, float r2)
+                    {
+                        if (l == k)
+                            return;
+                        float s = grid.sortedCharge[l] * pairFactor(r2, eps2, shift);
+                        field += s * glm::vec3(dx, dy, dz);
+                    });
+                uint32_t i = grid.sortedIndices[k];
+                float coef = coulomb_coupling * particles.charge[i] / particles.mass[i];
+                particles.accX[i] = coef * field.x;
+                particles.accY[i] = coef * field.y;
+                particles.accZ[i] = coef * field.z;
+            }
+        });
+}
+
+void CutoffSolver::accumulateFromList(ParticleSystem& particles)
+{
+    const float eps2 = particles.softening * particles.softening;
+    const float cutoff2 = cutoff * cutoff;
+    const float shift = pairFactor(cutoff2, 0.0f, 0.0f) * cutoff;
+    parallelFor(jobs, 0, particles.size(), CELL_LIST_PARTICLES_PER_TASK,
+        [&](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t k = begin; k < end; k++)
+            {
+                float x = grid.sortedX[k];
+                float y = grid.sortedY[k];
+                float z = grid.sortedZ[k];
+                glm::vec3 field(0.0f);
+                for (uint32_t m = neighbourList.offsets[k]; m < neighbourList.offsets[k + 1]; m++)
+                {
+                    uint32_t l = neighbourList.neighbours[m];
+                    float dx = x - grid.sortedX[l];
+                    float dy = y - grid.sortedY[l];
+                    float dz = z - grid.sortedZ[l];
+                    float r2 = dx * dx + dy * dy + dz * dz;
+                    if (r2 < cutoff2)
+                    {
+                        float s = grid.sortedCharge[l] * pairFactor(r2, eps2, shift);
+                        field += s * glm::vec3(dx, dy, dz);
+                    }
+                }
+                uint32_t i = grid.sortedIndices[k];
+                float coef = coulomb_coupling * particles.charge[i] / particles.mass[i];
+                particles.accX[i] = coef * field.x;
+                particles.accY[i] = coef * field.y;
+                particles.accZ[i] = coef * field.z;
+            }
+        });
+}
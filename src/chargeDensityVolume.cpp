@@ -0,0 +1,177 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "chargeDensityVolume.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static const std::size_t VOLUME_PARTICLES_PER_TASK = 2048;
+static const std::size_t VOLUME_PLANES_PER_TASK = 1;
+
+ChargeDensityVolume::ChargeDensityVolume()
+    : gridSize(64),
+      macroCellSize(8),
+      assignment(ChargeAssignment::TriangularShapedCloud),
+      origin(0.0f),
+      cellSize(1.0f),
+      maxAbsDensity(0.0f)
+{}
+
+ChargeDensityVolume::ChargeDensityVolume(uint32_t gridSize, uint32_t macroCellSize)
+    : gridSize(gridSize),
+      macroCellSize(macroCellSize),
+      assignment(ChargeAssignment::TriangularShapedCloud),
+      origin(0.0f),
+      cellSize(1.0f),
+      maxAbsDensity(0.0f)
+{}
+
+void ChargeDensityVolume::splat(const std::vector<glm::vec3>& positions, const std::vector<float>& charges, JobSystem* jobs)
+{
+    macroCellSize = std::max<uint32_t>(macroCellSize, 1);
+    gridSize = std::max<uint32_t>(gridSize / macroCellSize, 1) * macroCellSize;
+    gridSize = std::max<uint32_t>(gridSize, 8);
+    const std::size_t n = gridSize;
+    const std::size_t cells = n * n * n;
+    std::size_t threads = jobs != nullptr ? jobs->threadCount() : 1;
+    threadDensity.resize(threads);
+    for (std::vector<float>& grid : threadDensity)
+    {
+        grid.assign(cells, 0.0f);
+    }
+    density.resize(cells);
+    if (positions.empty())
+    {
+        std::fill(density.begin(), density.end(), 0.0f);
+        buildMacroRanges(jobs);
+        return;
+    }
+    fitGrid(positions);
+
+    const float inverseCell = 1.0f / cellSize;
+    const float inverseVolume = inverseCell * inverseCell * inverseCell;
+    // Fitted particles sit in [1.5, n - 2.5], the clamp only keeps rounding at
+    // the float limit from stepping a cell outside the grid
+    const float highest = float(n) - 2.5f;
+    parallelFor(jobs, 0, positions.size(), VOLUME_PARTICLES_PER_TASK,
+        [this, &positions, &charges, n, inverseCell, inverseVolume, highest](std::size_t begin, std::size_t end, unsigned int thread)
+        {
+            float* grid = threadDensity[thread].data();
+            float wx[3], wy[3], wz[3];
+            for (std::size_t i = begin; i < end; i++)
+            {
+                if (charges[i] == 0.0f || !isFinitePosition(positions[i]))
+                    continue;
+                glm::vec3 u = (positions[i] - origin) * inverseCell;
+                int x0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.x, 1.0f, highest), wx);
+                int y0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.y, 1.0f, highest), wy);
+                int z0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.z, 1.0f, highest), wz);
+                float q = charges[i] * inverseVolume;
+                for (int c = 0; c < 3; c++)
+                {
+                    for (int b = 0; b < 3; b++)
+                    {
+                        float* row = grid + (std::size_t(z0 + c) * n + std::size_t(y0 + b)) * n + std::size_t(x0);
+                        float w = q * wz[c] * wy[b];
+                        for (int a = 0; a < 3; a++)
+                        {
+                            row[a] += w * wx[a];
+                        }
+                    }
+                }
+            }
+        });
+
+    parallelFor(jobs, 0, n, VOLUME_PLANES_PER_TASK,
+        [this, n](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t cell = begin * n * n; cell < end * n * n; cell++)
+            {
+                float sum = 0.0f;
+                for (const std::vector<float>& grid : threadDensity)
+                {
+                    sum += grid[cell];
+                }
+                density[cell] = sum;
+            }
+        });
+    buildMacroRanges(jobs);
+}
+
+// Same fit as ParticleInCellSolver: the bounding cube spans gridSize - 4
+// cells, so every particle's 3 cells per axis stay inside the grid.
+// Non-finite positions are left out, as the splat skips them.
+void ChargeDensityVolume::fitGrid(const std::vector<glm::vec3>& positions)
+{
+    glm::vec3 low(0.0f);
+    glm::vec3 high(0.0f);
+    bool first = true;
+    for (const glm::vec3& position : positions)
+    {
+        if (!isFinitePosition(position))
+            continue;
+        low = first ? position : glm::min(low, position);
+        high = first ? position : glm::max(high, position);
+        first = false;
+    }
+    glm::vec3 extent = high - low;
+    float side = std::max(std::max(extent.x, extent.y), extent.z);
+    side = std::clamp(side, 1.0e-3f, 0.25f * std::numeric_limits<float>::max());
+    cellSize = side / float(gridSize - 4);
+    origin = (0.5f * low + 0.5f * high) - glm::vec3(0.5f * float(gridSize - 1) * cellSize);
+}
+
+void ChargeDensityVolume::buildMacroRanges(JobSystem* jobs)
+{
+    const int n = int(gridSize);
+    const int s = int(macroCellSize);
+    const int m = int(macroGridSize());
+    macroRanges.resize(std::size_t(m) * m * m);
+    parallelFor(jobs, 0, std::size_t(m), VOLUME_PLANES_PER_TASK,
+        [this, n, s, m](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (int mz = int(begin); mz < int(end); mz++)
+            {
+                for (int my = 0; my < m; my++)
+                {
+                    for (int mx = 0; mx < m; mx++)
+                    {
+                        glm::ivec3 low = glm::max(glm::ivec3(mx, my, mz) * s - 1, glm::ivec3(0));
+                        glm::ivec3 high = glm::min(glm::ivec3(mx, my, mz) * s + s, glm::ivec3(n - 1));
+                        glm::vec2 range(0.0f);
+                        for (int z = low.z; z <= high.z; z++)
+                        {
+                            for (int y = low.y; y <= high.y; y++)
+                            {
+                                const float* row = density.data() + (std::size_t(z) * n + std::size_t(y)) * n;
+                                for (int x = low.x; x <= high.x; x++)
+                                {
+                                    range.x = std::min(range.x, row[x]);
+                                    range.y = std::max(range.y, row[x]);
+                                }
+                            }
+                        }
+                        macroRanges[(std::size_t(mz) * m + std::size_t(my)) * m + std::size_t(mx)] = range;
+                    }
+                }
+            }
+        });
+    maxAbsDensity = 0.0f;
+    for (const glm::vec2& range : macroRanges)
+    {
+        maxAbsDensity = std::max(maxAbsDensity, std::max(-range.x, range.y));
+    }
+}
+
+void ChargeDensityVolume::upload()
+{
+    const int n = int(gridSize);
+    const int m = int(macroGridSize());
+    densityTexture.allocate(n, n, n, GL_R32F, GL_LINEAR);
+    densityTexture.upload(GL_RED, GL_FLOAT, density.data());
+    macroTexture.allocate(m, m, m, GL_RG32F, GL_NEAREST);
+    macroTexture.upload(GL_RG, GL_FLOAT, macroRanges.data());
+}
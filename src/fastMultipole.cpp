@@ -0,0 +1,579 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "fastMultipole.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+static const int MAX_TREE_DEPTH = 32;
+static const int FAST_MULTIPOLE_MAX_TERMS = (FAST_MULTIPOLE_MAX_ORDER + 1) * (FAST_MULTIPOLE_MAX_ORDER + 2) * (FAST_MULTIPOLE_MAX_ORDER + 3) / 6;
+static const std::size_t FAST_MULTIPOLE_NODES_PER_TASK = 64;
+// The walk is cut into at least this many target subtrees per thread, for load balance
+static const std::size_t FAST_MULTIPOLE_WALK_TASKS_PER_THREAD = 8;
+
+// Number of multi-indices with |n| <= degree
+static int termCount(int degree)
+{
+    return (degree + 1) * (degree + 2) * (degree + 3) / 6;
+}
+
+MultipoleTables::MultipoleTables()
+    : order(0),
+      terms(0)
+{}
+
+void MultipoleTables::build(int expansionOrder)
+{
+    order = expansionOrder;
+    terms = termCount(order);
+    int side = order + 1;
+    index.assign(side * side * side, -1);
+    exponents.clear();
+    for (int degree = 0; degree <= order; degree++)
+    {
+        for (int nx = degree; nx >= 0; nx--)
+        {
+            for (int ny = degree - nx; ny >= 0; ny--)
+            {
+                int nz = degree - nx - ny;
+                index[(nx * side + ny) * side + nz] = int(exponents.size());
+                exponents.push_back(glm::ivec3(nx, ny, nz));
+            }
+        }
+    }
+
+    auto lookup = [this, side](glm::ivec3 n)
+    {
+        if (n.x < 0 || n.y < 0 || n.z < 0 || n.x + n.y + n.z > order)
+            return -1;
+        return index[(n.x * side + n.y) * side + n.z];
+    };
+
+    parentTerm.assign(terms, -1);
+    parentAxis.assign(terms, 0);
+    raisedTerm.assign(terms, glm::ivec3(-1));
+    for (int t = 0; t < terms; t++)
+    {
+        glm::ivec3 n = exponents[t];
+        // Built along the highest nonzero axis, so n - e_axis keeps the same
+        // axis whenever n_axis > 1 (derivatives() relies on it)
+        int axis = n.z > 0 ? 2 : (n.y > 0 ? 1 : 0);
+        if (t > 0)
+        {
+            glm::ivec3 parent = n;
+            parent[axis]--;
+            parentTerm[t] = lookup(parent);
+            parentAxis[t] = axis;
+        }
+        for (int a = 0; a < 3; a++)
+        {
+            glm::ivec3 raised = n;
+            raised[a]++;
+            raisedTerm[t][a] = lookup(raised);
+        }
+    }
+
+    m2lTerms.clear();
+    m2mTerms.clear();
+    l2lTerms.clear();
+    for (int k = 0; k < terms; k++)
+    {
+        for (int n = 0; n < terms; n++)
+        {
+            glm::ivec3 sum = exponents[k] + exponents[n];
+            int derivative = lookup(sum);
+            if (derivative >= 0)
+            {
+                m2lTerms.push_back({ k, n, derivative });
+            }
+            glm::ivec3 difference = exponents[k] - exponents[n];
+            int offset = lookup(difference);
+            if (offset >= 0)
+            {
+                // k >= n: multipole n of the child feeds k of the parent, local k of the parent feeds n of the child
+                m2mTerms.push_back({ k, n, offset });
+                l2lTerms.push_back({ n, k, offset });
+            }
+        }
+    }
+}
+
+void MultipoleTables::monomials(glm::dvec3 d, double* out) const
+{
+    out[0] = 1.0;
+    for (int t = 1; t < terms; t++)
+    {
+        int axis = parentAxis[t];
+        out[t] = out[parentTerm[t]] * d[axis] / double(exponents[t][axis]);
+    }
+}
+
+void MultipoleTables::derivatives(glm::dvec3 r, double* out, double* scratch) const
+{
+    // McMurchie-Davidson recursion on 1 / r = F(s), s = r^2 / 2:
+    //   R(m, 0) = F^(m)(s) = (-1)^m (2m - 1)!! / r^(2m + 1)
+    //   R(m, n + e_i) = r_i R(m + 1, n) + n_i R(m + 1, n - e_i)
+    // and d^n (1 / r) = R(0, n). Level m only needs |n| <= order - m.
+    double invR2 = 1.0 / glm::dot(r, r);
+    double invR = std::sqrt(invR2);
+    double f = invR;
+    for (int m = 0; m <= order; m++)
+    {
+        scratch[m * terms] = f;
+        f *= -double(2 * m + 1) * invR2;
+    }
+    for (int m = order - 1; m >= 0; m--)
+    {
+        double* level = scratch + m * terms;
+        const double* above = scratch + (m + 1) * terms;
+        int count = termCount(order - m);
+        for (int t = 1; t < count; t++)
+        {
+            int axis = parentAxis[t];
+            int parent = parentTerm[t];
+            double value = r[axis] * above[parent];
+            int lowered = exponents[parent][axis];
+            if (lowered > 0)
+            {
+                value += double(lowered) * above[parentTerm[parent]];
+            }
+            level[t] = value;
+        }
+    }
+    std::copy(scratch, scratch + terms, out);
+}
+
+FastMultipoleSolver::FastMultipoleSolver()
+    : order(4),
+      theta(0.6f),
+      leafSize(64),
+      jobs(nullptr)
+{}
+
+FastMultipoleSolver::FastMultipoleSolver(int order, float theta, JobSystem* jobs)
+    : order(order),
+      theta(theta),
+      leafSize(64),
+      jobs(jobs)
+{}
+
+const char* FastMultipoleSolver::name() const
+{
+    return "fmm";
+}
+
+void FastMultipoleSolver::build(const ParticleSystem& particles)
+{
+    uint32_t n = uint32_t(particles.size());
+    nodes.clear();
+    levels.clear();
+    sortedIndices.resize(n);
+    scratch.resize(n);
+    octants.resize(n);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        sortedIndices[i] = i;
+    }
+
+    glm::vec3 lo(0.0f);
+    glm::vec3 hi(0.0f);
+    if (n > 0)
+    {
+        lo = hi = particles.position(0);
+    }
+    for (uint32_t i = 1; i < n; i++)
+    {
+        glm::vec3 p = particles.position(i);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+    glm::vec3 extent = hi - lo;
+
+    FastMultipoleNode root;
+    root.boxCenter = 0.5f * (lo + hi);
+    root.halfSize = 0.5f * std::max(std::max(extent.x, extent.y), extent.z) * 1.001f + 1.0e-6f;
+    root.parent = 0;
+    root.begin = 0;
+    root.end = n;
+    root.firstChild = 0;
+    root.childCount = 0;
+    nodes.push_back(root);
+    buildNode(particles, 0, 0);
+
+    sortedParticles.resize(n);
+    for (uint32_t k = 0; k < n; k++)
+    {
+        uint32_t i = sortedIndices[k];
+        sortedParticles[k] = glm::vec4(particles.position(i), particles.charge[i]);
+    }
+    for (uint32_t i = 0; i < uint32_t(nodes.size()); i++)
+    {
+        uint32_t depth = nodes[i].depth;
+        if (levels.size() <= depth)
+            levels.resize(depth + 1);
+        levels[depth].push_back(i);
+    }
+}
+
+void FastMultipoleSolver::buildNode(const ParticleSystem& particles, uint32_t nodeIndex, uint32_t depth)
+{
+    nodes[nodeIndex].depth = depth;
+    uint32_t begin = nodes[nodeIndex].begin;
+    uint32_t end = nodes[nodeIndex].end;
+    if (end - begin <= leafSize || depth >= MAX_TREE_DEPTH)
+    {
+        return;
+    }
+
+    // Same counting sort into octants as BarnesHutSolver::buildNode
+    glm::vec3 boxCenter = nodes[nodeIndex].boxCenter;
+    float halfSize = nodes[nodeIndex].halfSize;
+    uint32_t counts[8] = {};
+    for (uint32_t k = begin; k < end; k++)
+    {
+        uint32_t i = sortedIndices[k];
+        uint8_t octant = (particles.posX[i] >= boxCenter.x ? 1 : 0)
+                       | (particles.posY[i] >= boxCenter.y ? 2 : 0)
+                       | (particles.posZ[i] >= boxCenter.z ? 4 : 0);
+        octants[i] = octant;
+        counts[octant]++;
+    }
+    uint32_t offsets[8];
+    uint32_t offset = begin;
+    for (int o = 0; o < 8; o++)
+    {
+        offsets[o] = offset;
+        offset += counts[o];
+    }
+    uint32_t starts[8];
+    std::copy(offsets, offsets + 8, starts);
+    for (uint32_t k = begin; k < end; k++)
+    {
+        uint32_t i = sortedIndices[k];
+        scratch[offsets[octants[i]]++] = i;
+    }
+    std::copy(scratch.begin() + begin, scratch.begin() + end, sortedIndices.begin() + begin);
+
+    uint32_t firstChild = uint32_t(nodes.size());
+    uint32_t childCount = 0;
+    float childHalf = 0.5f * halfSize;
+    for (int o = 0; o < 8; o++)
+    {
+        if (counts[o] == 0)
+            continue;
+        FastMultipoleNode child;
+        child.boxCenter = boxCenter + glm::vec3(o & 1 ? childHalf : -childHalf,
+                                                o & 2 ? childHalf : -childHalf,
+                                                o & 4 ? childHalf : -childHalf);
+        child.halfSize = childHalf;
+        child.parent = nodeIndex;
+        child.begin = starts[o];
+        child.end = starts[o] + counts[o];
+        child.firstChild = 0;
+        child.childCount = 0;
+        nodes.push_back(child);
+        childCount++;
+    }
+    nodes[nodeIndex].firstChild = firstChild;
+    nodes[nodeIndex].childCount = childCount;
+
+    for (uint32_t c = 0; c < childCount; c++)
+    {
+        buildNode(particles, firstChild + c, depth + 1);
+    }
+}
+
+void FastMultipoleSolver::computeLeafMoments(uint32_t nodeIndex)
+{
+    FastMultipoleNode& node = nodes[nodeIndex];
+    float absCharge = 0.0f;
+    glm::vec3 weighted(0.0f);
+    for (uint32_t k = node.begin; k < node.end; k++)
+    {
+        float q = std::abs(sortedParticles[k].w);
+        absCharge += q;
+        weighted += q * glm::vec3(sortedParticles[k]);
+    }
+    node.absCharge = absCharge;
+    node.center = absCharge > 0.0f ? weighted / absCharge : node.boxCenter;
+
+    // P2M
+    double* multipole = multipoles.data() + std::size_t(nodeIndex) * tables.terms;
+    std::fill(multipole, multipole + tables.terms, 0.0);
+    double powers[FAST_MULTIPOLE_MAX_TERMS];
+    float radius2 = 0.0f;
+    for (uint32_t k = node.begin; k < node.end; k++)
+    {
+        glm::vec3 d = node.center - glm::vec3(sortedParticles[k]);
+        radius2 = std::max(radius2, glm::dot(d, d));
+        tables.monomials(glm::dvec3(d), powers);
+        double q = sortedParticles[k].w;
+        for (int t = 0; t < tables.terms; t++)
+        {
+            multipole[t] += q * powers[t];
+        }
+    }
+    node.radius = std::sqrt(radius2);
+}
+
+void FastMultipoleSolver::computeParentMoments(uint32_t nodeIndex)
+{
+    FastMultipoleNode& node = nodes[nodeIndex];
+    float absCharge = 0.0f;
+    glm::vec3 weighted(0.0f);
+    for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++)
+    {
+        absCharge += nodes[c].absCharge;
+        weighted += nodes[c].absCharge * nodes[c].center;
+    }
+    node.absCharge = absCharge;
+    node.center = absCharge > 0.0f ? weighted / absCharge : node.boxCenter;
+
+    // M2M, and the children's spheres bound the parent's (the box does too)
+    double* multipole = multipoles.data() + std::size_t(nodeIndex) * tables.terms;
+    std::fill(multipole, multipole + tables.terms, 0.0);
+    double powers[FAST_MULTIPOLE_MAX_TERMS];
+    float radius = 0.0f;
+    for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++)
+    {
+        const FastMultipoleNode& child = nodes[c];
+        radius = std::max(radius, glm::distance(child.center, node.center) + child.radius);
+        tables.monomials(glm::dvec3(node.center - child.center), powers);
+        const double* childMultipole = multipoles.data() + std::size_t(c) * tables.terms;
+        for (const MultipoleTables::ShiftTerm& term : tables.m2mTerms)
+        {
+            multipole[term.target] += childMultipole[term.source] * powers[term.offset];
+        }
+    }
+    node.radius = std::min(radius, glm::distance(node.center, node.boxCenter) + std::sqrt(3.0f) * node.halfSize);
+}
+
+void FastMultipoleSolver::upwardPass()
+{
+    multipoles.resize(nodes.size() * std::size_t(tables.terms));
+    for (std::size_t depth = levels.size(); depth-- > 0;)
+    {
+        const std::vector<uint32_t>& level = levels[depth];
+        parallelFor(jobs, 0, level.size(), FAST_MULTIPOLE_NODES_PER_TASK,
+            [this, &level](std::size_t begin, std::size_t end, unsigned int)
+            {
+                for (std::size_t k = begin; k < end; k++)
+                {
+                    if (nodes[level[k]].childCount == 0)
+                        computeLeafMoments(level[k]);
+                    else
+                        computeParentMoments(level[k]);
+                }
+            });
+    }
+}
+
+void FastMultipoleSolver::multipoleToLocal(uint32_t source, uint32_t target, std::vector<double>& work)
+{
+    double* derivatives = work.data();
+    tables.derivatives(glm::dvec3(nodes[target].center - nodes[source].center), derivatives, derivatives + tables.terms);
+    const double* multipole = multipoles.data() + std::size_t(source) * tables.terms;
+    double* local = locals.data() + std::size_t(target) * tables.terms;
+    for (const MultipoleTables::M2LTerm& term : tables.m2lTerms)
+    {
+        local[term.local] += multipole[term.multipole] * derivatives[term.derivative];
+    }
+}
+
+void FastMultipoleSolver::particleToParticle(uint32_t source, uint32_t target, float eps2)
+{
+    const FastMultipoleNode& sourceNode = nodes[source];
+    const FastMultipoleNode& targetNode = nodes[target];
+    for (uint32_t k = targetNode.begin; k < targetNode.end; k++)
+    {
+        glm::vec3 point = glm::vec3(sortedParticles[k]);
+        glm::vec3 field(0.0f);
+        for (uint32_t j = sourceNode.begin; j < sourceNode.end; j++)
+        {
+            glm::vec3 d = point - glm::vec3(sortedParticles[j]);
+            float r2 = glm::dot(d, d) + eps2;
+            field += sortedParticles[j].w / (r2 * std::sqrt(r2)) * d;
+        }
+        fields[k] += field;
+    }
+}
+
+void FastMultipoleSolver::interact(uint32_t source, uint32_t target, float eps2, std::vector<double>& work)
+{
+    const FastMultipoleNode& a = nodes[source];
+    const FastMultipoleNode& b = nodes[target];
+    if (source == target)
+    {
+        if (a.childCount == 0)
+        {
+            particleToParticle(source, target, eps2);
+            return;
+        }
+        for (uint32_t i = a.firstChild; i < a.firstChild + a.childCount; i++)
+        {
+            for (uint32_t j = a.firstChild; j < a.firstChild + a.childCount; j++)
+            {
+                interact(i, j, eps2, work);
+            }
+        }
+        return;
+    }
+
+    if (glm::distance(a.center, b.center) * theta > a.radius + b.radius)
+    {
+        multipoleToLocal(source, target, work);
+        return;
+    }
+    if (a.childCount == 0 && b.childCount == 0)
+    {
+        particleToParticle(source, target, eps2);
+        return;
+    }
+    // Split the bigger node, so both sides of a pair stay about the same size
+    if (b.childCount == 0 || (a.childCount > 0 && a.radius >= b.radius))
+    {
+        for (uint32_t c = a.firstChild; c < a.firstChild + a.childCount; c++)
+        {
+            interact(c, target, eps2, work);
+        }
+    }
+    else
+    {
+        for (uint32_t c = b.firstChild; c < b.firstChild + b.childCount; c++)
+        {
+            interact(source, c, eps2, work);
+        }
+    }
+}
+
+void FastMultipoleSolver::downwardPass()
+{
+    // L2L, parents are finished a level before their children
+    for (std::size_t depth = 1; depth < levels.size(); depth++)
+    {
+        const std::vector<uint32_t>& level = levels[depth];
+        parallelFor(jobs, 0, level.size(), FAST_MULTIPOLE_NODES_PER_TASK,
+            [this, &level](std::size_t begin, std::size_t end, unsigned int)
+            {
+                double powers[FAST_MULTIPOLE_MAX_TERMS];
+                for (std::size_t k = begin; k < end; k++)
+                {
+                    const FastMultipoleNode& node = nodes[level[k]];
+                    tables.monomials(glm::dvec3(node.center - nodes[node.parent].center), powers);
+                    const double* parentLocal = locals.data() + std::size_t(node.parent) * tables.terms;
+                    double* local = locals.data() + std::size_t(level[k]) * tables.terms;
+                    for (const MultipoleTables::ShiftTerm& term : tables.l2lTerms)
+                    {
+                        local[term.target] += parentLocal[term.source] * powers[term.offset];
+                    }
+                }
+            });
+    }
+
+    // L2P, E = -grad phi = -sum_k L_(k + e_i) (x - z)^k / k!
+    parallelFor(jobs, 0, nodes.size(), FAST_MULTIPOLE_NODES_PER_TASK,
+        [this](std::size_t begin, std::size_t end, unsigned int)
+        {
+            double powers[FAST_MULTIPOLE_MAX_TERMS];
+            int gradientTerms = termCount(tables.order - 1);
+            for (std::size_t n = begin; n < end; n++)
+            {
+                const FastMultipoleNode& node = nodes[n];
+                if (node.childCount > 0)
+                    continue;
+                const double* local = locals.data() + n * tables.terms;
+                for (uint32_t k = node.begin; k < node.end; k++)
+                {
+                    tables.monomials(glm::dvec3(glm::vec3(sortedParticles[k]) - node.center), powers);
+                    glm::dvec3 gradient(0.0);
+                    for (int t = 0; t < gradientTerms; t++)
+                    {
+                        const glm::ivec3& raised = tables.raisedTerm[t];
+                        gradient += powers[t] * glm::dvec3(local[raised.x], local[raised.y], local[raised.z]);
+                    }
+                    fields[k] -= glm::vec3(gradient);
+                }
+            }
+        });
+}
+
+void FastMultipoleSolver::computeAccelerations(ParticleSystem& particles)
+{
+    int clampedOrder = std::clamp(order, 1, FAST_MULTIPOLE_MAX_ORDER);
+    if (tables.terms == 0 || tables.order != clampedOrder)
+    {
+        tables.build(clampedOrder);
+    }
+    build(particles);
+    if (particles.size() == 0)
+        return;
+
+    upwardPass();
+    locals.assign(nodes.size() * std::size_t(tables.terms), 0.0);
+    fields.assign(sortedParticles.size(), glm::vec3(0.0f));
+
+    // Cut the tree into disjoint target subtrees, a level at a time, until
+    // there are enough of them to keep every thread busy. The cut decides
+    // which node pairs interact, so a deterministic walk cuts as if for a
+    // fixed thread count.
+    unsigned int threads = jobs != nullptr ? jobs->threadCount() : 1;
+    std::size_t wantedTargets = FAST_MULTIPOLE_WALK_TASKS_PER_THREAD * (deterministic ? DETERMINISTIC_SPLIT_COUNT : threads);
+    std::vector<uint32_t> targets(1, 0);
+    std::vector<uint32_t> nextTargets;
+    bool split = true;
+    while (split && targets.size() < wantedTargets)
+    {
+        split = false;
+        nextTargets.clear();
+        for (uint32_t t : targets)
+        {
+            const FastMultipoleNode& node = nodes[t];
+            if (node.childCount == 0)
+            {
+                nextTargets.push_back(t);
+                continue;
+            }
+            for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++)
+            {
+                nextTargets.push_back(c);
+            }
+            split = true;
+        }
+        targets.swap(nextTargets);
+    }
+
+    threadWork.resize(threads);
+    for (std::vector<double>& work : threadWork)
+    {
+        work.resize(std::size_t(tables.order + 2) * tables.terms);
+    }
+    const float eps2 = particles.softening * particles.softening;
+    // Every target subtree against the whole source tree
+    parallelFor(jobs, 0, targets.size(), 1,
+        [this, &targets, eps2](std::size_t begin, std::size_t end, unsigned int thread)
+        {
+            for (std::size_t t = begin; t < end; t++)
+            {
+                interact(0, targets[t], eps2, threadWork[thread]);
+            }
+        });
+
+    downwardPass();
+
+    parallelFor(jobs, 0, sortedIndices.size(), 4096,
+        [this, &particles](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t k = begin; k < end; k++)
+            {
+                uint32_t i = sortedIndices[k];
+                float coef = coulomb_coupling * particles.charge[i] / particles.mass[i];
+                particles.accX[i] = coef * fields[k].x;
+                particles.accY[i] = coef * fields[k].y;
+                particles.accZ[i] = coef * fields[k].z;
+            }
+        });
+}
@@ -0,0 +1,131 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "forceSolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Rows per task, enough to amortize scheduling against an O(N) row
+static const std::size_t BRUTE_FORCE_ROWS_PER_TASK = 64;
+
+void ForceSolver::computeSubsetAccelerations(ParticleSystem& particles, const std::vector<uint32_t>& targets)
+{
+    AlignedFloats keptX = particles.accX;
+    AlignedFloats keptY = particles.accY;
+    AlignedFloats keptZ = particles.accZ;
+    computeAccelerations(particles);
+    for (uint32_t i : targets)
+    {
+        keptX[i] = particles.accX[i];
+        keptY[i] = particles.accY[i];
+        keptZ[i] = particles.accZ[i];
+    }
+    particles.accX.swap(keptX);
+    particles.accY.swap(keptY);
+    particles.accZ.swap(keptZ);
+}
+
+BruteForceSolver::BruteForceSolver()
+    : jobs(nullptr),
+      useSimd(true),
+      compensatedSummation(false)
+{}
+
+BruteForceSolver::BruteForceSolver(JobSystem* jobs)
+    : jobs(jobs),
+      useSimd(true),
+      compensatedSummation(false)
+{}
+
+const char* BruteForceSolver::name() const
+{
+    return "brute-force";
+}
+
+void BruteForceSolver::computeAccelerations(ParticleSystem& particles)
+{
+    parallelFor(jobs, 0, particles.size(), BRUTE_FORCE_ROWS_PER_TASK,
+        [this, &particles](std::size_t begin, std::size_t end, unsigned int)
+        {
+            computeRows(particles, begin, end);
+        });
+}
+
+void BruteForceSolver::computeRows(ParticleSystem& particles, std::size_t begin, std::size_t end) const
+{
+    if (compensatedSummation)
+    {
+        if (useSimd)
+            coulombAccelerationsCompensatedSimd(particles, begin, end);
+        else
+            coulombAccelerationsCompensatedScalar(particles, begin, end);
+    }
+    else if (useSimd)
+        particles.computeAccelerations(begin, end);
+    else
+        coulombAccelerationsScalar(particles, begin, end);
+}
+
+void BruteForceSolver::computeSubsetAccelerations(ParticleSystem& particles, const std::vector<uint32_t>& targets)
+{
+    parallelFor(jobs, 0, targets.size(), BRUTE_FORCE_ROWS_PER_TASK,
+        [this, &particles, &targets](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t k = begin; k < end; k++)
+            {
+                std::size_t i = targets[k];
+                computeRows(particles, i, i + 1);
+            }
+        });
+}
+
+void pairwiseReduce(std::vector<std::vector<double>>& partials, std::size_t begin, std::size_t end)
+{
+    for (std::size_t stride = 1; stride < partials.size(); stride *= 2)
+    {
+        for (std::size_t p = 0; p + stride < partials.size(); p += 2 * stride)
+        {
+            double* out = partials[p].data();
+            const double* in = partials[p + stride].data();
+            for (std::size_t k = begin; k < end; k++)
+            {
+                out[k] += in[k];
+            }
+        }
+    }
+}
+
+ForceError measureForceError(const ParticleSystem& particles, ForceSolver& reference, ForceSolver& candidate)
+{
+    ParticleSystem expected = particles;
+    ParticleSystem actual = particles;
+    reference.computeAccelerations(expected);
+    candidate.computeAccelerations(actual);
+
+    double errorSum = 0.0;
+    double referenceSum = 0.0;
+    double maxRelative = 0.0;
+    for (std::size_t i = 0; i < particles.size(); i++)
+    {
+        double dx = double(actual.accX[i]) - expected.accX[i];
+        double dy = double(actual.accY[i]) - expected.accY[i];
+        double dz = double(actual.accZ[i]) - expected.accZ[i];
+        double error2 = dx * dx + dy * dy + dz * dz;
+        double reference2 = double(expected.accX[i]) * expected.accX[i]
+                          + double(expected.accY[i]) * expected.accY[i]
+                          + double(expected.accZ[i]) * expected.accZ[i];
+        errorSum += error2;
+        referenceSum += reference2;
+        if (reference2 > 0.0)
+        {
+            maxRelative = std::max(maxRelative, std::sqrt(error2 / reference2));
+        }
+    }
+
+    ForceError error;
+    error.rmsRelative = referenceSum > 0.0 ? float(std::sqrt(errorSum / referenceSum)) : 0.0f;
+    error.maxRelative = float(maxRelative);
+    return error;
+}
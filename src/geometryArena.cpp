@@ -0,0 +1,398 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "geometryArena.h"
+
+#include <algorithm>
+#include <iterator>
+
+// glMultiDrawElementsIndirect's command layout
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+static const std::size_t INITIAL_INSTANCE_CAPACITY = 256;
+
+FreeListAllocator::FreeListAllocator()
+    : capacity(0),
+      used(0)
+{}
+
+FreeListAllocator::FreeListAllocator(std::size_t capacity)
+    : capacity(0),
+      used(0)
+{
+    reset(capacity);
+}
+
+void FreeListAllocator::reset(std::size_t newCapacity)
+{
+    freeByOffset.clear();
+    freeBySize.clear();
+    capacity = newCapacity;
+    used = 0;
+    if (capacity > 0)
+        insertFree(0, capacity);
+}
+
+std::size_t FreeListAllocator::allocate(std::size_t size)
+{
+    if (size == 0)
+        return 0;
+    auto fit = freeBySize.lower_bound(size);
+    if (fit == freeBySize.end())
+        return NO_SPACE;
+    std::size_t offset = fit->second;
+    std::size_t blockSize = fit->first;
+    eraseFree(freeByOffset.find(offset));
+    // The rest of the block stays free, after the allocation
+    if (blockSize > size)
+        insertFree(offset + size, blockSize - size);
+    used += size;
+    return offset;
+}
+
+void FreeListAllocator::free(std::size_t offset, std::size_t size)
+{
+    if (size == 0)
+        return;
+    used -= size;
+    std::size_t end = offset + size;
+    auto next = freeByOffset.lower_bound(offset);
+    if (next != freeByOffset.end() && next->first == end)
+    {
+        end += next->second;
+        auto merged = next++;
+        eraseFree(merged);
+    }
+    if (next != freeByOffset.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            offset = previous->first;
+            eraseFree(previous);
+        }
+    }
+    insertFree(offset, end - offset);
+}
+
+std::size_t FreeListAllocator::getLargestFreeBlock() const
+{
+    return freeBySize.empty() ? 0 : freeBySize.rbegin()->first;
+}
+
+void FreeListAllocator::insertFree(std::size_t offset, std::size_t size)
+{
+    freeByOffset.emplace(offset, size);
+    freeBySize.emplace(size, offset);
+}
+
+void FreeListAllocator::eraseFree(std::map<std::size_t, std::size_t>::iterator block)
+{
+    auto sameSize = freeBySize.equal_range(block->second);
+    for (auto it = sameSize.first; it != sameSize.second; ++it)
+    {
+        if (it->second == block->first)
+        {
+            freeBySize.erase(it);
+            break;
+        }
+    }
+    freeByOffset.erase(block);
+}
+
+GeometryArena::GeometryArena(const GeometryArenaSettings& settings)
+    : layout(settings.layout),
+      stride(vertexStride(settings.layout)),
+      boundsMin(settings.boundsMin),
+      boundsMax(settings.boundsMax),
+      positionOffset(0.0f),
+      positionScale(1.0f),
+      VAO(0),
+      vertexBuffer(0),
+      indexBuffer(0),
+      instanceBuffer(0),
+      indirectBuffer(0),
+      instanceCapacity(INITIAL_INSTANCE_CAPACITY),
+      indirectCapacity(0)
+{
+    if (layout.quantizePositions)
+    {
+        positionOffset = boundsMin;
+        positionScale = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+    }
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &instanceBuffer);
+    glGenBuffers(1, &indirectBuffer);
+
+    // aModel points at the instance buffer for good, it keeps its name when it grows
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * instanceCapacity, NULL, GL_STREAM_DRAW);
+    setInstanceModelAttributes();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    relocate(std::max<std::size_t>(settings.vertexCapacity, 1), std::max<std::size_t>(settings.indexCapacity, 1));
+}
+
+GeometryArena::~GeometryArena()
+{
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteBuffers(1, &indirectBuffer);
+}
+
+GeometryHandle GeometryArena::add(const Mesh& mesh)
+{
+    if (mesh.vertices.empty() || mesh.indices.empty())
+        return INVALID_GEOMETRY;
+    PackedVertices packed = packVertices(mesh.vertices, mesh.normals, mesh.texCoords, layout, boundsMin, boundsMax);
+
+    Entry entry;
+    entry.live = true;
+    entry.vertexCount = mesh.vertices.size();
+    entry.indexCount = mesh.indices.size();
+    std::vector<uint16_t> shortIndices;
+    const void* indexData = mesh.indices.data();
+    std::size_t indexBytes = sizeof(unsigned int) * mesh.indices.size();
+    // Relative to the mesh's own first vertex, so the arena's size doesn't matter
+    if (mesh.vertices.size() <= 65536)
+    {
+        shortIndices.assign(mesh.indices.begin(), mesh.indices.end());
+        entry.indexType = GL_UNSIGNED_SHORT;
+        indexData = shortIndices.data();
+        indexBytes = sizeof(uint16_t) * shortIndices.size();
+    }
+    entry.indexSlots = (indexBytes + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    entry.vertexOffset = vertexAllocator.allocate(entry.vertexCount);
+    entry.indexOffset = indexAllocator.allocate(entry.indexSlots);
+    if (entry.vertexOffset == FreeListAllocator::NO_SPACE || entry.indexOffset == FreeListAllocator::NO_SPACE)
+    {
+        if (entry.vertexOffset != FreeListAllocator::NO_SPACE)
+            vertexAllocator.free(entry.vertexOffset, entry.vertexCount);
+        if (entry.indexOffset != FreeListAllocator::NO_SPACE)
+            indexAllocator.free(entry.indexOffset, entry.indexSlots);
+        // Enough space in total only needs the free blocks joined, otherwise double until it fits
+        std::size_t vertexCapacity = vertexAllocator.getCapacity();
+        std::size_t indexCapacity = indexAllocator.getCapacity();
+        while (vertexCapacity - vertexAllocator.getUsed() < entry.vertexCount)
+            vertexCapacity *= 2;
+        while (indexCapacity - indexAllocator.getUsed() < entry.indexSlots)
+            indexCapacity *= 2;
+        relocate(vertexCapacity, indexCapacity);
+        entry.vertexOffset = vertexAllocator.allocate(entry.vertexCount);
+        entry.indexOffset = indexAllocator.allocate(entry.indexSlots);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(entry.vertexOffset * stride), GLsizeiptr(packed.bytes.size()), packed.bytes.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(entry.indexOffset * sizeof(uint32_t)), GLsizeiptr(indexBytes), indexData);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    GeometryHandle handle;
+    if (!freeHandles.empty())
+    {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+        entries[handle] = entry;
+    }
+    else
+    {
+        handle = GeometryHandle(entries.size());
+        entries.push_back(entry);
+    }
+    return handle;
+}
+
+void GeometryArena::remove(GeometryHandle handle)
+{
+    if (handle >= entries.size() || !entries[handle].live)
+        return;
+    Entry& entry = entries[handle];
+    vertexAllocator.free(entry.vertexOffset, entry.vertexCount);
+    indexAllocator.free(entry.indexOffset, entry.indexSlots);
+    entry.live = false;
+    freeHandles.push_back(handle);
+}
+
+void GeometryArena::defragment()
+{
+    relocate(vertexAllocator.getCapacity(), indexAllocator.getCapacity());
+}
+
+void GeometryArena::bind() const
+{
+    glBindVertexArray(VAO);
+}
+
+void GeometryArena::draw(GeometryHandle handle) const
+{
+    if (handle >= entries.size() || !entries[handle].live)
+        return;
+    const Entry& entry = entries[handle];
+    glDrawElementsBaseVertex(GL_TRIANGLES, GLsizei(entry.indexCount), entry.indexType,
+                             (void*) (entry.indexOffset * sizeof(uint32_t)), GLint(entry.vertexOffset));
+}
+
+void GeometryArena::drawInstanced(GeometryHandle handle, GLsizei instanceCount) const
+{
+    if (instanceCount <= 0 || handle >= entries.size() || !entries[handle].live)
+        return;
+    const Entry& entry = entries[handle];
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, GLsizei(entry.indexCount), entry.indexType,
+                                      (void*) (entry.indexOffset * sizeof(uint32_t)), instanceCount, GLint(entry.vertexOffset));
+}
+
+void GeometryArena::drawInstanced(GeometryHandle handle, const std::vector<glm::mat4>& models)
+{
+    if (models.empty())
+        return;
+    uploadInstances(models);
+    drawInstanced(handle, (GLsizei) models.size());
+}
+
+void GeometryArena::multiDraw(const std::vector<GeometryHandle>& handles, const std::vector<glm::mat4>& models)
+{
+    const std::size_t drawCount = std::min(handles.size(), models.size());
+    if (drawCount == 0)
+        return;
+    uploadInstances(models);
+
+    // baseInstance picks each draw's model, the 16-bit meshes go first, then the 32-bit ones
+    std::vector<DrawElementsIndirectCommand> commands;
+    commands.reserve(drawCount);
+    std::size_t shortCount = 0;
+    for (GLenum type : {GL_UNSIGNED_SHORT, GL_UNSIGNED_INT})
+    {
+        const std::size_t indexSize = type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        for (std::size_t i = 0; i < drawCount; i++)
+        {
+            GeometryHandle handle = handles[i];
+            if (handle >= entries.size() || !entries[handle].live || entries[handle].indexType != type)
+                continue;
+            const Entry& entry = entries[handle];
+            DrawElementsIndirectCommand command;
+            command.count = GLuint(entry.indexCount);
+            command.instanceCount = 1;
+            command.firstIndex = GLuint(entry.indexOffset * sizeof(uint32_t) / indexSize);
+            command.baseVertex = GLint(entry.vertexOffset);
+            command.baseInstance = GLuint(i);
+            commands.push_back(command);
+        }
+        if (type == GL_UNSIGNED_SHORT)
+            shortCount = commands.size();
+    }
+    if (commands.empty())
+        return;
+
+    // Orphaned like the instance buffer, so the driver doesn't wait on the last frame's draws
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+    if (commands.size() > indirectCapacity)
+        indirectCapacity = std::max(commands.size(), 2 * indirectCapacity);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * indirectCapacity, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * commands.size(), commands.data());
+    if (shortCount > 0)
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, (void*) 0, GLsizei(shortCount), 0);
+    if (commands.size() > shortCount)
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*) (sizeof(DrawElementsIndirectCommand) * shortCount),
+                                    GLsizei(commands.size() - shortCount), 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+GeometryRange GeometryArena::getRange(GeometryHandle handle) const
+{
+    GeometryRange range;
+    if (handle >= entries.size() || !entries[handle].live)
+        return range;
+    const Entry& entry = entries[handle];
+    const std::size_t indexSize = entry.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    range.baseVertex = GLint(entry.vertexOffset);
+    range.vertexCount = GLsizei(entry.vertexCount);
+    range.firstIndex = GLuint(entry.indexOffset * sizeof(uint32_t) / indexSize);
+    range.indexCount = GLsizei(entry.indexCount);
+    range.indexType = entry.indexType;
+    return range;
+}
+
+void GeometryArena::relocate(std::size_t vertexCapacity, std::size_t indexCapacity)
+{
+    GLuint newVertexBuffer;
+    GLuint newIndexBuffer;
+    glGenBuffers(1, &newVertexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newVertexBuffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, GLsizeiptr(vertexCapacity * stride), NULL, GL_DYNAMIC_STORAGE_BIT);
+    glGenBuffers(1, &newIndexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newIndexBuffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, GLsizeiptr(indexCapacity * sizeof(uint32_t)), NULL, GL_DYNAMIC_STORAGE_BIT);
+
+    // Packed from the front in the order they sat, so meshes added together stay together
+    std::vector<GeometryHandle> live;
+    for (GeometryHandle handle = 0; handle < entries.size(); handle++)
+    {
+        if (entries[handle].live)
+            live.push_back(handle);
+    }
+    std::sort(live.begin(), live.end(),
+              [&](GeometryHandle a, GeometryHandle b) { return entries[a].vertexOffset < entries[b].vertexOffset; });
+    vertexAllocator.reset(vertexCapacity);
+    indexAllocator.reset(indexCapacity);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, vertexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newVertexBuffer);
+    for (GeometryHandle handle : live)
+    {
+        Entry& entry = entries[handle];
+        std::size_t offset = vertexAllocator.allocate(entry.vertexCount);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GLintptr(entry.vertexOffset * stride),
+                            GLintptr(offset * stride), GLsizeiptr(entry.vertexCount * stride));
+        entry.vertexOffset = offset;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, indexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newIndexBuffer);
+    for (GeometryHandle handle : live)
+    {
+        Entry& entry = entries[handle];
+        std::size_t offset = indexAllocator.allocate(entry.indexSlots);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GLintptr(entry.indexOffset * sizeof(uint32_t)),
+                            GLintptr(offset * sizeof(uint32_t)), GLsizeiptr(entry.indexSlots * sizeof(uint32_t)));
+        entry.indexOffset = offset;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (vertexBuffer != 0)
+        glDeleteBuffers(1, &vertexBuffer);
+    if (indexBuffer != 0)
+        glDeleteBuffers(1, &indexBuffer);
+    vertexBuffer = newVertexBuffer;
+    indexBuffer = newIndexBuffer;
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    setVertexAttributes(layout);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBindVertexArray(0);
+}
+
+void GeometryArena::uploadInstances(const std::vector<glm::mat4>& models)
+{
+    if (models.size() > instanceCapacity)
+        instanceCapacity = std::max(models.size(), 2 * instanceCapacity);
+    // Orphan the old storage so the driver doesn't wait on last frame's draw
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * instanceCapacity, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::mat4) * models.size(), models.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,198 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "gpuParticles.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+
+// Must match local_size_x in the particle compute shaders
+static const GLuint PARTICLE_WORK_GROUP_SIZE = 256;
+
+GpuParticleSystem::GpuParticleSystem()
+    : buffers{ 0, 0, 0, 0 },
+      forceCountUniform(-1),
+      forceSofteningUniform(-1),
+      integrateCountUniform(-1),
+      kickUniform(-1),
+      driftUniform(-1),
+      count(0),
+      negativeCount(0),
+      softening2(0.0f),
+      accelerationsValid(false)
+{}
+
+GpuParticleSystem::~GpuParticleSystem()
+{
+    deleteBuffersIfAllocated();
+}
+
+void GpuParticleSystem::loadShaders(const char* forceShaderPath, const char* integrateShaderPath)
+{
+    forceShader.compileComputeShader(forceShaderPath);
+    forceShader.linkShaders();
+    forceCountUniform = forceShader.getUniform("particleCount");
+    forceSofteningUniform = forceShader.getUniform("softening2");
+
+    integrateShader.compileComputeShader(integrateShaderPath);
+    integrateShader.linkShaders();
+    integrateCountUniform = integrateShader.getUniform("particleCount");
+    kickUniform = integrateShader.getUniform("kick");
+    driftUniform = integrateShader.getUniform("drift");
+}
+
+void GpuParticleSystem::upload(const ParticleSystem& particles)
+{
+    count = particles.size();
+    softening2 = particles.softening * particles.softening;
+    accelerationsValid = false;
+
+    std::vector<uint32_t> drawOrder;
+    drawOrder.reserve(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        if (particles.charge[i] < 0.0f)
+            drawOrder.push_back(uint32_t(i));
+    }
+    negativeCount = GLsizei(drawOrder.size());
+    for (std::size_t i = 0; i < count; i++)
+    {
+        if (!(particles.charge[i] < 0.0f))
+            drawOrder.push_back(uint32_t(i));
+    }
+
+    std::vector<glm::vec4> positions(count);
+    std::vector<glm::vec4> velocities(count);
+    std::vector<glm::vec4> accelerations(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        // Same expression as the CPU kernels, so the coefficient rounds the same way
+        float coef = coulomb_coupling * particles.charge[i] / particles.mass[i];
+        positions[i] = glm::vec4(particles.posX[i], particles.posY[i], particles.posZ[i], particles.charge[i]);
+        velocities[i] = glm::vec4(particles.velX[i], particles.velY[i], particles.velZ[i], coef);
+        accelerations[i] = glm::vec4(particles.accX[i], particles.accY[i], particles.accZ[i], 0.0f);
+    }
+
+    deleteBuffersIfAllocated();
+    allocateBuffers();
+    const void* data[] = { positions.data(), velocities.data(), accelerations.data(), drawOrder.data() };
+    std::size_t elementSizes[] = { sizeof(glm::vec4), sizeof(glm::vec4), sizeof(glm::vec4), sizeof(uint32_t) };
+    for (int b = 0; b < 4; b++)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[b]);
+        // Keep one element so an empty system still has valid buffers to bind
+        glBufferData(GL_SHADER_STORAGE_BUFFER, elementSizes[b] * std::max<std::size_t>(count, 1), count > 0 ? data[b] : nullptr, GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuParticleSystem::download(ParticleSystem& particles) const
+{
+    if (count == 0 || count != particles.size())
+    {
+        return;
+    }
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    std::vector<glm::vec4> positions(count);
+    std::vector<glm::vec4> velocities(count);
+    std::vector<glm::vec4> accelerations(count);
+    glGetNamedBufferSubData(buffers[0], 0, sizeof(glm::vec4) * count, positions.data());
+    glGetNamedBufferSubData(buffers[1], 0, sizeof(glm::vec4) * count, velocities.data());
+    glGetNamedBufferSubData(buffers[2], 0, sizeof(glm::vec4) * count, accelerations.data());
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        particles.posX[i] = positions[i].x;
+        particles.posY[i] = positions[i].y;
+        particles.posZ[i] = positions[i].z;
+        particles.velX[i] = velocities[i].x;
+        particles.velY[i] = velocities[i].y;
+        particles.velZ[i] = velocities[i].z;
+        particles.accX[i] = accelerations[i].x;
+        particles.accY[i] = accelerations[i].y;
+        particles.accZ[i] = accelerations[i].z;
+    }
+}
+
+void GpuParticleSystem::step(IntegrationScheme scheme, float dt)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    // Same pass order as Integrator::velocityVerlet and Integrator::leapfrog.
+    // There are no per-particle levels on the GPU, block timesteps with every
+    // particle on level 0 is velocity Verlet.
+    if (scheme != IntegrationScheme::Leapfrog)
+    {
+        if (!accelerationsValid)
+        {
+            computeAccelerations();
+        }
+        integrate(0.5f * dt, dt);
+        computeAccelerations();
+        integrate(0.5f * dt, 0.0f);
+        accelerationsValid = true;
+    }
+    else
+    {
+        integrate(0.0f, 0.5f * dt);
+        computeAccelerations();
+        integrate(dt, 0.5f * dt);
+        accelerationsValid = false;
+    }
+}
+
+void GpuParticleSystem::computeAccelerations()
+{
+    bindSimulationBuffers();
+    forceShader.use();
+    setUInt(forceCountUniform, (unsigned int) count);
+    setFloat(forceSofteningUniform, softening2);
+    glDispatchCompute((GLuint(count) + PARTICLE_WORK_GROUP_SIZE - 1) / PARTICLE_WORK_GROUP_SIZE, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GpuParticleSystem::integrate(float kick, float drift)
+{
+    bindSimulationBuffers();
+    integrateShader.use();
+    setUInt(integrateCountUniform, (unsigned int) count);
+    setFloat(kickUniform, kick);
+    setFloat(driftUniform, drift);
+    glDispatchCompute((GLuint(count) + PARTICLE_WORK_GROUP_SIZE - 1) / PARTICLE_WORK_GROUP_SIZE, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GpuParticleSystem::bindSimulationBuffers() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_POSITION_BINDING, buffers[0]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_VELOCITY_BINDING, buffers[1]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_ACCELERATION_BINDING, buffers[2]);
+}
+
+void GpuParticleSystem::bindForDrawing() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_POSITION_BINDING, buffers[0]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_DRAW_ORDER_BINDING, buffers[3]);
+}
+
+void GpuParticleSystem::allocateBuffers()
+{
+    glGenBuffers(4, buffers);
+}
+
+void GpuParticleSystem::deleteBuffersIfAllocated()
+{
+    for (int b = 0; b < 4; b++)
+    {
+        if (buffers[b] != 0)
+        {
+            glDeleteBuffers(1, &buffers[b]);
+            buffers[b] = 0;
+        }
+    }
+}
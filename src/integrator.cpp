@@ -0,0 +1,245 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "integrator.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+const char* integrationSchemeName(IntegrationScheme scheme)
+{
+    switch (scheme)
+    {
+    case IntegrationScheme::VelocityVerlet:
+        return "velocity-verlet";
+    case IntegrationScheme::Leapfrog:
+        return "leapfrog";
+    case IntegrationScheme::BlockTimesteps:
+        return "block-timesteps";
+    }
+    return "unknown";
+}
+
+Integrator::Integrator()
+    : scheme(IntegrationScheme::VelocityVerlet),
+      timeStep(1.0f / 120.0f),
+      substeps(1),
+      maxStepsPerFrame(8),
+      jobs(nullptr),
+      maxTimestepLevel(8),
+      timestepAccuracy(0.05f),
+      accumulator(0.0f),
+      accelerationsValid(false)
+{}
+
+Integrator::Integrator(float timeStep, int substeps, IntegrationScheme scheme, JobSystem* jobs)
+    : scheme(scheme),
+      timeStep(timeStep),
+      substeps(substeps),
+      maxStepsPerFrame(8),
+      jobs(jobs),
+      maxTimestepLevel(8),
+      timestepAccuracy(0.05f),
+      accumulator(0.0f),
+      accelerationsValid(false)
+{}
+
+int Integrator::advance(ParticleSystem& particles, ForceSolver& solver, float frameTime)
+{
+    int steps = consumeSteps(frameTime);
+    for (int i = 0; i < steps; i++)
+    {
+        step(particles, solver);
+    }
+    return steps;
+}
+
+int Integrator::consumeSteps(float frameTime)
+{
+    accumulator += frameTime;
+    int steps = 0;
+    while (accumulator >= timeStep && steps < maxStepsPerFrame)
+    {
+        accumulator -= timeStep;
+        steps++;
+    }
+    // Fell too far behind, slow the simulation down rather than stall the frame
+    if (steps == maxStepsPerFrame)
+    {
+        accumulator = std::min(accumulator, timeStep);
+    }
+    return steps;
+}
+
+void Integrator::step(ParticleSystem& particles, ForceSolver& solver)
+{
+    int count = std::max(substeps, 1);
+    float dt = substepTime();
+    for (int i = 0; i < count; i++)
+    {
+        if (scheme == IntegrationScheme::VelocityVerlet)
+            velocityVerlet(particles, solver, dt);
+        else if (scheme == IntegrationScheme::Leapfrog)
+            leapfrog(particles, solver, dt);
+        else
+            blockTimesteps(particles, solver, dt);
+    }
+}
+
+void Integrator::velocityVerlet(ParticleSystem& particles, ForceSolver& solver, float dt)
+{
+    if (!accelerationsValid)
+    {
+        solver.computeAccelerations(particles);
+    }
+    particles.kick(0.5f * dt, jobs);
+    particles.drift(dt, jobs);
+    solver.computeAccelerations(particles);
+    particles.kick(0.5f * dt, jobs);
+    accelerationsValid = true;
+}
+
+void Integrator::leapfrog(ParticleSystem& particles, ForceSolver& solver, float dt)
+{
+    particles.drift(0.5f * dt, jobs);
+    solver.computeAccelerations(particles);
+    particles.kick(dt, jobs);
+    particles.drift(0.5f * dt, jobs);
+    // These are the half-step accelerations, not the ones at the new positions
+    accelerationsValid = false;
+}
+
+// Enough particles per task to hide the scheduling, the loops are a few flops each
+static const std::size_t BLOCK_PARTICLES_PER_TASK = 4096;
+
+int Integrator::chooseLevel(float dt, glm::vec3 acceleration, glm::vec3 jerk, float softening) const
+{
+    float a = glm::length(acceleration);
+    float j = glm::length(jerk);
+    float wanted = dt;
+    if (a > 0.0f)
+    {
+        wanted = std::min(wanted, timestepAccuracy * std::sqrt(softening / a));
+    }
+    if (j > 0.0f)
+    {
+        wanted = std::min(wanted, timestepAccuracy * a / j);
+    }
+    if (!(wanted > 0.0f))
+    {
+        return maxTimestepLevel;
+    }
+    int level = int(std::ceil(std::log2(dt / wanted)));
+    return std::clamp(level, 0, maxTimestepLevel);
+}
+
+// Time runs in ticks, a particle on level l steps every 2^(maxLevel - l)
+// ticks and the whole step dt is 2^maxLevel ticks. Every particle gets an
+// opening half kick at the start. Then, boundary by boundary, everyone
+// drifts to the next boundary of the finest occupied level, and the
+// particles whose step ends there get new accelerations, their closing half
+// kick, a new level and (unless dt is over) the opening half kick of their
+// next step. Drifting everyone keeps the force sources synchronized, it is
+// O(N) against the O(N log N) or worse of an evaluation.
+//
+// A particle may move to a finer level at any of its boundaries, to a coarser
+// one only where that level's steps start, so the levels always nest. With
+// everyone on level 0 this is exactly velocity Verlet.
+void Integrator::blockTimesteps(ParticleSystem& particles, ForceSolver& solver, float dt)
+{
+    const std::size_t n = particles.size();
+    const int maxLevel = std::clamp(maxTimestepLevel, 0, 30);
+    const uint32_t ticks = 1u << maxLevel;
+    const float tickTime = dt / float(ticks);
+
+    if (!accelerationsValid || levels.size() != n)
+    {
+        solver.computeAccelerations(particles);
+        levels.resize(n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            levels[i] = uint8_t(chooseLevel(dt, particles.acceleration(i), glm::vec3(0.0f), particles.softening));
+        }
+        accelerationsValid = true;
+    }
+    levelCounts.assign(maxLevel + 1, 0);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        levels[i] = uint8_t(std::min<int>(levels[i], maxLevel));
+        levelCounts[levels[i]]++;
+    }
+
+    parallelFor(jobs, 0, n, BLOCK_PARTICLES_PER_TASK,
+        [this, &particles, dt](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                float halfStep = 0.5f * std::ldexp(dt, -int(levels[i]));
+                particles.velX[i] += particles.accX[i] * halfStep;
+                particles.velY[i] += particles.accY[i] * halfStep;
+                particles.velZ[i] += particles.accZ[i] * halfStep;
+            }
+        });
+
+    uint32_t tick = 0;
+    while (tick < ticks)
+    {
+        int finest = maxLevel;
+        while (finest > 0 && levelCounts[finest] == 0)
+        {
+            finest--;
+        }
+        uint32_t stride = ticks >> finest;
+        uint32_t next = (tick / stride + 1) * stride;
+        particles.drift(float(next - tick) * tickTime, jobs);
+        tick = next;
+
+        // Levels l >= coarsest have a boundary here
+        int coarsest = tick == ticks ? 0 : maxLevel - std::countr_zero(tick);
+        activeParticles.clear();
+        for (std::size_t i = 0; i < n; i++)
+        {
+            if (levels[i] >= coarsest)
+                activeParticles.push_back(uint32_t(i));
+        }
+        startAccelerations.resize(activeParticles.size());
+        for (std::size_t k = 0; k < activeParticles.size(); k++)
+        {
+            startAccelerations[k] = particles.acceleration(activeParticles[k]);
+        }
+
+        if (activeParticles.size() == n)
+            solver.computeAccelerations(particles);
+        else
+            solver.computeSubsetAccelerations(particles, activeParticles);
+
+        bool finished = tick == ticks;
+        parallelFor(jobs, 0, activeParticles.size(), BLOCK_PARTICLES_PER_TASK,
+            [this, &particles, dt, coarsest, finished](std::size_t begin, std::size_t end, unsigned int)
+            {
+                for (std::size_t k = begin; k < end; k++)
+                {
+                    uint32_t i = activeParticles[k];
+                    float step = std::ldexp(dt, -int(levels[i]));
+                    glm::vec3 acceleration = particles.acceleration(i);
+                    glm::vec3 jerk = (acceleration - startAccelerations[k]) / step;
+                    int level = std::max(chooseLevel(dt, acceleration, jerk, particles.softening), finished ? 0 : coarsest);
+                    // Closing half kick of this step, opening half kick of the next
+                    float kick = 0.5f * step + (finished ? 0.0f : 0.5f * std::ldexp(dt, -level));
+                    particles.velX[i] += acceleration.x * kick;
+                    particles.velY[i] += acceleration.y * kick;
+                    particles.velZ[i] += acceleration.z * kick;
+                    levels[i] = uint8_t(level);
+                }
+            });
+        levelCounts.assign(maxLevel + 1, 0);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            levelCounts[levels[i]]++;
+        }
+    }
+}
@@ -0,0 +1,182 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "jobSystem.h"
+
+#include <algorithm>
+
+// Which JobSystem (if any) the current thread is a worker of
+static thread_local const JobSystem* workerOwner = nullptr;
+static thread_local unsigned int workerIndex = 0;
+
+JobSystem::JobSystem(unsigned int workerCount)
+    : queuedTasks(0),
+      stopping(false)
+{
+    if (workerCount == 0)
+    {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+    // Slot 0 belongs to whichever outside thread calls parallelFor()
+    for (unsigned int i = 0; i < workerCount + 1; i++)
+    {
+        queues.push_back(std::make_unique<TaskQueue>());
+    }
+    for (unsigned int i = 1; i < workerCount + 1; i++)
+    {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+unsigned int JobSystem::currentThreadIndex() const
+{
+    return workerOwner == this ? workerIndex : 0;
+}
+
+void JobSystem::workerLoop(unsigned int index)
+{
+    workerOwner = this;
+    workerIndex = index;
+    while (true)
+    {
+        if (runOneTask(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queuedTasks.load() > 0; });
+        if (stopping)
+            return;
+    }
+}
+
+bool JobSystem::runOneTask(unsigned int index)
+{
+    Task task;
+    bool found = false;
+
+    // Own queue first, newest task (still warm in cache)
+    {
+        TaskQueue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+    // Then steal the oldest task from the others
+    for (unsigned int offset = 1; !found && offset < queues.size(); offset++)
+    {
+        TaskQueue& victim = *queues[(index + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+    if (!found)
+        return false;
+
+    queuedTasks.fetch_sub(1);
+    Loop& loop = *task.loop;
+    if (!loop.failed.load(std::memory_order_relaxed))
+    {
+        // Caught here, a worker would terminate and the caller wait forever on pending
+        try
+        {
+            (*task.body)(task.begin, task.end, index);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(loop.errorMutex);
+            if (!loop.error)
+                loop.error = std::current_exception();
+            loop.failed.store(true, std::memory_order_relaxed);
+        }
+    }
+    // Last, the caller may return and destroy the loop as soon as this reaches 0
+    loop.pending.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void JobSystem::parallelFor(std::size_t begin, std::size_t end, std::size_t chunkSize, const ParallelForBody& body)
+{
+    if (end <= begin)
+        return;
+    chunkSize = std::max<std::size_t>(chunkSize, 1);
+    std::size_t chunkCount = (end - begin + chunkSize - 1) / chunkSize;
+    unsigned int self = currentThreadIndex();
+    std::unique_lock<std::recursive_mutex> externalLock(externalMutex, std::defer_lock);
+    if (workerOwner != this)
+    {
+        externalLock.lock();
+    }
+    if (chunkCount == 1 || workers.empty())
+    {
+        for (std::size_t chunk = begin; chunk < end; chunk += chunkSize)
+        {
+            body(chunk, std::min(chunk + chunkSize, end), self);
+        }
+        return;
+    }
+
+    // Deal the chunks out round-robin, starting with the calling thread
+    Loop loop;
+    loop.pending.store(chunkCount);
+    loop.failed.store(false);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedTasks.fetch_add(chunkCount);
+    }
+    std::size_t chunkIndex = 0;
+    for (std::size_t chunk = begin; chunk < end; chunk += chunkSize, chunkIndex++)
+    {
+        TaskQueue& queue = *queues[(self + chunkIndex) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{ &body, chunk, std::min(chunk + chunkSize, end), &loop });
+    }
+    wake.notify_all();
+
+    while (loop.pending.load(std::memory_order_acquire) > 0)
+    {
+        if (!runOneTask(self))
+        {
+            std::this_thread::yield();
+        }
+    }
+    if (loop.error)
+    {
+        std::rethrow_exception(loop.error);
+    }
+}
+
+void parallelFor(JobSystem* jobs, std::size_t begin, std::size_t end, std::size_t chunkSize, const ParallelForBody& body)
+{
+    if (jobs != nullptr)
+    {
+        jobs->parallelFor(begin, end, chunkSize, body);
+        return;
+    }
+    for (std::size_t chunk = begin; chunk < end; chunk += std::max<std::size_t>(chunkSize, 1))
+    {
+        body(chunk, std::min(chunk + std::max<std::size_t>(chunkSize, 1), end), 0);
+    }
+}
@@ -17,19 +17,40 @@
 #include <numbers>
 #include <random>
 #include <chrono>
+#include <fstream>
 
 #include "shader.h"
 #include "camera.h"
 #include "texture.h"
 #include "mesh.h"
 #include "proceduralMesh.h"
+#include "meshOptimizer.h"
+#include "geometryArena.h"
 #include "lights.h"
+#include "particleSystem.h"
+#include "forceSolver.h"
+#include "barnesHut.h"
+#include "fastMultipole.h"
+#include "particleInCell.h"
+#include "particleMeshEwald.h"
+#include "cellList.h"
+#include "jobSystem.h"
+#include "integrator.h"
+#include "gpuParticles.h"
+#include "trajectory.h"
+#include "simulationThread.h"
+#include "sphereImpostors.h"
+#include "chargeDensityVolume.h"
+#include "volumeRenderer.h"
+#include "pointCloud.h"
+#include "particleTrails.h"
 
 // OpenGL functions
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void mouse_callback(GLFWwindow* window, double xPos, double yPos);
 void scroll_callback(GLFWwindow* window, double xOffset, double yOffset);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void processInput(GLFWwindow* window);
 void GLAPIENTRY debug_message_callback(GLenum source,
     GLenum type,
@@ -51,6 +72,53 @@ float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 float currentFrame = 0.0f;
 
+// B cycles through the force solvers
+int forceSolverIndex = 0;
+bool forceSolverChanged = false;
+
+// K wraps the particles into a periodic box and switches to particle-mesh
+// Ewald, the box's 26 neighbouring images are drawn around it. B and G do
+// nothing meanwhile, the other solvers and the GPU path only know open boundaries.
+const float periodicBoxSide = 12.0f;
+bool periodicBoundaries = false;
+bool periodicToggled = false;
+
+// Fixed 120 Hz physics on its own thread, [ and ] change the substeps, L cycles the scheme
+Integrator integrator;
+SimulationThread simulation;
+
+// G moves the particle simulation between the CPU and the compute shaders
+bool useGpuParticles = false;
+bool gpuParticlesChanged = false;
+
+// R records the CPU simulation to trajectory.ptrj, P plays it back, left and right seek by a second
+const char* trajectoryPath = "trajectory.ptrj";
+bool recordingToggled = false;
+bool playbackToggled = false;
+int playbackSeek = 0;
+
+// I switches the particles between ray-cast impostors and meshes. With
+// impostors, particles covering more than this radius on screen still get a mesh.
+bool useImpostors = true;
+const float impostorMaxRadiusPixels = 48.0f;
+const float electronRadius = 0.05f;
+const float protonRadius = 0.1f;
+
+// V overlays the charge density as a ray-marched volume (CPU simulation and playback only)
+bool showChargeDensity = false;
+
+// A point cloud octree built by tools/buildPointCloud.cpp is streamed in
+// under this much VRAM when the file exists, O hides and shows it
+const char* pointCloudPath = "pointcloud.pcot";
+const std::size_t pointCloudBudgetBytes = std::size_t(256) << 20;
+bool showPointCloud = true;
+
+// T draws a fading trail behind every particle (CPU simulation and playback
+// only). A longer step than this between frames, a seek or a wrap around
+// the periodic box, breaks the trail instead of drawing a line across.
+bool showTrails = false;
+const float trailMaxStep = 2.0f;
+
 
 int main()
 {
@@ -76,6 +144,7 @@ int main()
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
     // GLAD Setup
@@ -99,10 +168,10 @@ int main()
     Shader meshShader = Shader();
     meshShader.compileVertexShader("shaders/mesh_vert.glsl");
     meshShader.compileFragmentShader("shaders/mesh_frag.glsl");
+    meshShader.compileFragmentShader("shaders/lighting_frag.glsl");
     meshShader.linkShaders();
 
     meshShader.use();
-    MeshUniform meshUniform = meshShader.getMeshUniform("mesh");
     MaterialUniform materialUniform = meshShader.getMaterialUniform("material");
     CameraUniform cameraUniform = meshShader.getCameraUniform("camera");
     SpotLightUniform spotLightUniform = meshShader.getSpotLightUniform("spotLights[0]");
@@ -111,10 +180,69 @@ int main()
     GLint numSpotLightsUniform = meshShader.getUniform("numSpotLights");
     GLint numPointLightsUniform = meshShader.getUniform("numPointLights");
     GLint numDirLightsUniform = meshShader.getUniform("numDirLights");
+    GLint renderInstancedUniform = meshShader.getUniform("renderInstanced");
+    VertexFormatUniform vertexFormatUniform = meshShader.getVertexFormatUniform("vertexFormat");
     setInt(numSpotLightsUniform, 0);
     setInt(numPointLightsUniform, 1);
     setInt(numDirLightsUniform, 1);
 
+    // Same lighting as meshShader, but the particle positions come from the compute shader's SSBO
+    Shader particleShader = Shader();
+    particleShader.compileVertexShader("shaders/particle_vert.glsl");
+    particleShader.compileFragmentShader("shaders/mesh_frag.glsl");
+    particleShader.compileFragmentShader("shaders/lighting_frag.glsl");
+    particleShader.linkShaders();
+
+    particleShader.use();
+    MeshUniform particleMeshUniform = particleShader.getMeshUniform("mesh");
+    MaterialUniform particleMaterialUniform = particleShader.getMaterialUniform("material");
+    CameraUniform particleCameraUniform = particleShader.getCameraUniform("camera");
+    SpotLightUniform particleSpotLightUniform = particleShader.getSpotLightUniform("spotLights[0]");
+    PointLightUniform particlePointLightUniform = particleShader.getPointLightUniform("pointLights[0]");
+    DirLightUniform particleDirLightUniform = particleShader.getDirLightUniform("dirLights[0]");
+    GLint particleNumSpotLightsUniform = particleShader.getUniform("numSpotLights");
+    GLint particleNumPointLightsUniform = particleShader.getUniform("numPointLights");
+    GLint particleNumDirLightsUniform = particleShader.getUniform("numDirLights");
+    GLint firstParticleUniform = particleShader.getUniform("firstParticle");
+    VertexFormatUniform particleVertexFormatUniform = particleShader.getVertexFormatUniform("vertexFormat");
+
+    // Same lighting again, on spheres ray-cast from one quad per particle
+    Shader impostorShader = Shader();
+    impostorShader.compileVertexShader("shaders/particleImpostor_vert.glsl");
+    impostorShader.compileFragmentShader("shaders/particleImpostor_frag.glsl");
+    impostorShader.compileFragmentShader("shaders/lighting_frag.glsl");
+    impostorShader.linkShaders();
+
+    impostorShader.use();
+    MaterialUniform impostorMaterialUniform = impostorShader.getMaterialUniform("material");
+    CameraUniform impostorCameraUniform = impostorShader.getCameraUniform("camera");
+    SpotLightUniform impostorSpotLightUniform = impostorShader.getSpotLightUniform("spotLights[0]");
+    PointLightUniform impostorPointLightUniform = impostorShader.getPointLightUniform("pointLights[0]");
+    DirLightUniform impostorDirLightUniform = impostorShader.getDirLightUniform("dirLights[0]");
+    GLint impostorNumSpotLightsUniform = impostorShader.getUniform("numSpotLights");
+    GLint impostorNumPointLightsUniform = impostorShader.getUniform("numPointLights");
+    GLint impostorNumDirLightsUniform = impostorShader.getUniform("numDirLights");
+    GLint impostorRadiusUniform = impostorShader.getUniform("radius");
+    GLint impostorUseParticleBufferUniform = impostorShader.getUniform("useParticleBuffer");
+    GLint impostorFirstParticleUniform = impostorShader.getUniform("firstParticle");
+    GLint impostorBoxSideUniform = impostorShader.getUniform("boxSide");
+    GLint impostorFirstImageUniform = impostorShader.getUniform("firstImage");
+    GLint impostorImageCountUniform = impostorShader.getUniform("imageCount");
+    SphereImpostors impostors;
+    ChargeDensityVolume chargeDensity(64, 8);
+    VolumeRenderer volumeRenderer;
+    volumeRenderer.loadShaders("shaders/fullscreen_vert.glsl", "shaders/volumeRaymarch_frag.glsl", "shaders/volumeUpsample_frag.glsl");
+    ParticleTrails trails;
+    trails.loadShaders("shaders/particleTrail_vert.glsl", "shaders/particleTrail_frag.glsl");
+    PointCloud pointCloud;
+    if (std::ifstream(pointCloudPath).good() && pointCloud.open(pointCloudPath, pointCloudBudgetBytes))
+    {
+        pointCloud.loadShaders("shaders/pointCloud_vert.glsl", "shaders/pointCloud_frag.glsl");
+    }
+
+    GpuParticleSystem gpuParticles;
+    gpuParticles.loadShaders("shaders/particleForces_comp.glsl", "shaders/particleIntegrate_comp.glsl");
+
     Material material(glm::vec3(0.8f, 0.1f, 0.1f));
     Material blueMat(glm::vec3(0.1f, 0.1f, 0.8f));
 
@@ -132,43 +260,71 @@ int main()
     spotLight.fadeAngle = 20.0f;
 
     camera.position = glm::vec3(0.0f, 0.0f, 10.0f);
-    struct particle
-    {
-        glm::vec3 position;
-        glm::vec3 velocity;
-        glm::vec3 acceleration;
-        void update(float timeStep)
-        {
-            velocity += acceleration * timeStep;
-            position += velocity * timeStep;
-        }
-    };
-
-    std::vector<particle> electrons(10);
-    std::vector<particle> protons(10);
-
-    Mesh proton = uvSphere(0.1f, 10, 10);
-    Mesh electron = uvSphere(0.05f, 10, 10);
+    ParticleSystem particles;
+    particles.reserve(20);
     for (int i = 0; i < 10; i++)
     {
         float xVal = float(i) - 5.0f;
-        electrons[i].position = glm::vec3(xVal, 0.0f, 1.0f);
-        protons[i].position = glm::vec3(xVal, 0.0f, -1.0f);
-    }
-    proton.position = glm::vec3(0.0f, 0.0f, 0.0f);
-    electron.position = glm::vec3(0.0f, 0.0f, 0.3f);
-    glm::vec3 protonVelocity = glm::vec3(0.0f, 0.0f, 0.0f);
-    glm::vec3 electronVelocity = glm::vec3(0.01f, 0.01f, 0.0f);
-    glm::vec3 protonAcceleration = glm::vec3(0.0f, 0.0f, 0.0f);
-    glm::vec3 electronAcceleration = glm::vec3(0.0f, 0.0f, 0.0f);
-    glm::vec3 distanceVec;
-    glm::vec3 dirVec;
-    float distanceSquared;
+        particles.addParticle(ParticleSpecies::Electron, glm::vec3(xVal, 0.0f, 1.0f));
+        particles.addParticle(ParticleSpecies::Proton, glm::vec3(xVal, 0.0f, -1.0f));
+    }
+
+    JobSystem jobs;
+    BruteForceSolver bruteForce(&jobs);
+    BarnesHutSolver barnesHut(0.5f, &jobs);
+    CutoffSolver cutoffSolver(2.0f, 0.0f, true, &jobs);
+    FastMultipoleSolver fastMultipole(4, 0.6f, &jobs);
+    ParticleInCellSolver particleInCell(64, ChargeAssignment::TriangularShapedCloud, &jobs);
+    ForceSolver* forceSolvers[] = { &bruteForce, &barnesHut, &cutoffSolver, &fastMultipole, &particleInCell };
+    const int forceSolverCount = sizeof(forceSolvers) / sizeof(forceSolvers[0]);
+    ParticleMeshEwaldSolver particleMeshEwald(32, ChargeAssignment::TriangularShapedCloud, 6.0f, &jobs);
+    integrator.jobs = &jobs;
+    std::vector<glm::vec3> particlePositions;
+    std::vector<glm::mat4> particleModels;
+    // Per particle, 1 when it is drawn as a mesh (uint8_t, written from job threads)
+    std::vector<uint8_t> particleDrawnAsMesh;
+    std::vector<glm::vec3> electronCenters;
+    std::vector<glm::vec3> protonCenters;
+    // Particles drawn as a mesh in a periodic box, their other images are still impostors
+    std::vector<glm::vec3> electronImageCenters;
+    std::vector<glm::vec3> protonImageCenters;
+    std::vector<glm::mat4> electronModels;
+    std::vector<glm::mat4> protonModels;
+
+    TrajectoryRecorder recorder;
+    TrajectoryReader playback;
+    ParticleSystem playbackParticles;
+    std::size_t playbackFrame = 0;
+
+    // The two newest snapshots from the simulation thread, drawn blended
+    ParticleSnapshot previousSnapshot;
+    ParticleSnapshot currentSnapshot;
+    simulation.setPaused(true);
+    simulation.start(particles, integrator, forceSolvers[0], &recorder);
+
+    Mesh proton = uvSphere(protonRadius, 10, 10);
+    Mesh electron = uvSphere(electronRadius, 10, 10);
     float countDown = 10.0f;
 
     lastFrame = glfwGetTime();
-    electron.bufferToGPU();
-    proton.bufferToGPU();
+    // The particles aren't textured, so the sphere's seam and pole copies can go
+    WeldSettings particleWeld;
+    particleWeld.texCoordEpsilon = -1.0f;
+    weldVertices(electron, particleWeld);
+    weldVertices(proton, particleWeld);
+    optimizeMesh(electron);
+    optimizeMesh(proton);
+    // Both spheres share one VAO and buffers, half the vertex memory of plain
+    // floats, quantized in a box around the larger one so one vertexFormat serves both
+    GeometryArenaSettings particleArenaSettings;
+    particleArenaSettings.layout = VertexLayout::compact();
+    particleArenaSettings.boundsMin = glm::vec3(-std::max(electronRadius, protonRadius));
+    particleArenaSettings.boundsMax = glm::vec3(std::max(electronRadius, protonRadius));
+    particleArenaSettings.vertexCapacity = electron.vertices.size() + proton.vertices.size();
+    particleArenaSettings.indexCapacity = electron.indices.size() + proton.indices.size();
+    GeometryArena particleArena(particleArenaSettings);
+    GeometryHandle electronGeometry = particleArena.add(electron);
+    GeometryHandle protonGeometry = particleArena.add(proton);
     // Render Loop
     while (!glfwWindowShouldClose(window))
     {
@@ -183,72 +339,133 @@ int main()
         glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        if (countDown <= 0.0f)
+        // Everything below that touches particles, integrator or recorder needs the simulation thread idle
+        if (gpuParticlesChanged || recordingToggled || playbackToggled || periodicToggled)
+        {
+            simulation.setPaused(true);
+        }
+
+        if (periodicToggled)
         {
-            for (int i = 0; i < 1; i++)
+            if (useGpuParticles)
             {
-                float dT = deltaTime * float(i) / 100.0f;
-                for (int a = 0; a < electrons.size(); a++)
-                {
-                    electrons[a].acceleration = glm::vec3(0.0f);
-                }
-                for (int a = 0; a < protons.size(); a++)
-                {
-                    protons[a].acceleration = glm::vec3(0.0f);
-                }
-                for (int a = 0; a < electrons.size(); a++)
-                {
-                    for (int b = 0; b < electrons.size(); b++)
-                    {
-                        if (a != b)
-                        {
-                            distanceVec = electrons[a].position - electrons[b].position;
-                            distanceSquared = glm::dot(distanceVec, distanceVec);
-                            dirVec = normalize(distanceVec);
-                            electrons[a].acceleration += accel_on_e_from_e_per_m2 * distanceSquared * dirVec;
-                            electrons[b].acceleration += accel_on_e_from_e_per_m2 * distanceSquared * -dirVec;
-                        }
-                    }
-                }
-                for (int a = 0; a < protons.size(); a++)
-                {
-                    for (int b = 0; b < protons.size(); b++)
-                    {
-                        if (a != b)
-                        {
-                            distanceVec = protons[a].position - protons[b].position;
-                            distanceSquared = glm::dot(distanceVec, distanceVec);
-                            dirVec = normalize(distanceVec);
-                            electrons[a].acceleration += accel_on_e_from_e_per_m2 * distanceSquared * -dirVec;
-                            electrons[b].acceleration += accel_on_e_from_e_per_m2 * distanceSquared * dirVec;
-                        }
-                    }
-                }
-                for (int a = 0; a < electrons.size(); a++)
-                {
-                    for (int b = 0; b < protons.size(); b++)
-                    {
-                        distanceVec = electrons[a].position - protons[b].position;
-                        distanceSquared = glm::dot(distanceVec, distanceVec);
-                        dirVec = normalize(distanceVec);
-                        electrons[a].acceleration += accel_on_e_from_e_per_m2 * distanceSquared * dirVec;
-                        protons[b].acceleration += accel_on_e_from_e_per_m2 * distanceSquared * dirVec;
-                    }
-                }
+                std::cout << "Periodic boundaries need the CPU simulation" << std::endl;
+            }
+            else if (periodicBoundaries)
+            {
+                particles.box = PeriodicBox();
+                periodicBoundaries = false;
+                ForceSolver* forceSolver = forceSolvers[forceSolverIndex % forceSolverCount];
+                simulation.setForceSolver(forceSolver);
+                std::cout << "Open boundaries, force solver: " << forceSolver->name() << std::endl;
+            }
+            else
+            {
+                particles.box = PeriodicBox(periodicBoxSide);
+                particles.wrapPositions(&jobs);
+                periodicBoundaries = true;
+                simulation.setForceSolver(&particleMeshEwald);
+                std::cout << "Periodic box of side " << periodicBoxSide << ", force solver: " << particleMeshEwald.name() << std::endl;
+            }
+            integrator.invalidateAccelerations();
+            periodicToggled = false;
+        }
 
+        if (gpuParticlesChanged)
+        {
+            // The path being switched to takes over the other one's state
+            if (useGpuParticles)
+            {
+                gpuParticles.upload(particles);
+            }
+            else
+            {
+                gpuParticles.download(particles);
+                integrator.invalidateAccelerations();
+            }
+            std::cout << "Particle simulation: " << (useGpuParticles ? "GPU" : "CPU") << std::endl;
+            gpuParticlesChanged = false;
+        }
 
-                for (int a = 0; a < electrons.size(); a++)
-                {
-                    electrons[a].update(deltaTime);
-                }
-                for (int a = 0; a < protons.size(); a++)
+        if (recordingToggled)
+        {
+            if (recorder.isOpen())
+            {
+                recorder.close();
+                std::cout << "Recorded " << recorder.getRecordedFrames() << " frames to " << trajectoryPath << std::endl;
+            }
+            else if (recorder.open(trajectoryPath, particles))
+            {
+                std::cout << "Recording to " << trajectoryPath << std::endl;
+            }
+            recordingToggled = false;
+        }
+        if (playbackToggled)
+        {
+            if (playback.isOpen())
+            {
+                playback.close();
+            }
+            else if (playback.open(trajectoryPath))
+            {
+                playbackFrame = 0;
+                std::cout << "Playing " << trajectoryPath << ", " << playback.getFrameCount() << " frames" << std::endl;
+            }
+            playbackToggled = false;
+        }
+
+        if (playback.isOpen())
+        {
+            // One recorded frame per fixed step, so playback runs at the recorded speed
+            long long frame = (long long) playbackFrame + integrator.consumeSteps(deltaTime) + playbackSeek;
+            long long frameCount = (long long) playback.getFrameCount();
+            playbackFrame = frameCount > 0 ? std::size_t(((frame % frameCount) + frameCount) % frameCount) : 0;
+            playbackSeek = 0;
+            playback.readFrame(playbackFrame, playbackParticles);
+        }
+        else if (countDown <= 0.0f)
+        {
+            if (forceSolverChanged)
+            {
+                ForceSolver* forceSolver = forceSolvers[forceSolverIndex % forceSolverCount];
+                simulation.setForceSolver(forceSolver);
+                std::cout << "Force solver: " << forceSolver->name() << std::endl;
+                forceSolverChanged = false;
+            }
+            if (useGpuParticles)
+            {
+                // Always all-pairs, the solver choice only applies to the CPU path.
+                // The simulation thread is paused, so the integrator is free to use here.
+                int substeps = std::max(simulation.getSubsteps(), 1);
+                int steps = integrator.consumeSteps(deltaTime) * substeps;
+                for (int s = 0; s < steps; s++)
                 {
-                    protons[a].update(deltaTime);
+                    gpuParticles.step(simulation.getScheme(), integrator.timeStep / float(substeps));
                 }
             }
         }
+        // The CPU path steps and records on the simulation thread
+        simulation.setPaused(countDown > 0.0f || useGpuParticles || playback.isOpen());
         camera.updateProjection();
         camera.updateView();
+        if (pointCloud.isOpen() && showPointCloud)
+        {
+            int viewportWidth, viewportHeight;
+            glfwGetFramebufferSize(window, &viewportWidth, &viewportHeight);
+            pointCloud.update(camera, viewportHeight);
+            pointCloud.draw(camera, viewportHeight);
+        }
+        if (useImpostors)
+        {
+            impostorShader.use();
+            setSpotLight(impostorSpotLightUniform, spotLight);
+            setPointLight(impostorPointLightUniform, pointLight);
+            setDirLight(impostorDirLightUniform, dirLight);
+            setCamera(impostorCameraUniform, camera);
+            setInt(impostorNumSpotLightsUniform, 1);
+            setInt(impostorNumPointLightsUniform, 1);
+            setInt(impostorNumDirLightsUniform, 1);
+        }
         meshShader.use();
         setSpotLight(spotLightUniform, spotLight);
         setPointLight(pointLightUniform, pointLight);
@@ -258,23 +475,196 @@ int main()
         setInt(numSpotLightsUniform, 1);
         setInt(numPointLightsUniform, 1);
         setInt(numDirLightsUniform, 1);
-        setMesh(meshUniform, electron);
-        setMaterial(materialUniform, blueMat);
-        for (int a = 0; a < electrons.size(); a++)
+
+        if (useGpuParticles && !playback.isOpen() && useImpostors)
         {
-            electron.position = electrons[a].position;
-            electron.calculateModel();
-            electron.calculateNormal();
-            electron.draw();
+            // The positions never leave the GPU, so there is no distance test
+            // here and every particle is an impostor
+            impostorShader.use();
+            gpuParticles.bindForDrawing();
+            setBool(impostorUseParticleBufferUniform, true);
+            setInt(impostorFirstImageUniform, 0);
+            setInt(impostorImageCountUniform, 1);
+
+            setMaterial(impostorMaterialUniform, blueMat);
+            setFloat(impostorRadiusUniform, electronRadius);
+            setUInt(impostorFirstParticleUniform, 0);
+            impostors.drawInstanced(gpuParticles.getNegativeCount());
+
+            setMaterial(impostorMaterialUniform, material);
+            setFloat(impostorRadiusUniform, protonRadius);
+            setUInt(impostorFirstParticleUniform, (unsigned int) gpuParticles.getNegativeCount());
+            impostors.drawInstanced(gpuParticles.getPositiveCount());
         }
-        setMesh(meshUniform, proton);
-        setMaterial(materialUniform, material);
-        for (int a = 0; a < protons.size(); a++)
+        else if (useGpuParticles && !playback.isOpen())
         {
-            proton.position = protons[a].position;
-            proton.calculateModel();
-            proton.calculateNormal();
-            proton.draw();
+            particleShader.use();
+            setSpotLight(particleSpotLightUniform, spotLight);
+            setPointLight(particlePointLightUniform, pointLight);
+            setDirLight(particleDirLightUniform, dirLight);
+            setCamera(particleCameraUniform, camera);
+            setInt(particleNumSpotLightsUniform, 1);
+            setInt(particleNumPointLightsUniform, 1);
+            setInt(particleNumDirLightsUniform, 1);
+            gpuParticles.bindForDrawing();
+
+            // The translation comes from the SSBO, the uniform only carries rotation and scale
+            glm::mat4 electronModel = calculateModelMatrix(glm::vec3(0.0f), electron.rotation, electron.scale);
+            setMaterial(particleMaterialUniform, blueMat);
+            setMesh(particleMeshUniform, electronModel, calculateNormalMatrix(electronModel));
+            setUInt(firstParticleUniform, 0);
+            setVertexFormat(particleVertexFormatUniform, particleArena);
+            particleArena.bind();
+            particleArena.drawInstanced(electronGeometry, gpuParticles.getNegativeCount());
+
+            glm::mat4 protonModel = calculateModelMatrix(glm::vec3(0.0f), proton.rotation, proton.scale);
+            setMaterial(particleMaterialUniform, material);
+            setMesh(particleMeshUniform, protonModel, calculateNormalMatrix(protonModel));
+            setUInt(firstParticleUniform, (unsigned int) gpuParticles.getNegativeCount());
+            particleArena.drawInstanced(protonGeometry, gpuParticles.getPositiveCount());
+            glBindVertexArray(0);
+        }
+        else
+        {
+            if (playback.isOpen())
+            {
+                previousSnapshot.positions.clear();
+                currentSnapshot.boxSide = 0.0f;
+                currentSnapshot.positions.resize(playbackParticles.size());
+                currentSnapshot.charges.resize(playbackParticles.size());
+                for (std::size_t a = 0; a < playbackParticles.size(); a++)
+                {
+                    currentSnapshot.positions[a] = playbackParticles.position(a);
+                    currentSnapshot.charges[a] = playbackParticles.charge[a];
+                }
+            }
+            else if (simulation.snapshots().update())
+            {
+                std::swap(previousSnapshot, currentSnapshot);
+                currentSnapshot = simulation.snapshots().readBuffer();
+            }
+            // One snapshot behind the simulation, so there is always a newer state to move towards
+            float blend = snapshotBlend(previousSnapshot, currentSnapshot, steadySeconds());
+            const ParticleSnapshot& shown = currentSnapshot;
+            const PeriodicBox box(shown.boxSide);
+            int framebufferWidth, framebufferHeight;
+            glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+            particlePositions.resize(shown.positions.size());
+            particleModels.resize(shown.positions.size());
+            particleDrawnAsMesh.resize(shown.positions.size());
+            jobs.parallelFor(0, shown.positions.size(), 256,
+                [&](std::size_t begin, std::size_t end, unsigned int)
+                {
+                    for (std::size_t a = begin; a < end; a++)
+                    {
+                        const Mesh& particleMesh = shown.charges[a] < 0.0f ? electron : proton;
+                        float radius = shown.charges[a] < 0.0f ? electronRadius : protonRadius;
+                        glm::vec3 position = shown.positions[a];
+                        // A particle that wrapped between the two blends from its nearest image
+                        if (blend < 1.0f)
+                            position += (1.0f - blend) * (box.isPeriodic()
+                                ? box.minimumImage(previousSnapshot.positions[a] - position)
+                                : previousSnapshot.positions[a] - position);
+                        particlePositions[a] = position;
+                        float pixels = projectedRadiusPixels(camera.projection, float(framebufferHeight),
+                            glm::distance(position, camera.position), radius);
+                        particleDrawnAsMesh[a] = !useImpostors || pixels > impostorMaxRadiusPixels;
+                        if (particleDrawnAsMesh[a])
+                            particleModels[a] = calculateModelMatrix(position, particleMesh.rotation, particleMesh.scale);
+                    }
+                });
+            electronModels.clear();
+            protonModels.clear();
+            electronCenters.clear();
+            protonCenters.clear();
+            electronImageCenters.clear();
+            protonImageCenters.clear();
+            for (std::size_t a = 0; a < shown.positions.size(); a++)
+            {
+                if (shown.charges[a] == 0.0f)
+                    continue;
+                bool isElectron = shown.charges[a] < 0.0f;
+                std::vector<glm::mat4>& models = isElectron ? electronModels : protonModels;
+                if (!particleDrawnAsMesh[a])
+                {
+                    (isElectron ? electronCenters : protonCenters).push_back(particlePositions[a]);
+                    continue;
+                }
+                models.push_back(particleModels[a]);
+                if (!box.isPeriodic())
+                    continue;
+                if (useImpostors)
+                {
+                    (isElectron ? electronImageCenters : protonImageCenters).push_back(particlePositions[a]);
+                }
+                else
+                {
+                    // Meshes have no image uniforms, every image is a model of its own
+                    const Mesh& particleMesh = isElectron ? electron : proton;
+                    for (int image = 1; image < PERIODIC_IMAGE_COUNT; image++)
+                    {
+                        models.push_back(calculateModelMatrix(particlePositions[a] + box.imageOffset(image),
+                            particleMesh.rotation, particleMesh.scale));
+                    }
+                }
+            }
+
+            // One draw call per species
+            setBool(renderInstancedUniform, true);
+            setVertexFormat(vertexFormatUniform, particleArena);
+            particleArena.bind();
+            setMaterial(materialUniform, blueMat);
+            particleArena.drawInstanced(electronGeometry, electronModels);
+            setMaterial(materialUniform, material);
+            particleArena.drawInstanced(protonGeometry, protonModels);
+            glBindVertexArray(0);
+            setBool(renderInstancedUniform, false);
+
+            if (useImpostors)
+            {
+                // Every image of the impostor particles, then the images
+                // around the mesh particles, which drew their own box already
+                GLuint imageCount = box.isPeriodic() ? PERIODIC_IMAGE_COUNT : 1;
+                impostorShader.use();
+                setBool(impostorUseParticleBufferUniform, false);
+                setFloat(impostorBoxSideUniform, box.side);
+                setInt(impostorFirstImageUniform, 0);
+                setInt(impostorImageCountUniform, int(imageCount));
+                setMaterial(impostorMaterialUniform, blueMat);
+                setFloat(impostorRadiusUniform, electronRadius);
+                impostors.draw(electronCenters, imageCount);
+                setMaterial(impostorMaterialUniform, material);
+                setFloat(impostorRadiusUniform, protonRadius);
+                impostors.draw(protonCenters, imageCount);
+                if (box.isPeriodic())
+                {
+                    setInt(impostorFirstImageUniform, 1);
+                    setMaterial(impostorMaterialUniform, blueMat);
+                    setFloat(impostorRadiusUniform, electronRadius);
+                    impostors.draw(electronImageCenters, imageCount - 1);
+                    setMaterial(impostorMaterialUniform, material);
+                    setFloat(impostorRadiusUniform, protonRadius);
+                    impostors.draw(protonImageCenters, imageCount - 1);
+                }
+            }
+
+            if (showTrails)
+            {
+                trails.record(particlePositions, shown.charges);
+                trails.draw(camera, box.isPeriodic() ? std::min(trailMaxStep, 0.5f * box.side) : trailMaxStep);
+            }
+            else if (trails.getRecordedLength() > 0)
+            {
+                trails.clear();
+            }
+
+            // Last, so it composites over every opaque particle
+            if (showChargeDensity)
+            {
+                chargeDensity.splat(particlePositions, shown.charges, &jobs);
+                chargeDensity.upload();
+                volumeRenderer.render(chargeDensity, camera, framebufferWidth, framebufferHeight);
+            }
         }
 
         // Swap frame buffers and get next events
@@ -282,6 +672,7 @@ int main()
         glfwPollEvents();
     }
 
+    simulation.stop();
     glfwTerminate();
 
     return 0;
@@ -335,6 +726,80 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     glViewport(0, 0, width, height);
 }
 
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (key == GLFW_KEY_B && action == GLFW_PRESS && !periodicBoundaries)
+    {
+        forceSolverIndex++;
+        forceSolverChanged = true;
+    }
+    if (key == GLFW_KEY_RIGHT_BRACKET && action == GLFW_PRESS)
+    {
+        simulation.setSubsteps(simulation.getSubsteps() + 1);
+        std::cout << "Substeps: " << simulation.getSubsteps() << std::endl;
+    }
+    if (key == GLFW_KEY_LEFT_BRACKET && action == GLFW_PRESS)
+    {
+        simulation.setSubsteps(std::max(simulation.getSubsteps() - 1, 1));
+        std::cout << "Substeps: " << simulation.getSubsteps() << std::endl;
+    }
+    if (key == GLFW_KEY_G && action == GLFW_PRESS && !periodicBoundaries)
+    {
+        useGpuParticles = !useGpuParticles;
+        gpuParticlesChanged = true;
+    }
+    if (key == GLFW_KEY_R && action == GLFW_PRESS)
+    {
+        recordingToggled = true;
+    }
+    if (key == GLFW_KEY_P && action == GLFW_PRESS)
+    {
+        playbackToggled = true;
+    }
+    if (key == GLFW_KEY_LEFT && (action == GLFW_PRESS || action == GLFW_REPEAT))
+    {
+        playbackSeek -= 120;
+    }
+    if (key == GLFW_KEY_RIGHT && (action == GLFW_PRESS || action == GLFW_REPEAT))
+    {
+        playbackSeek += 120;
+    }
+    if (key == GLFW_KEY_V && action == GLFW_PRESS)
+    {
+        showChargeDensity = !showChargeDensity;
+        std::cout << "Charge density volume: " << (showChargeDensity ? "on" : "off") << std::endl;
+    }
+    if (key == GLFW_KEY_K && action == GLFW_PRESS)
+    {
+        periodicToggled = true;
+    }
+    if (key == GLFW_KEY_I && action == GLFW_PRESS)
+    {
+        useImpostors = !useImpostors;
+        std::cout << "Particles: " << (useImpostors ? "impostors" : "meshes") << std::endl;
+    }
+    if (key == GLFW_KEY_T && action == GLFW_PRESS)
+    {
+        showTrails = !showTrails;
+        std::cout << "Particle trails: " << (showTrails ? "on" : "off") << std::endl;
+    }
+    if (key == GLFW_KEY_O && action == GLFW_PRESS)
+    {
+        showPointCloud = !showPointCloud;
+        std::cout << "Point cloud: " << (showPointCloud ? "on" : "off") << std::endl;
+    }
+    if (key == GLFW_KEY_L && action == GLFW_PRESS)
+    {
+        if (simulation.getScheme() == IntegrationScheme::VelocityVerlet)
+            simulation.setScheme(IntegrationScheme::Leapfrog);
+        else if (simulation.getScheme() == IntegrationScheme::Leapfrog)
+            simulation.setScheme(IntegrationScheme::BlockTimesteps);
+        else
+            simulation.setScheme(IntegrationScheme::VelocityVerlet);
+        std::cout << "Integrator: " << integrationSchemeName(simulation.getScheme()) << std::endl;
+    }
+}
+
 void processInput(GLFWwindow* window)
 {
     float distance = 5.0f * deltaTime;
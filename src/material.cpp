@@ -32,17 +32,20 @@ Material::Material(glm::vec3 diffuse, glm::vec3 specular, float shininess)
 {}
 
 
+// Built in place, a braced list would copy each Texture out of it
 Material::Material(std::string diffuseTex)
     :   baseDiffuseColor(black),
         baseSpecularColor(black),
-        diffuseTextures({Texture(diffuseTex)}),
         shininess(1.0f)
-{}
+{
+    diffuseTextures.emplace_back(diffuseTex);
+}
 
 Material::Material(std::string diffuseTex, std::string specularTex)
     :   baseDiffuseColor(black),
         baseSpecularColor(black),
-        diffuseTextures({Texture(diffuseTex)}),
-        specularTextures({Texture(specularTex)}),
         shininess(1.0f)
-{}
\ No newline at end of file
+{
+    diffuseTextures.emplace_back(diffuseTex);
+    specularTextures.emplace_back(specularTex);
+}
\ No newline at end of file
@@ -3,17 +3,153 @@
 // Author: Kyle Bueche
 
 #include "mesh.h"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <numbers>
 #include "glm/ext/matrix_transform.hpp"
+#include "glm/gtc/packing.hpp"
+
+VertexLayout VertexLayout::compact()
+{
+    VertexLayout layout;
+    layout.quantizePositions = true;
+    layout.octahedralNormals = true;
+    layout.texCoords = TexCoordFormat::Half;
+    return layout;
+}
+
+// Quantized positions take four unorm16, so every attribute starts 4-byte aligned
+static GLsizei positionBytes(VertexLayout layout)
+{
+    return layout.quantizePositions ? 4 * sizeof(uint16_t) : sizeof(glm::vec3);
+}
+
+static GLsizei normalBytes(VertexLayout layout)
+{
+    return layout.octahedralNormals ? 2 * sizeof(int16_t) : sizeof(glm::vec3);
+}
+
+static GLsizei texCoordBytes(VertexLayout layout)
+{
+    return layout.texCoords == TexCoordFormat::Float ? sizeof(glm::vec2) : 2 * sizeof(uint16_t);
+}
+
+GLsizei vertexStride(VertexLayout layout)
+{
+    return positionBytes(layout) + normalBytes(layout) + texCoordBytes(layout);
+}
+
+glm::vec2 octahedralEncode(glm::vec3 normal)
+{
+    normal /= std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    glm::vec2 encoded(normal.x, normal.y);
+    if (normal.z < 0.0f)
+    {
+        // The lower half folds out over the corners
+        encoded.x = (1.0f - std::abs(normal.y)) * (normal.x >= 0.0f ? 1.0f : -1.0f);
+        encoded.y = (1.0f - std::abs(normal.x)) * (normal.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return encoded;
+}
+
+glm::vec3 octahedralDecode(glm::vec2 encoded)
+{
+    glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+    if (normal.z < 0.0f)
+    {
+        normal.x = (1.0f - std::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f);
+        normal.y = (1.0f - std::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return glm::normalize(normal);
+}
+
+PackedVertices packVertices(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals,
+                            const std::vector<glm::vec2>& texCoords, VertexLayout layout)
+{
+    glm::vec3 lo(0.0f);
+    glm::vec3 hi(1.0f);
+    if (layout.quantizePositions && !positions.empty())
+    {
+        lo = positions[0];
+        hi = positions[0];
+        for (const glm::vec3& p : positions)
+        {
+            lo = glm::min(lo, p);
+            hi = glm::max(hi, p);
+        }
+    }
+    return packVertices(positions, normals, texCoords, layout, lo, hi);
+}
+
+PackedVertices packVertices(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals,
+                            const std::vector<glm::vec2>& texCoords, VertexLayout layout, glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+    PackedVertices packed;
+    packed.stride = vertexStride(layout);
+    packed.bytes.resize(positions.size() * std::size_t(packed.stride));
+
+    glm::vec3 inverseScale(1.0f);
+    if (layout.quantizePositions)
+    {
+        packed.positionOffset = boundsMin;
+        packed.positionScale = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+        // A flat axis keeps scale 0, every vertex on it decodes to boundsMin
+        inverseScale = glm::vec3(
+            packed.positionScale.x > 0.0f ? 1.0f / packed.positionScale.x : 0.0f,
+            packed.positionScale.y > 0.0f ? 1.0f / packed.positionScale.y : 0.0f,
+            packed.positionScale.z > 0.0f ? 1.0f / packed.positionScale.z : 0.0f);
+    }
+
+    const GLsizei normalOffset = positionBytes(layout);
+    const GLsizei texCoordOffset = normalOffset + normalBytes(layout);
+    for (std::size_t i = 0; i < positions.size(); i++)
+    {
+        uint8_t* vertex = packed.bytes.data() + i * std::size_t(packed.stride);
+        glm::vec3 normal = i < normals.size() ? normals[i] : glm::vec3(0.0f);
+        glm::vec2 texCoord = i < texCoords.size() ? texCoords[i] : glm::vec2(0.0f);
+
+        if (layout.quantizePositions)
+        {
+            uint64_t bits = glm::packUnorm4x16(glm::vec4((positions[i] - packed.positionOffset) * inverseScale, 0.0f));
+            std::memcpy(vertex, &bits, sizeof(bits));
+        }
+        else
+        {
+            std::memcpy(vertex, &positions[i], sizeof(glm::vec3));
+        }
+
+        if (layout.octahedralNormals)
+        {
+            uint32_t bits = normal == glm::vec3(0.0f) ? 0 : glm::packSnorm2x16(octahedralEncode(normal));
+            std::memcpy(vertex + normalOffset, &bits, sizeof(bits));
+        }
+        else
+        {
+            std::memcpy(vertex + normalOffset, &normal, sizeof(glm::vec3));
+        }
+
+        if (layout.texCoords == TexCoordFormat::Float)
+        {
+            std::memcpy(vertex + texCoordOffset, &texCoord, sizeof(glm::vec2));
+        }
+        else
+        {
+            uint32_t bits = layout.texCoords == TexCoordFormat::Half ? glm::packHalf2x16(texCoord) : glm::packUnorm2x16(texCoord);
+            std::memcpy(vertex + texCoordOffset, &bits, sizeof(bits));
+        }
+    }
+    return packed;
+}
 
 Mesh::Mesh()
 {
-    VAO = 0;
-    VBOs[0] = 0;
-    VBOs[1] = 0;
-    VBOs[2] = 0;
-    EBO = 0;
+    positionOffset = glm::vec3(0.0f);
+    positionScale = glm::vec3(1.0f);
+    vertexBufferBytes = 0;
+    indexType = GL_UNSIGNED_INT;
+    indexBufferBytes = 0;
+    instanceCapacity = 0;
     vertices = std::vector<glm::vec3>();
     normals = std::vector<glm::vec3>();
     texCoords = std::vector<glm::vec2>();
@@ -27,15 +163,17 @@ Mesh::Mesh()
 
 Mesh::Mesh(const Mesh& other)
 {
-    VAO = 0;
-    VBOs[0] = 0;
-    VBOs[1] = 0;
-    VBOs[2] = 0;
-    EBO = 0;
+    positionOffset = glm::vec3(0.0f);
+    positionScale = glm::vec3(1.0f);
+    vertexBufferBytes = 0;
+    indexType = GL_UNSIGNED_INT;
+    indexBufferBytes = 0;
+    instanceCapacity = 0;
     vertices = other.vertices;
     normals = other.normals;
     texCoords = other.texCoords;
     indices = other.indices;
+    vertexLayout = other.vertexLayout;
     position = other.position;
     rotation = other.rotation;
     scale = other.scale;
@@ -43,40 +181,53 @@ Mesh::Mesh(const Mesh& other)
     normal = other.normal;
 }
 
-Mesh::~Mesh()
+Mesh::Mesh(Mesh&& other) noexcept = default;
+
+Mesh& Mesh::operator=(const Mesh& other)
 {
-    deleteBuffersIfAllocated();
+    if (this != &other)
+    {
+        *this = Mesh(other);
+    }
+    return *this;
 }
 
+Mesh& Mesh::operator=(Mesh&& other) noexcept = default;
+
 void Mesh::bufferToGPU()
 {
-    deleteBuffersIfAllocated();
+    deleteBuffers();
     allocateBuffers();
 
-    // Vertex Array Object
-    glBindVertexArray(VAO);
-
-    // Vertices
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*) 0);
-    glEnableVertexAttribArray(0);
+    PackedVertices packed = packVertices(vertices, normals, texCoords, vertexLayout);
+    bufferedLayout = vertexLayout;
+    positionOffset = packed.positionOffset;
+    positionScale = packed.positionScale;
+    vertexBufferBytes = packed.bytes.size();
 
-    // Normals
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * normals.size(), &normals[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*) 0);
-    glEnableVertexAttribArray(1);
+    // Vertex Array Object
+    glBindVertexArray(VAO.get());
 
-    // Texture Coordinates
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[2]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec2) * texCoords.size(), &texCoords[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*) 0);
-    glEnableVertexAttribArray(2);
+    // Positions, normals and texture coordinates, interleaved
+    glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
+    glBufferData(GL_ARRAY_BUFFER, packed.bytes.size(), packed.bytes.data(), GL_STATIC_DRAW);
+    setVertexAttributes(vertexLayout);
 
-    // Indices
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
+    // Indices, half the size and fetch bandwidth when they fit in 16 bits
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO.get());
+    if (vertices.size() <= 65536)
+    {
+        std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+        indexType = GL_UNSIGNED_SHORT;
+        indexBufferBytes = sizeof(uint16_t) * shortIndices.size();
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferBytes, shortIndices.data(), GL_STATIC_DRAW);
+    }
+    else
+    {
+        indexType = GL_UNSIGNED_INT;
+        indexBufferBytes = sizeof(unsigned int) * indices.size();
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferBytes, indices.data(), GL_STATIC_DRAW);
+    }
 
     // Unbind Vertex Array
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -85,41 +236,126 @@ void Mesh::bufferToGPU()
 
 void Mesh::draw()
 {
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    glBindVertexArray(VAO.get());
+    glDrawElements(GL_TRIANGLES, indices.size(), indexType, 0);
+    glBindVertexArray(0);
+}
+
+void Mesh::drawInstanced(GLsizei instanceCount)
+{
+    if (instanceCount <= 0)
+        return;
+    glBindVertexArray(VAO.get());
+    glDrawElementsInstanced(GL_TRIANGLES, indices.size(), indexType, 0, instanceCount);
     glBindVertexArray(0);
 }
 
+void Mesh::drawInstanced(const std::vector<glm::mat4>& models)
+{
+    if (models.empty())
+        return;
+    if (!instanceVBO || models.size() > instanceCapacity)
+        allocateInstanceBuffer(std::max(models.size(), 2 * instanceCapacity));
+
+    // Orphan the old storage so the driver doesn't wait on last frame's draw
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO.get());
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * instanceCapacity, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::mat4) * models.size(), models.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    drawInstanced((GLsizei) models.size());
+}
+
+void Mesh::allocateInstanceBuffer(std::size_t capacity)
+{
+    if (!instanceVBO)
+        instanceVBO = createGLBuffer();
+    instanceCapacity = capacity;
+
+    glBindVertexArray(VAO.get());
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO.get());
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * instanceCapacity, NULL, GL_STREAM_DRAW);
+    setInstanceModelAttributes();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void setVertexAttributes(VertexLayout layout)
+{
+    const GLsizei stride = vertexStride(layout);
+    const GLsizei normalOffset = positionBytes(layout);
+    const GLsizei texCoordOffset = normalOffset + normalBytes(layout);
+    if (layout.quantizePositions)
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*) 0);
+    else
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*) 0);
+    glEnableVertexAttribArray(0);
+
+    if (layout.octahedralNormals)
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*) std::size_t(normalOffset));
+    else
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*) std::size_t(normalOffset));
+    glEnableVertexAttribArray(1);
+
+    if (layout.texCoords == TexCoordFormat::Half)
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*) std::size_t(texCoordOffset));
+    else if (layout.texCoords == TexCoordFormat::Unorm16)
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*) std::size_t(texCoordOffset));
+    else
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*) std::size_t(texCoordOffset));
+    glEnableVertexAttribArray(2);
+}
+
+void setInstanceModelAttributes()
+{
+    // A mat4 attribute takes four vec4 locations, 3 to 6
+    for (int column = 0; column < 4; column++)
+    {
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*) (sizeof(glm::vec4) * column));
+        glEnableVertexAttribArray(3 + column);
+        glVertexAttribDivisor(3 + column, 1);
+    }
+}
+
 void Mesh::calculateModel()
 {
-    model = glm::mat4(1.0f);
+    model = calculateModelMatrix(position, rotation, scale);
+}
+
+void Mesh::calculateNormal()
+{
+    normal = calculateNormalMatrix(model);
+}
+
+glm::mat4 calculateModelMatrix(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale)
+{
+    glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, position);
     model = glm::rotate(model, rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
     model = glm::rotate(model, rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
     model = glm::rotate(model, rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
     model = glm::scale(model, scale);
+    return model;
 }
 
-void Mesh::calculateNormal()
+glm::mat3 calculateNormalMatrix(const glm::mat4& model)
 {
-    normal = glm::mat3(glm::transpose(glm::inverse(model)));
+    return glm::mat3(glm::transpose(glm::inverse(model)));
 }
 
 void Mesh::allocateBuffers()
 {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(3, VBOs);
-    glGenBuffers(1, &EBO);
+    VAO = createGLVertexArray();
+    VBO = createGLBuffer();
+    EBO = createGLBuffer();
 }
 
-void Mesh::deleteBuffersIfAllocated()
+void Mesh::deleteBuffers()
 {
-    if (EBO != 0)
-        glDeleteBuffers(1, &EBO);
-    for (int i = 0; i < 3; i++)
-        if (VBOs[i] != 0)
-            glDeleteBuffers(1, &VBOs[i]);
-    if (VAO != 0)
-        glDeleteVertexArrays(1, &VAO);
+    instanceVBO.reset();
+    instanceCapacity = 0;
+    EBO.reset();
+    VBO.reset();
+    VAO.reset();
 }
 
@@ -0,0 +1,695 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "meshOptimizer.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+typedef std::chrono::steady_clock OptimizeClock;
+
+// Forsyth's scoring assumes an LRU cache of this many vertices, larger than any real one
+static const int FORSYTH_CACHE_SIZE = 32;
+static const int FORSYTH_MAX_VALENCE = 64;
+// Pixels per side of analyzeOverdraw's views
+static const int OVERDRAW_VIEWPORT_SIZE = 256;
+
+const char* vertexCacheOrderName(VertexCacheOrder order)
+{
+    switch (order)
+    {
+        case VertexCacheOrder::None: return "none";
+        case VertexCacheOrder::Forsyth: return "forsyth";
+        case VertexCacheOrder::Tipsify: return "tipsify";
+    }
+    return "unknown";
+}
+
+static bool validTriangles(const std::vector<unsigned int>& indices, std::size_t vertexCount)
+{
+    if (indices.size() % 3 != 0)
+        return false;
+    for (unsigned int index : indices)
+    {
+        if (index >= vertexCount)
+            return false;
+    }
+    return true;
+}
+
+// The triangles using each vertex, once per corner
+struct TriangleAdjacency
+{
+    // Vertex v's triangles are triangles[offsets[v]] up to triangles[offsets[v + 1]]
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+};
+
+static TriangleAdjacency buildAdjacency(const std::vector<unsigned int>& indices, std::size_t vertexCount)
+{
+    TriangleAdjacency adjacency;
+    adjacency.offsets.assign(vertexCount + 1, 0);
+    for (unsigned int index : indices)
+    {
+        adjacency.offsets[index + 1]++;
+    }
+    for (std::size_t v = 0; v < vertexCount; v++)
+    {
+        adjacency.offsets[v + 1] += adjacency.offsets[v];
+    }
+    adjacency.triangles.resize(indices.size());
+    std::vector<uint32_t> next(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (std::size_t i = 0; i < indices.size(); i++)
+    {
+        adjacency.triangles[next[indices[i]]++] = uint32_t(i / 3);
+    }
+    return adjacency;
+}
+
+static void applyTriangleOrder(std::vector<unsigned int>& indices, const std::vector<uint32_t>& order)
+{
+    std::vector<unsigned int> ordered;
+    ordered.reserve(indices.size());
+    for (uint32_t triangle : order)
+    {
+        ordered.push_back(indices[3 * triangle + 0]);
+        ordered.push_back(indices[3 * triangle + 1]);
+        ordered.push_back(indices[3 * triangle + 2]);
+    }
+    indices.swap(ordered);
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, std::size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indices.empty() || !validTriangles(indices, vertexCount))
+        return stats;
+    // A vertex is in the FIFO while fewer than cacheSize others entered after it
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    std::vector<bool> used(vertexCount, false);
+    uint32_t time = cacheSize + 1;
+    std::size_t misses = 0;
+    std::size_t usedVertices = 0;
+    for (unsigned int index : indices)
+    {
+        if (time - timestamps[index] > cacheSize)
+        {
+            timestamps[index] = time++;
+            misses++;
+        }
+        if (!used[index])
+        {
+            used[index] = true;
+            usedVertices++;
+        }
+    }
+    stats.acmr = double(misses) / double(indices.size() / 3);
+    stats.atvr = double(misses) / double(usedVertices);
+    return stats;
+}
+
+static double edgeFunction(const glm::dvec3& a, const glm::dvec3& b, double x, double y)
+{
+    return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+double analyzeOverdraw(const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions)
+{
+    if (indices.empty() || !validTriangles(indices, positions.size()))
+        return 0.0;
+    glm::vec3 lo(std::numeric_limits<float>::max());
+    glm::vec3 hi(-std::numeric_limits<float>::max());
+    for (unsigned int index : indices)
+    {
+        lo = glm::min(lo, positions[index]);
+        hi = glm::max(hi, positions[index]);
+    }
+    glm::vec3 extent = hi - lo;
+    float largest = std::max(extent.x, std::max(extent.y, extent.z));
+    if (largest <= 0.0f)
+        return 0.0;
+    const int size = OVERDRAW_VIEWPORT_SIZE;
+    const double scale = size / double(largest);
+
+    std::vector<double> depth(std::size_t(size) * size);
+    uint64_t covered = 0;
+    uint64_t shaded = 0;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        for (double direction : {1.0, -1.0})
+        {
+            std::fill(depth.begin(), depth.end(), std::numeric_limits<double>::infinity());
+            int u = (axis + 1) % 3;
+            int v = (axis + 2) % 3;
+            for (std::size_t t = 0; t < indices.size(); t += 3)
+            {
+                glm::dvec3 corners[3];
+                for (int c = 0; c < 3; c++)
+                {
+                    glm::vec3 p = positions[indices[t + c]];
+                    corners[c] = glm::dvec3((p[u] - lo[u]) * scale, (p[v] - lo[v]) * scale, direction * p[axis]);
+                }
+                double area = edgeFunction(corners[0], corners[1], corners[2].x, corners[2].y);
+                if (area == 0.0)
+                    continue;
+                // Both windings are drawn, flip to one so the edge tests agree
+                if (area < 0.0)
+                {
+                    std::swap(corners[1], corners[2]);
+                    area = -area;
+                }
+                int minX = std::max(0, int(std::floor(std::min({corners[0].x, corners[1].x, corners[2].x}))));
+                int maxX = std::min(size - 1, int(std::ceil(std::max({corners[0].x, corners[1].x, corners[2].x}))));
+                int minY = std::max(0, int(std::floor(std::min({corners[0].y, corners[1].y, corners[2].y}))));
+                int maxY = std::min(size - 1, int(std::ceil(std::max({corners[0].y, corners[1].y, corners[2].y}))));
+                for (int y = minY; y <= maxY; y++)
+                {
+                    for (int x = minX; x <= maxX; x++)
+                    {
+                        double px = x + 0.5;
+                        double py = y + 0.5;
+                        double w0 = edgeFunction(corners[1], corners[2], px, py);
+                        double w1 = edgeFunction(corners[2], corners[0], px, py);
+                        double w2 = edgeFunction(corners[0], corners[1], px, py);
+                        if (w0 < 0.0 || w1 < 0.0 || w2 < 0.0)
+                            continue;
+                        double z = (w0 * corners[0].z + w1 * corners[1].z + w2 * corners[2].z) / area;
+                        double& stored = depth[std::size_t(y) * size + x];
+                        if (z < stored)
+                        {
+                            stored = z;
+                            shaded++;
+                        }
+                    }
+                }
+            }
+            for (double stored : depth)
+            {
+                if (stored != std::numeric_limits<double>::infinity())
+                    covered++;
+            }
+        }
+    }
+    return covered == 0 ? 0.0 : double(shaded) / double(covered);
+}
+
+void optimizeVertexCacheForsyth(std::vector<unsigned int>& indices, std::size_t vertexCount)
+{
+    if (indices.empty() || !validTriangles(indices, vertexCount))
+        return;
+    const std::size_t triangleCount = indices.size() / 3;
+    TriangleAdjacency adjacency = buildAdjacency(indices, vertexCount);
+
+    // The last triangle's 3 vertices score the same whatever order they came in,
+    // older entries less the closer they are to falling out
+    float cacheScores[FORSYTH_CACHE_SIZE];
+    for (int i = 0; i < FORSYTH_CACHE_SIZE; i++)
+    {
+        cacheScores[i] = i < 3 ? 0.75f : std::pow(1.0f - float(i - 3) / float(FORSYTH_CACHE_SIZE - 3), 1.5f);
+    }
+    // Vertices with few triangles left score higher, so they're finished off instead of left as stragglers
+    float valenceScores[FORSYTH_MAX_VALENCE];
+    for (int i = 1; i < FORSYTH_MAX_VALENCE; i++)
+    {
+        valenceScores[i] = 2.0f / std::sqrt(float(i));
+    }
+    auto vertexScore = [&](int cachePosition, uint32_t live)
+    {
+        if (live == 0)
+            return -1.0f;
+        float score = cachePosition >= 0 ? cacheScores[cachePosition] : 0.0f;
+        return score + (live < uint32_t(FORSYTH_MAX_VALENCE) ? valenceScores[live] : 2.0f / std::sqrt(float(live)));
+    };
+
+    std::vector<uint32_t> live(vertexCount);
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; v++)
+    {
+        live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+        vertexScores[v] = vertexScore(-1, live[v]);
+    }
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    int64_t best = 0;
+    for (std::size_t t = 0; t < triangleCount; t++)
+    {
+        triangleScores[t] = vertexScores[indices[3 * t]] + vertexScores[indices[3 * t + 1]] + vertexScores[indices[3 * t + 2]];
+        if (triangleScores[t] > triangleScores[best])
+            best = int64_t(t);
+    }
+
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+    std::vector<uint32_t> order;
+    order.reserve(triangleCount);
+    std::size_t deadEndCursor = 0;
+    while (order.size() < triangleCount)
+    {
+        // No triangle touches the cache, carry on with the next one in the old order
+        if (best < 0)
+        {
+            while (emitted[deadEndCursor])
+                deadEndCursor++;
+            best = int64_t(deadEndCursor);
+        }
+        uint32_t triangle = uint32_t(best);
+        emitted[triangle] = true;
+        order.push_back(triangle);
+
+        nextCache.clear();
+        for (int c = 0; c < 3; c++)
+        {
+            unsigned int v = indices[3 * triangle + c];
+            live[v]--;
+            if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+                nextCache.push_back(v);
+        }
+        const std::size_t newest = nextCache.size();
+        for (unsigned int v : cache)
+        {
+            if (std::find(nextCache.begin(), nextCache.begin() + newest, v) == nextCache.begin() + newest)
+                nextCache.push_back(v);
+        }
+
+        // Rescore everything that moved in the cache or fell out of it, and the triangles around them
+        for (std::size_t i = 0; i < nextCache.size(); i++)
+        {
+            unsigned int v = nextCache[i];
+            cachePositions[v] = i < std::size_t(FORSYTH_CACHE_SIZE) ? int(i) : -1;
+            vertexScores[v] = vertexScore(cachePositions[v], live[v]);
+        }
+        best = -1;
+        float bestScore = -std::numeric_limits<float>::max();
+        for (unsigned int v : nextCache)
+        {
+            for (uint32_t k = adjacency.offsets[v]; k < adjacency.offsets[v + 1]; k++)
+            {
+                uint32_t t = adjacency.triangles[k];
+                if (emitted[t])
+                    continue;
+                float score = vertexScores[indices[3 * t]] + vertexScores[indices[3 * t + 1]] + vertexScores[indices[3 * t + 2]];
+                triangleScores[t] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = int64_t(t);
+                }
+            }
+        }
+        if (nextCache.size() > std::size_t(FORSYTH_CACHE_SIZE))
+            nextCache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(nextCache);
+    }
+    applyTriangleOrder(indices, order);
+}
+
+void optimizeVertexCacheTipsify(std::vector<unsigned int>& indices, std::size_t vertexCount, uint32_t cacheSize)
+{
+    if (indices.empty() || !validTriangles(indices, vertexCount))
+        return;
+    const std::size_t triangleCount = indices.size() / 3;
+    TriangleAdjacency adjacency = buildAdjacency(indices, vertexCount);
+    std::vector<uint32_t> live(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; v++)
+    {
+        live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    // Recently emitted vertices, where a walk that ran dry looks for live triangles first
+    std::vector<unsigned int> deadEnds;
+    std::vector<unsigned int> candidates;
+    std::vector<uint32_t> order;
+    order.reserve(triangleCount);
+    uint32_t time = cacheSize + 1;
+    std::size_t deadEndCursor = 0;
+
+    auto skipDeadEnd = [&]() -> int64_t
+    {
+        while (!deadEnds.empty())
+        {
+            unsigned int v = deadEnds.back();
+            deadEnds.pop_back();
+            if (live[v] > 0)
+                return v;
+        }
+        while (deadEndCursor < vertexCount)
+        {
+            if (live[deadEndCursor] > 0)
+                return int64_t(deadEndCursor);
+            deadEndCursor++;
+        }
+        return -1;
+    };
+
+    int64_t fan = skipDeadEnd();
+    while (fan >= 0)
+    {
+        // Emits every remaining triangle around the fan vertex
+        candidates.clear();
+        for (uint32_t k = adjacency.offsets[fan]; k < adjacency.offsets[fan + 1]; k++)
+        {
+            uint32_t t = adjacency.triangles[k];
+            if (emitted[t])
+                continue;
+            for (int c = 0; c < 3; c++)
+            {
+                unsigned int v = indices[3 * t + c];
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - timestamps[v] > cacheSize)
+                    timestamps[v] = time++;
+            }
+            emitted[t] = true;
+            order.push_back(t);
+        }
+
+        // The next fan is the oldest candidate that will still be in the
+        // cache once its own triangles are emitted, 2 new vertices a triangle at most
+        fan = -1;
+        int64_t bestPriority = -1;
+        for (unsigned int v : candidates)
+        {
+            if (live[v] == 0)
+                continue;
+            int64_t age = int64_t(time - timestamps[v]);
+            int64_t priority = age + 2 * int64_t(live[v]) <= int64_t(cacheSize) ? age : 0;
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                fan = v;
+            }
+        }
+        if (fan < 0)
+            fan = skipDeadEnd();
+    }
+    applyTriangleOrder(indices, order);
+}
+
+std::size_t optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions,
+                             uint32_t cacheSize, float threshold)
+{
+    if (indices.empty() || !validTriangles(indices, positions.size()))
+        return 0;
+    const std::size_t triangleCount = indices.size() / 3;
+    const double meshAcmr = analyzeVertexCache(indices, positions.size(), cacheSize).acmr;
+
+    std::vector<uint32_t> timestamps(positions.size(), 0);
+    uint32_t time = cacheSize + 1;
+    auto misses = [&](std::size_t triangle)
+    {
+        int count = 0;
+        for (int c = 0; c < 3; c++)
+        {
+            unsigned int v = indices[3 * triangle + c];
+            if (time - timestamps[v] > cacheSize)
+            {
+                timestamps[v] = time++;
+                count++;
+            }
+        }
+        return count;
+    };
+
+    // Hard boundaries, where the cache order started over with nothing cached
+    std::vector<std::size_t> hardStarts;
+    for (std::size_t t = 0; t < triangleCount; t++)
+    {
+        if (misses(t) == 3 || t == 0)
+            hardStarts.push_back(t);
+    }
+    hardStarts.push_back(triangleCount);
+
+    // Soft boundaries inside them, as soon as a cluster has paid back its cold start
+    std::vector<std::size_t> clusterStarts;
+    for (std::size_t h = 0; h + 1 < hardStarts.size(); h++)
+    {
+        std::size_t begin = hardStarts[h];
+        std::size_t end = hardStarts[h + 1];
+        clusterStarts.push_back(begin);
+        time += cacheSize + 1;
+        std::size_t clusterMisses = 0;
+        std::size_t clusterTriangles = 0;
+        for (std::size_t t = begin; t < end; t++)
+        {
+            clusterMisses += misses(t);
+            clusterTriangles++;
+            if (t + 1 < end && double(clusterMisses) <= threshold * meshAcmr * double(clusterTriangles))
+            {
+                clusterStarts.push_back(t + 1);
+                time += cacheSize + 1;
+                clusterMisses = 0;
+                clusterTriangles = 0;
+            }
+        }
+    }
+    clusterStarts.push_back(triangleCount);
+    const std::size_t clusterCount = clusterStarts.size() - 1;
+
+    // Clusters facing outwards and far out go first, they are the likeliest to be in front of the rest
+    glm::dvec3 meshCentroid(0.0);
+    double meshArea = 0.0;
+    std::vector<glm::dvec3> centroids(clusterCount);
+    std::vector<glm::dvec3> normals(clusterCount);
+    for (std::size_t cluster = 0; cluster < clusterCount; cluster++)
+    {
+        glm::dvec3 weightedCentroid(0.0);
+        glm::dvec3 plainCentroid(0.0);
+        glm::dvec3 normal(0.0);
+        double area = 0.0;
+        for (std::size_t t = clusterStarts[cluster]; t < clusterStarts[cluster + 1]; t++)
+        {
+            glm::dvec3 a(positions[indices[3 * t]]);
+            glm::dvec3 b(positions[indices[3 * t + 1]]);
+            glm::dvec3 c(positions[indices[3 * t + 2]]);
+            glm::dvec3 cross = glm::cross(b - a, c - a);
+            double triangleArea = glm::length(cross);
+            glm::dvec3 centroid = (a + b + c) / 3.0;
+            weightedCentroid += centroid * triangleArea;
+            plainCentroid += centroid;
+            normal += cross;
+            area += triangleArea;
+        }
+        std::size_t triangles = clusterStarts[cluster + 1] - clusterStarts[cluster];
+        centroids[cluster] = area > 0.0 ? weightedCentroid / area : plainCentroid / double(triangles);
+        double normalLength = glm::length(normal);
+        normals[cluster] = normalLength > 0.0 ? normal / normalLength : glm::dvec3(0.0);
+        meshCentroid += weightedCentroid;
+        meshArea += area;
+    }
+    if (meshArea > 0.0)
+        meshCentroid /= meshArea;
+
+    std::vector<double> keys(clusterCount);
+    std::vector<std::size_t> clusterOrder(clusterCount);
+    for (std::size_t cluster = 0; cluster < clusterCount; cluster++)
+    {
+        keys[cluster] = glm::dot(centroids[cluster] - meshCentroid, normals[cluster]);
+        clusterOrder[cluster] = cluster;
+    }
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+                     [&](std::size_t a, std::size_t b) { return keys[a] > keys[b]; });
+
+    std::vector<uint32_t> order;
+    order.reserve(triangleCount);
+    for (std::size_t cluster : clusterOrder)
+    {
+        for (std::size_t t = clusterStarts[cluster]; t < clusterStarts[cluster + 1]; t++)
+        {
+            order.push_back(uint32_t(t));
+        }
+    }
+    applyTriangleOrder(indices, order);
+    return clusterCount;
+}
+
+std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int>& indices, std::size_t vertexCount)
+{
+    if (!validTriangles(indices, vertexCount))
+        return std::vector<unsigned int>();
+    std::vector<unsigned int> remap(vertexCount, UNUSED_VERTEX);
+    unsigned int next = 0;
+    for (unsigned int& index : indices)
+    {
+        if (remap[index] == UNUSED_VERTEX)
+            remap[index] = next++;
+        index = remap[index];
+    }
+    return remap;
+}
+
+static uint64_t hashCell(int64_t x, int64_t y, int64_t z)
+{
+    uint64_t h = uint64_t(x) * 0x9E3779B97F4A7C15ull;
+    h ^= uint64_t(y) * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+    h ^= uint64_t(z) * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+template <typename T>
+static bool withinEpsilon(const T& a, const T& b, float epsilon)
+{
+    for (int i = 0; i < T::length(); i++)
+    {
+        if (std::abs(a[i] - b[i]) > epsilon)
+            return false;
+    }
+    return true;
+}
+
+std::size_t weldVertices(Mesh& mesh, const WeldSettings& settings)
+{
+    const std::size_t vertexCount = mesh.vertices.size();
+    if (!validTriangles(mesh.indices, vertexCount))
+        return 0;
+    const bool compareNormals = settings.normalEpsilon >= 0.0f && mesh.normals.size() == vertexCount;
+    const bool compareTexCoords = settings.texCoordEpsilon >= 0.0f && mesh.texCoords.size() == vertexCount;
+    const float epsilon = std::max(settings.positionEpsilon, 0.0f);
+
+    // Cell of a position: epsilon sized when there is one, else the exact bits, so only equal positions share it
+    auto cellOf = [&](glm::vec3 p)
+    {
+        glm::i64vec3 cell;
+        for (int i = 0; i < 3; i++)
+        {
+            if (epsilon > 0.0f)
+            {
+                cell[i] = int64_t(std::floor(double(p[i]) / epsilon));
+            }
+            else
+            {
+                float component = p[i] == 0.0f ? 0.0f : p[i];
+                uint32_t bits;
+                std::memcpy(&bits, &component, sizeof(bits));
+                cell[i] = bits;
+            }
+        }
+        return cell;
+    };
+    const int reach = epsilon > 0.0f ? 1 : 0;
+
+    // Welded vertices per cell hash, as chains through nextInCell
+    std::unordered_map<uint64_t, unsigned int> cellHeads;
+    cellHeads.reserve(vertexCount);
+    std::vector<unsigned int> nextInCell;
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texCoords;
+    for (std::size_t i = 0; i < vertexCount; i++)
+    {
+        glm::vec3 p = mesh.vertices[i];
+        glm::i64vec3 cell = cellOf(p);
+        unsigned int match = UNUSED_VERTEX;
+        for (int dx = -reach; dx <= reach && match == UNUSED_VERTEX; dx++)
+        {
+            for (int dy = -reach; dy <= reach && match == UNUSED_VERTEX; dy++)
+            {
+                for (int dz = -reach; dz <= reach && match == UNUSED_VERTEX; dz++)
+                {
+                    auto head = cellHeads.find(hashCell(cell.x + dx, cell.y + dy, cell.z + dz));
+                    if (head == cellHeads.end())
+                        continue;
+                    for (unsigned int w = head->second; w != UNUSED_VERTEX; w = nextInCell[w])
+                    {
+                        if (!withinEpsilon(p, vertices[w], epsilon))
+                            continue;
+                        if (compareNormals && !withinEpsilon(mesh.normals[i], normals[w], settings.normalEpsilon))
+                            continue;
+                        if (compareTexCoords && !withinEpsilon(mesh.texCoords[i], texCoords[w], settings.texCoordEpsilon))
+                            continue;
+                        match = w;
+                        break;
+                    }
+                }
+            }
+        }
+        if (match == UNUSED_VERTEX)
+        {
+            match = (unsigned int) vertices.size();
+            vertices.push_back(p);
+            if (mesh.normals.size() == vertexCount)
+                normals.push_back(mesh.normals[i]);
+            if (mesh.texCoords.size() == vertexCount)
+                texCoords.push_back(mesh.texCoords[i]);
+            auto inserted = cellHeads.emplace(hashCell(cell.x, cell.y, cell.z), match);
+            nextInCell.push_back(inserted.second ? UNUSED_VERTEX : inserted.first->second);
+            inserted.first->second = match;
+        }
+        remap[i] = match;
+    }
+
+    std::vector<unsigned int> indices;
+    indices.reserve(mesh.indices.size());
+    for (std::size_t t = 0; t < mesh.indices.size(); t += 3)
+    {
+        unsigned int a = remap[mesh.indices[t]];
+        unsigned int b = remap[mesh.indices[t + 1]];
+        unsigned int c = remap[mesh.indices[t + 2]];
+        if (a == b || b == c || c == a)
+            continue;
+        indices.push_back(a);
+        indices.push_back(b);
+        indices.push_back(c);
+    }
+    std::size_t removed = vertexCount - vertices.size();
+    mesh.vertices.swap(vertices);
+    if (mesh.normals.size() == vertexCount)
+        mesh.normals.swap(normals);
+    if (mesh.texCoords.size() == vertexCount)
+        mesh.texCoords.swap(texCoords);
+    mesh.indices.swap(indices);
+    return removed;
+}
+
+void optimizeMesh(Mesh& mesh, const MeshOptimizeSettings& settings, MeshOptimizeStats* stats)
+{
+    if (stats != nullptr)
+    {
+        *stats = MeshOptimizeStats();
+        stats->triangles = mesh.indices.size() / 3;
+        stats->verticesBefore = mesh.vertices.size();
+        stats->cacheBefore = analyzeVertexCache(mesh.indices, mesh.vertices.size(), settings.cacheSize);
+        stats->overdrawBefore = analyzeOverdraw(mesh.indices, mesh.vertices);
+    }
+
+    OptimizeClock::time_point start = OptimizeClock::now();
+    std::size_t clusters = 0;
+    if (!mesh.indices.empty() && validTriangles(mesh.indices, mesh.vertices.size()))
+    {
+        if (settings.cacheOrder == VertexCacheOrder::Forsyth)
+            optimizeVertexCacheForsyth(mesh.indices, mesh.vertices.size());
+        else if (settings.cacheOrder == VertexCacheOrder::Tipsify)
+            optimizeVertexCacheTipsify(mesh.indices, mesh.vertices.size(), settings.cacheSize);
+        if (settings.optimizeOverdraw)
+            clusters = optimizeOverdraw(mesh.indices, mesh.vertices, settings.cacheSize, settings.overdrawThreshold);
+        if (settings.optimizeVertexFetch)
+        {
+            std::vector<unsigned int> remap = optimizeVertexFetch(mesh.indices, mesh.vertices.size());
+            std::size_t usedVertices = remap.size() - std::count(remap.begin(), remap.end(), UNUSED_VERTEX);
+            remapVertexAttribute(mesh.vertices, remap, usedVertices);
+            remapVertexAttribute(mesh.normals, remap, usedVertices);
+            remapVertexAttribute(mesh.texCoords, remap, usedVertices);
+        }
+    }
+
+    if (stats != nullptr)
+    {
+        stats->seconds = std::chrono::duration<double>(OptimizeClock::now() - start).count();
+        stats->clusters = clusters;
+        stats->verticesAfter = mesh.vertices.size();
+        stats->cacheAfter = analyzeVertexCache(mesh.indices, mesh.vertices.size(), settings.cacheSize);
+        stats->overdrawAfter = analyzeOverdraw(mesh.indices, mesh.vertices);
+    }
+}
@@ -3,6 +3,7 @@
 // Author: Kyle Bueche
 
 #include "model.h"
+#include "meshOptimizer.h"
 #include <string>
 
 void Model::Draw(Shader &shader)
@@ -80,6 +81,10 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene)
         //loadMaterialTextures(newMesh., material, aiTextureType_DIFFUSE, "texture_diffuse");
         //loadMaterialTextures(newMesh.textures, material, aiTextureType_SPECULAR, "texture_specular");
     }
+    // Files come unwelded and in whatever order their exporter left, merge
+    // duplicates then reorder for the vertex cache, overdraw and fetch
+    weldVertices(newMesh);
+    optimizeMesh(newMesh);
     return newMesh;
 }
 
@@ -93,6 +98,6 @@ void Model::loadMaterialTextures(std::vector<Texture> &textures, aiMaterial *mat
         //texture.id = loadTexture(str.C_Str(), directory);
         //texture.type = typeName;
         //texture.path = str.C_Str();
-        textures.push_back(texture);
+        textures.push_back(std::move(texture));
     }
 }
\ No newline at end of file
@@ -0,0 +1,296 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "particleInCell.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#include "electrons.h"
+
+// Particles per deposit/gather task, each touches up to 27 cells
+static const std::size_t PIC_PARTICLES_PER_TASK = 2048;
+// Grid planes per task for the cell loops
+static const std::size_t PIC_PLANES_PER_TASK = 1;
+
+const char* chargeAssignmentName(ChargeAssignment assignment)
+{
+    switch (assignment)
+    {
+    case ChargeAssignment::CloudInCell:
+        return "cic";
+    case ChargeAssignment::TriangularShapedCloud:
+        return "tsc";
+    }
+    return "unknown";
+}
+
+ParticleInCellSolver::ParticleInCellSolver()
+    : gridSize(64),
+      assignment(ChargeAssignment::TriangularShapedCloud),
+      jobs(nullptr),
+      greenGridSize(0),
+      origin(0.0f),
+      cellSize(1.0f)
+{}
+
+ParticleInCellSolver::ParticleInCellSolver(uint32_t gridSize, ChargeAssignment assignment, JobSystem* jobs)
+    : gridSize(gridSize),
+      assignment(assignment),
+      jobs(jobs),
+      greenGridSize(0),
+      origin(0.0f),
+      cellSize(1.0f)
+{}
+
+const char* ParticleInCellSolver::name() const
+{
+    return "pic";
+}
+
+void ParticleInCellSolver::computeAccelerations(ParticleSystem& particles)
+{
+    if (particles.size() == 0)
+    {
+        return;
+    }
+    gridSize = std::max<uint32_t>(std::bit_ceil(gridSize), 8);
+    if (greenGridSize != gridSize)
+    {
+        buildGreenFunction();
+    }
+    fitGrid(particles);
+    depositCharge(particles);
+    solvePotential();
+    computeField();
+    gatherAccelerations(particles);
+}
+
+// The bounding cube spans gridSize - 4 cells, which keeps every particle's
+// cells inside the grid and a cell of potential past them on each side for the
+// central differences. Non-finite positions are left out.
+void ParticleInCellSolver::fitGrid(const ParticleSystem& particles)
+{
+    glm::vec3 low(0.0f);
+    glm::vec3 high(0.0f);
+    bool first = true;
+    for (std::size_t i = 0; i < particles.size(); i++)
+    {
+        glm::vec3 position = particles.position(i);
+        if (!isFinitePosition(position))
+            continue;
+        low = first ? position : glm::min(low, position);
+        high = first ? position : glm::max(high, position);
+        first = false;
+    }
+    glm::vec3 extent = high - low;
+    float side = std::max(std::max(extent.x, extent.y), extent.z);
+    // A single particle (or all of them at one point) still needs a finite cell,
+    // and positions near the float limit an extent that doesn't overflow
+    side = std::clamp(side, 1.0e-3f, 0.25f * std::numeric_limits<float>::max());
+    cellSize = side / float(gridSize - 4);
+    origin = (0.5f * low + 0.5f * high) - glm::vec3(0.5f * float(gridSize - 1) * cellSize);
+}
+
+// G(n) = 1 / |n| on the doubled grid, distances wrapped so the kernel covers
+// -gridSize..gridSize per axis. G(0) only ever enters the potential of a
+// particle's own cells, the antisymmetric difference and the matching
+// gather cancel it, so any finite value does.
+void ParticleInCellSolver::buildGreenFunction()
+{
+    const std::size_t m = 2 * std::size_t(gridSize);
+    fft.init(m, m, m);
+    padded.assign(fft.realSize(), 0.0);
+    spectrum.resize(fft.spectrumSize());
+    parallelFor(jobs, 0, m, PIC_PLANES_PER_TASK,
+        [this, m](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t x = begin; x < end; x++)
+            {
+                double dx = double(std::min(x, m - x));
+                for (std::size_t y = 0; y < m; y++)
+                {
+                    double dy = double(std::min(y, m - y));
+                    for (std::size_t z = 0; z < m; z++)
+                    {
+                        double dz = double(std::min(z, m - z));
+                        double r = std::sqrt(dx * dx + dy * dy + dz * dz);
+                        padded[(x * m + y) * m + z] = r > 0.0 ? 1.0 / r : 1.0;
+                    }
+                }
+            }
+        });
+    fft.forward(padded.data(), spectrum.data(), jobs);
+    greenSpectrum.resize(spectrum.size());
+    for (std::size_t k = 0; k < spectrum.size(); k++)
+    {
+        greenSpectrum[k] = spectrum[k].real();
+    }
+    greenGridSize = gridSize;
+
+    std::size_t cells = std::size_t(gridSize) * gridSize * gridSize;
+    fieldX.resize(cells);
+    fieldY.resize(cells);
+    fieldZ.resize(cells);
+}
+
+void ParticleInCellSolver::depositCharge(const ParticleSystem& particles)
+{
+    const std::size_t n = gridSize;
+    const std::size_t cells = n * n * n;
+    // Deterministic: one grid per fixed range of particles instead of per thread
+    std::size_t partials = deterministic ? DETERMINISTIC_SPLIT_COUNT : (jobs != nullptr ? jobs->threadCount() : 1);
+    std::size_t particlesPerTask = deterministic
+        ? std::max<std::size_t>((particles.size() + partials - 1) / partials, 1)
+        : PIC_PARTICLES_PER_TASK;
+    partialCharges.resize(partials);
+    for (std::vector<double>& charges : partialCharges)
+    {
+        charges.assign(cells, 0.0);
+    }
+
+    const float inverseCell = 1.0f / cellSize;
+    // Every fitted particle is in [1.5, n - 2.5], the clamp only catches rounding far from the grid
+    const float highest = float(n) - 2.5f;
+    parallelFor(jobs, 0, particles.size(), particlesPerTask,
+        [this, &particles, n, inverseCell, highest, particlesPerTask](std::size_t begin, std::size_t end, unsigned int thread)
+        {
+            double* charges = partialCharges[deterministic ? begin / particlesPerTask : thread].data();
+            float wx[3], wy[3], wz[3];
+            for (std::size_t i = begin; i < end; i++)
+            {
+                float q = particles.charge[i];
+                if (q == 0.0f || !isFinitePosition(particles.position(i)))
+                    continue;
+                glm::vec3 u = (particles.position(i) - origin) * inverseCell;
+                int x0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.x, 1.0f, highest), wx);
+                int y0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.y, 1.0f, highest), wy);
+                int z0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.z, 1.0f, highest), wz);
+                for (int a = 0; a < 3; a++)
+                {
+                    for (int b = 0; b < 3; b++)
+                    {
+                        double* row = charges + ((std::size_t(x0 + a) * n + std::size_t(y0 + b)) * n + std::size_t(z0));
+                        float w = q * wx[a] * wy[b];
+                        for (int c = 0; c < 3; c++)
+                        {
+                            row[c] += w * wz[c];
+                        }
+                    }
+                }
+            }
+        });
+
+    // Sum the partial grids into the corner of the zeroed doubled grid
+    const std::size_t m = 2 * n;
+    std::fill(padded.begin(), padded.end(), 0.0);
+    parallelFor(jobs, 0, n, PIC_PLANES_PER_TASK,
+        [this, n, m](std::size_t begin, std::size_t end, unsigned int)
+        {
+            pairwiseReduce(partialCharges, begin * n * n, end * n * n);
+            const double* charges = partialCharges[0].data();
+            for (std::size_t x = begin; x < end; x++)
+            {
+                for (std::size_t y = 0; y < n; y++)
+                {
+                    std::copy(charges + (x * n + y) * n, charges + (x * n + y + 1) * n, padded.begin() + (x * m + y) * m);
+                }
+            }
+        });
+}
+
+// phi = G * rho as a product of spectra. The unit-cell kernel is scaled by
+// 1 / cellSize, and the inverse FFT's m^3 is divided out in the same multiply.
+void ParticleInCellSolver::solvePotential()
+{
+    fft.forward(padded.data(), spectrum.data(), jobs);
+    const std::size_t m = fft.sizeX();
+    const double scale = 1.0 / (double(m) * double(m) * double(m) * double(cellSize));
+    parallelFor(jobs, 0, spectrum.size(), 1 << 16,
+        [this, scale](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t k = begin; k < end; k++)
+            {
+                spectrum[k] *= greenSpectrum[k] * scale;
+            }
+        });
+    fft.inverse(spectrum.data(), padded.data(), jobs);
+}
+
+// E = -grad phi by central differences. Index -1 wraps to m - 1, which on the
+// doubled grid is still a correct open-boundary potential.
+void ParticleInCellSolver::computeField()
+{
+    const std::size_t n = gridSize;
+    const std::size_t m = 2 * n;
+    const double inverseTwoCells = 1.0 / (2.0 * double(cellSize));
+    parallelFor(jobs, 0, n, PIC_PLANES_PER_TASK,
+        [this, n, m, inverseTwoCells](std::size_t begin, std::size_t end, unsigned int)
+        {
+            auto phi = [this, m](std::size_t x, std::size_t y, std::size_t z)
+            {
+                return padded[(((x + m) % m) * m + (y + m) % m) * m + (z + m) % m];
+            };
+            for (std::size_t x = begin; x < end; x++)
+            {
+                for (std::size_t y = 0; y < n; y++)
+                {
+                    for (std::size_t z = 0; z < n; z++)
+                    {
+                        std::size_t cell = (x * n + y) * n + z;
+                        fieldX[cell] = float((phi(x - 1, y, z) - phi(x + 1, y, z)) * inverseTwoCells);
+                        fieldY[cell] = float((phi(x, y - 1, z) - phi(x, y + 1, z)) * inverseTwoCells);
+                        fieldZ[cell] = float((phi(x, y, z - 1) - phi(x, y, z + 1)) * inverseTwoCells);
+                    }
+                }
+            }
+        });
+}
+
+void ParticleInCellSolver::gatherAccelerations(ParticleSystem& particles)
+{
+    const std::size_t n = gridSize;
+    const float inverseCell = 1.0f / cellSize;
+    const float highest = float(n) - 2.5f;
+    parallelFor(jobs, 0, particles.size(), PIC_PARTICLES_PER_TASK,
+        [this, &particles, n, inverseCell, highest](std::size_t begin, std::size_t end, unsigned int)
+        {
+            float wx[3], wy[3], wz[3];
+            for (std::size_t i = begin; i < end; i++)
+            {
+                if (!isFinitePosition(particles.position(i)))
+                {
+                    particles.accX[i] = 0.0f;
+                    particles.accY[i] = 0.0f;
+                    particles.accZ[i] = 0.0f;
+                    continue;
+                }
+                glm::vec3 u = (particles.position(i) - origin) * inverseCell;
+                int x0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.x, 1.0f, highest), wx);
+                int y0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.y, 1.0f, highest), wy);
+                int z0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.z, 1.0f, highest), wz);
+                glm::vec3 field(0.0f);
+                for (int a = 0; a < 3; a++)
+                {
+                    for (int b = 0; b < 3; b++)
+                    {
+                        std::size_t row = (std::size_t(x0 + a) * n + std::size_t(y0 + b)) * n + std::size_t(z0);
+                        float w = wx[a] * wy[b];
+                        for (int c = 0; c < 3; c++)
+                        {
+                            field += (w * wz[c]) * glm::vec3(fieldX[row + c], fieldY[row + c], fieldZ[row + c]);
+                        }
+                    }
+                }
+                float coef = coulomb_coupling * particles.charge[i] / particles.mass[i];
+                particles.accX[i] = coef * field.x;
+                particles.accY[i] = coef * field.y;
+                particles.accZ[i] = coef * field.z;
+            }
+        });
+}
@@ -0,0 +1,412 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "particleMeshEwald.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iostream>
+#include <numbers>
+
+#include "electrons.h"
+
+// Particles per deposit/gather/real-space task
+static const std::size_t PME_PARTICLES_PER_TASK = 1024;
+static const std::size_t PME_PLANES_PER_TASK = 1;
+// alpha * cutoff, erfc(3.12) is about 1e-5
+static const float PME_SPLITTING_TIMES_CUTOFF = 3.12f;
+
+ParticleMeshEwaldSolver::ParticleMeshEwaldSolver()
+    : gridSize(32),
+      assignment(ChargeAssignment::TriangularShapedCloud),
+      cutoffCells(6.0f),
+      jobs(nullptr),
+      influenceGridSize(0),
+      influenceAssignment(ChargeAssignment::TriangularShapedCloud),
+      influenceSide(0.0f),
+      influenceAlpha(0.0f),
+      cutoff(0.0f),
+      alpha(0.0f)
+{}
+
+ParticleMeshEwaldSolver::ParticleMeshEwaldSolver(uint32_t gridSize, ChargeAssignment assignment, float cutoffCells, JobSystem* jobs)
+    : gridSize(gridSize),
+      assignment(assignment),
+      cutoffCells(cutoffCells),
+      jobs(jobs),
+      influenceGridSize(0),
+      influenceAssignment(assignment),
+      influenceSide(0.0f),
+      influenceAlpha(0.0f),
+      cutoff(0.0f),
+      alpha(0.0f)
+{}
+
+const char* ParticleMeshEwaldSolver::name() const
+{
+    return "pme";
+}
+
+void ParticleMeshEwaldSolver::computeAccelerations(ParticleSystem& particles)
+{
+    if (particles.size() == 0)
+    {
+        return;
+    }
+    if (!particles.box.isPeriodic())
+    {
+        static bool reported = false;
+        if (!reported)
+        {
+            std::cout << "ERROR: PME needs a periodic box, accelerations set to zero" << std::endl;
+            reported = true;
+        }
+        std::fill(particles.accX.begin(), particles.accX.begin() + particles.size(), 0.0f);
+        std::fill(particles.accY.begin(), particles.accY.begin() + particles.size(), 0.0f);
+        std::fill(particles.accZ.begin(), particles.accZ.begin() + particles.size(), 0.0f);
+        return;
+    }
+
+    const float side = particles.box.side;
+    gridSize = std::max<uint32_t>(std::bit_ceil(gridSize), 8);
+    cutoff = std::min(cutoffCells * side / float(gridSize), 0.5f * side);
+    alpha = PME_SPLITTING_TIMES_CUTOFF / cutoff;
+    if (influenceGridSize != gridSize || influenceAssignment != assignment ||
+        influenceSide != side || influenceAlpha != alpha)
+    {
+        buildInfluenceFunction(side);
+    }
+    depositCharge(particles, side);
+    solveField();
+    gatherAccelerations(particles, side);
+    addRealSpace(particles, side);
+}
+
+// sinc^p(k h / 2) per axis is the transform of the assignment window, p = 2
+// for CIC and 3 for TSC. Dividing it out once for the deposit and once for
+// the gather leaves the aliasing error, which falls off quickly with p.
+void ParticleMeshEwaldSolver::buildInfluenceFunction(float side)
+{
+    const std::size_t n = gridSize;
+    fft.init(n, n, n);
+    const std::size_t sz = fft.spectrumZ();
+    const double pi = std::numbers::pi;
+    const double h = double(side) / double(n);
+    const double volume = double(side) * double(side) * double(side);
+    const double power = assignment == ChargeAssignment::CloudInCell ? 2.0 : 3.0;
+
+    wavenumbers.resize(n);
+    std::vector<double> window(n);
+    for (std::size_t m = 0; m < n; m++)
+    {
+        double frequency = m <= n / 2 ? double(m) : double(m) - double(n);
+        double k = 2.0 * pi * frequency / double(side);
+        double x = 0.5 * k * h;
+        window[m] = x != 0.0 ? std::pow(std::sin(x) / x, power) : 1.0;
+        wavenumbers[m] = m == n / 2 ? 0.0 : k;
+    }
+
+    influence.resize(fft.spectrumSize());
+    const double inverseFourAlpha2 = 1.0 / (4.0 * double(alpha) * double(alpha));
+    parallelFor(jobs, 0, n, PME_PLANES_PER_TASK,
+        [this, n, sz, pi, side, volume, inverseFourAlpha2, &window](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t x = begin; x < end; x++)
+            {
+                for (std::size_t y = 0; y < n; y++)
+                {
+                    for (std::size_t z = 0; z < sz; z++)
+                    {
+                        // The true wavenumbers, the Nyquist zeroing only applies to the derivative
+                        double fx = x <= n / 2 ? double(x) : double(x) - double(n);
+                        double fy = y <= n / 2 ? double(y) : double(y) - double(n);
+                        double fz = double(z);
+                        double k2 = 4.0 * pi * pi * (fx * fx + fy * fy + fz * fz) / (double(side) * double(side));
+                        double w = window[x] * window[y] * window[z];
+                        std::size_t index = (x * n + y) * sz + z;
+                        influence[index] = k2 > 0.0
+                            ? 4.0 * pi * std::exp(-k2 * inverseFourAlpha2) / (k2 * volume * w * w)
+                            : 0.0;
+                    }
+                }
+            }
+        });
+
+    std::size_t cells = n * n * n;
+    charges.resize(cells);
+    scratch.resize(cells);
+    spectrum.resize(fft.spectrumSize());
+    fieldSpectrum.resize(fft.spectrumSize());
+    fieldX.resize(cells);
+    fieldY.resize(cells);
+    fieldZ.resize(cells);
+    influenceGridSize = gridSize;
+    influenceAssignment = assignment;
+    influenceSide = side;
+    influenceAlpha = alpha;
+}
+
+// Grid point j sits at -side / 2 + j * h, cell indices wrap around the box.
+// Wrapped positions are in [0, n] grid units. The clamp only matters for a
+// finite position so far out that wrapping it loses every digit, and
+// non-finite particles are skipped, wrap() turns them into NaN.
+void ParticleMeshEwaldSolver::depositCharge(const ParticleSystem& particles, float side)
+{
+    const std::size_t n = gridSize;
+    const std::size_t cells = n * n * n;
+    // Deterministic: one grid per fixed range of particles instead of per thread
+    std::size_t partials = deterministic ? DETERMINISTIC_SPLIT_COUNT : (jobs != nullptr ? jobs->threadCount() : 1);
+    std::size_t particlesPerTask = deterministic
+        ? std::max<std::size_t>((particles.size() + partials - 1) / partials, 1)
+        : PME_PARTICLES_PER_TASK;
+    partialCharges.resize(partials);
+    for (std::vector<double>& grid : partialCharges)
+    {
+        grid.assign(cells, 0.0);
+    }
+
+    const float inverseCell = float(n) / side;
+    const PeriodicBox box = particles.box;
+    parallelFor(jobs, 0, particles.size(), particlesPerTask,
+        [this, &particles, n, side, inverseCell, box, particlesPerTask](std::size_t begin, std::size_t end, unsigned int thread)
+        {
+            double* grid = partialCharges[deterministic ? begin / particlesPerTask : thread].data();
+            float wx[3], wy[3], wz[3];
+            for (std::size_t i = begin; i < end; i++)
+            {
+                float q = particles.charge[i];
+                if (q == 0.0f || !isFinitePosition(particles.position(i)))
+                    continue;
+                glm::vec3 u = (box.wrap(particles.position(i)) + 0.5f * side) * inverseCell;
+                int x0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.x, 0.0f, float(n)), wx);
+                int y0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.y, 0.0f, float(n)), wy);
+                int z0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.z, 0.0f, float(n)), wz);
+                for (int a = 0; a < 3; a++)
+                {
+                    std::size_t x = std::size_t(x0 + a + int(n)) % n;
+                    for (int b = 0; b < 3; b++)
+                    {
+                        std::size_t y = std::size_t(y0 + b + int(n)) % n;
+                        double* row = grid + (x * n + y) * n;
+                        float w = q * wx[a] * wy[b];
+                        for (int c = 0; c < 3; c++)
+                        {
+                            row[std::size_t(z0 + c + int(n)) % n] += w * wz[c];
+                        }
+                    }
+                }
+            }
+        });
+
+    parallelFor(jobs, 0, n, PME_PLANES_PER_TASK,
+        [this, n](std::size_t begin, std::size_t end, unsigned int)
+        {
+            pairwiseReduce(partialCharges, begin * n * n, end * n * n);
+        });
+    // The sum is in partialCharges[0], which is zeroed again before its next use
+    charges.swap(partialCharges[0]);
+}
+
+// E(k) = -i k influence(k) Q(k), each component back through its own inverse
+// FFT. The inverse is the plain sum over k the Ewald formula asks for, so
+// nothing is left to normalize.
+void ParticleMeshEwaldSolver::solveField()
+{
+    fft.forward(charges.data(), spectrum.data(), jobs);
+    const std::size_t n = gridSize;
+    const std::size_t sz = fft.spectrumZ();
+    std::vector<float>* fields[3] = { &fieldX, &fieldY, &fieldZ };
+    for (int axis = 0; axis < 3; axis++)
+    {
+        parallelFor(jobs, 0, n, PME_PLANES_PER_TASK,
+            [this, n, sz, axis](std::size_t begin, std::size_t end, unsigned int)
+            {
+                for (std::size_t x = begin; x < end; x++)
+                {
+                    for (std::size_t y = 0; y < n; y++)
+                    {
+                        for (std::size_t z = 0; z < sz; z++)
+                        {
+                            std::size_t index = (x * n + y) * sz + z;
+                            double k = axis == 0 ? wavenumbers[x] : axis == 1 ? wavenumbers[y] : wavenumbers[z];
+                            fieldSpectrum[index] = Complex(0.0, -k * influence[index]) * spectrum[index];
+                        }
+                    }
+                }
+            });
+        fft.inverse(fieldSpectrum.data(), scratch.data(), jobs);
+        std::vector<float>& field = *fields[axis];
+        parallelFor(jobs, 0, scratch.size(), 1 << 16,
+            [this, &field](std::size_t begin, std::size_t end, unsigned int)
+            {
+                for (std::size_t cell = begin; cell < end; cell++)
+                {
+                    field[cell] = float(scratch[cell]);
+                }
+            });
+    }
+}
+
+void ParticleMeshEwaldSolver::gatherAccelerations(ParticleSystem& particles, float side)
+{
+    const std::size_t n = gridSize;
+    const float inverseCell = float(n) / side;
+    const PeriodicBox box = particles.box;
+    parallelFor(jobs, 0, particles.size(), PME_PARTICLES_PER_TASK,
+        [this, &particles, n, side, inverseCell, box](std::size_t begin, std::size_t end, unsigned int)
+        {
+            float wx[3], wy[3], wz[3];
+            for (std::size_t i = begin; i < end; i++)
+            {
+                if (!isFinitePosition(particles.position(i)))
+                {
+                    particles.accX[i] = 0.0f;
+                    particles.accY[i] = 0.0f;
+                    particles.accZ[i] = 0.0f;
+                    continue;
+                }
+                glm::vec3 u = (box.wrap(particles.position(i)) + 0.5f * side) * inverseCell;
+                int x0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.x, 0.0f, float(n)), wx);
+                int y0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.y, 0.0f, float(n)), wy);
+                int z0 = chargeAssignmentWeights(assignment, clampGridCoordinate(u.z, 0.0f, float(n)), wz);
+                glm::vec3 field(0.0f);
+                for (int a = 0; a < 3; a++)
+                {
+                    std::size_t x = std::size_t(x0 + a + int(n)) % n;
+                    for (int b = 0; b < 3; b++)
+                    {
+                        std::size_t y = std::size_t(y0 + b + int(n)) % n;
+                        std::size_t row = (x * n + y) * n;
+                        float w = wx[a] * wy[b];
+                        for (int c = 0; c < 3; c++)
+                        {
+                            std::size_t cell = row + std::size_t(z0 + c + int(n)) % n;
+                            field += (w * wz[c]) * glm::vec3(fieldX[cell], fieldY[cell], fieldZ[cell]);
+                        }
+                    }
+                }
+                float coef = coulomb_coupling * particles.charge[i] / particles.mass[i];
+                particles.accX[i] = coef * field.x;
+                particles.accY[i] = coef * field.y;
+                particles.accZ[i] = coef * field.z;
+            }
+        });
+}
+
+// erfc(alpha r) / r pairs within the cutoff, nearest image only since the
+// cutoff is at most half the box. The mesh sums the unsoftened erf(alpha r) / r,
+// so the pair term here is the softened Coulomb force minus that part, and the
+// two halves add up to the same softened pair as the other solvers. The
+// softening's share is cut off with the rest, which only matters once the
+// softening length is a sizeable fraction of the cutoff. Cells of side >= cutoff, so the 27 around a
+// particle's own hold every partner; with fewer than 3 per side the 27 would
+// repeat cells and every pair is walked instead.
+void ParticleMeshEwaldSolver::addRealSpace(ParticleSystem& particles, float side)
+{
+    const uint32_t count = uint32_t(particles.size());
+    const int dims = std::max(int(side / cutoff), 1);
+    const uint32_t cellCount = uint32_t(dims * dims * dims);
+    const PeriodicBox box = particles.box;
+
+    // Counting sort into cells
+    cellStart.assign(cellCount + 1, 0);
+    particleCell.resize(count);
+    sortedIndices.resize(count);
+    const float inverseCell = float(dims) / side;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        // Clamped before the cast, a non-finite particle lands in cell 0 and is skipped below
+        glm::vec3 u = glm::floor((box.wrap(particles.position(i)) + 0.5f * side) * inverseCell);
+        const float last = float(dims - 1);
+        glm::ivec3 c = glm::ivec3(clampGridCoordinate(u.x, 0.0f, last), clampGridCoordinate(u.y, 0.0f, last),
+                                  clampGridCoordinate(u.z, 0.0f, last));
+        particleCell[i] = uint32_t((c.x * dims + c.y) * dims + c.z);
+        cellStart[particleCell[i] + 1]++;
+    }
+    for (uint32_t c = 0; c < cellCount; c++)
+    {
+        cellStart[c + 1] += cellStart[c];
+    }
+    cursor.assign(cellStart.begin(), cellStart.end() - 1);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        sortedIndices[cursor[particleCell[i]]++] = i;
+    }
+
+    const float cutoff2 = cutoff * cutoff;
+    const float eps2 = particles.softening * particles.softening;
+    const float twoAlphaOverSqrtPi = 2.0f * alpha / std::sqrt(std::numbers::pi_v<float>);
+    const float alpha2 = alpha * alpha;
+    const bool walkCells = dims >= 3;
+    parallelFor(jobs, 0, count, PME_PARTICLES_PER_TASK,
+        [this, &particles, box, dims, walkCells, count, cutoff2, eps2, twoAlphaOverSqrtPi, alpha2](std::size_t begin, std::size_t end, unsigned int)
+        {
+            // The field of erf(alpha r) / r over r, what the mesh supplies. Below
+            // alpha r = 0.1 its two terms cancel in float, so the series instead.
+            auto longRange = [&](float r2)
+            {
+                float x2 = alpha2 * r2;
+                if (x2 < 0.01f)
+                    return twoAlphaOverSqrtPi * alpha2 * (2.0f / 3.0f - x2 * (0.4f - x2 / 7.0f));
+                float r = std::sqrt(r2);
+                return (std::erf(alpha * r) / r - twoAlphaOverSqrtPi * std::exp(-x2)) / r2;
+            };
+            auto pairField = [&](uint32_t i, uint32_t j, glm::vec3 position, glm::vec3& field)
+            {
+                if (i == j || particles.charge[j] == 0.0f || !isFinitePosition(particles.position(j)))
+                    return;
+                glm::vec3 d = box.minimumImage(position - particles.position(j));
+                float r2 = glm::dot(d, d);
+                if (r2 >= cutoff2)
+                    return;
+                float rs2 = r2 + eps2;
+                float f = 1.0f / (rs2 * std::sqrt(rs2)) - longRange(r2);
+                field += (particles.charge[j] * f) * d;
+            };
+            for (std::size_t i = begin; i < end; i++)
+            {
+                glm::vec3 position = particles.position(i);
+                if (particles.charge[i] == 0.0f || !isFinitePosition(position))
+                    continue;
+                glm::vec3 field(0.0f);
+                if (walkCells)
+                {
+                    uint32_t own = particleCell[i];
+                    int cx = int(own) / (dims * dims);
+                    int cy = (int(own) / dims) % dims;
+                    int cz = int(own) % dims;
+                    for (int ox = -1; ox <= 1; ox++)
+                    {
+                        int x = (cx + ox + dims) % dims;
+                        for (int oy = -1; oy <= 1; oy++)
+                        {
+                            int y = (cy + oy + dims) % dims;
+                            for (int oz = -1; oz <= 1; oz++)
+                            {
+                                uint32_t cell = uint32_t((x * dims + y) * dims + (cz + oz + dims) % dims);
+                                for (uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; k++)
+                                {
+                                    pairField(uint32_t(i), sortedIndices[k], position, field);
+                                }
+                            }
+                        }
+                    }
+                }
+                else
+                {
+                    for (uint32_t j = 0; j < count; j++)
+                    {
+                        pairField(uint32_t(i), j, position, field);
+                    }
+                }
+                float coef = coulomb_coupling * particles.charge[i] / particles.mass[i];
+                particles.accX[i] += coef * field.x;
+                particles.accY[i] += coef * field.y;
+                particles.accZ[i] += coef * field.z;
+            }
+        });
+}
@@ -0,0 +1,173 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "particlePool.h"
+
+ParticleHandle::ParticleHandle()
+    : slot(INVALID_PARTICLE_SLOT),
+      generation(0)
+{}
+
+ParticleHandle::ParticleHandle(uint32_t slot, uint32_t generation)
+    : slot(slot),
+      generation(generation)
+{}
+
+ParticlePool::ParticlePool()
+    : maxHoleFraction(0.25f)
+{}
+
+void ParticlePool::reserve(std::size_t capacity)
+{
+    particles.reserve(capacity);
+    slotIndices.reserve(capacity);
+    slotGenerations.reserve(capacity);
+    freeSlots.reserve(capacity);
+    owners.reserve(capacity);
+    holes.reserve(capacity);
+}
+
+void ParticlePool::clear()
+{
+    // Every slot goes back to the free list with its generation bumped, so
+    // handles from before the clear stay stale
+    freeSlots.clear();
+    for (uint32_t slot = 0; slot < slotIndices.size(); slot++)
+    {
+        if (slotIndices[slot] != INVALID_PARTICLE_SLOT)
+        {
+            slotIndices[slot] = INVALID_PARTICLE_SLOT;
+            slotGenerations[slot]++;
+        }
+        freeSlots.push_back(slot);
+    }
+    owners.clear();
+    holes.clear();
+    particles.truncate(0);
+}
+
+ParticleHandle ParticlePool::spawn(ParticleSpecies species, glm::vec3 position, glm::vec3 velocity)
+{
+    return spawn(speciesCharge(species), speciesMass(species), position, velocity);
+}
+
+ParticleHandle ParticlePool::spawn(float particleCharge, float particleMass, glm::vec3 position, glm::vec3 velocity)
+{
+    uint32_t index;
+    if (!holes.empty())
+    {
+        index = holes.back();
+        holes.pop_back();
+        particles.setParticle(index, particleCharge, particleMass, position, velocity);
+    }
+    else
+    {
+        index = (uint32_t) particles.addParticle(particleCharge, particleMass, position, velocity);
+        owners.push_back(INVALID_PARTICLE_SLOT);
+    }
+
+    uint32_t slot;
+    if (!freeSlots.empty())
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        slot = (uint32_t) slotIndices.size();
+        slotIndices.push_back(INVALID_PARTICLE_SLOT);
+        slotGenerations.push_back(0);
+    }
+    slotIndices[slot] = index;
+    owners[index] = slot;
+    return ParticleHandle(slot, slotGenerations[slot]);
+}
+
+bool ParticlePool::despawn(ParticleHandle handle)
+{
+    uint32_t index = indexOf(handle);
+    if (index == INVALID_PARTICLE_SLOT)
+    {
+        return false;
+    }
+    despawnIndex(index);
+    return true;
+}
+
+void ParticlePool::despawnIndex(std::size_t index)
+{
+    uint32_t slot = owners[index];
+    slotIndices[slot] = INVALID_PARTICLE_SLOT;
+    slotGenerations[slot]++;
+    freeSlots.push_back(slot);
+
+    // Keeps the position so the hole doesn't jump to the origin, where it would
+    // sit inside every tree and grid
+    glm::vec3 position = particles.position(index);
+    particles.setParticle(index, 0.0f, 1.0f, position, glm::vec3(0.0f));
+    owners[index] = INVALID_PARTICLE_SLOT;
+    holes.push_back((uint32_t) index);
+}
+
+bool ParticlePool::isAlive(ParticleHandle handle) const
+{
+    return indexOf(handle) != INVALID_PARTICLE_SLOT;
+}
+
+uint32_t ParticlePool::indexOf(ParticleHandle handle) const
+{
+    if (handle.slot >= slotIndices.size() || slotGenerations[handle.slot] != handle.generation)
+    {
+        return INVALID_PARTICLE_SLOT;
+    }
+    return slotIndices[handle.slot];
+}
+
+ParticleHandle ParticlePool::handleAt(std::size_t index) const
+{
+    uint32_t slot = owners[index];
+    if (slot == INVALID_PARTICLE_SLOT)
+    {
+        return ParticleHandle();
+    }
+    return ParticleHandle(slot, slotGenerations[slot]);
+}
+
+// Each hole below the end takes the last live particle, holes at the end are
+// just cut off. O(holes), and everything that doesn't move keeps its index.
+void ParticlePool::compact()
+{
+    std::size_t count = particles.size();
+    for (uint32_t hole : holes)
+    {
+        while (count > 0 && owners[count - 1] == INVALID_PARTICLE_SLOT)
+        {
+            count--;
+        }
+        // Holes past count were cut off with the tail
+        if (hole >= count)
+        {
+            continue;
+        }
+        uint32_t last = (uint32_t) (count - 1);
+        particles.moveParticle(last, hole);
+        owners[hole] = owners[last];
+        slotIndices[owners[hole]] = hole;
+        owners[last] = INVALID_PARTICLE_SLOT;
+        count--;
+    }
+    holes.clear();
+    particles.truncate(count);
+    owners.resize(count);
+}
+
+bool ParticlePool::compactIfFragmented()
+{
+    if (holes.empty() || float(holes.size()) <= maxHoleFraction * float(particles.size()))
+    {
+        return false;
+    }
+    compact();
+    return true;
+}
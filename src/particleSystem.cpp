@@ -0,0 +1,453 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "particleSystem.h"
+
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+float speciesCharge(ParticleSpecies species)
+{
+    switch (species)
+    {
+    case ParticleSpecies::Electron:
+        return ELECTRON_CHARGE_E;
+    case ParticleSpecies::Proton:
+        return PROTON_CHARGE_E;
+    }
+    return 0.0f;
+}
+
+float speciesMass(ParticleSpecies species)
+{
+    switch (species)
+    {
+    case ParticleSpecies::Electron:
+        return ELECTRON_MASS_KG;
+    case ParticleSpecies::Proton:
+        return PROTON_MASS_KG;
+    }
+    return 1.0f;
+}
+
+ParticleSystem::ParticleSystem()
+{
+    softening = 1.0e-3f;
+    count = 0;
+}
+
+void ParticleSystem::reserve(std::size_t capacity)
+{
+    std::size_t padded = (capacity + PARTICLE_SIMD_WIDTH - 1) / PARTICLE_SIMD_WIDTH * PARTICLE_SIMD_WIDTH;
+    AlignedFloats* arrays[] = { &posX, &posY, &posZ, &velX, &velY, &velZ, &accX, &accY, &accZ, &charge, &mass };
+    for (AlignedFloats* array : arrays)
+    {
+        array->reserve(padded);
+    }
+}
+
+void ParticleSystem::clear()
+{
+    count = 0;
+    resizeArrays(0);
+}
+
+std::size_t ParticleSystem::addParticle(ParticleSpecies species, glm::vec3 position, glm::vec3 velocity)
+{
+    return addParticle(speciesCharge(species), speciesMass(species), position, velocity);
+}
+
+std::size_t ParticleSystem::addParticle(float particleCharge, float particleMass, glm::vec3 position, glm::vec3 velocity)
+{
+    std::size_t i = count;
+    count++;
+    if (count > paddedSize())
+    {
+        resizeArrays(paddedSize() + PARTICLE_SIMD_WIDTH);
+    }
+    setParticle(i, particleCharge, particleMass, position, velocity);
+    return i;
+}
+
+void ParticleSystem::setParticle(std::size_t i, float particleCharge, float particleMass, glm::vec3 position, glm::vec3 velocity)
+{
+    posX[i] = position.x;
+    posY[i] = position.y;
+    posZ[i] = position.z;
+    velX[i] = velocity.x;
+    velY[i] = velocity.y;
+    velZ[i] = velocity.z;
+    accX[i] = 0.0f;
+    accY[i] = 0.0f;
+    accZ[i] = 0.0f;
+    charge[i] = particleCharge;
+    mass[i] = particleMass;
+}
+
+void ParticleSystem::moveParticle(std::size_t from, std::size_t to)
+{
+    AlignedFloats* arrays[] = { &posX, &posY, &posZ, &velX, &velY, &velZ, &accX, &accY, &accZ, &charge, &mass };
+    for (AlignedFloats* array : arrays)
+    {
+        (*array)[to] = (*array)[from];
+    }
+}
+
+void ParticleSystem::truncate(std::size_t newCount)
+{
+    if (newCount >= count)
+    {
+        return;
+    }
+    count = newCount;
+    // Shrinking first refills everything past newCount with the padding values,
+    // the capacity stays so neither step allocates
+    resizeArrays(newCount);
+    resizeArrays((newCount + PARTICLE_SIMD_WIDTH - 1) / PARTICLE_SIMD_WIDTH * PARTICLE_SIMD_WIDTH);
+}
+
+void ParticleSystem::resizeArrays(std::size_t padded)
+{
+    AlignedFloats* arrays[] = { &posX, &posY, &posZ, &velX, &velY, &velZ, &accX, &accY, &accZ, &charge };
+    for (AlignedFloats* array : arrays)
+    {
+        array->resize(padded, 0.0f);
+    }
+    // Padding keeps a unit mass so q / m stays finite if a kernel touches it
+    mass.resize(padded, 1.0f);
+}
+
+void ParticleSystem::computeAccelerations()
+{
+    computeAccelerations(0, count);
+}
+
+void ParticleSystem::computeAccelerations(std::size_t begin, std::size_t end)
+{
+    coulombAccelerationsSimd(*this, begin, end);
+}
+
+// Enough work per task to hide the scheduling, the loops are a few flops per particle
+static const std::size_t PARTICLES_PER_UPDATE_TASK = 4096;
+
+void ParticleSystem::kick(float dt, JobSystem* jobs)
+{
+    parallelFor(jobs, 0, count, PARTICLES_PER_UPDATE_TASK,
+        [this, dt](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                velX[i] += accX[i] * dt;
+                velY[i] += accY[i] * dt;
+                velZ[i] += accZ[i] * dt;
+            }
+        });
+}
+
+void ParticleSystem::drift(float dt, JobSystem* jobs)
+{
+    parallelFor(jobs, 0, count, PARTICLES_PER_UPDATE_TASK,
+        [this, dt](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                posX[i] += velX[i] * dt;
+                posY[i] += velY[i] * dt;
+                posZ[i] += velZ[i] * dt;
+            }
+        });
+    // A separate pass, so open boundaries keep the exact arithmetic of the GPU path
+    if (box.isPeriodic())
+    {
+        wrapPositions(jobs);
+    }
+}
+
+void ParticleSystem::wrapPositions(JobSystem* jobs)
+{
+    if (!box.isPeriodic())
+    {
+        return;
+    }
+    parallelFor(jobs, 0, count, PARTICLES_PER_UPDATE_TASK,
+        [this](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                posX[i] = box.wrap(posX[i]);
+                posY[i] = box.wrap(posY[i]);
+                posZ[i] = box.wrap(posZ[i]);
+            }
+        });
+}
+
+void coulombAccelerationsScalar(ParticleSystem& particles, std::size_t begin, std::size_t end)
+{
+    const float* px = particles.posX.data();
+    const float* py = particles.posY.data();
+    const float* pz = particles.posZ.data();
+    const float* q = particles.charge.data();
+    const std::size_t n = particles.paddedSize();
+    const float eps2 = particles.softening * particles.softening;
+
+    for (std::size_t i = begin; i < end; i++)
+    {
+        float xi = px[i];
+        float yi = py[i];
+        float zi = pz[i];
+        float ax = 0.0f;
+        float ay = 0.0f;
+        float az = 0.0f;
+        for (std::size_t j = 0; j < n; j++)
+        {
+            float dx = xi - px[j];
+            float dy = yi - py[j];
+            float dz = zi - pz[j];
+            float r2 = dx * dx + dy * dy + dz * dz + eps2;
+            float s = q[j] / (r2 * std::sqrt(r2));
+            ax += s * dx;
+            ay += s * dy;
+            az += s * dz;
+        }
+        float coef = coulomb_coupling * q[i] / particles.mass[i];
+        particles.accX[i] = coef * ax;
+        particles.accY[i] = coef * ay;
+        particles.accZ[i] = coef * az;
+    }
+}
+
+// sum += term, with the rounding error of every add carried in compensation
+static inline void kahanAdd(float& sum, float& compensation, float term)
+{
+    float y = term - compensation;
+    float t = sum + y;
+    compensation = (t - sum) - y;
+    sum = t;
+}
+
+void coulombAccelerationsCompensatedScalar(ParticleSystem& particles, std::size_t begin, std::size_t end)
+{
+    const float* px = particles.posX.data();
+    const float* py = particles.posY.data();
+    const float* pz = particles.posZ.data();
+    const float* q = particles.charge.data();
+    const std::size_t n = particles.paddedSize();
+    const float eps2 = particles.softening * particles.softening;
+
+    for (std::size_t i = begin; i < end; i++)
+    {
+        float xi = px[i];
+        float yi = py[i];
+        float zi = pz[i];
+        float ax = 0.0f, cx = 0.0f;
+        float ay = 0.0f, cy = 0.0f;
+        float az = 0.0f, cz = 0.0f;
+        for (std::size_t j = 0; j < n; j++)
+        {
+            float dx = xi - px[j];
+            float dy = yi - py[j];
+            float dz = zi - pz[j];
+            float r2 = dx * dx + dy * dy + dz * dz + eps2;
+            float s = q[j] / (r2 * std::sqrt(r2));
+            kahanAdd(ax, cx, s * dx);
+            kahanAdd(ay, cy, s * dy);
+            kahanAdd(az, cz, s * dz);
+        }
+        float coef = coulomb_coupling * q[i] / particles.mass[i];
+        particles.accX[i] = coef * ax;
+        particles.accY[i] = coef * ay;
+        particles.accZ[i] = coef * az;
+    }
+}
+
+#if defined(__AVX__)
+
+static inline float horizontalSum(__m256 v)
+{
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    lo = _mm_add_ps(lo, hi);
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 0x55));
+    return _mm_cvtss_f32(lo);
+}
+
+#if defined(__FMA__)
+#define MUL_ADD_256(a, b, c) _mm256_fmadd_ps(a, b, c)
+#else
+#define MUL_ADD_256(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#endif
+
+void coulombAccelerationsSimd(ParticleSystem& particles, std::size_t begin, std::size_t end)
+{
+    const float* px = particles.posX.data();
+    const float* py = particles.posY.data();
+    const float* pz = particles.posZ.data();
+    const float* q = particles.charge.data();
+    const std::size_t n = particles.paddedSize();
+    const __m256 eps2 = _mm256_set1_ps(particles.softening * particles.softening);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    for (std::size_t i = begin; i < end; i++)
+    {
+        __m256 xi = _mm256_set1_ps(px[i]);
+        __m256 yi = _mm256_set1_ps(py[i]);
+        __m256 zi = _mm256_set1_ps(pz[i]);
+        __m256 ax = _mm256_setzero_ps();
+        __m256 ay = _mm256_setzero_ps();
+        __m256 az = _mm256_setzero_ps();
+        for (std::size_t j = 0; j < n; j += 8)
+        {
+            __m256 dx = _mm256_sub_ps(xi, _mm256_load_ps(px + j));
+            __m256 dy = _mm256_sub_ps(yi, _mm256_load_ps(py + j));
+            __m256 dz = _mm256_sub_ps(zi, _mm256_load_ps(pz + j));
+            __m256 r2 = MUL_ADD_256(dx, dx, eps2);
+            r2 = MUL_ADD_256(dy, dy, r2);
+            r2 = MUL_ADD_256(dz, dz, r2);
+            __m256 invR3 = _mm256_div_ps(one, _mm256_mul_ps(r2, _mm256_sqrt_ps(r2)));
+            __m256 s = _mm256_mul_ps(_mm256_load_ps(q + j), invR3);
+            ax = MUL_ADD_256(s, dx, ax);
+            ay = MUL_ADD_256(s, dy, ay);
+            az = MUL_ADD_256(s, dz, az);
+        }
+        float coef = coulomb_coupling * q[i] / particles.mass[i];
+        particles.accX[i] = coef * horizontalSum(ax);
+        particles.accY[i] = coef * horizontalSum(ay);
+        particles.accZ[i] = coef * horizontalSum(az);
+    }
+}
+
+// Kahan per lane, then the lanes and their compensations summed in double
+static inline float horizontalSumCompensated(__m256 sum, __m256 compensation)
+{
+    alignas(32) float sums[8];
+    alignas(32) float compensations[8];
+    _mm256_store_ps(sums, sum);
+    _mm256_store_ps(compensations, compensation);
+    double total = 0.0;
+    for (int lane = 0; lane < 8; lane++)
+    {
+        total += double(sums[lane]) - double(compensations[lane]);
+    }
+    return float(total);
+}
+
+static inline void kahanAdd(__m256& sum, __m256& compensation, __m256 term)
+{
+    __m256 y = _mm256_sub_ps(term, compensation);
+    __m256 t = _mm256_add_ps(sum, y);
+    compensation = _mm256_sub_ps(_mm256_sub_ps(t, sum), y);
+    sum = t;
+}
+
+void coulombAccelerationsCompensatedSimd(ParticleSystem& particles, std::size_t begin, std::size_t end)
+{
+    const float* px = particles.posX.data();
+    const float* py = particles.posY.data();
+    const float* pz = particles.posZ.data();
+    const float* q = particles.charge.data();
+    const std::size_t n = particles.paddedSize();
+    const __m256 eps2 = _mm256_set1_ps(particles.softening * particles.softening);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    for (std::size_t i = begin; i < end; i++)
+    {
+        __m256 xi = _mm256_set1_ps(px[i]);
+        __m256 yi = _mm256_set1_ps(py[i]);
+        __m256 zi = _mm256_set1_ps(pz[i]);
+        __m256 ax = _mm256_setzero_ps(), cx = _mm256_setzero_ps();
+        __m256 ay = _mm256_setzero_ps(), cy = _mm256_setzero_ps();
+        __m256 az = _mm256_setzero_ps(), cz = _mm256_setzero_ps();
+        for (std::size_t j = 0; j < n; j += 8)
+        {
+            __m256 dx = _mm256_sub_ps(xi, _mm256_load_ps(px + j));
+            __m256 dy = _mm256_sub_ps(yi, _mm256_load_ps(py + j));
+            __m256 dz = _mm256_sub_ps(zi, _mm256_load_ps(pz + j));
+            __m256 r2 = MUL_ADD_256(dx, dx, eps2);
+            r2 = MUL_ADD_256(dy, dy, r2);
+            r2 = MUL_ADD_256(dz, dz, r2);
+            __m256 invR3 = _mm256_div_ps(one, _mm256_mul_ps(r2, _mm256_sqrt_ps(r2)));
+            __m256 s = _mm256_mul_ps(_mm256_load_ps(q + j), invR3);
+            kahanAdd(ax, cx, _mm256_mul_ps(s, dx));
+            kahanAdd(ay, cy, _mm256_mul_ps(s, dy));
+            kahanAdd(az, cz, _mm256_mul_ps(s, dz));
+        }
+        float coef = coulomb_coupling * q[i] / particles.mass[i];
+        particles.accX[i] = coef * horizontalSumCompensated(ax, cx);
+        particles.accY[i] = coef * horizontalSumCompensated(ay, cy);
+        particles.accZ[i] = coef * horizontalSumCompensated(az, cz);
+    }
+}
+
+#undef MUL_ADD_256
+
+#elif defined(__SSE2__)
+
+static inline float horizontalSum(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 0x55));
+    return _mm_cvtss_f32(v);
+}
+
+void coulombAccelerationsSimd(ParticleSystem& particles, std::size_t begin, std::size_t end)
+{
+    const float* px = particles.posX.data();
+    const float* py = particles.posY.data();
+    const float* pz = particles.posZ.data();
+    const float* q = particles.charge.data();
+    const std::size_t n = particles.paddedSize();
+    const __m128 eps2 = _mm_set1_ps(particles.softening * particles.softening);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (std::size_t i = begin; i < end; i++)
+    {
+        __m128 xi = _mm_set1_ps(px[i]);
+        __m128 yi = _mm_set1_ps(py[i]);
+        __m128 zi = _mm_set1_ps(pz[i]);
+        __m128 ax = _mm_setzero_ps();
+        __m128 ay = _mm_setzero_ps();
+        __m128 az = _mm_setzero_ps();
+        for (std::size_t j = 0; j < n; j += 4)
+        {
+            __m128 dx = _mm_sub_ps(xi, _mm_load_ps(px + j));
+            __m128 dy = _mm_sub_ps(yi, _mm_load_ps(py + j));
+            __m128 dz = _mm_sub_ps(zi, _mm_load_ps(pz + j));
+            __m128 r2 = _mm_add_ps(_mm_mul_ps(dx, dx), eps2);
+            r2 = _mm_add_ps(_mm_mul_ps(dy, dy), r2);
+            r2 = _mm_add_ps(_mm_mul_ps(dz, dz), r2);
+            __m128 invR3 = _mm_div_ps(one, _mm_mul_ps(r2, _mm_sqrt_ps(r2)));
+            __m128 s = _mm_mul_ps(_mm_load_ps(q + j), invR3);
+            ax = _mm_add_ps(_mm_mul_ps(s, dx), ax);
+            ay = _mm_add_ps(_mm_mul_ps(s, dy), ay);
+            az = _mm_add_ps(_mm_mul_ps(s, dz), az);
+        }
+        float coef = coulomb_coupling * q[i] / particles.mass[i];
+        particles.accX[i] = coef * horizontalSum(ax);
+        particles.accY[i] = coef * horizontalSum(ay);
+        particles.accZ[i] = coef * horizontalSum(az);
+    }
+}
+
+void coulombAccelerationsCompensatedSimd(ParticleSystem& particles, std::size_t begin, std::size_t end)
+{
+    coulombAccelerationsCompensatedScalar(particles, begin, end);
+}
+
+#else
+
+void coulombAccelerationsSimd(ParticleSystem& particles, std::size_t begin, std::size_t end)
+{
+    coulombAccelerationsScalar(particles, begin, end);
+}
+
+void coulombAccelerationsCompensatedSimd(ParticleSystem& particles, std::size_t begin, std::size_t end)
+{
+    coulombAccelerationsCompensatedScalar(particles, begin, end);
+}
+
+#endif
@@ -0,0 +1,186 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "particleTrails.h"
+
+#include <algorithm>
+
+// TrailHistory in particleTrail_vert.glsl, after the point cloud's 4
+static const GLuint TRAIL_HISTORY_BINDING = 5;
+static const GLbitfield TRAIL_MAP_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+static void waitAndDelete(GLsync& fence)
+{
+    if (fence == 0)
+        return;
+    GLenum result;
+    do
+    {
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    } while (result == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(fence);
+    fence = 0;
+}
+
+ParticleTrails::ParticleTrails()
+    : trailLength(64),
+      negativeColor(0.3f, 0.4f, 1.0f),
+      positiveColor(1.0f, 0.3f, 0.2f),
+      projectionUniform(-1),
+      viewUniform(-1),
+      rowStrideUniform(-1),
+      rowCountUniform(-1),
+      newestRowUniform(-1),
+      pointsPerTrailUniform(-1),
+      maxSegmentLengthUniform(-1),
+      negativeColorUniform(-1),
+      positiveColorUniform(-1),
+      historyBuffer(0),
+      history(nullptr),
+      emptyVAO(0),
+      particleCount(0),
+      allocatedLength(0),
+      rowCount(0),
+      newestRow(0),
+      recordedRows(0),
+      frame(0),
+      fences()
+{}
+
+ParticleTrails::~ParticleTrails()
+{
+    release();
+    if (emptyVAO != 0)
+        glDeleteVertexArrays(1, &emptyVAO);
+}
+
+void ParticleTrails::loadShaders(const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+    shader.compileVertexShader(vertexShaderPath);
+    shader.compileFragmentShader(fragmentShaderPath);
+    shader.linkShaders();
+    projectionUniform = shader.getUniform("projection");
+    viewUniform = shader.getUniform("view");
+    rowStrideUniform = shader.getUniform("rowStride");
+    rowCountUniform = shader.getUniform("rowCount");
+    newestRowUniform = shader.getUniform("newestRow");
+    pointsPerTrailUniform = shader.getUniform("pointsPerTrail");
+    maxSegmentLengthUniform = shader.getUniform("maxSegmentLength");
+    negativeColorUniform = shader.getUniform("negativeColor");
+    positiveColorUniform = shader.getUniform("positiveColor");
+}
+
+void ParticleTrails::record(const std::vector<glm::vec3>& positions, const std::vector<float>& charges)
+{
+    if (positions.empty())
+    {
+        clear();
+        return;
+    }
+    trailLength = std::max<uint32_t>(trailLength, 2);
+    if (positions.size() != particleCount || trailLength != allocatedLength || historyBuffer == 0)
+        allocate(positions.size());
+
+    // This fence is from TRAIL_FRAMES_IN_FLIGHT + 1 frames ago, the last draw that read the row about to be written
+    frame++;
+    waitAndDelete(fences[frame % (TRAIL_FRAMES_IN_FLIGHT + 1)]);
+    uint32_t row = recordedRows == 0 ? 0 : (newestRow + 1) % rowCount;
+    glm::vec4* out = history + std::size_t(row) * particleCount;
+    for (std::size_t i = 0; i < particleCount; i++)
+    {
+        out[i] = glm::vec4(positions[i], charges[i]);
+    }
+    newestRow = row;
+    recordedRows = std::min(recordedRows + 1, trailLength);
+}
+
+void ParticleTrails::draw(const Camera& camera, float maxSegmentLength)
+{
+    if (recordedRows < 2 || historyBuffer == 0)
+        return;
+    if (emptyVAO == 0)
+        glGenVertexArrays(1, &emptyVAO);
+
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    GLboolean depthMask;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+    // Faded lines blend over the scene, and don't hide each other
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+
+    shader.use();
+    setMat4(projectionUniform, camera.projection);
+    setMat4(viewUniform, camera.view);
+    setUInt(rowStrideUniform, (unsigned int) particleCount);
+    setUInt(rowCountUniform, rowCount);
+    setUInt(newestRowUniform, newestRow);
+    setUInt(pointsPerTrailUniform, recordedRows);
+    setFloat(maxSegmentLengthUniform, maxSegmentLength);
+    setVec3(negativeColorUniform, negativeColor);
+    setVec3(positiveColorUniform, positiveColor);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TRAIL_HISTORY_BINDING, historyBuffer);
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_LINES, 0, GLsizei(particleCount * (recordedRows - 1) * 2));
+    glBindVertexArray(0);
+
+    GLsync& fence = fences[frame % (TRAIL_FRAMES_IN_FLIGHT + 1)];
+    if (fence != 0)
+        glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    glDepthMask(depthMask);
+    if (!blend)
+        glDisable(GL_BLEND);
+}
+
+void ParticleTrails::clear()
+{
+    // Rows restart at 0, which draws still in flight may be reading
+    for (GLsync& fence : fences)
+    {
+        waitAndDelete(fence);
+    }
+    recordedRows = 0;
+}
+
+void ParticleTrails::allocate(std::size_t count)
+{
+    release();
+    particleCount = count;
+    allocatedLength = trailLength;
+    rowCount = trailLength + TRAIL_FRAMES_IN_FLIGHT;
+    GLsizeiptr size = GLsizeiptr(std::size_t(rowCount) * particleCount * sizeof(glm::vec4));
+
+    glGenBuffers(1, &historyBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, historyBuffer);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, size, NULL, TRAIL_MAP_FLAGS);
+    history = static_cast<glm::vec4*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, size, TRAIL_MAP_FLAGS));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    newestRow = 0;
+    recordedRows = 0;
+    frame = 0;
+}
+
+void ParticleTrails::release()
+{
+    // The old buffer lives on in the driver until draws still using it finish
+    for (GLsync& fence : fences)
+    {
+        if (fence != 0)
+            glDeleteSync(fence);
+        fence = 0;
+    }
+    if (historyBuffer != 0)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, historyBuffer);
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glDeleteBuffers(1, &historyBuffer);
+    }
+    historyBuffer = 0;
+    history = nullptr;
+    particleCount = 0;
+    recordedRows = 0;
+}
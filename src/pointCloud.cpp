@@ -0,0 +1,458 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "pointCloud.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <utility>
+
+// Loads asked of the loader at once, queued or read and waiting for upload
+static const std::size_t MAX_PENDING_LOADS = 16;
+// SlotSpacing in pointCloud_vert.glsl, after the particle buffers' 0 to 3
+static const GLuint POINT_CLOUD_SPACING_BINDING = 4;
+
+PointCloud::PointCloud()
+    : maxScreenSpaceError(1.5f),
+      uploadBytesPerFrame(std::size_t(8) << 20),
+      maxPointSize(16.0f),
+      header(),
+      slotCount(0),
+      frame(0),
+      stopping(false),
+      cameraProjectionUniform(-1),
+      cameraViewUniform(-1),
+      projectionScaleUniform(-1),
+      pointsPerSlotUniform(-1),
+      maxPointSizeUniform(-1),
+      VAO(0),
+      VBO(0),
+      spacingSSBO(0)
+{}
+
+PointCloud::~PointCloud()
+{
+    close();
+}
+
+bool PointCloud::open(const std::string& path, std::size_t vramBudgetBytes)
+{
+    close();
+    file.open(path, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "ERROR::POINT_CLOUD_OPEN_FAILED: \"" << path << "\"" << std::endl;
+        return false;
+    }
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, "PCOT", 4) != 0 || header.version != POINT_CLOUD_VERSION ||
+        header.nodeCount == 0 || header.rootNode >= header.nodeCount || header.maxNodePoints == 0 ||
+        header.samplingGridSize == 0)
+    {
+        std::cout << "ERROR::POINT_CLOUD_BAD_HEADER: \"" << path << "\"" << std::endl;
+        file.close();
+        return false;
+    }
+    nodes.resize(header.nodeCount);
+    file.seekg(std::streamoff(header.nodeTableOffset));
+    file.read(reinterpret_cast<char*>(nodes.data()), std::streamsize(nodes.size() * sizeof(PointCloudNodeRecord)));
+    bool valid = bool(file);
+    for (const PointCloudNodeRecord& node : nodes)
+    {
+        // A node larger than a slot would spill into the next one
+        valid = valid && node.pointCount <= header.maxNodePoints;
+        for (int32_t child : node.children)
+        {
+            valid = valid && child >= POINT_CLOUD_NO_NODE && child < int32_t(header.nodeCount);
+        }
+    }
+    if (!valid)
+    {
+        std::cout << "ERROR::POINT_CLOUD_BAD_NODE_TABLE: \"" << path << "\"" << std::endl;
+        nodes.clear();
+        file.close();
+        return false;
+    }
+
+    slotCount = std::max<std::size_t>(vramBudgetBytes / slotBytes(), 1);
+    nodeStates.assign(nodes.size(), NodeState::Absent);
+    nodeSlots.assign(nodes.size(), -1);
+    nodeLastDrawn.assign(nodes.size(), 0);
+    nodeRefinedDepth.assign(nodes.size(), 0);
+    slotNodes.assign(slotCount, -1);
+    slotSpacing.assign(slotCount, 0.0f);
+    frame = 0;
+    stats = PointCloudStats();
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &spacingSSBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(slotCount * slotBytes()), NULL, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CloudPoint), (void*) offsetof(CloudPoint, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CloudPoint), (void*) offsetof(CloudPoint, color));
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, spacingSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(slotCount * sizeof(float)), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    stopping = false;
+    loader = std::thread(&PointCloud::loaderLoop, this);
+    return true;
+}
+
+void PointCloud::close()
+{
+    if (loader.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(loaderMutex);
+            stopping = true;
+        }
+        loaderCondition.notify_one();
+        loader.join();
+    }
+    requests.clear();
+    completed.clear();
+    if (file.is_open())
+        file.close();
+    nodes.clear();
+    nodeStates.clear();
+    nodeSlots.clear();
+    nodeLastDrawn.clear();
+    nodeRefinedDepth.clear();
+    slotNodes.clear();
+    slotSpacing.clear();
+    drawNodes.clear();
+    slotCount = 0;
+    if (VBO != 0)
+        glDeleteBuffers(1, &VBO);
+    if (spacingSSBO != 0)
+        glDeleteBuffers(1, &spacingSSBO);
+    if (VAO != 0)
+        glDeleteVertexArrays(1, &VAO);
+    VBO = 0;
+    spacingSSBO = 0;
+    VAO = 0;
+}
+
+void PointCloud::loadShaders(const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+    shader.compileVertexShader(vertexShaderPath);
+    shader.compileFragmentShader(fragmentShaderPath);
+    shader.linkShaders();
+    cameraProjectionUniform = shader.getUniform("projection");
+    cameraViewUniform = shader.getUniform("view");
+    projectionScaleUniform = shader.getUniform("projectionScale");
+    pointsPerSlotUniform = shader.getUniform("pointsPerSlot");
+    maxPointSizeUniform = shader.getUniform("maxPointSize");
+}
+
+void PointCloud::loaderLoop()
+{
+    while (true)
+    {
+        uint32_t node;
+        {
+            std::unique_lock<std::mutex> lock(loaderMutex);
+            loaderCondition.wait(lock, [this] { return stopping || !requests.empty(); });
+            if (stopping)
+                return;
+            node = requests.front();
+            requests.pop_front();
+        }
+        // Nodes never change after open(), and only this thread touches the file
+        LoadedNode loaded;
+        loaded.node = node;
+        loaded.points.resize(nodes[node].pointCount);
+        file.seekg(std::streamoff(nodes[node].offset));
+        file.read(reinterpret_cast<char*>(loaded.points.data()), std::streamsize(loaded.points.size() * sizeof(CloudPoint)));
+        if (!file)
+        {
+            // Comes back empty, the node then draws nothing rather than being asked for again every frame
+            std::cout << "ERROR::POINT_CLOUD_NODE_READ_FAILED: node " << node << std::endl;
+            file.clear();
+            loaded.points.clear();
+        }
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        completed.push_back(std::move(loaded));
+    }
+}
+
+void PointCloud::update(const Camera& camera, int viewportHeight)
+{
+    if (!isOpen())
+        return;
+    frame++;
+    stats.uploads = 0;
+    stats.evictions = 0;
+
+    // Requests the loader hasn't started are from an older view, drop them
+    // and ask again below in this frame's order
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        for (uint32_t node : requests)
+        {
+            nodeStates[node] = NodeState::Absent;
+        }
+        stats.pendingLoads -= requests.size();
+        requests.clear();
+    }
+
+    std::vector<uint32_t> wanted;
+    selectNodes(camera, viewportHeight, wanted);
+    updateSlotSpacing();
+
+    std::size_t slotsDrawn = 0;
+    stats.nodesDrawn = 0;
+    stats.pointsDrawn = 0;
+    for (uint32_t node : drawNodes)
+    {
+        if (nodeSlots[node] < 0)
+            continue;
+        slotsDrawn++;
+        stats.nodesDrawn++;
+        stats.pointsDrawn += nodes[node].pointCount;
+    }
+
+    // Only as many loads as there are slots not being drawn, so none of them
+    // would have to evict a node on screen
+    std::size_t queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        for (uint32_t node : wanted)
+        {
+            if (stats.pendingLoads >= MAX_PENDING_LOADS || slotsDrawn + stats.pendingLoads >= slotCount)
+                break;
+            requests.push_back(node);
+            nodeStates[node] = NodeState::Requested;
+            stats.pendingLoads++;
+            queued++;
+        }
+    }
+    if (queued > 0)
+        loaderCondition.notify_one();
+
+    uploadCompletedLoads();
+    stats.residentNodes = 0;
+    for (int32_t node : slotNodes)
+    {
+        if (node >= 0)
+            stats.residentNodes++;
+    }
+}
+
+// Best first through the octree, largest projected point spacing first. A
+// child never projects larger than its parent, so parents always come first.
+void PointCloud::selectNodes(const Camera& camera, int viewportHeight, std::vector<uint32_t>& wanted)
+{
+    // Frustum planes of projection * view, pointing inwards
+    glm::mat4 viewProjection = camera.projection * camera.view;
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+    {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+    glm::vec4 planes[6] = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+                            rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2] };
+    auto visible = [this, &planes](uint32_t node)
+    {
+        const PointCloudNodeRecord& record = nodes[node];
+        glm::vec3 center(record.center[0], record.center[1], record.center[2]);
+        for (const glm::vec4& plane : planes)
+        {
+            float reach = record.halfSide * (std::abs(plane.x) + std::abs(plane.y) + std::abs(plane.z));
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -reach)
+                return false;
+        }
+        return true;
+    };
+    const float projectionScale = camera.projection[1][1] * 0.5f * float(viewportHeight);
+    const float spacingPerSide = 1.0f / float(header.samplingGridSize);
+    auto screenSpaceError = [this, &camera, projectionScale, spacingPerSide](uint32_t node)
+    {
+        const PointCloudNodeRecord& record = nodes[node];
+        glm::vec3 center(record.center[0], record.center[1], record.center[2]);
+        glm::vec3 outside = glm::max(glm::abs(camera.position - center) - glm::vec3(record.halfSide), glm::vec3(0.0f));
+        float distance = glm::length(outside);
+        if (distance <= 0.0f)
+            return FLT_MAX;
+        return 2.0f * record.halfSide * spacingPerSide * projectionScale / distance;
+    };
+
+    drawNodes.clear();
+    wanted.clear();
+    std::priority_queue<std::pair<float, uint32_t>> queue;
+    if (visible(header.rootNode))
+        queue.emplace(screenSpaceError(header.rootNode), header.rootNode);
+    std::size_t slotsUsed = 0;
+    while (!queue.empty())
+    {
+        auto [error, node] = queue.top();
+        queue.pop();
+        const PointCloudNodeRecord& record = nodes[node];
+        // Nothing to load, the levels above took all its points
+        if (record.pointCount == 0)
+            nodeStates[node] = NodeState::Resident;
+        if (nodeStates[node] != NodeState::Resident)
+        {
+            if (nodeStates[node] == NodeState::Absent && wanted.size() < MAX_PENDING_LOADS)
+                wanted.push_back(node);
+            continue;
+        }
+        // Out of budget: leave the rest undrawn, and so evictable, for the
+        // loads more important nodes are waiting on
+        bool needsSlot = nodeSlots[node] >= 0;
+        if (needsSlot && slotsUsed + wanted.size() >= slotCount)
+            continue;
+        if (needsSlot)
+            slotsUsed++;
+        nodeLastDrawn[node] = frame;
+        drawNodes.push_back(node);
+        if (error <= maxScreenSpaceError)
+            continue;
+        for (int32_t child : record.children)
+        {
+            if (child != POINT_CLOUD_NO_NODE && visible(uint32_t(child)))
+                queue.emplace(screenSpaceError(uint32_t(child)), uint32_t(child));
+        }
+    }
+}
+
+// A drawn node whose children are all drawn too, down to some depth, is
+// filled in at the children's spacing, so its points shrink to match theirs
+void PointCloud::updateSlotSpacing()
+{
+    // Children come after their parents in drawNodes, so walking it backwards
+    // settles every child before its parent looks at it
+    for (std::size_t i = drawNodes.size(); i-- > 0;)
+    {
+        uint32_t node = drawNodes[i];
+        const PointCloudNodeRecord& record = nodes[node];
+        int depth = -1;
+        for (int32_t child : record.children)
+        {
+            if (child == POINT_CLOUD_NO_NODE)
+                continue;
+            int childDepth = nodeLastDrawn[child] == frame ? nodeRefinedDepth[child] + 1 : 0;
+            depth = depth < 0 ? childDepth : std::min(depth, childDepth);
+        }
+        nodeRefinedDepth[node] = uint8_t(std::clamp(depth, 0, 31));
+        int32_t slot = nodeSlots[node];
+        if (slot >= 0)
+            slotSpacing[slot] = std::ldexp(2.0f * record.halfSide / float(header.samplingGridSize), -int(nodeRefinedDepth[node]));
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, spacingSSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, GLsizeiptr(slotSpacing.size() * sizeof(float)), slotSpacing.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void PointCloud::uploadCompletedLoads()
+{
+    std::size_t uploadedBytes = 0;
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    while (true)
+    {
+        LoadedNode loaded;
+        {
+            std::lock_guard<std::mutex> lock(loaderMutex);
+            if (completed.empty())
+                break;
+            std::size_t bytes = completed.front().points.size() * sizeof(CloudPoint);
+            // Always at least one, however large, so loads never stall completely
+            if (uploadedBytes > 0 && uploadedBytes + bytes > uploadBytesPerFrame)
+                break;
+            loaded = std::move(completed.front());
+            completed.pop_front();
+        }
+        stats.pendingLoads--;
+        uint32_t node = loaded.node;
+        if (loaded.points.empty())
+        {
+            nodeStates[node] = NodeState::Resident;
+            continue;
+        }
+        int32_t slot = acquireSlot();
+        if (slot < 0)
+        {
+            nodeStates[node] = NodeState::Absent;
+            continue;
+        }
+        std::size_t bytes = loaded.points.size() * sizeof(CloudPoint);
+        glBufferSubData(GL_ARRAY_BUFFER, GLintptr(std::size_t(slot) * slotBytes()), GLsizeiptr(bytes), loaded.points.data());
+        slotNodes[slot] = int32_t(node);
+        nodeSlots[node] = slot;
+        nodeStates[node] = NodeState::Resident;
+        // Not drawn yet, but too new to be evicted by the next upload
+        nodeLastDrawn[node] = frame;
+        uploadedBytes += bytes;
+        stats.uploads++;
+        stats.totalUploads++;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// A free slot, else the one whose node was drawn least recently, never one drawn this frame
+int32_t PointCloud::acquireSlot()
+{
+    int32_t oldest = -1;
+    for (std::size_t slot = 0; slot < slotCount; slot++)
+    {
+        int32_t node = slotNodes[slot];
+        if (node < 0)
+            return int32_t(slot);
+        if (nodeLastDrawn[node] < frame && (oldest < 0 || nodeLastDrawn[node] < nodeLastDrawn[slotNodes[oldest]]))
+            oldest = int32_t(slot);
+    }
+    if (oldest < 0)
+        return -1;
+    int32_t evicted = slotNodes[oldest];
+    nodeStates[evicted] = NodeState::Absent;
+    nodeSlots[evicted] = -1;
+    slotNodes[oldest] = -1;
+    stats.evictions++;
+    stats.totalEvictions++;
+    return oldest;
+}
+
+void PointCloud::draw(const Camera& camera, int viewportHeight)
+{
+    if (!isOpen())
+        return;
+    drawFirsts.clear();
+    drawCounts.clear();
+    for (uint32_t node : drawNodes)
+    {
+        // No points of its own, or its read failed
+        if (nodeSlots[node] < 0)
+            continue;
+        drawFirsts.push_back(GLint(std::size_t(nodeSlots[node]) * header.maxNodePoints));
+        drawCounts.push_back(GLsizei(nodes[node].pointCount));
+    }
+    if (drawFirsts.empty())
+        return;
+
+    GLboolean programPointSize = glIsEnabled(GL_PROGRAM_POINT_SIZE);
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    shader.use();
+    setMat4(cameraProjectionUniform, camera.projection);
+    setMat4(cameraViewUniform, camera.view);
+    setFloat(projectionScaleUniform, camera.projection[1][1] * 0.5f * float(viewportHeight));
+    setInt(pointsPerSlotUniform, int(header.maxNodePoints));
+    setFloat(maxPointSizeUniform, maxPointSize);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POINT_CLOUD_SPACING_BINDING, spacingSSBO);
+    glBindVertexArray(VAO);
+    glMultiDrawArrays(GL_POINTS, drawFirsts.data(), drawCounts.data(), GLsizei(drawFirsts.size()));
+    glBindVertexArray(0);
+    if (!programPointSize)
+        glDisable(GL_PROGRAM_POINT_SIZE);
+}
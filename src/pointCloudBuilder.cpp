@@ -0,0 +1,617 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "pointCloudBuilder.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+typedef std::chrono::steady_clock BuildClock;
+
+static const std::size_t READ_BATCH_POINTS = 65536;
+// Deep enough for any real scan, what still doesn't fit this far down is
+// points on top of each other
+static const uint32_t MAX_POINT_CLOUD_LEVEL = 24;
+
+static double secondsSince(BuildClock::time_point start)
+{
+    return std::chrono::duration<double>(BuildClock::now() - start).count();
+}
+
+static bool isFinitePoint(const CloudPoint& point)
+{
+    return std::isfinite(point.position.x) && std::isfinite(point.position.y) && std::isfinite(point.position.z);
+}
+
+bool RawPointFileSource::open(const std::string& path)
+{
+    file.open(path, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "ERROR::POINT_CLOUD_INPUT_OPEN_FAILED: \"" << path << "\"" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void RawPointFileSource::rewind()
+{
+    file.clear();
+    file.seekg(0);
+}
+
+std::size_t RawPointFileSource::read(CloudPoint* out, std::size_t maxCount)
+{
+    file.read(reinterpret_cast<char*>(out), std::streamsize(maxCount * sizeof(CloudPoint)));
+    // A torn record at the end of the file is ignored
+    return std::size_t(file.gcount()) / sizeof(CloudPoint);
+}
+
+static uint64_t splitMix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Top 24 bits as a float in [0, 1)
+static float unitFloat(uint64_t bits)
+{
+    return float(bits >> 40) * (1.0f / 16777216.0f);
+}
+
+SyntheticPointSource::SyntheticPointSource(uint64_t count, float side, uint64_t seed)
+    : count(count),
+      side(side),
+      seed(seed),
+      next(0)
+{}
+
+std::size_t SyntheticPointSource::read(CloudPoint* out, std::size_t maxCount)
+{
+    std::size_t n = std::size_t(std::min<uint64_t>(maxCount, count - next));
+    const glm::vec3 low(60.0f, 120.0f, 40.0f);
+    const glm::vec3 middle(125.0f, 95.0f, 55.0f);
+    const glm::vec3 high(235.0f, 235.0f, 235.0f);
+    for (std::size_t k = 0; k < n; k++)
+    {
+        uint64_t a = splitMix64(seed * 0x100000001B3ull + next + k);
+        uint64_t b = splitMix64(a);
+        uint64_t c = splitMix64(b);
+        float u = unitFloat(a) - 0.5f;
+        float v = unitFloat(b) - 0.5f;
+        // Height as a fraction of the side, roughly within +-0.12
+        float h = 0.08f * std::sin(6.3f * u + 1.0f) * std::cos(5.1f * v)
+                + 0.03f * std::sin(23.0f * u + 17.0f * v)
+                + 0.01f * std::sin(71.0f * u) * std::sin(67.0f * v);
+        float jitter = (unitFloat(c) - 0.5f) * 0.0005f;
+        out[k].position = glm::vec3(u, h + jitter, v) * side;
+
+        float t = std::clamp((h + 0.12f) / 0.24f, 0.0f, 1.0f);
+        glm::vec3 color = t < 0.6f ? glm::mix(low, middle, t / 0.6f) : glm::mix(middle, high, (t - 0.6f) / 0.4f);
+        out[k].color[0] = uint8_t(color.r);
+        out[k].color[1] = uint8_t(color.g);
+        out[k].color[2] = uint8_t(color.b);
+        out[k].color[3] = 255;
+    }
+    next += n;
+    return n;
+}
+
+namespace
+{
+    // The octree above the chunks, cut from the counting grid. A node is
+    // either a chunk or has at least one child.
+    struct ChunkTreeNode
+    {
+        uint32_t level;
+        glm::uvec3 cell;
+        int32_t chunk;
+        int32_t children[8];
+    };
+
+    struct Chunk
+    {
+        uint32_t level;
+        glm::uvec3 cell;
+        std::string path;
+        std::vector<CloudPoint> buffer;
+        std::size_t flushedPoints;
+        uint32_t rootNode;
+        // The chunk's top node, written after the levels above took their samples
+        std::vector<CloudPoint> rootPoints;
+        std::vector<uint8_t> taken;
+    };
+
+    struct BuildState
+    {
+        const PointCloudBuildSettings& settings;
+        PointCloudBuildStats& stats;
+        std::ofstream& out;
+        uint64_t writeOffset;
+        glm::vec3 boundsMin;
+        float boundsSide;
+        std::vector<PointCloudNodeRecord> nodes;
+        std::vector<ChunkTreeNode> tree;
+        std::vector<Chunk> chunks;
+        // A sampling cell is taken in the current node when its stamp is the current one,
+        // so the grid never needs clearing between nodes
+        std::vector<uint32_t> samplingStamps;
+        uint32_t stamp;
+        std::mt19937 rng;
+    };
+}
+
+static glm::vec3 octantOffset(int octant)
+{
+    return glm::vec3(float(octant & 1), float((octant >> 1) & 1), float((octant >> 2) & 1));
+}
+
+static int octantOf(const glm::vec3& position, const glm::vec3& center)
+{
+    return int(position.x >= center.x) | int(position.y >= center.y) << 1 | int(position.z >= center.z) << 2;
+}
+
+static float nodeSideAt(const BuildState& state, uint32_t level)
+{
+    return std::ldexp(state.boundsSide, -int(level));
+}
+
+static uint32_t addNode(BuildState& state, uint32_t level, const glm::vec3& nodeMin, float nodeSide)
+{
+    PointCloudNodeRecord record;
+    record.offset = 0;
+    record.pointCount = 0;
+    record.level = level;
+    std::fill(std::begin(record.children), std::end(record.children), POINT_CLOUD_NO_NODE);
+    glm::vec3 center = nodeMin + glm::vec3(0.5f * nodeSide);
+    record.center[0] = center.x;
+    record.center[1] = center.y;
+    record.center[2] = center.z;
+    record.halfSide = 0.5f * nodeSide;
+    state.nodes.push_back(record);
+    state.stats.depth = std::max(state.stats.depth, level);
+    return uint32_t(state.nodes.size() - 1);
+}
+
+static void writeNodePoints(BuildState& state, uint32_t node, const std::vector<CloudPoint>& points)
+{
+    state.nodes[node].offset = state.writeOffset;
+    state.nodes[node].pointCount = uint32_t(points.size());
+    std::size_t bytes = points.size() * sizeof(CloudPoint);
+    state.out.write(reinterpret_cast<const char*>(points.data()), std::streamsize(bytes));
+    state.writeOffset += bytes;
+    state.stats.writtenPoints += points.size();
+}
+
+static void beginNodeSampling(BuildState& state)
+{
+    state.stamp++;
+    if (state.stamp == 0)
+    {
+        std::fill(state.samplingStamps.begin(), state.samplingStamps.end(), 0u);
+        state.stamp = 1;
+    }
+}
+
+// True if position's sampling cell in the node was still free, and takes it
+static bool claimSamplingCell(BuildState& state, const glm::vec3& position, const glm::vec3& nodeMin, float nodeSide)
+{
+    const int s = int(state.settings.samplingGridSize);
+    glm::ivec3 cell = glm::clamp(glm::ivec3((position - nodeMin) * (float(s) / nodeSide)), glm::ivec3(0), glm::ivec3(s - 1));
+    uint32_t& stamp = state.samplingStamps[(std::size_t(cell.z) * s + std::size_t(cell.y)) * s + std::size_t(cell.x)];
+    if (stamp == state.stamp)
+        return false;
+    stamp = state.stamp;
+    return true;
+}
+
+// Builds the subtree of one node from all the points inside it, which it
+// consumes. A node over the point limit keeps the first point to land in each
+// sampling cell (points arrive shuffled) and splits the rest into octants.
+// With keepInMemory the node's own points go there instead of the file.
+static uint32_t buildSubtree(BuildState& state, std::vector<CloudPoint>& points, uint32_t level,
+                             const glm::vec3& nodeMin, float nodeSide, std::vector<CloudPoint>* keepInMemory)
+{
+    const std::size_t maxPoints = state.settings.maxNodePoints;
+    uint32_t node = addNode(state, level, nodeMin, nodeSide);
+    std::vector<CloudPoint> kept;
+    std::vector<CloudPoint> octants[8];
+    if (points.size() <= maxPoints || level >= MAX_POINT_CLOUD_LEVEL)
+    {
+        if (points.size() > maxPoints)
+        {
+            state.stats.droppedPoints += points.size() - maxPoints;
+            points.resize(maxPoints);
+        }
+        kept.swap(points);
+    }
+    else
+    {
+        beginNodeSampling(state);
+        kept.reserve(maxPoints);
+        glm::vec3 center = nodeMin + glm::vec3(0.5f * nodeSide);
+        for (const CloudPoint& point : points)
+        {
+            if (kept.size() < maxPoints && claimSamplingCell(state, point.position, nodeMin, nodeSide))
+                kept.push_back(point);
+            else
+                octants[octantOf(point.position, center)].push_back(point);
+        }
+        std::vector<CloudPoint>().swap(points);
+    }
+    if (keepInMemory != nullptr)
+        *keepInMemory = std::move(kept);
+    else
+        writeNodePoints(state, node, kept);
+    std::vector<CloudPoint>().swap(kept);
+
+    float half = 0.5f * nodeSide;
+    for (int octant = 0; octant < 8; octant++)
+    {
+        if (octants[octant].empty())
+            continue;
+        uint32_t child = buildSubtree(state, octants[octant], level + 1, nodeMin + octantOffset(octant) * half, half, nullptr);
+        state.nodes[node].children[octant] = int32_t(child);
+    }
+    return node;
+}
+
+static int32_t cutChunks(BuildState& state, const std::vector<std::vector<uint64_t>>& pyramid,
+                         std::vector<int32_t>& cellChunks, uint32_t level, const glm::uvec3& cell)
+{
+    const uint32_t finestLevel = uint32_t(pyramid.size() - 1);
+    const std::size_t n = std::size_t(1) << level;
+    uint64_t count = pyramid[level][(cell.z * n + cell.y) * n + cell.x];
+    if (count == 0)
+        return POINT_CLOUD_NO_NODE;
+
+    int32_t treeNode = int32_t(state.tree.size());
+    ChunkTreeNode node;
+    node.level = level;
+    node.cell = cell;
+    node.chunk = POINT_CLOUD_NO_NODE;
+    std::fill(std::begin(node.children), std::end(node.children), POINT_CLOUD_NO_NODE);
+    state.tree.push_back(node);
+
+    // The finest counting cells become chunks however full they are
+    if (count <= state.settings.maxChunkPoints || level == finestLevel)
+    {
+        int32_t chunkIndex = int32_t(state.chunks.size());
+        Chunk chunk;
+        chunk.level = level;
+        chunk.cell = cell;
+        chunk.flushedPoints = 0;
+        chunk.rootNode = 0;
+        state.chunks.push_back(std::move(chunk));
+        state.tree[treeNode].chunk = chunkIndex;
+
+        const std::size_t g = std::size_t(1) << finestLevel;
+        const uint32_t span = 1u << (finestLevel - level);
+        glm::uvec3 first = cell * span;
+        for (uint32_t z = first.z; z < first.z + span; z++)
+        {
+            for (uint32_t y = first.y; y < first.y + span; y++)
+            {
+                int32_t* row = cellChunks.data() + (z * g + y) * g;
+                std::fill(row + first.x, row + first.x + span, chunkIndex);
+            }
+        }
+        return treeNode;
+    }
+    for (int octant = 0; octant < 8; octant++)
+    {
+        glm::uvec3 childCell = cell * 2u + glm::uvec3(octant & 1, (octant >> 1) & 1, (octant >> 2) & 1);
+        int32_t child = cutChunks(state, pyramid, cellChunks, level + 1, childCell);
+        state.tree[treeNode].children[octant] = child;
+    }
+    return treeNode;
+}
+
+static void collectCandidates(const BuildState& state, int32_t treeNode, std::vector<std::pair<uint32_t, uint32_t>>& candidates)
+{
+    const ChunkTreeNode& node = state.tree[treeNode];
+    if (node.chunk != POINT_CLOUD_NO_NODE)
+    {
+        const Chunk& chunk = state.chunks[node.chunk];
+        for (std::size_t i = 0; i < chunk.rootPoints.size(); i++)
+        {
+            if (!chunk.taken[i])
+                candidates.emplace_back(uint32_t(node.chunk), uint32_t(i));
+        }
+        return;
+    }
+    for (int32_t child : node.children)
+    {
+        if (child != POINT_CLOUD_NO_NODE)
+            collectCandidates(state, child, candidates);
+    }
+}
+
+// The nodes above the chunks sample, top down, from the top nodes of the
+// chunks below them. Sampled points move up, so nothing is stored twice.
+static uint32_t buildUpperLevels(BuildState& state, int32_t treeNode)
+{
+    const ChunkTreeNode treeEntry = state.tree[treeNode];
+    if (treeEntry.chunk != POINT_CLOUD_NO_NODE)
+        return state.chunks[treeEntry.chunk].rootNode;
+
+    float nodeSide = nodeSideAt(state, treeEntry.level);
+    glm::vec3 nodeMin = state.boundsMin + glm::vec3(treeEntry.cell) * nodeSide;
+    uint32_t node = addNode(state, treeEntry.level, nodeMin, nodeSide);
+
+    // In random order, so the point limit doesn't favour one chunk
+    std::vector<std::pair<uint32_t, uint32_t>> candidates;
+    collectCandidates(state, treeNode, candidates);
+    std::shuffle(candidates.begin(), candidates.end(), state.rng);
+    beginNodeSampling(state);
+    std::vector<CloudPoint> kept;
+    for (const std::pair<uint32_t, uint32_t>& candidate : candidates)
+    {
+        if (kept.size() >= state.settings.maxNodePoints)
+            break;
+        Chunk& chunk = state.chunks[candidate.first];
+        const CloudPoint& point = chunk.rootPoints[candidate.second];
+        if (claimSamplingCell(state, point.position, nodeMin, nodeSide))
+        {
+            kept.push_back(point);
+            chunk.taken[candidate.second] = 1;
+        }
+    }
+    writeNodePoints(state, node, kept);
+
+    for (int octant = 0; octant < 8; octant++)
+    {
+        if (treeEntry.children[octant] == POINT_CLOUD_NO_NODE)
+            continue;
+        uint32_t child = buildUpperLevels(state, treeEntry.children[octant]);
+        state.nodes[node].children[octant] = int32_t(child);
+    }
+    return node;
+}
+
+static bool flushChunkBuffer(Chunk& chunk)
+{
+    if (chunk.buffer.empty())
+        return true;
+    std::ofstream file(chunk.path, std::ios::binary | (chunk.flushedPoints == 0 ? std::ios::trunc : std::ios::app));
+    file.write(reinterpret_cast<const char*>(chunk.buffer.data()), std::streamsize(chunk.buffer.size() * sizeof(CloudPoint)));
+    if (!file)
+    {
+        std::cout << "ERROR::POINT_CLOUD_CHUNK_WRITE_FAILED: \"" << chunk.path << "\"" << std::endl;
+        return false;
+    }
+    chunk.flushedPoints += chunk.buffer.size();
+    chunk.buffer.clear();
+    return true;
+}
+
+static bool loadChunk(Chunk& chunk, std::vector<CloudPoint>& points)
+{
+    // Small chunks never left their buffer
+    if (chunk.flushedPoints == 0)
+    {
+        points.swap(chunk.buffer);
+        std::vector<CloudPoint>().swap(chunk.buffer);
+        return true;
+    }
+    if (!flushChunkBuffer(chunk))
+        return false;
+    std::vector<CloudPoint>().swap(chunk.buffer);
+    points.resize(chunk.flushedPoints);
+    std::ifstream file(chunk.path, std::ios::binary);
+    file.read(reinterpret_cast<char*>(points.data()), std::streamsize(points.size() * sizeof(CloudPoint)));
+    bool complete = bool(file);
+    file.close();
+    std::remove(chunk.path.c_str());
+    if (!complete)
+    {
+        std::cout << "ERROR::POINT_CLOUD_CHUNK_READ_FAILED: \"" << chunk.path << "\"" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static void removeChunkFiles(std::vector<Chunk>& chunks)
+{
+    for (Chunk& chunk : chunks)
+    {
+        if (chunk.flushedPoints > 0)
+            std::remove(chunk.path.c_str());
+    }
+}
+
+bool buildPointCloud(PointSource& source, const std::string& outputPath,
+                     const PointCloudBuildSettings& settings, PointCloudBuildStats* stats)
+{
+    PointCloudBuildStats localStats;
+    PointCloudBuildStats& buildStats = stats != nullptr ? *stats : localStats;
+    buildStats = PointCloudBuildStats();
+    PointCloudBuildSettings checked = settings;
+    checked.maxNodePoints = std::max<uint32_t>(checked.maxNodePoints, 1);
+    checked.samplingGridSize = std::clamp<uint32_t>(checked.samplingGridSize, 1, 512);
+    checked.countingGridSize = std::bit_floor(std::clamp<uint32_t>(checked.countingGridSize, 1, 512));
+    checked.maxChunkPoints = std::max<std::size_t>(checked.maxChunkPoints, checked.maxNodePoints);
+    checked.distributeBufferPoints = std::max<std::size_t>(checked.distributeBufferPoints, 1);
+    std::vector<CloudPoint> batch(READ_BATCH_POINTS);
+
+    // Bounds, a cube around the points
+    BuildClock::time_point start = BuildClock::now();
+    glm::vec3 low(0.0f);
+    glm::vec3 high(0.0f);
+    source.rewind();
+    for (std::size_t read; (read = source.read(batch.data(), batch.size())) > 0;)
+    {
+        for (std::size_t i = 0; i < read; i++)
+        {
+            if (!isFinitePoint(batch[i]))
+                continue;
+            if (buildStats.inputPoints == 0)
+                low = high = batch[i].position;
+            low = glm::min(low, batch[i].position);
+            high = glm::max(high, batch[i].position);
+            buildStats.inputPoints++;
+        }
+    }
+    if (buildStats.inputPoints == 0)
+    {
+        std::cout << "ERROR::POINT_CLOUD_EMPTY_INPUT" << std::endl;
+        return false;
+    }
+    glm::vec3 extent = high - low;
+    float side = std::max(std::max(extent.x, extent.y), extent.z);
+    // A little slack, so the highest points still fall inside the last cell
+    side = std::max(side * 1.0001f, 1.0e-3f);
+    buildStats.boundsSeconds = secondsSince(start);
+
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cout << "ERROR::POINT_CLOUD_OUTPUT_OPEN_FAILED: \"" << outputPath << "\"" << std::endl;
+        return false;
+    }
+    BuildState state{ checked, buildStats, out };
+    state.writeOffset = sizeof(PointCloudFileHeader);
+    state.boundsMin = 0.5f * (low + high) - glm::vec3(0.5f * side);
+    state.boundsSide = side;
+    state.stamp = 0;
+    state.rng.seed(1);
+    PointCloudFileHeader header = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Counts on the finest counting grid, summed up into coarser ones
+    start = BuildClock::now();
+    const uint32_t finestLevel = uint32_t(std::countr_zero(checked.countingGridSize));
+    const std::size_t g = checked.countingGridSize;
+    const float toCell = float(g) / side;
+    auto countingCell = [&state, g, toCell](const glm::vec3& position)
+    {
+        glm::ivec3 cell = glm::clamp(glm::ivec3((position - state.boundsMin) * toCell), glm::ivec3(0), glm::ivec3(int(g) - 1));
+        return (std::size_t(cell.z) * g + std::size_t(cell.y)) * g + std::size_t(cell.x);
+    };
+    std::vector<std::vector<uint64_t>> pyramid(finestLevel + 1);
+    pyramid[finestLevel].assign(g * g * g, 0);
+    source.rewind();
+    for (std::size_t read; (read = source.read(batch.data(), batch.size())) > 0;)
+    {
+        for (std::size_t i = 0; i < read; i++)
+        {
+            if (isFinitePoint(batch[i]))
+                pyramid[finestLevel][countingCell(batch[i].position)]++;
+        }
+    }
+    for (uint32_t level = finestLevel; level > 0; level--)
+    {
+        const std::size_t fine = std::size_t(1) << level;
+        const std::size_t coarse = fine / 2;
+        pyramid[level - 1].assign(coarse * coarse * coarse, 0);
+        for (std::size_t z = 0; z < fine; z++)
+        {
+            for (std::size_t y = 0; y < fine; y++)
+            {
+                for (std::size_t x = 0; x < fine; x++)
+                {
+                    pyramid[level - 1][((z / 2) * coarse + y / 2) * coarse + x / 2] += pyramid[level][(z * fine + y) * fine + x];
+                }
+            }
+        }
+    }
+    std::vector<int32_t> cellChunks(g * g * g, POINT_CLOUD_NO_NODE);
+    cutChunks(state, pyramid, cellChunks, 0, glm::uvec3(0));
+    std::vector<std::vector<uint64_t>>().swap(pyramid);
+    buildStats.chunkCount = state.chunks.size();
+    for (std::size_t c = 0; c < state.chunks.size(); c++)
+    {
+        state.chunks[c].path = outputPath + ".chunk" + std::to_string(c);
+    }
+    buildStats.countSeconds = secondsSince(start);
+
+    // Every point appended to its chunk
+    start = BuildClock::now();
+    source.rewind();
+    for (std::size_t read; (read = source.read(batch.data(), batch.size())) > 0;)
+    {
+        for (std::size_t i = 0; i < read; i++)
+        {
+            if (!isFinitePoint(batch[i]))
+                continue;
+            Chunk& chunk = state.chunks[cellChunks[countingCell(batch[i].position)]];
+            chunk.buffer.push_back(batch[i]);
+            if (chunk.buffer.size() >= checked.distributeBufferPoints && !flushChunkBuffer(chunk))
+            {
+                removeChunkFiles(state.chunks);
+                return false;
+            }
+        }
+    }
+    std::vector<int32_t>().swap(cellChunks);
+    buildStats.distributeSeconds = secondsSince(start);
+
+    // Chunks one at a time, then the levels above them
+    start = BuildClock::now();
+    state.samplingStamps.assign(std::size_t(checked.samplingGridSize) * checked.samplingGridSize * checked.samplingGridSize, 0);
+    for (std::size_t c = 0; c < state.chunks.size(); c++)
+    {
+        Chunk& chunk = state.chunks[c];
+        std::vector<CloudPoint> points;
+        if (!loadChunk(chunk, points))
+        {
+            removeChunkFiles(state.chunks);
+            return false;
+        }
+        buildStats.largestChunkPoints = std::max(buildStats.largestChunkPoints, points.size());
+        std::mt19937 chunkRng(uint32_t(c) + 1);
+        std::shuffle(points.begin(), points.end(), chunkRng);
+        float chunkSide = nodeSideAt(state, chunk.level);
+        glm::vec3 chunkMin = state.boundsMin + glm::vec3(chunk.cell) * chunkSide;
+        chunk.rootNode = buildSubtree(state, points, chunk.level, chunkMin, chunkSide, &chunk.rootPoints);
+        chunk.taken.assign(chunk.rootPoints.size(), 0);
+    }
+    uint32_t rootNode = buildUpperLevels(state, 0);
+    for (Chunk& chunk : state.chunks)
+    {
+        std::vector<CloudPoint> remaining;
+        for (std::size_t i = 0; i < chunk.rootPoints.size(); i++)
+        {
+            if (!chunk.taken[i])
+                remaining.push_back(chunk.rootPoints[i]);
+        }
+        writeNodePoints(state, chunk.rootNode, remaining);
+        std::vector<CloudPoint>().swap(chunk.rootPoints);
+    }
+    buildStats.nodeCount = state.nodes.size();
+    buildStats.buildSeconds = secondsSince(start);
+
+    std::memcpy(header.magic, "PCOT", 4);
+    header.version = POINT_CLOUD_VERSION;
+    header.nodeCount = uint32_t(state.nodes.size());
+    header.rootNode = rootNode;
+    header.pointCount = buildStats.writtenPoints;
+    header.nodeTableOffset = state.writeOffset;
+    header.boundsMin[0] = state.boundsMin.x;
+    header.boundsMin[1] = state.boundsMin.y;
+    header.boundsMin[2] = state.boundsMin.z;
+    header.boundsSide = side;
+    header.maxNodePoints = checked.maxNodePoints;
+    header.samplingGridSize = checked.samplingGridSize;
+    out.write(reinterpret_cast<const char*>(state.nodes.data()), std::streamsize(state.nodes.size() * sizeof(PointCloudNodeRecord)));
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out)
+    {
+        std::cout << "ERROR::POINT_CLOUD_WRITE_FAILED: \"" << outputPath << "\"" << std::endl;
+        return false;
+    }
+    return true;
+}
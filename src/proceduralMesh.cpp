@@ -116,7 +116,7 @@ Mesh uvSphere(float radius, int uSegments, int vSegments)
                 sphere.indices.push_back(k2);
                 sphere.indices.push_back(k1 + 1);
             }
-            if (i != (uSegments - 1))
+            if (i != (vSegments - 1))
             {
                 sphere.indices.push_back(k1 + 1);
                 sphere.indices.push_back(k2);
@@ -3,6 +3,7 @@
 // Author: Kyle Bueche
 
 #include "../include/shader.h"
+#include "../include/geometryArena.h"
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -15,19 +16,9 @@
 
 Shader::Shader()
 {
-    ID = 0;
     shaders = std::vector<unsigned int>();
 }
 
-Shader::~Shader()
-{
-    // Silently ignored if ID = 0
-    if (ID != 0)
-    {
-        glDeleteProgram(ID);
-    }
-}
-
 void Shader::compileVertexShader(const char* shaderPath)
 {
     compileShader(shaderPath, GL_VERTEX_SHADER);
@@ -102,17 +93,17 @@ void Shader::linkShaders()
     int success;
     char infoLog[512];
 
-    ID = glCreateProgram();
+    ID = GLProgram(glCreateProgram());
     for (int i = 0; i < shaders.size(); i++)
     {
-        glAttachShader(ID, shaders[i]);
+        glAttachShader(ID.get(), shaders[i]);
     }
-    glLinkProgram(ID);
+    glLinkProgram(ID.get());
 
-    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    glGetProgramiv(ID.get(), GL_LINK_STATUS, &success);
     if(!success)
     {
-        glGetProgramInfoLog(ID, 512, NULL, infoLog);
+        glGetProgramInfoLog(ID.get(), 512, NULL, infoLog);
         std::cout << "ERROR::SHADER_LINKING_FAILED\n" << infoLog << std::endl;
     }
 
@@ -124,12 +115,12 @@ void Shader::linkShaders()
 
 void Shader::use()
 {
-    glUseProgram(ID);
+    glUseProgram(ID.get());
 }
 
 GLint Shader::getUniform(const std::string &name) const
 {
-    GLint i = glGetUniformLocation(ID, name.c_str());
+    GLint i = glGetUniformLocation(ID.get(), name.c_str());
     if (i == -1)
     {
         std::cout << "ERROR::SHADER_UNIFORM_DOESNT_EXIST: \"" << name.c_str() << "\"" << std::endl;
@@ -147,6 +138,11 @@ void setInt(GLint uniform, int value)
     glUniform1i(uniform, value);
 }
 
+void setUInt(GLint uniform, unsigned int value)
+{
+    glUniform1ui(uniform, value);
+}
+
 void setFloat(GLint uniform, float value)
 {
     glUniform1f(uniform, value);
@@ -256,6 +252,16 @@ MeshUniform Shader::getMeshUniform(std::string uniformName)
     return uniform;
 }
 
+VertexFormatUniform Shader::getVertexFormatUniform(std::string uniformName)
+{
+    VertexFormatUniform uniform;
+    uniform.quantizedPositions = getUniform((uniformName + ".quantizedPositions").c_str());
+    uniform.positionOffset = getUniform((uniformName + ".positionOffset").c_str());
+    uniform.positionScale = getUniform((uniformName + ".positionScale").c_str());
+    uniform.octahedralNormals = getUniform((uniformName + ".octahedralNormals").c_str());
+    return uniform;
+}
+
 void setDirLight(DirLightUniform uniform, DirLight dirLight)
 {
     setVec3(uniform.direction, dirLight.direction);
@@ -298,7 +304,7 @@ void setSpotLight(SpotLightUniform uniform, SpotLight spotLight)
     setFloat(uniform.quadratic, spotLight.quadratic);
 }
 
-void setMaterial(MaterialUniform uniform, Material material)
+void setMaterial(MaterialUniform uniform, const Material& material)
 {
     setVec3(uniform.baseDiffuseColor, material.baseDiffuseColor);
     setVec3(uniform.baseSpecularColor, material.baseSpecularColor);
@@ -307,13 +313,13 @@ void setMaterial(MaterialUniform uniform, Material material)
     //for (int i = 0; i < nDiffuse; i++)
     //{
     //    glActiveTexture(GL_TEXTURE0 + i);
-    //    glBindTexture(GL_TEXTURE_2D, material.diffuseTextures[i].id);
+    //    glBindTexture(GL_TEXTURE_2D, material.diffuseTextures[i].id.get());
     //    setInt(uniform.diffuseTextures[i], GL_TEXTURE0 + i);
     //}
     //for (int i = 0; i < nSpecular; i++)
     //{
     //    glActiveTexture(GL_TEXTURE0 + nDiffuse + i);
-    //    glBindTexture(GL_TEXTURE_2D, material.specularTextures[i].id);
+    //    glBindTexture(GL_TEXTURE_2D, material.specularTextures[i].id.get());
     //    setInt(uniform.specularTextures[i], GL_TEXTURE0 + nDiffuse + i);
     //}
     //glActiveTexture(GL_TEXTURE0);
@@ -333,4 +339,28 @@ void setMesh(MeshUniform uniform, Mesh& mesh)
 {
     setMat4(uniform.model, mesh.model);
     setMat3(uniform.normal, mesh.normal);
+}
+
+void setMesh(MeshUniform uniform, const glm::mat4& model, const glm::mat3& normal)
+{
+    setMat4(uniform.model, model);
+    setMat3(uniform.normal, normal);
+}
+
+void setVertexFormat(VertexFormatUniform uniform, const Mesh& mesh)
+{
+    VertexLayout layout = mesh.getBufferedLayout();
+    setBool(uniform.quantizedPositions, layout.quantizePositions);
+    setVec3(uniform.positionOffset, mesh.getPositionOffset());
+    setVec3(uniform.positionScale, mesh.getPositionScale());
+    setBool(uniform.octahedralNormals, layout.octahedralNormals);
+}
+
+void setVertexFormat(VertexFormatUniform uniform, const GeometryArena& arena)
+{
+    VertexLayout layout = arena.getLayout();
+    setBool(uniform.quantizedPositions, layout.quantizePositions);
+    setVec3(uniform.positionOffset, arena.getPositionOffset());
+    setVec3(uniform.positionScale, arena.getPositionScale());
+    setBool(uniform.octahedralNormals, layout.octahedralNormals);
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "simulationThread.h"
+
+#include <algorithm>
+#include <chrono>
+
+ParticleSnapshot::ParticleSnapshot()
+    : boxSide(0.0f),
+      simulationTime(0.0),
+      publishTime(0.0),
+      step(0),
+      epoch(0)
+{}
+
+double steadySeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+float snapshotBlend(const ParticleSnapshot& previous, const ParticleSnapshot& current, double now)
+{
+    if (previous.epoch != current.epoch || previous.positions.size() != current.positions.size())
+    {
+        return 1.0f;
+    }
+    double interval = current.publishTime - previous.publishTime;
+    if (interval <= 0.0)
+    {
+        return 1.0f;
+    }
+    return (float) std::clamp((now - current.publishTime) / interval, 0.0, 1.0);
+}
+
+SimulationThread::SimulationThread()
+    : particles(nullptr),
+      integrator(nullptr),
+      recorder(nullptr),
+      requestedSolver(nullptr),
+      requestedSubsteps(1),
+      requestedScheme(IntegrationScheme::VelocityVerlet),
+      pauseRequested(false),
+      stopping(false),
+      idle(false),
+      simulationTime(0.0),
+      stepCount(0),
+      epoch(0)
+{}
+
+SimulationThread::~SimulationThread()
+{
+    stop();
+}
+
+void SimulationThread::start(ParticleSystem& particles, Integrator& integrator, ForceSolver* solver, TrajectoryRecorder* recorder)
+{
+    stop();
+    this->particles = &particles;
+    this->integrator = &integrator;
+    this->recorder = recorder;
+    requestedSolver.store(solver, std::memory_order_relaxed);
+    requestedSubsteps.store(integrator.substeps, std::memory_order_relaxed);
+    requestedScheme.store(integrator.scheme, std::memory_order_relaxed);
+    stopping.store(false, std::memory_order_relaxed);
+    idle = false;
+    worker = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop()
+{
+    if (!worker.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        stopping.store(true, std::memory_order_relaxed);
+    }
+    wakeCondition.notify_one();
+    worker.join();
+}
+
+void SimulationThread::setPaused(bool paused)
+{
+    std::unique_lock<std::mutex> lock(controlMutex);
+    if (paused)
+    {
+        // Also waits when the pause was requested before start() and the thread hasn't got there yet
+        pauseRequested.store(true, std::memory_order_relaxed);
+        idleCondition.wait(lock, [this] { return idle || !worker.joinable(); });
+    }
+    else if (pauseRequested.load(std::memory_order_relaxed))
+    {
+        pauseRequested.store(false, std::memory_order_relaxed);
+        wakeCondition.notify_one();
+    }
+}
+
+bool SimulationThread::waitWhilePaused()
+{
+    std::unique_lock<std::mutex> lock(controlMutex);
+    if (pauseRequested.load(std::memory_order_relaxed) && !stopping)
+    {
+        idle = true;
+        idleCondition.notify_all();
+        wakeCondition.wait(lock, [this] { return !pauseRequested.load(std::memory_order_relaxed) || stopping; });
+        idle = false;
+        // The state may have been replaced while paused
+        integrator->invalidateAccelerations();
+        epoch++;
+    }
+    return !stopping;
+}
+
+void SimulationThread::run()
+{
+    publishSnapshot();
+    double lastTime = steadySeconds();
+    ForceSolver* lastSolver = requestedSolver.load(std::memory_order_relaxed);
+    while (true)
+    {
+        if (pauseRequested.load(std::memory_order_relaxed))
+        {
+            if (!waitWhilePaused())
+            {
+                break;
+            }
+            publishSnapshot();
+            // Don't catch up on the time spent paused
+            lastTime = steadySeconds();
+        }
+        else if (stopping.load(std::memory_order_relaxed))
+        {
+            break;
+        }
+
+        integrator->substeps = std::max(requestedSubsteps.load(std::memory_order_relaxed), 1);
+        IntegrationScheme scheme = requestedScheme.load(std::memory_order_relaxed);
+        if (scheme != integrator->scheme)
+        {
+            integrator->scheme = scheme;
+            integrator->invalidateAccelerations();
+        }
+        // The accelerations carried over from the last step came from the old solver
+        ForceSolver* solver = requestedSolver.load(std::memory_order_relaxed);
+        if (solver != lastSolver)
+        {
+            lastSolver = solver;
+            integrator->invalidateAccelerations();
+        }
+
+        double now = steadySeconds();
+        int steps = integrator->consumeSteps(float(now - lastTime));
+        lastTime = now;
+        for (int s = 0; s < steps && solver != nullptr; s++)
+        {
+            integrator->step(*particles, *solver);
+            simulationTime += integrator->timeStep;
+            stepCount++;
+            if (recorder != nullptr)
+            {
+                recorder->record(*particles, simulationTime);
+            }
+        }
+        if (steps > 0)
+        {
+            publishSnapshot();
+        }
+        else
+        {
+            // Sleep until the next step is due rather than spin
+            double untilNextStep = (1.0 - integrator->alpha()) * integrator->timeStep;
+            std::this_thread::sleep_for(std::chrono::duration<double>(std::max(untilNextStep, 0.0)));
+        }
+    }
+}
+
+void SimulationThread::publishSnapshot()
+{
+    ParticleSnapshot& snapshot = exchange.writeBuffer();
+    std::size_t count = particles->size();
+    snapshot.positions.resize(count);
+    snapshot.charges.resize(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        snapshot.positions[i] = particles->position(i);
+        snapshot.charges[i] = particles->charge[i];
+    }
+    snapshot.boxSide = particles->box.side;
+    snapshot.simulationTime = simulationTime;
+    snapshot.publishTime = steadySeconds();
+    snapshot.step = stepCount;
+    snapshot.epoch = epoch;
+    exchange.publish();
+}
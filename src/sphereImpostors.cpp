@@ -0,0 +1,88 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "sphereImpostors.h"
+
+#include <algorithm>
+#include <cmath>
+
+SphereImpostors::SphereImpostors()
+    : VAO(0),
+      emptyVAO(0),
+      instanceVBO(0),
+      instanceCapacity(0),
+      divisor(1)
+{}
+
+SphereImpostors::~SphereImpostors()
+{
+    if (instanceVBO != 0)
+        glDeleteBuffers(1, &instanceVBO);
+    if (VAO != 0)
+        glDeleteVertexArrays(1, &VAO);
+    if (emptyVAO != 0)
+        glDeleteVertexArrays(1, &emptyVAO);
+}
+
+void SphereImpostors::draw(const std::vector<glm::vec3>& centers, GLuint imagesPerCenter)
+{
+    if (centers.empty() || imagesPerCenter == 0)
+        return;
+    if (centers.size() > instanceCapacity)
+        allocateInstanceBuffer(std::max(centers.size(), 2 * instanceCapacity));
+
+    // Orphan the old storage so the driver doesn't wait on last frame's draw
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * instanceCapacity, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::vec3) * centers.size(), centers.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindVertexArray(VAO);
+    if (divisor != imagesPerCenter)
+    {
+        divisor = imagesPerCenter;
+        glVertexAttribDivisor(0, divisor);
+    }
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei) (centers.size() * imagesPerCenter));
+    glBindVertexArray(0);
+}
+
+void SphereImpostors::drawInstanced(GLsizei instanceCount)
+{
+    if (instanceCount <= 0)
+        return;
+    // A core profile draw needs a VAO, even one without attributes
+    if (emptyVAO == 0)
+        glGenVertexArrays(1, &emptyVAO);
+    glBindVertexArray(emptyVAO);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instanceCount);
+    glBindVertexArray(0);
+}
+
+void SphereImpostors::allocateInstanceBuffer(std::size_t capacity)
+{
+    if (VAO == 0)
+        glGenVertexArrays(1, &VAO);
+    if (instanceVBO == 0)
+        glGenBuffers(1, &instanceVBO);
+    instanceCapacity = capacity;
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * instanceCapacity, NULL, GL_STREAM_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*) 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, divisor);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+float projectedRadiusPixels(const glm::mat4& projection, float viewportHeight, float distance, float radius)
+{
+    if (distance <= radius)
+        return viewportHeight;
+    // projection[1][1] is cot(fov / 2), the sphere's angular radius is asin(r / d)
+    float angularRadius = std::asin(radius / distance);
+    return std::tan(angularRadius) * projection[1][1] * 0.5f * viewportHeight;
+}
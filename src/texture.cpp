@@ -56,7 +56,7 @@ Texture::Texture()
     nrChannels = 0;
     isResident = false;
     texData = nullptr;
-    glGenTextures(1, &id);
+    id = createGLTexture();
 }
 
 Texture::Texture(std::string filename)
@@ -66,19 +66,45 @@ Texture::Texture(std::string filename)
     nrChannels = 0;
     isResident = false;
     texData = nullptr;
-    glGenTextures(1, &id);
+    id = createGLTexture();
     loadFromFile(filename);
 }
 
 Texture::~Texture()
 {
-    glDeleteTextures(1, &id);
     if (texData)
     {
         stbi_image_free(texData);
     }
 }
 
+Texture::Texture(Texture&& other) noexcept
+    : width(std::exchange(other.width, 0)),
+      height(std::exchange(other.height, 0)),
+      nrChannels(std::exchange(other.nrChannels, 0)),
+      isResident(std::exchange(other.isResident, false)),
+      texData(std::exchange(other.texData, nullptr)),
+      id(std::move(other.id))
+{}
+
+Texture& Texture::operator=(Texture&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (texData)
+        {
+            stbi_image_free(texData);
+        }
+        width = std::exchange(other.width, 0);
+        height = std::exchange(other.height, 0);
+        nrChannels = std::exchange(other.nrChannels, 0);
+        isResident = std::exchange(other.isResident, false);
+        texData = std::exchange(other.texData, nullptr);
+        id = std::move(other.id);
+    }
+    return *this;
+}
+
 void Texture::loadToGPU()
 {
     if (texData)
@@ -102,7 +128,7 @@ void Texture::loadToGPU()
             std::cout << "ERROR: Unsupported number of channels: " << nrChannels << std::endl;
             return;
         }
-        glBindTexture(GL_TEXTURE_2D, id);
+        glBindTexture(GL_TEXTURE_2D, id.get());
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, texData);
         glGenerateMipmap(GL_TEXTURE_2D);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -119,14 +145,17 @@ void Texture::loadToGPU()
 
 void Texture::unloadFromGPU()
 {
-    glDeleteTextures(1, &id);
-    glGenTextures(1, &id);
+    id = createGLTexture();
     isResident = false;
 }
 
 void Texture::loadFromFile(std::string filename)
 {
     int width, height, nrChannels;
+    if (texData)
+    {
+        stbi_image_free(texData);
+    }
     texData = stbi_load(filename.c_str(), &width, &height, &nrChannels, 0);
 
     if (texData)
@@ -140,3 +169,67 @@ void Texture::loadFromFile(std::string filename)
         std::cout << "ERROR: Failed to load texture" << std::endl;
     }
 }
+
+Texture3D::Texture3D()
+{
+    width = 0;
+    height = 0;
+    depth = 0;
+    internalFormat = 0;
+    id = 0;
+}
+
+Texture3D::~Texture3D()
+{
+    if (id != 0)
+    {
+        glDeleteTextures(1, &id);
+    }
+}
+
+void Texture3D::allocate(int width, int height, int depth, GLenum internalFormat, GLint filter)
+{
+    if (id != 0 && width == this->width && height == this->height && depth == this->depth &&
+        internalFormat == this->internalFormat)
+    {
+        return;
+    }
+    if (id != 0)
+    {
+        glDeleteTextures(1, &id);
+    }
+    this->width = width;
+    this->height = height;
+    this->depth = depth;
+    this->internalFormat = internalFormat;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_3D, id);
+    glTexStorage3D(GL_TEXTURE_3D, 1, internalFormat, width, height, depth);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, filter);
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void Texture3D::upload(GLenum format, GLenum type, const void* data)
+{
+    if (id == 0)
+    {
+        std::cout << "ERROR: Texture3D upload before allocate" << std::endl;
+        return;
+    }
+    glBindTexture(GL_TEXTURE_3D, id);
+    // Rows are tightly packed, whatever the texel size
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, width, height, depth, format, type, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void Texture3D::bind(GLuint unit) const
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_3D, id);
+}
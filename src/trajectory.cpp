@@ -0,0 +1,554 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "trajectory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Chunks are sized in bytes rather than frames, so a million-particle run
+// doesn't need a gigabyte of chunk buffer
+static const std::size_t TARGET_CHUNK_BYTES = 4 << 20;
+static const uint32_t MAX_FRAMES_PER_CHUNK = 256;
+// Time is stored as a double in the first two words of every frame
+static const std::size_t TIME_WORDS = 2;
+
+// Byte planes of words, plane p holds byte p of every word
+static void shuffleBytes(const std::vector<uint32_t>& words, std::vector<uint8_t>& planes)
+{
+    std::size_t n = words.size();
+    planes.resize(n * 4);
+    for (std::size_t k = 0; k < n; k++)
+    {
+        uint32_t word = words[k];
+        planes[k] = uint8_t(word);
+        planes[n + k] = uint8_t(word >> 8);
+        planes[2 * n + k] = uint8_t(word >> 16);
+        planes[3 * n + k] = uint8_t(word >> 24);
+    }
+}
+
+static void unshuffleBytes(const std::vector<uint8_t>& planes, std::vector<uint32_t>& words)
+{
+    std::size_t n = words.size();
+    for (std::size_t k = 0; k < n; k++)
+    {
+        words[k] = uint32_t(planes[k])
+                 | uint32_t(planes[n + k]) << 8
+                 | uint32_t(planes[2 * n + k]) << 16
+                 | uint32_t(planes[3 * n + k]) << 24;
+    }
+}
+
+// Control byte c < 128 is followed by c + 1 literal bytes, c >= 128 stands
+// for c - 127 zero bytes. A lone zero stays inside a literal run, it would
+// cost as much as a run token.
+static void encodeZeroRuns(const std::vector<uint8_t>& bytes, std::vector<uint8_t>& out)
+{
+    out.clear();
+    std::size_t size = bytes.size();
+    std::size_t i = 0;
+    while (i < size)
+    {
+        if (bytes[i] == 0)
+        {
+            std::size_t run = 1;
+            while (i + run < size && run < 128 && bytes[i + run] == 0)
+            {
+                run++;
+            }
+            out.push_back(uint8_t(127 + run));
+            i += run;
+            continue;
+        }
+        std::size_t start = i;
+        while (i < size && i - start < 128)
+        {
+            if (bytes[i] == 0 && i + 1 < size && bytes[i + 1] == 0)
+                break;
+            i++;
+        }
+        out.push_back(uint8_t(i - start - 1));
+        out.insert(out.end(), bytes.begin() + start, bytes.begin() + i);
+    }
+}
+
+static bool decodeZeroRuns(const uint8_t* in, std::size_t inSize, std::vector<uint8_t>& bytes)
+{
+    std::size_t written = 0;
+    std::size_t i = 0;
+    while (i < inSize)
+    {
+        uint8_t control = in[i++];
+        if (control >= 128)
+        {
+            std::size_t run = control - 127;
+            if (written + run > bytes.size())
+                return false;
+            std::memset(bytes.data() + written, 0, run);
+            written += run;
+        }
+        else
+        {
+            std::size_t run = std::size_t(control) + 1;
+            if (written + run > bytes.size() || i + run > inSize)
+                return false;
+            std::memcpy(bytes.data() + written, in + i, run);
+            written += run;
+            i += run;
+        }
+    }
+    return written == bytes.size();
+}
+
+TrajectoryRecorder::TrajectoryRecorder()
+    : stopping(false),
+      particleCount(0),
+      frameWords(0),
+      framesPerChunk(1),
+      recordedFrames(0),
+      droppedFrames(0),
+      chunkFrames(0),
+      writtenFrames(0)
+{}
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+    close();
+}
+
+bool TrajectoryRecorder::open(const std::string& path, const ParticleSystem& particles, std::size_t bufferedFrames)
+{
+    close();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "ERROR::TRAJECTORY_OPEN_FAILED: \"" << path << "\"" << std::endl;
+        return false;
+    }
+
+    particleCount = particles.size();
+    frameWords = TIME_WORDS + 6 * particleCount;
+    std::size_t frameBytes = frameWords * sizeof(uint32_t);
+    framesPerChunk = (uint32_t) std::clamp<std::size_t>(TARGET_CHUNK_BYTES / frameBytes, 1, MAX_FRAMES_PER_CHUNK);
+
+    TrajectoryFileHeader header;
+    std::memcpy(header.magic, "PTRJ", 4);
+    header.version = TRAJECTORY_VERSION;
+    header.particleCount = (uint32_t) particleCount;
+    header.framesPerChunk = framesPerChunk;
+    file.write((const char*) &header, sizeof(header));
+    file.write((const char*) particles.charge.data(), sizeof(float) * particleCount);
+    file.write((const char*) particles.mass.data(), sizeof(float) * particleCount);
+
+    bufferedFrames = std::max<std::size_t>(bufferedFrames, 2);
+    slotData.assign(bufferedFrames * frameWords, 0);
+    filledSlots.reset(bufferedFrames);
+    freeSlots.reset(bufferedFrames);
+    for (uint32_t slot = 0; slot < bufferedFrames; slot++)
+    {
+        freeSlots.push(slot);
+    }
+    recordedFrames = 0;
+    droppedFrames = 0;
+
+    chunkWords.clear();
+    chunkWords.reserve(framesPerChunk * frameWords);
+    previousFrame.assign(frameWords, 0);
+    index.clear();
+    chunkFrames = 0;
+    writtenFrames = 0;
+
+    stopping.store(false);
+    writer = std::thread(&TrajectoryRecorder::writerLoop, this);
+    return true;
+}
+
+void TrajectoryRecorder::close()
+{
+    if (!writer.joinable())
+    {
+        return;
+    }
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+    file.close();
+    if (droppedFrames > 0)
+    {
+        std::cout << "Trajectory: dropped " << droppedFrames << " of " << recordedFrames + droppedFrames << " frames" << std::endl;
+    }
+}
+
+bool TrajectoryRecorder::record(const ParticleSystem& particles, double time)
+{
+    if (!isOpen() || particles.size() != particleCount)
+    {
+        return false;
+    }
+    uint32_t slot;
+    if (!freeSlots.pop(slot))
+    {
+        droppedFrames++;
+        return false;
+    }
+
+    uint32_t* words = slotData.data() + std::size_t(slot) * frameWords;
+    std::memcpy(words, &time, sizeof(double));
+    const AlignedFloats* arrays[] = { &particles.posX, &particles.posY, &particles.posZ, &particles.velX, &particles.velY, &particles.velZ };
+    for (int a = 0; a < 6; a++)
+    {
+        std::memcpy(words + TIME_WORDS + a * particleCount, arrays[a]->data(), sizeof(float) * particleCount);
+    }
+    filledSlots.push(slot);
+    recordedFrames++;
+    return true;
+}
+
+void TrajectoryRecorder::writerLoop()
+{
+    uint32_t slot;
+    while (true)
+    {
+        if (filledSlots.pop(slot))
+        {
+            appendFrame(slot);
+            freeSlots.push(slot);
+            continue;
+        }
+        // record() is never called after stopping is set, so once it is
+        // visible an empty ring really is the end
+        if (stopping.load(std::memory_order_acquire) && filledSlots.size() == 0)
+        {
+            break;
+        }
+        // Idle writer naps instead of spinning, the ring absorbs the latency
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    flushChunk();
+
+    TrajectoryFooter footer;
+    footer.indexOffset = (uint64_t) file.tellp();
+    footer.chunkCount = index.size();
+    std::memcpy(footer.magic, "PIDX", 4);
+    footer.version = TRAJECTORY_VERSION;
+    file.write((const char*) index.data(), sizeof(TrajectoryIndexEntry) * index.size());
+    file.write((const char*) &footer, sizeof(footer));
+    file.flush();
+}
+
+void TrajectoryRecorder::appendFrame(uint32_t slot)
+{
+    const uint32_t* words = slotData.data() + std::size_t(slot) * frameWords;
+    for (std::size_t k = 0; k < frameWords; k++)
+    {
+        chunkWords.push_back(words[k] ^ previousFrame[k]);
+    }
+    std::memcpy(previousFrame.data(), words, sizeof(uint32_t) * frameWords);
+    chunkFrames++;
+    if (chunkFrames == framesPerChunk)
+    {
+        flushChunk();
+    }
+}
+
+void TrajectoryRecorder::flushChunk()
+{
+    if (chunkFrames == 0)
+    {
+        return;
+    }
+    std::vector<uint8_t> planes;
+    shuffleBytes(chunkWords, planes);
+    encodeZeroRuns(planes, compressed);
+
+    TrajectoryIndexEntry entry;
+    entry.offset = (uint64_t) file.tellp();
+    entry.firstFrame = writtenFrames;
+    entry.frameCount = chunkFrames;
+    index.push_back(entry);
+
+    TrajectoryChunkHeader header;
+    std::memcpy(header.magic, "CHNK", 4);
+    header.frameCount = chunkFrames;
+    header.firstFrame = writtenFrames;
+    header.rawSize = planes.size();
+    header.compressedSize = compressed.size();
+    file.write((const char*) &header, sizeof(header));
+    file.write((const char*) compressed.data(), compressed.size());
+
+    writtenFrames += chunkFrames;
+    chunkFrames = 0;
+    chunkWords.clear();
+    std::fill(previousFrame.begin(), previousFrame.end(), 0);
+}
+
+TrajectoryReader::TrajectoryReader()
+    : data(nullptr),
+      fileSize(0),
+#if defined(_WIN32)
+      fileHandle(nullptr),
+      mappingHandle(nullptr),
+#else
+      fileDescriptor(-1),
+#endif
+      particleCount(0),
+      frameCount(0),
+      charges(nullptr),
+      masses(nullptr),
+      decodedChunk(SIZE_MAX)
+{}
+
+TrajectoryReader::~TrajectoryReader()
+{
+    close();
+}
+
+bool TrajectoryReader::open(const std::string& path)
+{
+    close();
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        std::cout << "ERROR::TRAJECTORY_OPEN_FAILED: \"" << path << "\"" << std::endl;
+        return false;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(handle, &size);
+    fileSize = (std::size_t) size.QuadPart;
+    fileHandle = handle;
+    if (fileSize > 0)
+    {
+        mappingHandle = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mappingHandle != nullptr)
+            data = (const uint8_t*) MapViewOfFile((HANDLE) mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    }
+#else
+    fileDescriptor = ::open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+    {
+        std::cout << "ERROR::TRAJECTORY_OPEN_FAILED: \"" << path << "\"" << std::endl;
+        return false;
+    }
+    struct stat status;
+    fstat(fileDescriptor, &status);
+    fileSize = (std::size_t) status.st_size;
+    if (fileSize > 0)
+    {
+        void* mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (mapped != MAP_FAILED)
+            data = (const uint8_t*) mapped;
+    }
+#endif
+    if (data == nullptr)
+    {
+        std::cout << "ERROR::TRAJECTORY_MAP_FAILED: \"" << path << "\"" << std::endl;
+        close();
+        return false;
+    }
+
+    TrajectoryFileHeader header;
+    if (fileSize < sizeof(header))
+    {
+        std::cout << "ERROR::TRAJECTORY_INVALID: \"" << path << "\"" << std::endl;
+        close();
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    std::size_t payloadStart = sizeof(header) + 2 * sizeof(float) * std::size_t(header.particleCount);
+    if (std::memcmp(header.magic, "PTRJ", 4) != 0 || header.version != TRAJECTORY_VERSION || fileSize < payloadStart)
+    {
+        std::cout << "ERROR::TRAJECTORY_INVALID: \"" << path << "\"" << std::endl;
+        close();
+        return false;
+    }
+    particleCount = header.particleCount;
+    charges = (const float*) (data + sizeof(header));
+    masses = charges + particleCount;
+    if (!loadIndex(payloadStart))
+    {
+        std::cout << "ERROR::TRAJECTORY_INVALID: \"" << path << "\"" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TrajectoryReader::close()
+{
+#if defined(_WIN32)
+    if (data != nullptr)
+        UnmapViewOfFile(data);
+    if (mappingHandle != nullptr)
+        CloseHandle((HANDLE) mappingHandle);
+    if (fileHandle != nullptr)
+        CloseHandle((HANDLE) fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (data != nullptr)
+        munmap((void*) data, fileSize);
+    if (fileDescriptor >= 0)
+        ::close(fileDescriptor);
+    fileDescriptor = -1;
+#endif
+    data = nullptr;
+    fileSize = 0;
+    particleCount = 0;
+    frameCount = 0;
+    charges = nullptr;
+    masses = nullptr;
+    index.clear();
+    decodedChunk = SIZE_MAX;
+}
+
+bool TrajectoryReader::loadIndex(std::size_t payloadStart)
+{
+    index.clear();
+    frameCount = 0;
+
+    TrajectoryFooter footer;
+    if (fileSize >= payloadStart + sizeof(footer))
+    {
+        std::memcpy(&footer, data + fileSize - sizeof(footer), sizeof(footer));
+        std::size_t indexBytes = sizeof(TrajectoryIndexEntry) * footer.chunkCount;
+        if (std::memcmp(footer.magic, "PIDX", 4) == 0 && footer.indexOffset >= payloadStart
+            && footer.chunkCount <= fileSize / sizeof(TrajectoryIndexEntry)
+            && footer.indexOffset <= fileSize
+            && footer.indexOffset + indexBytes + sizeof(footer) == fileSize)
+        {
+            index.resize(footer.chunkCount);
+            std::memcpy(index.data(), data + footer.indexOffset, indexBytes);
+        }
+    }
+
+    // No footer, the recording was cut short: recover every complete chunk
+    if (index.empty())
+    {
+        std::size_t offset = payloadStart;
+        TrajectoryChunkHeader header;
+        while (offset + sizeof(header) <= fileSize)
+        {
+            std::memcpy(&header, data + offset, sizeof(header));
+            if (std::memcmp(header.magic, "CHNK", 4) != 0 || header.compressedSize > fileSize - offset - sizeof(header))
+                break;
+            TrajectoryIndexEntry entry;
+            entry.offset = offset;
+            entry.firstFrame = header.firstFrame;
+            entry.frameCount = header.frameCount;
+            index.push_back(entry);
+            offset += sizeof(header) + header.compressedSize;
+        }
+    }
+
+    // readFrame binary searches on firstFrame, and neither a footer index nor
+    // recovered chunk headers are guaranteed to come in order
+    std::stable_sort(index.begin(), index.end(),
+        [](const TrajectoryIndexEntry& a, const TrajectoryIndexEntry& b) { return a.firstFrame < b.firstFrame; });
+    for (const TrajectoryIndexEntry& entry : index)
+    {
+        if (entry.frameCount > SIZE_MAX - entry.firstFrame)
+        {
+            return false;
+        }
+        frameCount = std::max<std::size_t>(frameCount, entry.firstFrame + entry.frameCount);
+    }
+    return true;
+}
+
+bool TrajectoryReader::decodeChunk(std::size_t chunk)
+{
+    if (chunk == decodedChunk)
+    {
+        return true;
+    }
+    const TrajectoryIndexEntry& entry = index[chunk];
+    TrajectoryChunkHeader header;
+    if (entry.offset + sizeof(header) > fileSize)
+    {
+        return false;
+    }
+    std::memcpy(&header, data + entry.offset, sizeof(header));
+    std::size_t frameWords = TIME_WORDS + 6 * particleCount;
+    if (std::memcmp(header.magic, "CHNK", 4) != 0
+        || header.frameCount != entry.frameCount
+        || header.compressedSize > fileSize - entry.offset - sizeof(header)
+        || header.rawSize != header.frameCount * frameWords * sizeof(uint32_t))
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> planes(header.rawSize);
+    if (!decodeZeroRuns(data + entry.offset + sizeof(header), header.compressedSize, planes))
+    {
+        return false;
+    }
+    decodedWords.resize(header.rawSize / sizeof(uint32_t));
+    unshuffleBytes(planes, decodedWords);
+    // Undo the XOR against the previous frame, front to back
+    for (std::size_t k = frameWords; k < decodedWords.size(); k++)
+    {
+        decodedWords[k] ^= decodedWords[k - frameWords];
+    }
+    decodedChunk = chunk;
+    return true;
+}
+
+bool TrajectoryReader::readFrame(std::size_t frame, ParticleSystem& particles, double* time)
+{
+    if (frame >= frameCount)
+    {
+        return false;
+    }
+    // Last chunk starting at or before frame, none if every chunk starts later
+    auto after = std::upper_bound(index.begin(), index.end(), frame,
+        [](std::size_t value, const TrajectoryIndexEntry& entry) { return value < entry.firstFrame; });
+    if (after == index.begin())
+    {
+        return false;
+    }
+    std::size_t chunk = std::size_t(after - index.begin()) - 1;
+    if (frame >= index[chunk].firstFrame + index[chunk].frameCount || !decodeChunk(chunk))
+    {
+        return false;
+    }
+
+    if (particles.size() != particleCount)
+    {
+        particles.clear();
+        particles.reserve(particleCount);
+        for (std::size_t i = 0; i < particleCount; i++)
+        {
+            float charge;
+            float mass;
+            std::memcpy(&charge, charges + i, sizeof(float));
+            std::memcpy(&mass, masses + i, sizeof(float));
+            particles.addParticle(charge, mass, glm::vec3(0.0f), glm::vec3(0.0f));
+        }
+    }
+
+    std::size_t frameWords = TIME_WORDS + 6 * particleCount;
+    const uint32_t* words = decodedWords.data() + (frame - index[chunk].firstFrame) * frameWords;
+    if (time != nullptr)
+    {
+        std::memcpy(time, words, sizeof(double));
+    }
+    AlignedFloats* arrays[] = { &particles.posX, &particles.posY, &particles.posZ, &particles.velX, &particles.velY, &particles.velZ };
+    for (int a = 0; a < 6; a++)
+    {
+        std::memcpy(arrays[a]->data(), words + TIME_WORDS + a * particleCount, sizeof(float) * particleCount);
+    }
+    return true;
+}
@@ -0,0 +1,204 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+#include "volumeRenderer.h"
+
+#include <algorithm>
+#include <iostream>
+
+VolumeRenderer::VolumeRenderer()
+    : downsample(2),
+      skipEmptySpace(true),
+      voxelOpticalDepth(0.25f),
+      samplesPerVoxel(1.0f),
+      inverseViewProjectionUniform(-1),
+      cameraPositionUniform(-1),
+      volumeMinUniform(-1),
+      volumeSideUniform(-1),
+      macroGridSizeUniform(-1),
+      densityScaleUniform(-1),
+      stepLengthUniform(-1),
+      skipEmptySpaceUniform(-1),
+      marchDownsampleUniform(-1),
+      upsampleInverseViewProjectionUniform(-1),
+      upsampleCameraPositionUniform(-1),
+      upsampleDownsampleUniform(-1),
+      emptyVAO(0),
+      sceneDepth(0),
+      marchFramebuffer(0),
+      marchColor(0),
+      marchDepth(0),
+      fullWidth(0),
+      fullHeight(0),
+      marchWidth(0),
+      marchHeight(0)
+{}
+
+VolumeRenderer::~VolumeRenderer()
+{
+    deleteTargets();
+    if (emptyVAO != 0)
+        glDeleteVertexArrays(1, &emptyVAO);
+}
+
+void VolumeRenderer::loadShaders(const char* vertexShaderPath, const char* raymarchShaderPath, const char* upsampleShaderPath)
+{
+    raymarchShader.compileVertexShader(vertexShaderPath);
+    raymarchShader.compileFragmentShader(raymarchShaderPath);
+    raymarchShader.linkShaders();
+    inverseViewProjectionUniform = raymarchShader.getUniform("inverseViewProjection");
+    cameraPositionUniform = raymarchShader.getUniform("cameraPosition");
+    volumeMinUniform = raymarchShader.getUniform("volumeMin");
+    volumeSideUniform = raymarchShader.getUniform("volumeSide");
+    macroGridSizeUniform = raymarchShader.getUniform("macroGridSize");
+    densityScaleUniform = raymarchShader.getUniform("densityScale");
+    stepLengthUniform = raymarchShader.getUniform("stepLength");
+    skipEmptySpaceUniform = raymarchShader.getUniform("skipEmptySpace");
+    marchDownsampleUniform = raymarchShader.getUniform("downsample");
+
+    upsampleShader.compileVertexShader(vertexShaderPath);
+    upsampleShader.compileFragmentShader(upsampleShaderPath);
+    upsampleShader.linkShaders();
+    upsampleInverseViewProjectionUniform = upsampleShader.getUniform("inverseViewProjection");
+    upsampleCameraPositionUniform = upsampleShader.getUniform("cameraPosition");
+    upsampleDownsampleUniform = upsampleShader.getUniform("downsample");
+}
+
+void VolumeRenderer::render(const ChargeDensityVolume& volume, const Camera& camera, int width, int height)
+{
+    if (width <= 0 || height <= 0 || volume.getMaxAbsDensity() <= 0.0f)
+        return;
+    downsample = std::max(downsample, 1);
+    if (width != fullWidth || height != fullHeight ||
+        (width + downsample - 1) / downsample != marchWidth || (height + downsample - 1) / downsample != marchHeight)
+    {
+        allocateTargets(width, height);
+    }
+    if (emptyVAO == 0)
+        glGenVertexArrays(1, &emptyVAO);
+
+    GLint previousFramebuffer;
+    GLint previousViewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+
+    // The scene's depth, read from the framebuffer being drawn into
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previousFramebuffer);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sceneDepth);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+    glm::mat4 inverseViewProjection = glm::inverse(camera.projection * camera.view);
+    float cellSize = volume.getCellSize();
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glBindFramebuffer(GL_FRAMEBUFFER, marchFramebuffer);
+    glViewport(0, 0, marchWidth, marchHeight);
+    raymarchShader.use();
+    setMat4(inverseViewProjectionUniform, inverseViewProjection);
+    setVec3(cameraPositionUniform, camera.position);
+    setVec3(volumeMinUniform, volume.boundsMin());
+    setFloat(volumeSideUniform, volume.boundsSide());
+    setInt(macroGridSizeUniform, int(volume.macroGridSize()));
+    setFloat(densityScaleUniform, voxelOpticalDepth / (volume.getMaxAbsDensity() * cellSize));
+    setFloat(stepLengthUniform, cellSize / std::max(samplesPerVoxel, 0.1f));
+    setBool(skipEmptySpaceUniform, skipEmptySpace);
+    setInt(marchDownsampleUniform, downsample);
+    volume.getDensityTexture().bind(1);
+    volume.getMacroTexture().bind(2);
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // Premultiplied colour over the scene
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    glViewport(0, 0, width, height);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    upsampleShader.use();
+    setMat4(upsampleInverseViewProjectionUniform, inverseViewProjection);
+    setVec3(upsampleCameraPositionUniform, camera.position);
+    setInt(upsampleDownsampleUniform, downsample);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, marchColor);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, marchDepth);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    if (!blend)
+        glDisable(GL_BLEND);
+    if (depthTest)
+        glEnable(GL_DEPTH_TEST);
+}
+
+void VolumeRenderer::allocateTargets(int width, int height)
+{
+    deleteTargets();
+    fullWidth = width;
+    fullHeight = height;
+    marchWidth = (width + downsample - 1) / downsample;
+    marchHeight = (height + downsample - 1) / downsample;
+
+    glGenTextures(1, &sceneDepth);
+    glBindTexture(GL_TEXTURE_2D, sceneDepth);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, width, height);
+
+    glGenTextures(1, &marchColor);
+    glBindTexture(GL_TEXTURE_2D, marchColor);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, marchWidth, marchHeight);
+    glGenTextures(1, &marchDepth);
+    glBindTexture(GL_TEXTURE_2D, marchDepth);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32F, marchWidth, marchHeight);
+    // Only ever read with texelFetch
+    GLuint textures[] = { sceneDepth, marchColor, marchDepth };
+    for (GLuint texture : textures)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint previousFramebuffer;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGenFramebuffers(1, &marchFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, marchFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, marchColor, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, marchDepth, 0);
+    GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR: Volume march framebuffer incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+}
+
+void VolumeRenderer::deleteTargets()
+{
+    if (marchFramebuffer != 0)
+        glDeleteFramebuffers(1, &marchFramebuffer);
+    GLuint textures[] = { sceneDepth, marchColor, marchDepth };
+    for (GLuint texture : textures)
+    {
+        if (texture != 0)
+            glDeleteTextures(1, &texture);
+    }
+    marchFramebuffer = 0;
+    sceneDepth = 0;
+    marchColor = 0;
+    marchDepth = 0;
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+// Builds a point cloud octree file for PointCloud to stream.
+// Usage: buildPointCloud <input> <output.pcot> [maxNodePoints]
+// input is a file of raw CloudPoint records (float x, y, z, then r, g, b, a
+// bytes, 16 bytes a point), or --synthetic=<count> for a generated terrain.
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "pointCloudBuilder.h"
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::printf("Usage: buildPointCloud <input points | --synthetic=count> <output.pcot> [maxNodePoints]\n");
+        return 1;
+    }
+    std::string input = argv[1];
+    std::string output = argv[2];
+    PointCloudBuildSettings settings;
+    if (argc > 3)
+        settings.maxNodePoints = (uint32_t) std::strtoul(argv[3], nullptr, 10);
+
+    std::unique_ptr<PointSource> source;
+    const std::string synthetic = "--synthetic=";
+    if (input.compare(0, synthetic.size(), synthetic) == 0)
+    {
+        uint64_t count = std::strtoull(input.c_str() + synthetic.size(), nullptr, 10);
+        source = std::make_unique<SyntheticPointSource>(count, 80.0f);
+    }
+    else
+    {
+        std::unique_ptr<RawPointFileSource> file = std::make_unique<RawPointFileSource>();
+        if (!file->open(input))
+            return 1;
+        source = std::move(file);
+    }
+
+    PointCloudBuildStats stats;
+    if (!buildPointCloud(*source, output, settings, &stats))
+        return 1;
+    double seconds = stats.boundsSeconds + stats.countSeconds + stats.distributeSeconds + stats.buildSeconds;
+    std::printf("points,%llu\n", (unsigned long long) stats.inputPoints);
+    std::printf("written,%llu\n", (unsigned long long) stats.writtenPoints);
+    std::printf("dropped,%llu\n", (unsigned long long) stats.droppedPoints);
+    std::printf("chunks,%zu\n", stats.chunkCount);
+    std::printf("largest_chunk,%zu\n", stats.largestChunkPoints);
+    std::printf("nodes,%zu\n", stats.nodeCount);
+    std::printf("depth,%u\n", stats.depth);
+    std::printf("seconds,%.3f (bounds %.3f, count %.3f, distribute %.3f, build %.3f)\n", seconds,
+        stats.boundsSeconds, stats.countSeconds, stats.distributeSeconds, stats.buildSeconds);
+    return 0;
+}
@@ -0,0 +1,224 @@
+// Copyright (c) 2025 Kyle Bueche
+// SPDX-License-Identifier: MIT
+// Author: Kyle Bueche
+
+// Welds a mesh's duplicate vertices, reorders its triangles and vertices for
+// the vertex cache, overdraw and vertex fetch, and reports ACMR, ATVR and
+// overdraw before and after.
+// Usage: optimizeMesh <input.obj | --sphere=segments | --plane=segments> [output.obj] [forsyth | tipsify | none]
+// Faces with more than 3 corners are split into fans, and each distinct
+// position / texture coordinate / normal triple becomes one vertex.
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+#include "meshOptimizer.h"
+#include "proceduralMesh.h"
+
+// OBJ indices are 1 based, negative ones count back from the last element so far
+static int resolveObjIndex(const std::string& field, std::size_t count)
+{
+    if (field.empty())
+        return -1;
+    int index = std::atoi(field.c_str());
+    if (index < 0)
+        return int(count) + index;
+    return index - 1;
+}
+
+static bool loadObj(const std::string& path, Mesh& mesh)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::printf("ERROR::OPTIMIZE_MESH::CANT_OPEN: %s\n", path.c_str());
+        return false;
+    }
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+    std::map<std::tuple<int, int, int>, unsigned int> vertexIds;
+    bool hasNormals = false;
+    bool hasTexCoords = false;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string type;
+        stream >> type;
+        if (type == "v")
+        {
+            glm::vec3 p(0.0f);
+            stream >> p.x >> p.y >> p.z;
+            positions.push_back(p);
+        }
+        else if (type == "vt")
+        {
+            glm::vec2 t(0.0f);
+            stream >> t.x >> t.y;
+            texCoords.push_back(t);
+        }
+        else if (type == "vn")
+        {
+            glm::vec3 n(0.0f);
+            stream >> n.x >> n.y >> n.z;
+            normals.push_back(n);
+        }
+        else if (type == "f")
+        {
+            std::vector<unsigned int> corners;
+            std::string corner;
+            while (stream >> corner)
+            {
+                std::string fields[3];
+                std::size_t first = corner.find('/');
+                fields[0] = corner.substr(0, first);
+                if (first != std::string::npos)
+                {
+                    std::size_t second = corner.find('/', first + 1);
+                    fields[1] = corner.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1);
+                    if (second != std::string::npos)
+                        fields[2] = corner.substr(second + 1);
+                }
+                int p = resolveObjIndex(fields[0], positions.size());
+                int t = resolveObjIndex(fields[1], texCoords.size());
+                int n = resolveObjIndex(fields[2], normals.size());
+                if (p < 0 || p >= int(positions.size()) || t >= int(texCoords.size()) || n >= int(normals.size()))
+                {
+                    std::printf("ERROR::OPTIMIZE_MESH::BAD_FACE: %s\n", line.c_str());
+                    return false;
+                }
+                auto key = std::make_tuple(p, t, n);
+                auto found = vertexIds.find(key);
+                if (found == vertexIds.end())
+                {
+                    found = vertexIds.emplace(key, (unsigned int) mesh.vertices.size()).first;
+                    mesh.vertices.push_back(positions[p]);
+                    mesh.texCoords.push_back(t >= 0 ? texCoords[t] : glm::vec2(0.0f));
+                    mesh.normals.push_back(n >= 0 ? normals[n] : glm::vec3(0.0f));
+                    hasTexCoords = hasTexCoords || t >= 0;
+                    hasNormals = hasNormals || n >= 0;
+                }
+                corners.push_back(found->second);
+            }
+            for (std::size_t i = 1; i + 1 < corners.size(); i++)
+            {
+                mesh.indices.push_back(corners[0]);
+                mesh.indices.push_back(corners[i]);
+                mesh.indices.push_back(corners[i + 1]);
+            }
+        }
+    }
+    if (!hasTexCoords)
+        mesh.texCoords.clear();
+    if (!hasNormals)
+        mesh.normals.clear();
+    return true;
+}
+
+static bool saveObj(const std::string& path, const Mesh& mesh)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr)
+    {
+        std::printf("ERROR::OPTIMIZE_MESH::CANT_WRITE: %s\n", path.c_str());
+        return false;
+    }
+    for (const glm::vec3& p : mesh.vertices)
+    {
+        std::fprintf(file, "v %.9g %.9g %.9g\n", p.x, p.y, p.z);
+    }
+    for (const glm::vec2& t : mesh.texCoords)
+    {
+        std::fprintf(file, "vt %.9g %.9g\n", t.x, t.y);
+    }
+    for (const glm::vec3& n : mesh.normals)
+    {
+        std::fprintf(file, "vn %.9g %.9g %.9g\n", n.x, n.y, n.z);
+    }
+    // Every attribute is indexed like the positions, so one index per corner serves all three
+    bool texCoords = !mesh.texCoords.empty();
+    bool normals = !mesh.normals.empty();
+    for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        std::fprintf(file, "f");
+        for (int c = 0; c < 3; c++)
+        {
+            unsigned int index = mesh.indices[i + c] + 1;
+            if (texCoords && normals)
+                std::fprintf(file, " %u/%u/%u", index, index, index);
+            else if (texCoords)
+                std::fprintf(file, " %u/%u", index, index);
+            else if (normals)
+                std::fprintf(file, " %u//%u", index, index);
+            else
+                std::fprintf(file, " %u", index);
+        }
+        std::fprintf(file, "\n");
+    }
+    std::fclose(file);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::printf("Usage: optimizeMesh <input.obj | --sphere=segments | --plane=segments> [output.obj] [forsyth | tipsify | none]\n");
+        return 1;
+    }
+    std::string input = argv[1];
+    std::string output;
+    MeshOptimizeSettings settings;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "forsyth")
+            settings.cacheOrder = VertexCacheOrder::Forsyth;
+        else if (argument == "tipsify")
+            settings.cacheOrder = VertexCacheOrder::Tipsify;
+        else if (argument == "none")
+            settings.cacheOrder = VertexCacheOrder::None;
+        else
+            output = argument;
+    }
+
+    Mesh mesh;
+    const std::string sphere = "--sphere=";
+    const std::string plane = "--plane=";
+    if (input.compare(0, sphere.size(), sphere) == 0)
+    {
+        int segments = std::atoi(input.c_str() + sphere.size());
+        mesh = uvSphere(1.0f, segments, segments);
+    }
+    else if (input.compare(0, plane.size(), plane) == 0)
+    {
+        int segments = std::atoi(input.c_str() + plane.size());
+        mesh = uvPlane(1.0f, segments, segments);
+    }
+    else if (!loadObj(input, mesh))
+    {
+        return 1;
+    }
+
+    std::size_t welded = weldVertices(mesh);
+    MeshOptimizeStats stats;
+    optimizeMesh(mesh, settings, &stats);
+    std::printf("order,%s\n", vertexCacheOrderName(settings.cacheOrder));
+    std::printf("welded,%zu\n", welded);
+    std::printf("triangles,%zu\n", stats.triangles);
+    std::printf("vertices,%zu,%zu\n", stats.verticesBefore, stats.verticesAfter);
+    std::printf("acmr,%.3f,%.3f\n", stats.cacheBefore.acmr, stats.cacheAfter.acmr);
+    std::printf("atvr,%.3f,%.3f\n", stats.cacheBefore.atvr, stats.cacheAfter.atvr);
+    std::printf("overdraw,%.3f,%.3f\n", stats.overdrawBefore, stats.overdrawAfter);
+    std::printf("clusters,%zu\n", stats.clusters);
+    std::printf("seconds,%.3f\n", stats.seconds);
+    if (!output.empty() && !saveObj(output, mesh))
+        return 1;
+    return 0;
+}